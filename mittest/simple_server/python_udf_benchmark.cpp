@@ -0,0 +1,409 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+/*
+ * End to end throughput of PREDICT queries.
+ *
+ * A synthetic table is filled with integer, double and varchar columns and a set of reference
+ * udfs is created: identities of each column type, a numpy linear model, a string tokeniser,
+ * a numpy tree ensemble and the same kind of ensemble as a LANGUAGE TREES udf. Every udf is
+ * run by `select count(PREDICT udf(...))` for each batch size (PREDICT_BATCH hint, 0 leaves it
+ * to _python_udf_batch_size_policy) and DOP (PARALLEL hint). Each run prints one JSON line
+ * starting with {"bench":"python_udf" to stdout, and to the file given by -o, with rows/s and
+ * the stages of the python calls taken from __all_virtual_python_udf_stat, so that results can
+ * be tracked over commits. The udfs need nothing but CPython and NumPy.
+ *
+ *   ./test_python_udf_benchmark -r 1000000 -n 5 -b 0,256,4096 -d 1,8 -o result.json
+ *
+ * -r rows of the table, -n reported runs per case, -b batch sizes, -d DOPs and -u runs only
+ * the udfs whose name contains the given string.
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#define USING_LOG_PREFIX SERVER
+#define protected public
+#define private public
+
+#include "env/ob_simple_cluster_test_base.h"
+#include "lib/mysqlclient/ob_mysql_result.h"
+#include "lib/time/ob_time_utility.h"
+
+static const char *TEST_FILE_NAME = "python_udf_benchmark";
+
+namespace oceanbase
+{
+namespace unittest
+{
+
+static const int64_t MAX_CASE_CNT = 16;
+
+class TestRunCtx
+{
+public:
+  uint64_t tenant_id_ = 0;
+  int64_t row_cnt_ = 100000;
+  int64_t repeat_cnt_ = 1;
+  int64_t batch_sizes_[MAX_CASE_CNT] = {0, 1024};
+  int64_t batch_size_cnt_ = 2;
+  int64_t dops_[MAX_CASE_CNT] = {1, 4};
+  int64_t dop_cnt_ = 2;
+  const char *udf_filter_ = nullptr;
+  FILE *output_ = nullptr;
+};
+
+TestRunCtx RunCtx;
+
+struct BenchUdf
+{
+  const char *name_;
+  const char *arg_type_; // column type of the args, for the report
+  const char *params_;
+  const char *ret_type_;
+  const char *options_;
+  const char *code_;
+  const char *args_;
+};
+
+static const char *LINEAR_CODE =
+    "import numpy as np\n"
+    "def pyinitial():\n"
+    "    global w, b\n"
+    "    rng = np.random.default_rng(7)\n"
+    "    w = rng.standard_normal(3)\n"
+    "    b = 0.5\n"
+    "def pyfun(x0, x1, x2):\n"
+    "    return w[0] * x0 + w[1] * x1 + w[2] * x2 + b\n";
+
+static const char *TOKENIZE_CODE =
+    "import numpy as np\n"
+    "def pyinitial():\n"
+    "    pass\n"
+    "def pyfun(s):\n"
+    "    return np.fromiter((len(v.split()) for v in s), dtype=np.int64, count=len(s))\n";
+
+// 32 complete trees of depth 6 over 3 features, walked level by level for all rows at once
+static const char *FOREST_CODE =
+    "import numpy as np\n"
+    "def pyinitial():\n"
+    "    global feat, thr, leaf\n"
+    "    rng = np.random.default_rng(11)\n"
+    "    feat = rng.integers(0, 3, size=(32, 63))\n"
+    "    thr = rng.random((32, 63))\n"
+    "    leaf = rng.standard_normal((32, 64))\n"
+    "def pyfun(x0, x1, x2):\n"
+    "    x = np.stack([x0, x1, x2])\n"
+    "    rows = np.arange(len(x0))\n"
+    "    out = np.zeros(len(x0))\n"
+    "    for t in range(feat.shape[0]):\n"
+    "        node = np.zeros(len(x0), dtype=np.int64)\n"
+    "        for _ in range(6):\n"
+    "            node = 2 * node + 1 + (x[feat[t, node], rows] > thr[t, node])\n"
+    "        out += leaf[t, node - feat.shape[1]]\n"
+    "    return out / feat.shape[0]\n";
+
+// xgboost json dump of a small ensemble, scored natively
+static const char *TREES_CODE =
+    "[{\"nodeid\": 0, \"depth\": 0, \"split\": \"f0\", \"split_condition\": 0.5,"
+    "  \"yes\": 1, \"no\": 2, \"missing\": 1, \"children\": ["
+    "    {\"nodeid\": 1, \"depth\": 1, \"split\": \"f1\", \"split_condition\": 0.3,"
+    "     \"yes\": 3, \"no\": 4, \"missing\": 3, \"children\": ["
+    "       {\"nodeid\": 3, \"leaf\": -0.4}, {\"nodeid\": 4, \"leaf\": 0.1}]},"
+    "    {\"nodeid\": 2, \"depth\": 1, \"split\": \"f2\", \"split_condition\": 0.7,"
+    "     \"yes\": 5, \"no\": 6, \"missing\": 5, \"children\": ["
+    "       {\"nodeid\": 5, \"leaf\": 0.2}, {\"nodeid\": 6, \"leaf\": 0.6}]}]},"
+    " {\"nodeid\": 0, \"depth\": 0, \"split\": \"f2\", \"split_condition\": 0.4,"
+    "  \"yes\": 1, \"no\": 2, \"missing\": 2, \"children\": ["
+    "    {\"nodeid\": 1, \"leaf\": -0.1}, {\"nodeid\": 2, \"leaf\": 0.3}]}]";
+
+static const BenchUdf BENCH_UDFS[] = {
+  {"bench_id_int", "int", "x INTEGER", "INTEGER", "",
+   "def pyinitial():\n    pass\ndef pyfun(x):\n    return x\n", "i0"},
+  {"bench_id_real", "double", "x REAL", "REAL", "",
+   "def pyinitial():\n    pass\ndef pyfun(x):\n    return x\n", "d0"},
+  {"bench_id_str", "varchar", "x STRING", "STRING", "",
+   "def pyinitial():\n    pass\ndef pyfun(x):\n    return x\n", "s0"},
+  {"bench_linear", "double", "x0 REAL, x1 REAL, x2 REAL", "REAL", "", LINEAR_CODE,
+   "d0, d1, d2"},
+  {"bench_tokenize", "varchar", "s STRING", "INTEGER", "", TOKENIZE_CODE, "s0"},
+  {"bench_forest", "double", "x0 REAL, x1 REAL, x2 REAL", "REAL", "", FOREST_CODE,
+   "d0, d1, d2"},
+  {"bench_trees", "double", "x0 REAL, x1 REAL, x2 REAL", "REAL", "LANGUAGE = TREES",
+   TREES_CODE, "d0, d1, d2"},
+};
+
+// sums of __all_virtual_python_udf_stat over the plans of a udf, times in us
+struct UdfStageSum
+{
+  int64_t batch_cnt_ = 0;
+  int64_t row_cnt_ = 0;
+  int64_t gil_wait_time_ = 0;
+  int64_t ob2py_time_ = 0;
+  int64_t infer_time_ = 0;
+  int64_t py2ob_time_ = 0;
+};
+
+#define EXE_SQL(sql_str)                                            \
+  ASSERT_EQ(OB_SUCCESS, sql.assign(sql_str));                       \
+  ASSERT_EQ(OB_SUCCESS, sql_proxy.write(sql.ptr(), affected_rows));
+
+#define EXE_SQL_FMT(...)                                            \
+  ASSERT_EQ(OB_SUCCESS, sql.assign_fmt(__VA_ARGS__));               \
+  ASSERT_EQ(OB_SUCCESS, sql_proxy.write(sql.ptr(), affected_rows));
+
+#define WRITE_SQL_BY_CONN(conn, sql_str)                                \
+  ASSERT_EQ(OB_SUCCESS, sql.assign(sql_str));                           \
+  ASSERT_EQ(OB_SUCCESS, conn->execute_write(RunCtx.tenant_id_, sql.ptr(), affected_rows));
+
+class ObPythonUdfBenchmark : public ObSimpleClusterTestBase
+{
+public:
+  ObPythonUdfBenchmark() : ObSimpleClusterTestBase(TEST_FILE_NAME, "20G", "20G") {}
+
+  void create_test_tenant()
+  {
+    ASSERT_EQ(OB_SUCCESS, create_tenant("tt1", "8G", "16G"));
+    ASSERT_EQ(OB_SUCCESS, get_tenant_id(RunCtx.tenant_id_));
+    ASSERT_NE(0, RunCtx.tenant_id_);
+    ASSERT_EQ(OB_SUCCESS, get_curr_simple_server().init_sql_proxy2());
+  }
+
+  void prepare_table()
+  {
+    common::ObMySQLProxy &sql_proxy = get_curr_simple_server().get_sql_proxy2();
+    int64_t affected_rows = 0;
+    ObSqlString sql;
+    EXE_SQL("set global ob_query_timeout = 10000000000");
+    EXE_SQL("set global ob_trx_timeout = 10000000000");
+    EXE_SQL("create table bench_seq (id bigint primary key)");
+    EXE_SQL("create table bench_t (id bigint primary key, i0 bigint, d0 double, d1 double,"
+            " d2 double, s0 varchar(128)) partition by hash(id) partitions 8");
+    // 1..row_cnt_ by doubling
+    EXE_SQL("insert into bench_seq values (1)");
+    for (int64_t cnt = 1; cnt < RunCtx.row_cnt_; cnt *= 2) {
+      EXE_SQL_FMT("insert into bench_seq select id + %ld from bench_seq where id + %ld <= %ld",
+                  cnt, cnt, RunCtx.row_cnt_);
+    }
+    EXE_SQL("insert into bench_t select id, id % 1000, mod(id * 7919, 10007) / 10007,"
+            " mod(id * 104729, 10009) / 10009, mod(id * 1299709, 10037) / 10037,"
+            " concat('w', id % 13, ' w', id % 31, repeat(' t', id % 8)) from bench_seq");
+    ASSERT_EQ(RunCtx.row_cnt_, affected_rows);
+    LOG_INFO("prepare python udf benchmark table", K(RunCtx.row_cnt_));
+  }
+
+  void create_udfs()
+  {
+    common::ObMySQLProxy &sql_proxy = get_curr_simple_server().get_sql_proxy2();
+    int64_t affected_rows = 0;
+    ObSqlString sql;
+    for (int64_t i = 0; i < ARRAYSIZEOF(BENCH_UDFS); ++i) {
+      const BenchUdf &udf = BENCH_UDFS[i];
+      EXE_SQL_FMT("CREATE PYTHON_UDF %s(%s) RETURNS %s %s {'%s'}",
+                  udf.name_, udf.params_, udf.ret_type_, udf.options_, udf.code_);
+    }
+  }
+
+  void get_stage_sum(const char *udf_name, UdfStageSum &sum)
+  {
+    common::ObMySQLProxy &sql_proxy = get_curr_simple_server().get_sql_proxy();
+    ObSqlString sql;
+    ASSERT_EQ(OB_SUCCESS, sql.assign_fmt(
+        "select cast(coalesce(sum(batch_cnt), 0) as signed) as batch_cnt,"
+        " cast(coalesce(sum(row_cnt), 0) as signed) as row_cnt,"
+        " cast(coalesce(sum(gil_wait_time), 0) as signed) as gil_wait_time,"
+        " cast(coalesce(sum(ob2py_time), 0) as signed) as ob2py_time,"
+        " cast(coalesce(sum(infer_time), 0) as signed) as infer_time,"
+        " cast(coalesce(sum(py2ob_time), 0) as signed) as py2ob_time"
+        " from oceanbase.__all_virtual_python_udf_stat where tenant_id = %lu and udf_name = '%s'",
+        RunCtx.tenant_id_, udf_name));
+    SMART_VAR(ObMySQLProxy::MySQLResult, res) {
+      ASSERT_EQ(OB_SUCCESS, sql_proxy.read(res, sql.ptr()));
+      sqlclient::ObMySQLResult *result = res.get_result();
+      ASSERT_NE(nullptr, result);
+      ASSERT_EQ(OB_SUCCESS, result->next());
+      ASSERT_EQ(OB_SUCCESS, result->get_int("batch_cnt", sum.batch_cnt_));
+      ASSERT_EQ(OB_SUCCESS, result->get_int("row_cnt", sum.row_cnt_));
+      ASSERT_EQ(OB_SUCCESS, result->get_int("gil_wait_time", sum.gil_wait_time_));
+      ASSERT_EQ(OB_SUCCESS, result->get_int("ob2py_time", sum.ob2py_time_));
+      ASSERT_EQ(OB_SUCCESS, result->get_int("infer_time", sum.infer_time_));
+      ASSERT_EQ(OB_SUCCESS, result->get_int("py2ob_time", sum.py2ob_time_));
+    }
+  }
+
+  void run_query(sqlclient::ObISQLConnection *conn, const BenchUdf &udf,
+                 const int64_t batch_size, const int64_t dop, int64_t &elapsed_us)
+  {
+    ObSqlString sql;
+    ObSqlString hint;
+    int64_t cnt = 0;
+    ASSERT_EQ(OB_SUCCESS, hint.assign_fmt("PARALLEL(%ld)", dop));
+    if (batch_size > 0) {
+      ASSERT_EQ(OB_SUCCESS, hint.append_fmt(" PREDICT_BATCH(%s, %ld)", udf.name_, batch_size));
+    }
+    ASSERT_EQ(OB_SUCCESS, sql.assign_fmt("select /*+ %s */ count(PREDICT %s(%s)) as cnt"
+                                         " from bench_t", hint.ptr(), udf.name_, udf.args_));
+    const int64_t begin_us = ObTimeUtility::current_time();
+    SMART_VAR(ObMySQLProxy::MySQLResult, res) {
+      ASSERT_EQ(OB_SUCCESS, conn->execute_read(RunCtx.tenant_id_, sql.ptr(), res));
+      sqlclient::ObMySQLResult *result = res.get_result();
+      ASSERT_NE(nullptr, result);
+      ASSERT_EQ(OB_SUCCESS, result->next());
+      ASSERT_EQ(OB_SUCCESS, result->get_int("cnt", cnt));
+    }
+    elapsed_us = ObTimeUtility::current_time() - begin_us;
+    ASSERT_EQ(RunCtx.row_cnt_, cnt);
+  }
+
+  void report(const BenchUdf &udf, const int64_t batch_size, const int64_t dop,
+              const int64_t iter, const int64_t elapsed_us,
+              const UdfStageSum &before, const UdfStageSum &after)
+  {
+    char line[1024];
+    const int64_t batch_cnt = after.batch_cnt_ - before.batch_cnt_;
+    const int64_t udf_row_cnt = after.row_cnt_ - before.row_cnt_;
+    snprintf(line, sizeof(line),
+             "{\"bench\":\"python_udf\",\"udf\":\"%s\",\"arg_type\":\"%s\",\"rows\":%ld,"
+             "\"batch_size\":%ld,\"dop\":%ld,\"iter\":%ld,\"elapsed_us\":%ld,"
+             "\"rows_per_sec\":%.1f,\"batch_cnt\":%ld,\"avg_batch_rows\":%.1f,"
+             "\"gil_wait_us\":%ld,\"ob2py_us\":%ld,\"infer_us\":%ld,\"py2ob_us\":%ld}\n",
+             udf.name_, udf.arg_type_, RunCtx.row_cnt_, batch_size, dop, iter, elapsed_us,
+             elapsed_us > 0 ? RunCtx.row_cnt_ * 1000000.0 / elapsed_us : 0.0,
+             batch_cnt, batch_cnt > 0 ? static_cast<double>(udf_row_cnt) / batch_cnt : 0.0,
+             after.gil_wait_time_ - before.gil_wait_time_,
+             after.ob2py_time_ - before.ob2py_time_,
+             after.infer_time_ - before.infer_time_,
+             after.py2ob_time_ - before.py2ob_time_);
+    fputs(line, stdout);
+    fflush(stdout);
+    if (nullptr != RunCtx.output_) {
+      fputs(line, RunCtx.output_);
+      fflush(RunCtx.output_);
+    }
+  }
+
+  void run_benchmark()
+  {
+    common::ObMySQLProxy &sql_proxy = get_curr_simple_server().get_sql_proxy2();
+    sqlclient::ObISQLConnection *conn = nullptr;
+    int64_t affected_rows = 0;
+    ObSqlString sql;
+    ASSERT_EQ(OB_SUCCESS, sql_proxy.acquire(conn));
+    ASSERT_NE(nullptr, conn);
+    WRITE_SQL_BY_CONN(conn, "set session ob_query_timeout = 10000000000");
+    WRITE_SQL_BY_CONN(conn, "set session ob_trx_timeout = 10000000000");
+    for (int64_t i = 0; i < ARRAYSIZEOF(BENCH_UDFS); ++i) {
+      const BenchUdf &udf = BENCH_UDFS[i];
+      if (nullptr != RunCtx.udf_filter_ && nullptr == strstr(udf.name_, RunCtx.udf_filter_)) {
+        continue;
+      }
+      for (int64_t b = 0; b < RunCtx.batch_size_cnt_; ++b) {
+        for (int64_t d = 0; d < RunCtx.dop_cnt_; ++d) {
+          const int64_t batch_size = RunCtx.batch_sizes_[b];
+          const int64_t dop = RunCtx.dops_[d];
+          int64_t elapsed_us = 0;
+          // the first run loads the udf and builds the plan, it is not reported
+          run_query(conn, udf, batch_size, dop, elapsed_us);
+          for (int64_t iter = 0; iter < RunCtx.repeat_cnt_; ++iter) {
+            UdfStageSum before;
+            UdfStageSum after;
+            get_stage_sum(udf.name_, before);
+            run_query(conn, udf, batch_size, dop, elapsed_us);
+            get_stage_sum(udf.name_, after);
+            report(udf, batch_size, dop, iter, elapsed_us, before, after);
+          }
+        }
+      }
+    }
+    ASSERT_EQ(OB_SUCCESS, sql_proxy.close(conn, OB_SUCCESS));
+  }
+};
+
+TEST_F(ObPythonUdfBenchmark, observer_start)
+{
+  LOG_INFO("observer_start succ");
+}
+
+TEST_F(ObPythonUdfBenchmark, prepare)
+{
+  create_test_tenant();
+  prepare_table();
+  create_udfs();
+}
+
+TEST_F(ObPythonUdfBenchmark, run)
+{
+  run_benchmark();
+}
+
+} // end unittest
+} // end oceanbase
+
+// "1,256,4096" -> values, at most MAX_CASE_CNT
+static int64_t parse_list(char *str, int64_t *values)
+{
+  int64_t cnt = 0;
+  for (char *tok = strtok(str, ","); nullptr != tok && cnt < oceanbase::unittest::MAX_CASE_CNT;
+       tok = strtok(nullptr, ",")) {
+    values[cnt++] = atoll(tok);
+  }
+  return cnt;
+}
+
+int main(int argc, char **argv)
+{
+  int c = 0;
+  char *log_level = (char*)"WARN";
+  const char *output = nullptr;
+  oceanbase::unittest::TestRunCtx &ctx = oceanbase::unittest::RunCtx;
+  while(EOF != (c = getopt(argc, argv, "r:n:b:d:u:o:l:"))) {
+    switch(c) {
+    case 'r':
+      ctx.row_cnt_ = atoll(optarg);
+      break;
+    case 'n':
+      ctx.repeat_cnt_ = atoll(optarg);
+      break;
+    case 'b':
+      ctx.batch_size_cnt_ = parse_list(optarg, ctx.batch_sizes_);
+      break;
+    case 'd':
+      ctx.dop_cnt_ = parse_list(optarg, ctx.dops_);
+      break;
+    case 'u':
+      ctx.udf_filter_ = optarg;
+      break;
+    case 'o':
+      output = optarg;
+      break;
+    case 'l':
+      log_level = optarg;
+      oceanbase::unittest::ObSimpleClusterTestBase::enable_env_warn_log_ = false;
+      break;
+    default:
+      break;
+    }
+  }
+  if (nullptr != output && nullptr == (ctx.output_ = fopen(output, "a"))) {
+    fprintf(stderr, "fail to open %s\n", output);
+    return 1;
+  }
+  oceanbase::unittest::init_log_and_gtest(argc, argv);
+  OB_LOGGER.set_log_level(log_level);
+
+  LOG_INFO("main>>>");
+  ::testing::InitGoogleTest(&argc, argv);
+  const int ret = RUN_ALL_TESTS();
+  if (nullptr != ctx.output_) {
+    fclose(ctx.output_);
+  }
+  return ret;
+}
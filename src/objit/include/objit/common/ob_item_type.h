@@ -2222,6 +2222,9 @@ typedef enum ObItemType
   T_DROP_PYTHON_UDF,  
   T_FUNCTION_ELEMENT_LIST,
   T_PARAM_DEFINITION,
+  T_PYTHON_UDF_OPTION_LIST,
+  T_PYTHON_UDF_OPTION,
+  T_PREDICT_BATCH,
 } ObItemType;
 
 typedef enum ObCacheType
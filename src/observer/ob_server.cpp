@@ -67,6 +67,7 @@
 #include "sql/dtl/ob_dtl.h"
 #include "sql/engine/cmd/ob_load_data_utils.h"
 #include "sql/engine/px/ob_px_worker.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_result_cache.h"
 #include "sql/ob_sql_init.h"
 #include "sql/ob_sql_task.h"
 #include "storage/ob_i_store.h"
@@ -381,6 +382,8 @@ int ObServer::init(const ObServerOptions &opts, const ObPLogWriterCfg &log_cfg)
       LOG_ERROR("init opt stat manager failed", KR(ret));
     } else if (OB_FAIL(ObOptStatMonitorManager::get_instance().init(&sql_proxy_))) {
       LOG_ERROR("init opt stat monitor manager failed", KR(ret));
+    } else if (OB_FAIL(sql::ObPyResultCache::get_instance().init())) {
+      LOG_ERROR("init python udf result cache failed", KR(ret));
     } else if (OB_FAIL(lst_operator_.set_callback_for_obs(
                 rs_rpc_proxy_, srv_rpc_proxy_, rs_mgr_, sql_proxy_))) {
       LOG_ERROR("set_use_rpc_table failed", KR(ret));
@@ -96,6 +96,10 @@
 #include "share/deadlock/ob_deadlock_detector_mgr.h"
 #include "lib/mysqlclient/ob_tenant_oci_envs.h"
 #include "sql/monitor/ob_sql_plan_manager.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_worker_pool.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_batch_tuner.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_stat.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_model_registry.h"
 #include "sql/udr/ob_udr_mgr.h"
 #include "storage/blocksstable/ob_shared_macro_block_manager.h"
 #include "storage/tx_storage/ob_tablet_gc_service.h"
@@ -443,6 +447,10 @@ int ObMultiTenant::init(ObAddr myaddr,
     MTL_BIND2(mtl_new_default, ObSharedMacroBlockMgr::mtl_init, mtl_start_default, mtl_stop_default, mtl_wait_default, mtl_destroy_default);
     MTL_BIND(ObFLTSpanMgr::mtl_init, ObFLTSpanMgr::mtl_destroy);
     MTL_BIND(ObSqlPlanMgr::mtl_init, ObSqlPlanMgr::mtl_destroy);
+    MTL_BIND(ObPyWorkerPool::mtl_init, ObPyWorkerPool::mtl_destroy);
+    MTL_BIND(ObPyBatchSizeCache::mtl_init, ObPyBatchSizeCache::mtl_destroy);
+    MTL_BIND(ObPyUdfStatMgr::mtl_init, ObPyUdfStatMgr::mtl_destroy);
+    MTL_BIND(ObPyModelRegistry::mtl_init, ObPyModelRegistry::mtl_destroy);
     MTL_BIND(common::sqlclient::ObTenantOciEnvs::mtl_init, common::sqlclient::ObTenantOciEnvs::mtl_destroy);
     MTL_BIND2(mtl_new_default, ObPlanCache::mtl_init, nullptr, ObPlanCache::mtl_stop, nullptr, mtl_destroy_default);
     MTL_BIND2(mtl_new_default, ObPsCache::mtl_init, nullptr, ObPsCache::mtl_stop, nullptr, mtl_destroy_default);
@@ -179,6 +179,8 @@
 #include "observer/virtual_table/ob_all_virtual_apply_stat.h"
 #include "observer/virtual_table/ob_all_virtual_ha_diagnose.h"
 #include "observer/virtual_table/ob_all_virtual_replay_stat.h"
+#include "observer/virtual_table/ob_all_virtual_python_udf_result_cache.h"
+#include "observer/virtual_table/ob_all_virtual_python_udf_stat.h"
 #include "observer/virtual_table/ob_all_virtual_unit.h"
 #include "observer/virtual_table/ob_all_virtual_server.h"
 #include "observer/virtual_table/ob_all_virtual_obj_lock.h"
@@ -2198,6 +2200,32 @@ int ObVTIterCreator::create_vt_iter(ObVTableScanParam &params,
             }
             break;
           }
+          case OB_ALL_VIRTUAL_PYTHON_UDF_RESULT_CACHE_TID: {
+            ObAllVirtualPythonUdfResultCache *result_cache = NULL;
+            omt::ObMultiTenant *omt = GCTX.omt_;
+            if (OB_UNLIKELY(NULL == omt)) {
+              ret = OB_ERR_UNEXPECTED;
+              SERVER_LOG(WARN, "get tenant fail", K(ret));
+            } else if (OB_FAIL(NEW_VIRTUAL_TABLE(ObAllVirtualPythonUdfResultCache, result_cache, omt))) {
+              SERVER_LOG(ERROR, "ObAllVirtualPythonUdfResultCache construct fail", K(ret));
+            } else {
+              vt_iter = static_cast<ObVirtualTableIterator *>(result_cache);
+            }
+            break;
+          }
+          case OB_ALL_VIRTUAL_PYTHON_UDF_STAT_TID: {
+            ObAllVirtualPythonUdfStat *udf_stat = NULL;
+            omt::ObMultiTenant *omt = GCTX.omt_;
+            if (OB_UNLIKELY(NULL == omt)) {
+              ret = OB_ERR_UNEXPECTED;
+              SERVER_LOG(WARN, "get tenant fail", K(ret));
+            } else if (OB_FAIL(NEW_VIRTUAL_TABLE(ObAllVirtualPythonUdfStat, udf_stat, omt))) {
+              SERVER_LOG(ERROR, "ObAllVirtualPythonUdfStat construct fail", K(ret));
+            } else {
+              vt_iter = static_cast<ObVirtualTableIterator *>(udf_stat);
+            }
+            break;
+          }
           case OB_ALL_VIRTUAL_TABLET_ENCRYPT_INFO_TID: {
             ObAllVirtualTabletEncryptInfo *partition_encrypt_info = NULL;
             if (OB_SUCC(NEW_VIRTUAL_TABLE(ObAllVirtualTabletEncryptInfo, partition_encrypt_info))) {
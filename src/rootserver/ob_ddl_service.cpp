@@ -30510,6 +30510,8 @@ int ObDDLService::drop_python_udf(const obrpc::ObDropPythonUdfArg &drop_python_u
         ret = OB_ERR_FUNCTION_UNKNOWN;
         LOG_WARN("function not exist, can't delete it", K(tenant_id), K(name), K(ret));
       }
+    } else if (OB_FAIL(check_python_udf_not_in_generated_column(schema_guard, tenant_id, name))) {
+      LOG_WARN("python udf is used by generated column", K(ret), K(tenant_id), K(name));
     } else if (OB_FAIL(schema_guard.get_schema_version(tenant_id, refreshed_schema_version))) {
       LOG_WARN("failed to get tenant schema version", KR(ret), K(tenant_id));
     } else if (OB_FAIL(trans.start(sql_proxy_, tenant_id, refreshed_schema_version))) {
@@ -30544,6 +30546,61 @@ int ObDDLService::drop_python_udf(const obrpc::ObDropPythonUdfArg &drop_python_u
   return ret;
 }
 
+int ObDDLService::check_python_udf_not_in_generated_column(ObSchemaGetterGuard &schema_guard,
+                                                           const uint64_t tenant_id,
+                                                           const ObString &name)
+{
+  int ret = OB_SUCCESS;
+  ObSEArray<const ObSimpleTableSchemaV2 *, 512> table_schemas;
+  ObArenaAllocator allocator("DropPyUdf");
+  if (OB_FAIL(schema_guard.get_table_schemas_in_tenant(tenant_id, table_schemas))) {
+    LOG_WARN("fail to get table schemas in tenant", K(ret), K(tenant_id));
+  }
+  for (int64_t i = 0; OB_SUCC(ret) && i < table_schemas.count(); ++i) {
+    const ObSimpleTableSchemaV2 *simple_schema = table_schemas.at(i);
+    const ObTableSchema *table_schema = NULL;
+    if (OB_ISNULL(simple_schema)) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("table schema is null", K(ret), K(i));
+    } else if (!simple_schema->is_user_table()) {
+      // python udfs are only allowed in generated columns of user tables
+    } else if (OB_FAIL(schema_guard.get_table_schema(tenant_id, simple_schema->get_table_id(),
+                                                     table_schema))) {
+      LOG_WARN("fail to get table schema", K(ret), K(tenant_id));
+    } else if (OB_ISNULL(table_schema)) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("table schema is null", K(ret), K(tenant_id));
+    } else if (!table_schema->has_generated_column()) {
+      // do nothing
+    } else {
+      for (ObTableSchema::const_column_iterator iter = table_schema->column_begin();
+           OB_SUCC(ret) && iter != table_schema->column_end(); ++iter) {
+        const ObColumnSchemaV2 *column = *iter;
+        ObString expr_str;
+        bool is_used = false;
+        if (OB_ISNULL(column)) {
+          ret = OB_ERR_UNEXPECTED;
+          LOG_WARN("column schema is null", K(ret));
+        } else if (!column->is_stored_generated_column()) {
+          // a python udf is rejected in virtual generated columns
+        } else if (OB_FAIL(column->get_cur_default_value().get_string(expr_str))) {
+          LOG_WARN("fail to get generated column expr", K(ret), KPC(column));
+        } else if (OB_FAIL(ObResolverUtils::check_generated_column_use_python_udf(
+                   expr_str, name, allocator, is_used))) {
+          LOG_WARN("fail to check generated column expr", K(ret), K(expr_str));
+        } else if (is_used) {
+          ret = OB_NOT_SUPPORTED;
+          LOG_WARN("python udf is used by generated column", K(ret), K(name),
+                   K(table_schema->get_table_name_str()), K(column->get_column_name_str()));
+          LOG_USER_ERROR(OB_NOT_SUPPORTED, "drop python udf used by a generated column");
+        }
+      }
+    }
+    allocator.reuse();
+  }
+  return ret;
+}
+
 int ObDDLService::check_python_udf_exist(uint64 tenant_id, const common::ObString &name, bool &is_exist, uint64_t &udf_id)
 {
   int ret = OB_SUCCESS;
@@ -830,6 +830,10 @@ public:
                            const common::ObString &ddl_stmt_str);
   virtual int drop_python_udf(const obrpc::ObDropPythonUdfArg &drop_python_udf_arg);
   virtual int check_python_udf_exist(uint64 tenant_id, const common::ObString &name, bool &is_exsit, uint64_t &udf_id);
+  // a stored generated column calling the udf would no longer resolve once it is dropped
+  int check_python_udf_not_in_generated_column(share::schema::ObSchemaGetterGuard &schema_guard,
+                                               const uint64_t tenant_id,
+                                               const common::ObString &name);
   //----End of Functions for managing udf----                        
   
   //----Functions for managing routine----
@@ -56,6 +56,13 @@ SQL_MONITOR_STATNAME_DEF(SSTABLE_INSERT_ROW_COUNT, sql_monitor_statname::INT, "s
 SQL_MONITOR_STATNAME_DEF(IO_READ_BYTES, sql_monitor_statname::CAPACITY, "total io bytes read from disk", "total io bytes read from storage")
 SQL_MONITOR_STATNAME_DEF(TOTAL_READ_BYTES, sql_monitor_statname::CAPACITY, "total bytes processed by storage", "total bytes processed by storage, including memtable")
 SQL_MONITOR_STATNAME_DEF(TOTAL_READ_ROW_COUNT, sql_monitor_statname::INT, "total rows processed by storage", "total rows processed by storage, including memtable")
+// python udf
+SQL_MONITOR_STATNAME_DEF(PYTHON_UDF_BATCH_COUNT, sql_monitor_statname::INT, "python udf batch count", "python calls of the python udfs in the operator")
+SQL_MONITOR_STATNAME_DEF(PYTHON_UDF_ROW_COUNT, sql_monitor_statname::INT, "python udf row count", "rows passed to the python udfs in the operator")
+SQL_MONITOR_STATNAME_DEF(PYTHON_UDF_GIL_WAIT_TIME, sql_monitor_statname::INT, "python udf gil wait time", "time in microseconds waiting for a python interpreter and its GIL, or a python worker")
+SQL_MONITOR_STATNAME_DEF(PYTHON_UDF_CONVERT_TIME, sql_monitor_statname::INT, "python udf convert time", "time in microseconds converting args to python and results back")
+SQL_MONITOR_STATNAME_DEF(PYTHON_UDF_INFER_TIME, sql_monitor_statname::INT, "python udf infer time", "time in microseconds running python udfs")
+SQL_MONITOR_STATNAME_DEF(PYTHON_UDF_PREDICT_SIZE, sql_monitor_statname::INT, "python udf predict size", "rows loaded per python udf batch by the operator")
 
 //end
 SQL_MONITOR_STATNAME_DEF(MONITOR_STATNAME_END, sql_monitor_statname::INVALID, "monitor end", "monitor stat name end")
@@ -153,6 +153,8 @@ def print_default_column(column_name, rowkey_id, index_id, part_key_pos, column_
     set_op = 'set_uint64({0})'.format(default_value)
   elif column_type == 'ObTinyIntType':
     set_op = 'set_tinyint({0})'.format(default_value)
+  elif column_type == 'ObDoubleType':
+    set_op = 'set_double({0})'.format(default_value)
   elif column_type == 'ObVarcharType':
       if column_collation_type == "CS_TYPE_BINARY":
         set_op = 'set_varbinary(ObString::make_string("{0}"))'.format(default_value)
@@ -6565,6 +6565,139 @@ int ObInnerTableSchema::all_python_udf_schema(ObTableSchema &table_schema)
       false, //is_nullable
       false); //is_autoincrement
   }
+
+  if (OB_SUCC(ret)) {
+    ObObj exec_mode_default;
+    exec_mode_default.set_int(0);
+    ADD_COLUMN_SCHEMA_T("exec_mode", //column_name
+      ++column_id, //column_id
+      0, //rowkey_id
+      0, //index_id
+      0, //part_key_pos
+      ObIntType, //column_type
+      CS_TYPE_INVALID, //column_collation_type
+      sizeof(int64_t), //column_length
+      -1, //column_precision
+      -1, //column_scale
+      false, //is_nullable
+      false, //is_autoincrement
+      exec_mode_default,
+      exec_mode_default); //default_value
+  }
+
+  if (OB_SUCC(ret)) {
+    ObObj row_cost_default;
+    row_cost_default.set_double(0);
+    ADD_COLUMN_SCHEMA_T("row_cost", //column_name
+      ++column_id, //column_id
+      0, //rowkey_id
+      0, //index_id
+      0, //part_key_pos
+      ObDoubleType, //column_type
+      CS_TYPE_INVALID, //column_collation_type
+      sizeof(double), //column_length
+      -1, //column_precision
+      -1, //column_scale
+      false, //is_nullable
+      false, //is_autoincrement
+      row_cost_default,
+      row_cost_default); //default_value
+  }
+
+  if (OB_SUCC(ret)) {
+    ObObj selectivity_default;
+    selectivity_default.set_double(0);
+    ADD_COLUMN_SCHEMA_T("selectivity", //column_name
+      ++column_id, //column_id
+      0, //rowkey_id
+      0, //index_id
+      0, //part_key_pos
+      ObDoubleType, //column_type
+      CS_TYPE_INVALID, //column_collation_type
+      sizeof(double), //column_length
+      -1, //column_precision
+      -1, //column_scale
+      false, //is_nullable
+      false, //is_autoincrement
+      selectivity_default,
+      selectivity_default); //default_value
+  }
+
+  if (OB_SUCC(ret)) {
+    ObObj deterministic_default;
+    deterministic_default.set_tinyint(false);
+    ADD_COLUMN_SCHEMA_T("deterministic", //column_name
+      ++column_id, //column_id
+      0, //rowkey_id
+      0, //index_id
+      0, //part_key_pos
+      ObTinyIntType, //column_type
+      CS_TYPE_INVALID, //column_collation_type
+      1, //column_length
+      -1, //column_precision
+      -1, //column_scale
+      false, //is_nullable
+      false, //is_autoincrement
+      deterministic_default,
+      deterministic_default); //default_value
+  }
+
+  if (OB_SUCC(ret)) {
+    ObObj language_default;
+    language_default.set_int(0);
+    ADD_COLUMN_SCHEMA_T("language", //column_name
+      ++column_id, //column_id
+      0, //rowkey_id
+      0, //index_id
+      0, //part_key_pos
+      ObIntType, //column_type
+      CS_TYPE_INVALID, //column_collation_type
+      sizeof(int64_t), //column_length
+      -1, //column_precision
+      -1, //column_scale
+      false, //is_nullable
+      false, //is_autoincrement
+      language_default,
+      language_default); //default_value
+  }
+
+  if (OB_SUCC(ret)) {
+    ObObj batch_format_default;
+    batch_format_default.set_int(0);
+    ADD_COLUMN_SCHEMA_T("batch_format", //column_name
+      ++column_id, //column_id
+      0, //rowkey_id
+      0, //index_id
+      0, //part_key_pos
+      ObIntType, //column_type
+      CS_TYPE_INVALID, //column_collation_type
+      sizeof(int64_t), //column_length
+      -1, //column_precision
+      -1, //column_scale
+      false, //is_nullable
+      false, //is_autoincrement
+      batch_format_default,
+      batch_format_default); //default_value
+  }
+
+  if (OB_SUCC(ret)) {
+    ObObj arg_passing_default;
+    arg_passing_default.set_int(0);
+    ADD_COLUMN_SCHEMA_T("arg_passing", //column_name
+      ++column_id, //column_id
+      0, //rowkey_id
+      0, //index_id
+      0, //part_key_pos
+      ObIntType, //column_type
+      CS_TYPE_INVALID, //column_collation_type
+      sizeof(int64_t), //column_length
+      -1, //column_precision
+      -1, //column_scale
+      false, //is_nullable
+      false, //is_autoincrement
+      arg_passing_default,
+      arg_passing_default); //default_value
+  }
   table_schema.set_index_using_type(USING_BTREE);
   table_schema.set_row_store_type(ENCODING_ROW_STORE);
   table_schema.set_store_format(OB_STORE_FORMAT_DYNAMIC_MYSQL);
@@ -5472,6 +5472,13 @@ def_table_schema(
       ('arg_types', 'varchar:OB_MAX_SYS_PARAM_INFO_LENGTH', 'false'),
       ('pycall', 'text:OB_MAX_TEXT_LENGTH', 'false'),
       ('schema_version', 'int'),
+      ('exec_mode', 'int', 'false', '0'),
+      ('row_cost', 'double', 'false', '0'),
+      ('selectivity', 'double', 'false', '0'),
+      ('deterministic', 'bool', 'false', 'false'),
+      ('language', 'int', 'false', '0'),
+      ('batch_format', 'int', 'false', '0'),
+      ('arg_passing', 'int', 'false', '0'),
     ],
 )
 
@@ -11470,6 +11477,58 @@ def_table_schema(
 # 12392: __all_virtual_kv_connection
 def_table_schema(**gen_mysql_sys_agent_virtual_table_def('12393', all_def_keywords['__all_virtual_long_ops_status']))
 # 12394: __all_virtual_ls_transfer_member_list_lock_info
+
+def_table_schema(
+  owner             = 'xujiahe.xjh',
+  table_name        = '__all_virtual_python_udf_result_cache',
+  table_id          = '12395',
+  table_type        = 'VIRTUAL_TABLE',
+  in_tenant_space   = True,
+  gm_columns        = [],
+  rowkey_columns    = [],
+  normal_columns    = [
+    ('svr_ip', 'varchar:MAX_IP_ADDR_LENGTH'),
+    ('svr_port', 'int'),
+    ('tenant_id', 'int'),
+    ('hit_cnt', 'int'),
+    ('miss_cnt', 'int'),
+    ('put_cnt', 'int'),
+    ('evict_cnt', 'int'),
+    ('kv_cnt', 'int'),
+    ('mem_size', 'int'),
+  ],
+  partition_columns = ['svr_ip', 'svr_port'],
+  vtable_route_policy = 'distributed',
+)
+
+def_table_schema(
+  owner             = 'xujiahe.xjh',
+  table_name        = '__all_virtual_python_udf_stat',
+  table_id          = '12396',
+  table_type        = 'VIRTUAL_TABLE',
+  in_tenant_space   = True,
+  gm_columns        = [],
+  rowkey_columns    = [],
+  normal_columns    = [
+    ('svr_ip', 'varchar:MAX_IP_ADDR_LENGTH'),
+    ('svr_port', 'int'),
+    ('tenant_id', 'int'),
+    ('udf_id', 'int'),
+    ('udf_name', 'varchar:OB_MAX_UDF_NAME_LENGTH'),
+    ('schema_version', 'int'),
+    ('plan_id', 'int'),
+    ('batch_cnt', 'int'),
+    ('row_cnt', 'int'),
+    ('gil_wait_time', 'int'),
+    ('ob2py_time', 'int'),
+    ('infer_time', 'int'),
+    ('py2ob_time', 'int'),
+    ('batch_size', 'int'),
+  ],
+  partition_columns = ['svr_ip', 'svr_port'],
+  vtable_route_policy = 'distributed',
+)
+
 #
 # 余留位置
 #
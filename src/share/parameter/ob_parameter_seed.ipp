@@ -340,6 +340,44 @@ DEF_INT(_rowsets_target_maxsize, OB_TENANT_PARAMETER, "524288", "[262144, 838860
 DEF_INT(_rowsets_max_rows, OB_TENANT_PARAMETER, "256", "[0, 65535]",
         "the row number processed by vectorized sql engine within one batch. Range: [0, 65535]",
         ObParameterAttr(Section::TENANT, Source::DEFAULT, EditLevel::DYNAMIC_EFFECTIVE));
+DEF_CAP(_python_udf_model_cache_size, OB_TENANT_PARAMETER, "1G", "[0M,)",
+        "the memory python udf models of the tenant may take in the main interpreter of a server, "
+        "least recently used models are unloaded above it, 0 means unlimited. Range: [0, +∞)",
+        ObParameterAttr(Section::TENANT, Source::DEFAULT, EditLevel::DYNAMIC_EFFECTIVE));
+DEF_INT(_python_udf_worker_pool_size, OB_TENANT_PARAMETER, "4", "[1, 64]",
+        "the number of python worker processes used by python udf of the tenant "
+        "created with EXECUTION = 'WORKER'. Range: [1, 64]",
+        ObParameterAttr(Section::TENANT, Source::DEFAULT, EditLevel::DYNAMIC_EFFECTIVE));
+DEF_CAP(_python_udf_worker_buffer_size, OB_TENANT_PARAMETER, "64M", "[1M, 1G]",
+        "the size of the shared memory buffer between the observer and a python worker process. "
+        "Range: [1M, 1G]",
+        ObParameterAttr(Section::TENANT, Source::DEFAULT, EditLevel::DYNAMIC_EFFECTIVE));
+DEF_STR(_python_udf_worker_executable, OB_CLUSTER_PARAMETER, "python3",
+        "the python executable used to start python udf worker processes",
+        ObParameterAttr(Section::OBSERVER, Source::DEFAULT, EditLevel::DYNAMIC_EFFECTIVE));
+DEF_BOOL(_enable_python_udf_pipeline, OB_TENANT_PARAMETER, "True",
+         "overlap the python udf call of a batch with fetching the next rows from the child operator",
+         ObParameterAttr(Section::TENANT, Source::DEFAULT, EditLevel::DYNAMIC_EFFECTIVE));
+DEF_BOOL(_enable_python_udf_filter_pushdown, OB_TENANT_PARAMETER, "True",
+         "keep selective python udf filters on a single table in its table scan, where storage "
+         "evaluates them on the decoded columns before projecting the rows",
+         ObParameterAttr(Section::TENANT, Source::DEFAULT, EditLevel::DYNAMIC_EFFECTIVE));
+DEF_BOOL(_enable_python_udf_px_redistribute, OB_TENANT_PARAMETER, "True",
+         "with parallel execution, redistribute the rows in front of a python udf so that "
+         "the prediction runs at the dop chosen by its inference cost",
+         ObParameterAttr(Section::TENANT, Source::DEFAULT, EditLevel::DYNAMIC_EFFECTIVE));
+DEF_STR(_python_udf_batch_size_policy, OB_TENANT_PARAMETER, "HILL_CLIMB",
+        "the policy tuning the number of rows per python udf call. "
+        "Values: HILL_CLIMB, GOLDEN_SECTION, LATENCY_SLO",
+        ObParameterAttr(Section::TENANT, Source::DEFAULT, EditLevel::DYNAMIC_EFFECTIVE));
+DEF_TIME(_python_udf_batch_latency_slo, OB_TENANT_PARAMETER, "100ms", "[1ms, 1h]",
+         "the latency a python udf call should stay below with batch size policy LATENCY_SLO. "
+         "Range: [1ms, 1h]",
+         ObParameterAttr(Section::TENANT, Source::DEFAULT, EditLevel::DYNAMIC_EFFECTIVE));
+DEF_DBL(_python_udf_dedup_distinct_ratio, OB_TENANT_PARAMETER, "0.5", "[0, 1]",
+        "batches of a python udf are deduplicated on the arguments before the python call "
+        "while their ratio of distinct rows is at most this value, 0 disables it. Range: [0, 1]",
+        ObParameterAttr(Section::TENANT, Source::DEFAULT, EditLevel::DYNAMIC_EFFECTIVE));
 DEF_STR_WITH_CHECKER(_ctx_memory_limit, OB_TENANT_PARAMETER, "",
         common::ObCtxMemoryLimitChecker,
         "specifies tenant ctx memory limit.",
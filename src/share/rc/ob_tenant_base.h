@@ -50,6 +50,10 @@ namespace sql {
   class ObUDRMgr;
   class ObPlanCache;
   class ObPsCache;
+  class ObPyWorkerPool;
+  class ObPyBatchSizeCache;
+  class ObPyUdfStatMgr;
+  class ObPyModelRegistry;
 }
 namespace blocksstable {
   class ObSharedMacroBlockMgr;
@@ -246,6 +250,10 @@ using ObPartTransCtxObjPool = common::ObServerObjectPool<transaction::ObPartTran
       sql::ObUDRMgr*,                        \
       sql::ObFLTSpanMgr*,                            \
       sql::ObSqlPlanMgr*,                            \
+      sql::ObPyWorkerPool*,                          \
+      sql::ObPyBatchSizeCache*,                      \
+      sql::ObPyUdfStatMgr*,                          \
+      sql::ObPyModelRegistry*,                       \
       ObTestModule*,                                 \
       oceanbase::common::sqlclient::ObTenantOciEnvs* \
   )
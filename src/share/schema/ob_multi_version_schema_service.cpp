@@ -2954,6 +2954,48 @@ int ObMultiVersionSchemaService::get_python_udf_info(const uint64_t tenant_id,
   return ret;
 }
 
+int ObMultiVersionSchemaService::get_python_udf_infos(const uint64_t tenant_id,
+                                                      common::ObIAllocator &allocator,
+                                                      common::ObIArray<ObPythonUDF *> &udf_infos)
+{
+  int ret = OB_SUCCESS;
+  udf_infos.reset();
+  if (OB_INVALID_ID == tenant_id || OB_ISNULL(sql_proxy_)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid argument", K(ret), K(tenant_id), KP_(sql_proxy));
+  } else {
+    SMART_VAR(ObMySQLProxy::MySQLResult, res) {
+      common::sqlclient::ObMySQLResult *result = NULL;
+      ObSqlString sql;
+      const char *const TABLE_NAME = "__all_python_udf";
+      if (OB_FAIL(sql.append_fmt("SELECT * FROM %s", TABLE_NAME))) {
+        LOG_WARN("append sql failed", K(ret));
+      } else if (OB_FAIL(sql_proxy_->read(res, tenant_id, sql.ptr()))) {
+        LOG_WARN("ObMultiVersionSchemaService execute sql failed", K(ret), K(tenant_id), K(sql));
+      } else if (OB_ISNULL(result = res.get_result())) {
+        ret = OB_ERR_UNEXPECTED;
+        LOG_WARN("fail to get result. ", K(ret));
+      } else {
+        while (OB_SUCC(ret) && OB_SUCC(result->next())) {
+          ObPythonUDF *udf_info = NULL;
+          if (OB_ISNULL(udf_info = OB_NEWx(ObPythonUDF, &allocator, &allocator))) {
+            ret = OB_ALLOCATE_MEMORY_FAILED;
+            LOG_WARN("fail to alloc python udf schema", K(ret));
+          } else if (OB_FAIL(fill_python_udf_schema(tenant_id, *result, *udf_info))) {
+            LOG_WARN("failed to retrieve python udf", K(ret));
+          } else if (OB_FAIL(udf_infos.push_back(udf_info))) {
+            LOG_WARN("fail to push back python udf", K(ret));
+          }
+        }
+        if (OB_ITER_END == ret) {
+          ret = OB_SUCCESS;
+        }
+      }
+    }
+  }
+  return ret;
+}
+
 int ObMultiVersionSchemaService::fill_python_udf_schema(const uint64_t tenant_id,
                                                    common::sqlclient::ObMySQLResult &result,
                                                    ObPythonUDF &udf_info) {
@@ -2969,6 +3011,20 @@ int ObMultiVersionSchemaService::fill_python_udf_schema(const uint64_t tenant_id
   EXTRACT_INT_FIELD_TO_CLASS_MYSQL(result, ret, udf_info, int);
   EXTRACT_VARCHAR_FIELD_TO_CLASS_MYSQL(result, pycall, udf_info);
   EXTRACT_INT_FIELD_TO_CLASS_MYSQL(result, schema_version, udf_info, uint64_t);
+  EXTRACT_INT_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, exec_mode, udf_info, int64_t, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, ObPythonUDF::EMBEDDED);
+  EXTRACT_DOUBLE_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, row_cost, udf_info, double, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, 0);
+  EXTRACT_DOUBLE_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, selectivity, udf_info, double, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, 0);
+  EXTRACT_BOOL_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, deterministic, udf_info, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, false);
+  EXTRACT_INT_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, language, udf_info, int64_t, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, ObPythonUDF::PYTHON);
+  EXTRACT_INT_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, batch_format, udf_info, int64_t, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, ObPythonUDF::NUMPY);
+  EXTRACT_INT_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, arg_passing, udf_info, int64_t, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, ObPythonUDF::POSITIONAL);
   return ret;
   }
 
@@ -290,6 +290,10 @@ public:
                           const common::ObString &udf_name,
                           share::schema::ObPythonUDF &udf_info,
                           bool &exist);
+  // every python udf of the tenant, allocated in allocator
+  int get_python_udf_infos(const uint64_t tenant_id,
+                           common::ObIAllocator &allocator,
+                           common::ObIArray<ObPythonUDF *> &udf_infos);
   int fill_python_udf_schema(const uint64_t tenant_id,
                              common::sqlclient::ObMySQLResult &result,
                              ObPythonUDF &udf_info);                        
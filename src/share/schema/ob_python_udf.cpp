@@ -27,14 +27,20 @@ namespace schema
 
 ObPythonUDF::ObPythonUDF(common::ObIAllocator *allocator)
     : ObSchema(allocator), tenant_id_(common::OB_INVALID_ID), udf_id_(common::OB_INVALID_ID), name_(), arg_num_(0), arg_names_(), arg_types_(),
-      ret_(PyUdfRetType::UDF_UNINITIAL), pycall_(), schema_version_(common::OB_INVALID_VERSION)
+      ret_(PyUdfRetType::UDF_UNINITIAL), pycall_(), schema_version_(common::OB_INVALID_VERSION),
+      exec_mode_(PyUdfExecMode::EMBEDDED), row_cost_(0), selectivity_(0),
+      deterministic_(false), language_(PyUdfLanguage::PYTHON),
+      batch_format_(PyUdfBatchFormat::NUMPY), arg_passing_(PyUdfArgPassing::POSITIONAL)
 {
   reset();
 }
 
 ObPythonUDF::ObPythonUDF(const ObPythonUDF &src_schema)
     : ObSchema(), tenant_id_(common::OB_INVALID_ID), udf_id_(common::OB_INVALID_ID), name_(), arg_num_(0), arg_names_(), arg_types_(),
-      ret_(PyUdfRetType::UDF_UNINITIAL), pycall_(), schema_version_(common::OB_INVALID_VERSION)
+      ret_(PyUdfRetType::UDF_UNINITIAL), pycall_(), schema_version_(common::OB_INVALID_VERSION),
+      exec_mode_(PyUdfExecMode::EMBEDDED), row_cost_(0), selectivity_(0),
+      deterministic_(false), language_(PyUdfLanguage::PYTHON),
+      batch_format_(PyUdfBatchFormat::NUMPY), arg_passing_(PyUdfArgPassing::POSITIONAL)
 {
   reset();
   *this = src_schema;
@@ -47,13 +53,21 @@ ObPythonUDF::~ObPythonUDF()
 int ObPythonUDF::get_arg_names_arr(common::ObSEArray<common::ObString, 16> &udf_attributes_names) const {
   int ret = OB_SUCCESS;
   udf_attributes_names.reuse();
-  char* arg_names_str = const_cast<char*>(get_arg_names());
-  std::istringstream ss(arg_names_str);
-  std::string token;
-  while (std::getline(ss, token, ',')) {
-      udf_attributes_names.push_back(common::ObString(token.length(),token.c_str()));
+  // names point into arg_names_ of the schema, callers keeping them copy them out
+  common::ObString arg_names = get_arg_names_str();
+  while (OB_SUCC(ret) && !arg_names.empty()) {
+    common::ObString name = arg_names.split_on(',');
+    if (OB_ISNULL(name.ptr())) {
+      // the last name
+      name = arg_names;
+      arg_names.reset();
+    }
+    if (OB_FAIL(udf_attributes_names.push_back(name))) {
+      LOG_WARN("fail to push back arg name", K(ret), K(name));
+    }
   }
-  if(udf_attributes_names.count() != arg_num_) {
+  if (OB_FAIL(ret)) {
+  } else if(udf_attributes_names.count() != arg_num_) {
     ret = OB_ERR_UNEXPECTED;
     LOG_WARN("fail to resolve arg names string", K(ret));
   }
@@ -92,7 +106,9 @@ int ObPythonUDF::check_pycall() const {
   //   ret = OB_INVALID_ARGUMENT;
   //   LOG_WARN("python code raise an exception", K(ret));
   // }
-  if (strstr(python_code, "pyinitial") == nullptr) {
+  if (TREES == language_) {
+    // a model dump, checked by ObPyTreeModel when the udf is resolved
+  } else if (strstr(python_code, "pyinitial") == nullptr) {
     ret = OB_INVALID_ARGUMENT;
     LOG_WARN("pycall lack pyinitial", K(ret));
   } else if (strstr(python_code, "pyfun") == nullptr) {
@@ -113,6 +129,13 @@ ObPythonUDF& ObPythonUDF::operator= (const ObPythonUDF &other) {
     arg_num_ = other.arg_num_;
     schema_version_ = other.schema_version_;
     ret_ = other.ret_;
+    exec_mode_ = other.exec_mode_;
+    row_cost_ = other.row_cost_;
+    selectivity_ = other.selectivity_;
+    deterministic_ = other.deterministic_;
+    language_ = other.language_;
+    batch_format_ = other.batch_format_;
+    arg_passing_ = other.arg_passing_;
     if (OB_FAIL(deep_copy_str(other.name_, name_))) {
       LOG_WARN("Fail to deep copy name", K(ret));
     } else if (OB_FAIL(deep_copy_str(other.arg_names_, arg_names_))) {
@@ -137,6 +160,13 @@ void ObPythonUDF::reset()
   arg_types_.reset();
   ret_ = PyUdfRetType::UDF_UNINITIAL;
   pycall_.reset();
+  exec_mode_ = PyUdfExecMode::EMBEDDED;
+  row_cost_ = 0;
+  selectivity_ = 0;
+  deterministic_ = false;
+  language_ = PyUdfLanguage::PYTHON;
+  batch_format_ = PyUdfBatchFormat::NUMPY;
+  arg_passing_ = PyUdfArgPassing::POSITIONAL;
   ObSchema::reset();
 }
 
@@ -148,7 +178,14 @@ OB_SERIALIZE_MEMBER(ObPythonUDF,
                     arg_names_,
                     arg_types_,
 				            ret_,
-                    pycall_);
+                    pycall_,
+                    exec_mode_,
+                    row_cost_,
+                    selectivity_,
+                    deterministic_,
+                    language_,
+                    batch_format_,
+                    arg_passing_);
 
 OB_SERIALIZE_MEMBER(ObPythonUDFMeta,
                     name_,
@@ -156,7 +193,16 @@ OB_SERIALIZE_MEMBER(ObPythonUDFMeta,
                     pycall_,
                     udf_attributes_names_,
                     udf_attributes_types_,
-                    init_);
+                    init_,
+                    udf_id_,
+                    schema_version_,
+                    exec_mode_,
+                    row_cost_,
+                    selectivity_,
+                    deterministic_,
+                    language_,
+                    batch_format_,
+                    arg_passing_);
 
 }// end schema
 }// end share
@@ -39,10 +39,34 @@ public:
         REAL,
         DECIMAL
     };
+    // where the udf runs, see ObPyWorkerPool
+    enum PyUdfExecMode {
+        EMBEDDED = 0, // in the observer process
+        WORKER = 1 // in an out-of-process python worker
+    };
+    // what the code of the udf is
+    enum PyUdfLanguage {
+        PYTHON = 0, // pycall with pyinitial and pyfun
+        TREES = 1 // json dump of a tree ensemble, scored natively, see ObPyTreeModel
+    };
+    // how a batch of args is handed to pyfun
+    enum PyUdfBatchFormat {
+        NUMPY = 0, // one numpy array per arg
+        ARROW = 1 // one pyarrow RecordBatch, see ObPyArrowBatch
+    };
+    // how the numpy args of a call are handed to pyfun
+    enum PyUdfArgPassing {
+        POSITIONAL = 0, // one array of the rows of the call per arg
+        BROADCAST = 1, // as POSITIONAL, an arg constant in the call is a 0-d array
+        KEYWORD = 2 // keyword args named after the params, a constant one is a python scalar
+    };
 
 public:
     ObPythonUDF() : ObSchema(), tenant_id_(common::OB_INVALID_ID), udf_id_(common::OB_INVALID_ID), name_(), arg_num_(0), arg_names_(), 
-                    arg_types_(), ret_(PyUdfRetType::UDF_UNINITIAL), pycall_(), schema_version_(common::OB_INVALID_VERSION) 
+                    arg_types_(), ret_(PyUdfRetType::UDF_UNINITIAL), pycall_(), schema_version_(common::OB_INVALID_VERSION),
+                    exec_mode_(PyUdfExecMode::EMBEDDED), row_cost_(0), selectivity_(0),
+                    deterministic_(false), language_(PyUdfLanguage::PYTHON),
+                    batch_format_(PyUdfBatchFormat::NUMPY), arg_passing_(PyUdfArgPassing::POSITIONAL)
                     { reset(); };
     explicit ObPythonUDF(common::ObIAllocator *allocator);
     ObPythonUDF(const ObPythonUDF &src_schema);
@@ -64,6 +88,17 @@ public:
     inline int set_arg_types(const common::ObString arg_types) { return deep_copy_str(arg_types, arg_types_); }
     inline int set_pycall(const common::ObString &pycall) { return deep_copy_str(pycall, pycall_); }
     inline void set_schema_version(int64_t version) { schema_version_ = version; }
+    inline void set_exec_mode(const enum PyUdfExecMode mode) { exec_mode_ = mode; }
+    inline void set_exec_mode(const int64_t mode) { exec_mode_ = PyUdfExecMode(mode); }
+    inline void set_row_cost(const double row_cost) { row_cost_ = row_cost; }
+    inline void set_selectivity(const double selectivity) { selectivity_ = selectivity; }
+    inline void set_deterministic(const bool deterministic) { deterministic_ = deterministic; }
+    inline void set_language(const enum PyUdfLanguage language) { language_ = language; }
+    inline void set_language(const int64_t language) { language_ = PyUdfLanguage(language); }
+    inline void set_batch_format(const enum PyUdfBatchFormat format) { batch_format_ = format; }
+    inline void set_batch_format(const int64_t format) { batch_format_ = PyUdfBatchFormat(format); }
+    inline void set_arg_passing(const enum PyUdfArgPassing passing) { arg_passing_ = passing; }
+    inline void set_arg_passing(const int64_t passing) { arg_passing_ = PyUdfArgPassing(passing); }
 
     //get methods
     inline uint64_t get_tenant_id() const { return tenant_id_; }
@@ -79,6 +114,13 @@ public:
     inline const char *get_pycall() const { return extract_str(pycall_); }
     inline const common::ObString &get_pycall_str() const { return pycall_; }
     inline int64_t get_schema_version() const { return schema_version_; }
+    inline enum PyUdfExecMode get_exec_mode() const { return exec_mode_; }
+    inline double get_row_cost() const { return row_cost_; }
+    inline double get_selectivity() const { return selectivity_; }
+    inline bool is_deterministic() const { return deterministic_; }
+    inline enum PyUdfLanguage get_language() const { return language_; }
+    inline enum PyUdfBatchFormat get_batch_format() const { return batch_format_; }
+    inline enum PyUdfArgPassing get_arg_passing() const { return arg_passing_; }
 
     //only for retrieve udf
     inline const char *get_udf_name() const { return extract_str(name_); }
@@ -98,7 +140,14 @@ public:
                  K_(arg_types),
                  K_(ret),
                  K_(pycall),
-                 K_(schema_version));
+                 K_(schema_version),
+                 K_(exec_mode),
+                 K_(row_cost),
+                 K_(selectivity),
+                 K_(deterministic),
+                 K_(language),
+                 K_(batch_format),
+                 K_(arg_passing));
 
 public:
     uint64_t tenant_id_;
@@ -110,6 +159,13 @@ public:
     enum PyUdfRetType ret_; //返回值类型
     common::ObString pycall_; //code
     int64_t schema_version_; //the last modify timestamp of this version
+    enum PyUdfExecMode exec_mode_; //embedded or worker process
+    double row_cost_; //declared inference time per row in us, 0 if unknown
+    double selectivity_; //declared selectivity of predicates on the udf, 0 if unknown
+    bool deterministic_; //same arguments give the same result, results may be cached
+    enum PyUdfLanguage language_; //python code or tree ensemble dump
+    enum PyUdfBatchFormat batch_format_; //numpy arrays or arrow record batch
+    enum PyUdfArgPassing arg_passing_; //positional arrays, broadcast constants or keyword args
 };
 
 /////////////////////////////////////////////
@@ -119,7 +175,13 @@ class ObPythonUDFMeta
   OB_UNIS_VERSION_V(1);
 public :
   ObPythonUDFMeta() : name_(), ret_(ObPythonUDF::PyUdfRetType::UDF_UNINITIAL), pycall_(), 
-                      udf_attributes_names_(), udf_attributes_types_(), init_(false) {} 
+                      udf_attributes_names_(), udf_attributes_types_(), init_(false),
+                      udf_id_(common::OB_INVALID_ID), schema_version_(common::OB_INVALID_VERSION),
+                      exec_mode_(ObPythonUDF::PyUdfExecMode::EMBEDDED), row_cost_(0),
+                      selectivity_(0), deterministic_(false),
+                      language_(ObPythonUDF::PyUdfLanguage::PYTHON),
+                      batch_format_(ObPythonUDF::PyUdfBatchFormat::NUMPY),
+                      arg_passing_(ObPythonUDF::PyUdfArgPassing::POSITIONAL) {} 
   virtual ~ObPythonUDFMeta() = default;
 
   void assign(const ObPythonUDFMeta &other) { 
@@ -129,6 +191,15 @@ public :
     udf_attributes_names_ = other.udf_attributes_names_;
     udf_attributes_types_ = other.udf_attributes_types_;
     init_ = other.init_;
+    udf_id_ = other.udf_id_;
+    schema_version_ = other.schema_version_;
+    exec_mode_ = other.exec_mode_;
+    row_cost_ = other.row_cost_;
+    selectivity_ = other.selectivity_;
+    deterministic_ = other.deterministic_;
+    language_ = other.language_;
+    batch_format_ = other.batch_format_;
+    arg_passing_ = other.arg_passing_;
   }
 
   ObPythonUDFMeta &operator=(const class ObPythonUDFMeta &other) {
@@ -138,6 +209,15 @@ public :
     udf_attributes_names_ = other.udf_attributes_names_;
     udf_attributes_types_ = other.udf_attributes_types_;
     init_ = other.init_;
+    udf_id_ = other.udf_id_;
+    schema_version_ = other.schema_version_;
+    exec_mode_ = other.exec_mode_;
+    row_cost_ = other.row_cost_;
+    selectivity_ = other.selectivity_;
+    deterministic_ = other.deterministic_;
+    language_ = other.language_;
+    batch_format_ = other.batch_format_;
+    arg_passing_ = other.arg_passing_;
     return *this;
   }
 
@@ -146,7 +226,16 @@ public :
                K_(pycall),
                K_(udf_attributes_names),
                K_(udf_attributes_types),
-               K_(init));
+               K_(init),
+               K_(udf_id),
+               K_(schema_version),
+               K_(exec_mode),
+               K_(row_cost),
+               K_(selectivity),
+               K_(deterministic),
+               K_(language),
+               K_(batch_format),
+               K_(arg_passing));
 
   common::ObString name_; //函数名
   ObPythonUDF::PyUdfRetType ret_; //返回值类型
@@ -154,6 +243,15 @@ public :
   common::ObSEArray<common::ObString, 16> udf_attributes_names_; //参数名称
   common::ObSEArray<ObPythonUDF::PyUdfRetType, 16> udf_attributes_types_; //参数类型
   bool init_; //是否已初始化
+  uint64_t udf_id_;
+  int64_t schema_version_; //python udf schema version, identify the loaded pycall
+  ObPythonUDF::PyUdfExecMode exec_mode_; //embedded or worker process
+  double row_cost_; //declared inference time per row in us, 0 if unknown
+  double selectivity_; //declared selectivity of predicates on the udf, 0 if unknown
+  bool deterministic_; //same arguments give the same result, results may be cached
+  ObPythonUDF::PyUdfLanguage language_; //python code or tree ensemble dump
+  ObPythonUDF::PyUdfBatchFormat batch_format_; //numpy arrays or arrow record batch
+  ObPythonUDF::PyUdfArgPassing arg_passing_; //positional arrays, broadcast constants or keyword args
 };
 
 }
@@ -29,21 +29,30 @@ using namespace common::hash;
 
 ObSimplePythonUdfSchema::ObSimplePythonUdfSchema()
   : ObSchema(), tenant_id_(common::OB_INVALID_ID), udf_id_(common::OB_INVALID_ID), udf_name_(), arg_num_(0),
-arg_names_(), arg_types_(), ret_(ObPythonUDF::UDF_UNINITIAL), pycall_(), schema_version_(common::OB_INVALID_VERSION) 
+arg_names_(), arg_types_(), ret_(ObPythonUDF::UDF_UNINITIAL), pycall_(), schema_version_(common::OB_INVALID_VERSION),
+exec_mode_(ObPythonUDF::EMBEDDED), row_cost_(0), selectivity_(0), deterministic_(false),
+language_(ObPythonUDF::PYTHON), batch_format_(ObPythonUDF::NUMPY),
+arg_passing_(ObPythonUDF::POSITIONAL)
 {
   reset();
 }
 
 ObSimplePythonUdfSchema::ObSimplePythonUdfSchema(ObIAllocator *allocator)
   : ObSchema(allocator), tenant_id_(common::OB_INVALID_ID), udf_id_(common::OB_INVALID_ID), udf_name_(), arg_num_(0),
-arg_names_(), arg_types_(), ret_(ObPythonUDF::UDF_UNINITIAL), pycall_(), schema_version_(common::OB_INVALID_VERSION) 
+arg_names_(), arg_types_(), ret_(ObPythonUDF::UDF_UNINITIAL), pycall_(), schema_version_(common::OB_INVALID_VERSION),
+exec_mode_(ObPythonUDF::EMBEDDED), row_cost_(0), selectivity_(0), deterministic_(false),
+language_(ObPythonUDF::PYTHON), batch_format_(ObPythonUDF::NUMPY),
+arg_passing_(ObPythonUDF::POSITIONAL)
 {
   reset();
 }
 
 ObSimplePythonUdfSchema::ObSimplePythonUdfSchema(const ObSimplePythonUdfSchema &other)
   : ObSchema(), tenant_id_(common::OB_INVALID_ID), udf_id_(common::OB_INVALID_ID), udf_name_(), arg_num_(0),
-arg_names_(), arg_types_(), ret_(ObPythonUDF::UDF_UNINITIAL), pycall_(), schema_version_(common::OB_INVALID_VERSION) 
+arg_names_(), arg_types_(), ret_(ObPythonUDF::UDF_UNINITIAL), pycall_(), schema_version_(common::OB_INVALID_VERSION),
+exec_mode_(ObPythonUDF::EMBEDDED), row_cost_(0), selectivity_(0), deterministic_(false),
+language_(ObPythonUDF::PYTHON), batch_format_(ObPythonUDF::NUMPY),
+arg_passing_(ObPythonUDF::POSITIONAL)
 {
   reset();
   *this = other;
@@ -61,6 +70,13 @@ void ObSimplePythonUdfSchema::reset()
   arg_types_.reset();
   ret_ = ObPythonUDF::UDF_UNINITIAL;
   pycall_.reset();
+  exec_mode_ = ObPythonUDF::EMBEDDED;
+  row_cost_ = 0;
+  selectivity_ = 0;
+  deterministic_ = false;
+  language_ = ObPythonUDF::PYTHON;
+  batch_format_ = ObPythonUDF::NUMPY;
+  arg_passing_ = ObPythonUDF::POSITIONAL;
   ObSchema::reset();
 }
 
@@ -99,6 +115,13 @@ ObSimplePythonUdfSchema &ObSimplePythonUdfSchema::operator =(const ObSimplePytho
     arg_num_ = other.arg_num_;
     schema_version_ = other.schema_version_;
     ret_ = other.ret_;
+    exec_mode_ = other.exec_mode_;
+    row_cost_ = other.row_cost_;
+    selectivity_ = other.selectivity_;
+    deterministic_ = other.deterministic_;
+    language_ = other.language_;
+    batch_format_ = other.batch_format_;
+    arg_passing_ = other.arg_passing_;
     if (OB_FAIL(deep_copy_str(other.udf_name_, udf_name_))) {
       LOG_WARN("Fail to deep copy udf name", K(ret));
     } else if (OB_FAIL(deep_copy_str(other.arg_names_, arg_names_))) {
@@ -42,7 +42,14 @@ public:
                K_(arg_types),
                K_(ret),
                K_(pycall),
-               K_(schema_version));
+               K_(schema_version),
+               K_(exec_mode),
+               K_(row_cost),
+               K_(selectivity),
+               K_(deterministic),
+               K_(language),
+               K_(batch_format),
+               K_(arg_passing));
   virtual void reset();
   inline bool is_valid() const;
   inline int64_t get_convert_size() const;
@@ -69,6 +76,17 @@ public:
   inline int set_arg_names(const common::ObString arg_names) { return deep_copy_str(arg_names, arg_names_); }
   inline int set_arg_types(const common::ObString arg_types) { return deep_copy_str(arg_types, arg_types_); }
   inline int set_pycall(const common::ObString &pycall) { return deep_copy_str(pycall, pycall_); }
+  inline void set_exec_mode(const enum ObPythonUDF::PyUdfExecMode mode) { exec_mode_ = mode; }
+  inline void set_exec_mode(const int64_t mode) { exec_mode_ = ObPythonUDF::PyUdfExecMode(mode); }
+  inline void set_row_cost(const double row_cost) { row_cost_ = row_cost; }
+  inline void set_selectivity(const double selectivity) { selectivity_ = selectivity; }
+  inline void set_deterministic(const bool deterministic) { deterministic_ = deterministic; }
+  inline void set_language(const enum ObPythonUDF::PyUdfLanguage language) { language_ = language; }
+  inline void set_language(const int64_t language) { language_ = ObPythonUDF::PyUdfLanguage(language); }
+  inline void set_batch_format(const enum ObPythonUDF::PyUdfBatchFormat format) { batch_format_ = format; }
+  inline void set_batch_format(const int64_t format) { batch_format_ = ObPythonUDF::PyUdfBatchFormat(format); }
+  inline void set_arg_passing(const enum ObPythonUDF::PyUdfArgPassing passing) { arg_passing_ = passing; }
+  inline void set_arg_passing(const int64_t passing) { arg_passing_ = ObPythonUDF::PyUdfArgPassing(passing); }
 
   inline const char *get_name() const { return extract_str(udf_name_); }
   inline const common::ObString &get_name_str() const { return udf_name_; }
@@ -80,6 +98,13 @@ public:
   inline enum ObPythonUDF::PyUdfRetType get_ret() const { return ret_; }
   inline const char *get_pycall() const { return extract_str(pycall_); }
   inline const common::ObString &get_pycall_str() const { return pycall_; }
+  inline enum ObPythonUDF::PyUdfExecMode get_exec_mode() const { return exec_mode_; }
+  inline double get_row_cost() const { return row_cost_; }
+  inline double get_selectivity() const { return selectivity_; }
+  inline bool is_deterministic() const { return deterministic_; }
+  inline enum ObPythonUDF::PyUdfLanguage get_language() const { return language_; }
+  inline enum ObPythonUDF::PyUdfBatchFormat get_batch_format() const { return batch_format_; }
+  inline enum ObPythonUDF::PyUdfArgPassing get_arg_passing() const { return arg_passing_; }
 
 private:
   uint64_t tenant_id_;
@@ -91,6 +116,13 @@ private:
   enum ObPythonUDF::PyUdfRetType ret_;
   common::ObString pycall_;
   int64_t schema_version_;
+  enum ObPythonUDF::PyUdfExecMode exec_mode_;
+  double row_cost_;
+  double selectivity_;
+  bool deterministic_;
+  enum ObPythonUDF::PyUdfLanguage language_;
+  enum ObPythonUDF::PyUdfBatchFormat batch_format_;
+  enum ObPythonUDF::PyUdfArgPassing arg_passing_;
 };
 
 template<class T, class V>
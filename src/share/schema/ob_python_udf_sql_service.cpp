@@ -97,6 +97,13 @@ int ObPythonUdfSqlService::add_python_udf(common::ObISQLClient &sql_client,
       SQL_COL_APPEND_ESCAPE_STR_VALUE(sql, values, PythonUdf_info.get_pycall(),
                                       PythonUdf_info.get_pycall_str().length(), "pycall");
       SQL_COL_APPEND_VALUE(sql, values, PythonUdf_info.get_schema_version(), "schema_version", "%ld");
+      SQL_COL_APPEND_VALUE(sql, values, PythonUdf_info.get_exec_mode(), "exec_mode", "%d");
+      SQL_COL_APPEND_VALUE(sql, values, PythonUdf_info.get_row_cost(), "row_cost", "%lf");
+      SQL_COL_APPEND_VALUE(sql, values, PythonUdf_info.get_selectivity(), "selectivity", "%lf");
+      SQL_COL_APPEND_VALUE(sql, values, PythonUdf_info.is_deterministic(), "deterministic", "%d");
+      SQL_COL_APPEND_VALUE(sql, values, PythonUdf_info.get_language(), "language", "%d");
+      SQL_COL_APPEND_VALUE(sql, values, PythonUdf_info.get_batch_format(), "batch_format", "%d");
+      SQL_COL_APPEND_VALUE(sql, values, PythonUdf_info.get_arg_passing(), "arg_passing", "%d");
       
       if (OB_SUCC(ret)) {
         int64_t affected_rows = 0;
@@ -1975,6 +1975,20 @@ int ObSchemaRetrieveUtils::fill_python_udf_schema(
   EXTRACT_INT_FIELD_TO_CLASS_MYSQL(result, ret, udf_info, int);
   EXTRACT_VARCHAR_FIELD_TO_CLASS_MYSQL(result, pycall, udf_info);
   EXTRACT_INT_FIELD_TO_CLASS_MYSQL(result, schema_version, udf_info, uint64_t);
+  EXTRACT_INT_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, exec_mode, udf_info, int64_t, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, ObPythonUDF::EMBEDDED);
+  EXTRACT_DOUBLE_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, row_cost, udf_info, double, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, 0);
+  EXTRACT_DOUBLE_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, selectivity, udf_info, double, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, 0);
+  EXTRACT_BOOL_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, deterministic, udf_info, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, false);
+  EXTRACT_INT_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, language, udf_info, int64_t, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, ObPythonUDF::PYTHON);
+  EXTRACT_INT_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, batch_format, udf_info, int64_t, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, ObPythonUDF::NUMPY);
+  EXTRACT_INT_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, arg_passing, udf_info, int64_t, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, ObPythonUDF::POSITIONAL);
   return ret;
 }
 
@@ -1997,6 +2011,20 @@ int ObSchemaRetrieveUtils::fill_python_udf_schema(
   EXTRACT_INT_FIELD_TO_CLASS_MYSQL(result, ret, udf_schema, int);
   EXTRACT_VARCHAR_FIELD_TO_CLASS_MYSQL(result, pycall, udf_schema);
   EXTRACT_INT_FIELD_TO_CLASS_MYSQL(result, schema_version, udf_schema, uint64_t);
+  EXTRACT_INT_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, exec_mode, udf_schema, int64_t, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, ObPythonUDF::EMBEDDED);
+  EXTRACT_DOUBLE_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, row_cost, udf_schema, double, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, 0);
+  EXTRACT_DOUBLE_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, selectivity, udf_schema, double, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, 0);
+  EXTRACT_BOOL_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, deterministic, udf_schema, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, false);
+  EXTRACT_INT_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, language, udf_schema, int64_t, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, ObPythonUDF::PYTHON);
+  EXTRACT_INT_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, batch_format, udf_schema, int64_t, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, ObPythonUDF::NUMPY);
+  EXTRACT_INT_FIELD_TO_CLASS_MYSQL_WITH_DEFAULT_VALUE(result, arg_passing, udf_schema, int64_t, true,
+      ObSchemaService::g_ignore_column_retrieve_error_, ObPythonUDF::POSITIONAL);
   return ret;
 }
 
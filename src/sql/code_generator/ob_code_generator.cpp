@@ -16,6 +16,7 @@
 #include "sql/code_generator/ob_static_engine_expr_cg.h"
 #include "sql/code_generator/ob_static_engine_cg.h"
 #include "sql/optimizer/ob_log_plan.h"
+#include "sql/optimizer/ob_log_python_udf.h"
 #include "observer/omt/ob_tenant_config_mgr.h"
 
 namespace oceanbase
@@ -34,6 +35,7 @@ int ObCodeGenerator::generate(const ObLogPlan &log_plan,
     log_plan.get_optimizer_context().set_batch_size(batch_size);
     phy_plan.set_batch_size(batch_size);
   }
+  OZ(ObLogPythonUDF::add_row_mode_notes(log_plan.get_optimizer_context(), batch_size));
   if (OB_FAIL(ret)) {
   } else if (OB_FAIL(generate_exprs(log_plan, phy_plan, cur_cluster_version))) {
     LOG_WARN("fail to get all raw exprs", K(ret));
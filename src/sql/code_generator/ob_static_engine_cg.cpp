@@ -2718,6 +2718,7 @@ int ObStaticEngineCG::generate_basic_transmit_spec(
     spec.is_wf_hybrid_ = op.is_wf_hybrid();
     spec.sample_type_ = op.get_sample_type();
     spec.repartition_table_id_ = op.get_repartition_table_id();
+    spec.random_chunk_rows_ = op.get_random_chunk_rows();
     OZ(check_rollup_distributor(&spec));
     LOG_TRACE("CG transmit", K(op.get_dfo_id()), K(op.get_op_id()),
               K(op.get_dist_method()), K(op.get_unmatch_row_dist_method()));
@@ -4937,6 +4938,21 @@ int ObStaticEngineCG::generate_spec(
   for(int i = 1; i < spec.projector_.count(); i = i + 2) {
     spec.col_exprs_.push_back(spec.projector_.at(i));
   }
+  //rows needed by the limit above
+  if (OB_SUCC(ret) && NULL != op.get_limit_expr()) {
+    OZ(generate_rt_expr(*op.get_limit_expr(), spec.limit_expr_));
+  }
+  //PREDICT_BATCH hint fixes the batch size of the python udfs
+  if (OB_SUCC(ret) && OB_NOT_NULL(op.get_plan())
+      && !op.get_plan()->get_optimizer_context().get_global_hint().predict_batches_.empty()) {
+    const ObGlobalHint &global_hint = op.get_plan()->get_optimizer_context().get_global_hint();
+    FOREACH_CNT_X(e, spec.calc_exprs_, OB_SUCC(ret)) {
+      OZ(ObPythonUDFOp::set_predict_batch_hint(*e, global_hint));
+    }
+    FOREACH_CNT_X(e, spec.output_, OB_SUCC(ret)) {
+      OZ(ObPythonUDFOp::set_predict_batch_hint(*e, global_hint));
+    }
+  }
   return ret;
 }
 
@@ -20,6 +20,9 @@
 #include "sql/engine/ob_physical_plan.h"
 #include "sql/session/ob_sql_session_info.h"
 #include "sql/code_generator/ob_expr_generator_impl.h"
+#include "sql/engine/expr/ob_expr_python_udf.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_model_registry.h"
+#include "share/rc/ob_tenant_base.h"
 
 namespace oceanbase
 {
@@ -52,6 +55,13 @@ int ObCreatePythonUdfExecutor::execute(ObExecContext &ctx, ObCreatePythonUdfStmt
   } else if (OB_FAIL(common_rpc_proxy->create_python_udf(create_python_udf_arg))) {
     LOG_WARN("rpc proxy create udf failed", K(ret),
                 "dst", common_rpc_proxy->get_server());
+  } else {
+    // python handles cached by running executions must be resolved again
+    ObExprPythonUdf::inc_udf_epoch();
+    // load the model ahead of the first query
+    if (NULL != MTL(ObPyModelRegistry*)) {
+      MTL(ObPyModelRegistry*)->notify_schema_changed();
+    }
   }
   return ret;
 }
@@ -80,6 +90,12 @@ int ObDropPythonUdfExecutor::execute(ObExecContext &ctx, ObDropPythonUdfStmt &st
   } else if (OB_FAIL(common_rpc_proxy->drop_python_udf(drop_python_udf_arg))) {
     LOG_WARN("rpc proxy drop python udf failed", K(ret),
                 "dst", common_rpc_proxy->get_server());
+  } else {
+    ObExprPythonUdf::inc_udf_epoch();
+    // release the model of the dropped udf
+    if (NULL != MTL(ObPyModelRegistry*)) {
+      MTL(ObPyModelRegistry*)->notify_schema_changed();
+    }
   }
   return ret;
 }
@@ -992,7 +992,8 @@ static ObExpr::EvalFunc g_expr_eval_functions[] = {
   NULL,                                                               /* 590 */
   NULL,                                                               /* 591 */
   ObExprNlsInitCap::calc_nls_initcap_expr,                             /* 592 */
-  ObExprPythonUdf::eval_test_udf                                      /* test meta data udf */
+  ObExprPythonUdf::eval_test_udf,                                     /* test meta data udf */
+  ObExprPythonUdf::eval_tree_udf                                      /* tree model udf */
 };
 
 static ObExpr::EvalBatchFunc g_expr_eval_batch_functions[] = {
@@ -1108,7 +1109,8 @@ static ObExpr::EvalBatchFunc g_expr_eval_batch_functions[] = {
   ObExprCoalesce::calc_batch_coalesce_expr,                           /* 109 */
   ObExprIsNot::calc_batch_is_not_null,                                /* 110 */
   ObExprNlsInitCap::calc_nls_initcap_batch,                            /* 111 */
-  ObExprPythonUdf::eval_test_udf_batch                                /* test meta data udf batch */
+  ObExprPythonUdf::eval_test_udf_batch,                               /* test meta data udf batch */
+  ObExprPythonUdf::eval_tree_udf_batch                                /* tree model udf batch */
 };
 
 REG_SER_FUNC_ARRAY(OB_SFA_SQL_EXPR_EVAL,
@@ -13,24 +13,35 @@
 #include <sys/syscall.h>
 
 #include "lib/oblog/ob_log.h"
+#include "lib/time/ob_time_utility.h"
+#include "lib/time/ob_tsc_timestamp.h"
 
 #include "share/object/ob_obj_cast.h"
 #include "share/config/ob_server_config.h"
 #include "share/datum/ob_datum_util.h"
+#include "share/rc/ob_tenant_base.h"
 #include "objit/common/ob_item_type.h"
 
 #include "sql/engine/expr/ob_expr_util.h"
 #include "sql/engine/expr/ob_expr_result_type_util.h"
 #include "sql/session/ob_sql_session_info.h"
+#include "sql/engine/ob_physical_plan.h"
 
 #include "storage/ob_storage_util.h"
 
 #include "sql/engine/expr/ob_expr_python_udf.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_util.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_worker_pool.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_model_registry.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_result_cache.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_arrow.h"
 
 namespace oceanbase {
 using namespace common;
 namespace sql {
 
+int64_t ObExprPythonUdf::udf_epoch_ = 0;
+
 ObExprPythonUdf::ObExprPythonUdf(ObIAllocator& alloc) : 
   ObExprOperator(alloc, T_FUN_SYS_PYTHON_UDF, N_PYTHON_UDF, MORE_THAN_ZERO), allocator_(alloc), udf_meta_()
 {}
@@ -97,6 +108,15 @@ int ObExprPythonUdf::deep_copy_udf_meta(share::schema::ObPythonUDFMeta &dst,
   int ret = OB_SUCCESS;
   dst.init_ = src.init_;
   dst.ret_ = src.ret_;
+  dst.udf_id_ = src.udf_id_;
+  dst.schema_version_ = src.schema_version_;
+  dst.exec_mode_ = src.exec_mode_;
+  dst.row_cost_ = src.row_cost_;
+  dst.selectivity_ = src.selectivity_;
+  dst.deterministic_ = src.deterministic_;
+  dst.language_ = src.language_;
+  dst.batch_format_ = src.batch_format_;
+  dst.arg_passing_ = src.arg_passing_;
   if (OB_FAIL(ob_write_string(alloc, src.name_, dst.name_))) {
     LOG_WARN("fail to write name", K(src.name_), K(ret));
   } else if (OB_FAIL(ob_write_string(alloc, src.pycall_, dst.pycall_))) {
@@ -105,6 +125,16 @@ int ObExprPythonUdf::deep_copy_udf_meta(share::schema::ObPythonUDFMeta &dst,
     for (int64_t i = 0; i < src.udf_attributes_types_.count(); i++) {
       dst.udf_attributes_types_.push_back(src.udf_attributes_types_.at(i));
     }
+    // parameter names are the keywords of ARG_PASSING KEYWORD
+    dst.udf_attributes_names_.reuse();
+    for (int64_t i = 0; OB_SUCC(ret) && i < src.udf_attributes_names_.count(); i++) {
+      ObString name;
+      if (OB_FAIL(ob_write_string(alloc, src.udf_attributes_names_.at(i), name))) {
+        LOG_WARN("fail to write attribute name", K(ret), K(i));
+      } else if (OB_FAIL(dst.udf_attributes_names_.push_back(name))) {
+        LOG_WARN("fail to push back attribute name", K(ret), K(i));
+      }
+    }
   }
   LOG_DEBUG("set udf meta", K(src), K(dst));
   return ret;
@@ -173,7 +203,10 @@ int ObExprPythonUdf::init_udf(const common::ObIArray<ObRawExpr*> &param_exprs)
   // check python code
   if (OB_FAIL(ret)) {
     LOG_WARN("Fail to check udf meta", K(ret));
-  } else if (import_udf(udf_meta_)) {
+  } else if (ObPythonUDF::TREES == udf_meta_.language_) {
+    // no python code, the model is parsed at code generation
+    udf_meta_.init_ = true;
+  } else if (OB_FAIL(import_udf(udf_meta_))) {
     LOG_WARN("Fail to import udf", K(ret));
   } else {
     udf_meta_.init_ = true;
@@ -182,14 +215,51 @@ int ObExprPythonUdf::init_udf(const common::ObIArray<ObRawExpr*> &param_exprs)
 }
 
 int ObExprPythonUdf::import_udf(const share::schema::ObPythonUDFMeta &udf_meta)
+{
+  int ret = OB_SUCCESS;
+  ObPyModelRegistry *registry = MTL(ObPyModelRegistry*);
+
+  //Acquire GIL of the main interpreter
+  bool nStatus = PyGILState_Check();
+  PyGILState_STATE gstate;
+  if(!nStatus) {
+    gstate = PyGILState_Ensure();
+    nStatus = true;
+  }
+
+  if (NULL != registry) {
+    // loaded once per udf version, usually ahead by the loader of the registry
+    if (OB_FAIL(registry->bind(udf_meta))) {
+      LOG_WARN("Fail to bind python udf model", K(ret));
+    }
+  } else if (OB_FAIL(load_udf(udf_meta))) {
+    LOG_WARN("Fail to load python udf", K(ret));
+  } else {
+    // __main__ now holds a new definition of the udf handlers
+    inc_udf_epoch();
+    LOG_DEBUG("Import python udf handler", K(ret));
+  }
+
+  //release GIL
+  if(nStatus)
+    PyGILState_Release(gstate);
+
+  return ret;
+}
+
+int ObExprPythonUdf::load_udf(const share::schema::ObPythonUDFMeta &udf_meta)
 {
   int ret = OB_SUCCESS;
 
   //runtime variables
   PyObject *pModule = NULL;
+  PyObject *main_dic = NULL;
   PyObject *dic = NULL;
   PyObject *v = NULL;
   PyObject *pInitial = NULL;
+  PyObject *pFun = NULL;
+  PyObject *pInitResult = NULL;
+  PyObject *pName = NULL;
 
   //name
   std::string name(udf_meta.name_.ptr());
@@ -202,14 +272,6 @@ int ObExprPythonUdf::import_udf(const share::schema::ObPythonUDFMeta &udf_meta)
   pycall.replace(pycall.find("pyinitial"), 9, pyinitial_handler);
   pycall.replace(pycall.find("pyfun"), 5, pyfun_handler);
   const char* pycall_c = pycall.c_str();
-  
-  //Acquire GIL
-  bool nStatus = PyGILState_Check();
-  PyGILState_STATE gstate;
-  if(!nStatus) {
-    gstate = PyGILState_Ensure();
-    nStatus = true;
-  }
 
   // prepare and import python code
   pModule = PyImport_AddModule("__main__"); // load main module
@@ -218,12 +280,24 @@ int ObExprPythonUdf::import_udf(const share::schema::ObPythonUDFMeta &udf_meta)
     LOG_WARN("fail to import main module", K(ret));
     goto destruction;
   }
-  dic = PyModule_GetDict(pModule); // get main module dic
-  if(OB_ISNULL(dic)) {
+  main_dic = PyModule_GetDict(pModule); // get main module dic
+  if(OB_ISNULL(main_dic)) {
     ret = OB_ERR_UNEXPECTED;
     LOG_WARN("fail to get main module dic", K(ret));
     goto destruction;
-  } 
+  }
+  // globals of the pycall are kept apart from other udfs, only the handlers go to __main__,
+  // so that the state built by pyinitial is released with the handlers
+  dic = PyDict_New();
+  pName = PyUnicode_FromString("__main__");
+  if(OB_ISNULL(dic) || OB_ISNULL(pName)
+     || PyDict_SetItemString(dic, "__builtins__", PyEval_GetBuiltins()) < 0
+     || PyDict_SetItemString(dic, "__name__", pName) < 0) {
+    process_python_exception();
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("fail to create udf globals", K(ret));
+    goto destruction;
+  }
   v = PyRun_StringFlags(pycall_c, Py_file_input, dic, dic, NULL); // test pycall
   if(OB_ISNULL(v)) {
     process_python_exception();
@@ -231,210 +305,197 @@ int ObExprPythonUdf::import_udf(const share::schema::ObPythonUDFMeta &udf_meta)
     LOG_WARN("fail to write pycall into module", K(ret));
     goto destruction;
   }
-  pInitial = PyObject_GetAttrString(pModule, pyinitial_handler.c_str()); // get pyInitial()
+  pInitial = PyDict_GetItemString(dic, pyinitial_handler.c_str()); // get pyInitial()
+  pFun = PyDict_GetItemString(dic, pyfun_handler.c_str());
   if(OB_ISNULL(pInitial) || !PyCallable_Check(pInitial)) {
     process_python_exception();
     ret = OB_ERR_UNEXPECTED;
     LOG_WARN("Fail to import pyinitial", K(ret));
     goto destruction;
-  } else if (OB_ISNULL(PyObject_CallObject(pInitial, NULL))){
+  } else if(OB_ISNULL(pFun) || !PyCallable_Check(pFun)) {
+    process_python_exception();
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("Fail to import pyfun", K(ret));
+    goto destruction;
+  } else if (OB_ISNULL(pInitResult = PyObject_CallObject(pInitial, NULL))){
     process_python_exception();
     ret = OB_ERR_UNEXPECTED;
     LOG_WARN("Fail to run pyinitial", K(ret));
     goto destruction;
+  } else if (PyDict_SetItemString(main_dic, pyinitial_handler.c_str(), pInitial) < 0
+             || PyDict_SetItemString(main_dic, pyfun_handler.c_str(), pFun) < 0) {
+    process_python_exception();
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("Fail to publish udf handlers", K(ret));
+    goto destruction;
   } else {
-    LOG_DEBUG("Import python udf handler", K(ret));
+    LOG_DEBUG("Load python udf handler", K(ret));
   }
 
   destruction: 
-  //release GIL
-  if(nStatus)
-    PyGILState_Release(gstate);
-
+  Py_XDECREF(pInitResult);
+  Py_XDECREF(v);
+  Py_XDECREF(pName);
+  Py_XDECREF(dic);
   return ret;
 }
 
+void ObExprPythonUdf::unload_udf(const common::ObString &name)
+{
+  PyObject *pModule = PyImport_AddModule("__main__");
+  PyObject *main_dic = NULL == pModule ? NULL : PyModule_GetDict(pModule);
+  if (NULL != main_dic) {
+    std::string pyinitial_handler(name.ptr(), name.length());
+    std::string pyfun_handler(name.ptr(), name.length());
+    pyinitial_handler.append("_pyinitial");
+    pyfun_handler.append("_pyfun");
+    // the globals of the udf go away with the last handler
+    if (PyDict_DelItemString(main_dic, pyinitial_handler.c_str()) < 0) {
+      PyErr_Clear();
+    }
+    if (PyDict_DelItemString(main_dic, pyfun_handler.c_str()) < 0) {
+      PyErr_Clear();
+    }
+  }
+}
+
 int ObExprPythonUdf::eval_test_udf(const ObExpr &expr, ObEvalCtx &ctx, ObDatum &expr_datum) {
   int ret = OB_SUCCESS;
 
-  //extract pyfun handler
+  //udf info and cached python handles
   const ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr.extra_info_);
-  std::string name(info->udf_meta_.name_.ptr());
-  name = name.substr(0, info->udf_meta_.name_.length());
-  std::string pyfun_handler = name.append("_pyfun");
-
-  //Ensure GIL
-  bool nStatus = PyGILState_Check();
-  PyGILState_STATE gstate;
-  if(!nStatus) {
-    gstate = PyGILState_Ensure();
-    nStatus = true;
-  }
+  ObPythonUdfExprCtx *udf_ctx = NULL;
 
-  //load numpy api
-  _import_array(); 
+  //interpreter running the udf, acquired in get_udf_ctx and released at return
+  ObPyInterpreterGuard interp_guard;
 
   //运行时变量
-  PyObject *pModule = NULL;
-  PyObject *pFunc = NULL;
-  PyObject *pArgs = PyTuple_New(expr.arg_cnt_);
+  PyObject *pArgs = NULL;
+  PyObject *pKwargs = NULL;
   PyObject *pResult = NULL;
   PyObject *numpyarray = NULL;
-  ObEvalCtx::TempAllocGuard alloc_guard(ctx);
-  ObIAllocator &tmp_alloc = alloc_guard.get_allocator(); 
-  PyObject **arrays = (PyObject **)tmp_alloc.alloc(sizeof(PyObject *) * expr.arg_cnt_);
-  for(int i = 0; i < expr.arg_cnt_; i++)
-    arrays[i] = NULL;
-  npy_intp elements[1] = {1};
+  const int32_t sel[1] = {0}; // single row
+  const bool is_keyword = OB_NOT_NULL(info) && ObPythonUDF::KEYWORD == info->udf_meta_.arg_passing_;
+  int64_t ret_size = 0;
   ObDatum *argDatum = NULL;
+  ObPyUdfStageStat stat;
+  int64_t begin_cycles = 0;
+  int64_t ob2py_end = 0;
+  int64_t infer_end = 0;
+
+  //get args from expr before entering the interpreter, args may be python udfs as well
+  for(int i = 0;i < expr.arg_cnt_;i++) {
+    if(expr.args_[i]->eval(ctx, argDatum) != OB_SUCCESS){
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("fail to obtain arg", K(ret));
+      return ret;
+    }
+  }
 
   //获取udf实例并核验
-  pModule = PyImport_AddModule("__main__");
-  if(OB_ISNULL(pModule)) {
+  if (OB_ISNULL(info)) {
     ret = OB_ERR_UNEXPECTED;
-    LOG_WARN("Fail to import main module", K(ret));
+    LOG_WARN("python udf info is null", K(ret));
     goto destruction;
-  }
-  pFunc = PyObject_GetAttrString(pModule, pyfun_handler.c_str());
-  if(OB_ISNULL(pFunc) || !PyCallable_Check(pFunc)) {
-    ret = OB_ERR_UNEXPECTED;
+  } else if (share::schema::ObPythonUDF::WORKER == info->udf_meta_.exec_mode_) {
+    if (OB_FAIL(eval_udf_in_worker(expr, ctx, sel, 1, false, &expr_datum))) {
+      LOG_WARN("fail to run python udf in worker", K(ret));
+    }
+    goto destruction;
+  } else if (OB_FAIL(get_udf_ctx(expr, ctx, interp_guard, udf_ctx))) {
     LOG_WARN("Fail to get function handler", K(ret));
     goto destruction;
+  } else if (OB_FAIL(ObPythonUdfUtil::import_numpy())) {
+    LOG_WARN("Fail to load numpy api", K(ret));
+    goto destruction;
+  } else if (ObPythonUDF::ARROW == info->udf_meta_.batch_format_) {
+    if (OB_FAIL(predict_arrow(expr, ctx, *udf_ctx, false, sel, 1, &expr_datum, pResult))) {
+      LOG_WARN("fail to predict python udf in arrow", K(ret));
+    }
+    goto destruction;
+  } else if (FALSE_IT(begin_cycles = rdtsc())) {
+  } else if (OB_ISNULL(pArgs = PyTuple_New(is_keyword ? 0 : expr.arg_cnt_))
+             || (is_keyword && OB_ISNULL(pKwargs = PyDict_New()))) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("fail to allocate python tuple", K(ret));
+    goto destruction;
   }
 
   //传递udf运行时参数
   for(int i = 0;i < expr.arg_cnt_;i++) {
-    //get args from expr
-    if(expr.args_[i]->eval(ctx, argDatum) != OB_SUCCESS){
-      ret = OB_ERR_UNEXPECTED;
-      LOG_WARN("fail to obtain arg", K(ret));
-      goto destruction;
-    }
-    //转换得到numpy array --> 单一元素
-    switch(expr.args_[i]->datum_meta_.type_) {
-      case ObCharType:
-      case ObVarcharType:
-      case ObTinyTextType:
-      case ObTextType:
-      case ObMediumTextType:
-      case ObLongTextType: {
-        //str in OB
-        ObString str = argDatum->get_string();
-        //put str into numpy array
-        numpyarray = PyArray_New(&PyArray_Type, 1, elements, NPY_OBJECT, NULL, NULL, 0, 0, NULL);
-        PyArray_SETITEM((PyArrayObject *)numpyarray, (char *)PyArray_GETPTR1((PyArrayObject *)numpyarray, 0), 
-          PyUnicode_FromStringAndSize(str.ptr(), str.length()));
-        break;
-      }
-      case ObTinyIntType:
-      case ObSmallIntType:
-      case ObMediumIntType:
-      case ObInt32Type:
-      case ObIntType: {
-        //put integer into numpy array
-        numpyarray = PyArray_EMPTY(1, elements, NPY_INT32, 0);
-        PyArray_SETITEM((PyArrayObject *)numpyarray, (char *)PyArray_GETPTR1((PyArrayObject *)numpyarray, 0), PyLong_FromLong(argDatum->get_int()));
-        break;
-      }
-      case ObDoubleType: {
-        //put double into numpy array
-        numpyarray = PyArray_EMPTY(1, elements, NPY_FLOAT64, 0);
-        PyArray_SETITEM((PyArrayObject *)numpyarray, (char *)PyArray_GETPTR1((PyArrayObject *)numpyarray, 0), PyFloat_FromDouble(argDatum->get_double()));
-        break;
-      }
-      case ObNumberType: {
-        ret = OB_ERR_UNEXPECTED;
-        LOG_WARN("number type, fail in obdatum2array", K(ret));
+    argDatum = &expr.locate_param_datum(ctx, i);
+    //转换得到numpy array --> 单一元素, 常量参数按ARG_PASSING转换为标量
+    if (ObPythonUDF::POSITIONAL != info->udf_meta_.arg_passing_
+        && expr.args_[i]->is_const_expr()) {
+      if (OB_FAIL(ObPythonUdfUtil::datum_to_python(expr.args_[i]->datum_meta_.type_, *argDatum,
+                                                   is_keyword, numpyarray))) {
+        LOG_WARN("fail to convert constant arg to python", K(ret), K(i));
         goto destruction;
       }
-      default: {
-        //error
+    } else if (OB_FAIL(ObPythonUdfUtil::datums_to_numpy(expr.args_[i]->datum_meta_.type_,
+                                                        argDatum, true, sel, 1, numpyarray))) {
+      LOG_WARN("fail to convert datum to numpy array", K(ret), K(i));
+      goto destruction;
+    }
+    //插入pArg, 关键字参数以参数名插入pKwargs
+    if (is_keyword) {
+      const int set_ret = PyDict_SetItem(pKwargs, udf_ctx->get_kw_name(i), numpyarray);
+      Py_DECREF(numpyarray);
+      if (0 != set_ret) {
+        process_python_exception();
         ret = OB_ERR_UNEXPECTED;
-        LOG_WARN("unknown arg type, fail in obdatum2array", K(ret));
+        LOG_WARN("fail to set keyword arg", K(ret), K(i));
         goto destruction;
       }
-    }
-    //插入pArg
-    if(PyTuple_SetItem(pArgs, i, numpyarray) != 0){
+    } else if(PyTuple_SetItem(pArgs, i, numpyarray) != 0){
       ret = OB_ERR_UNEXPECTED;
       LOG_WARN("fail to set numpy array arg", K(ret));
       goto destruction;
     }
-    arrays[i] = numpyarray;
   }
 
   //执行Python Code并获取返回值
-  pResult = PyObject_CallObject(pFunc, pArgs);
+  ob2py_end = rdtsc();
+  pResult = PyObject_Call(udf_ctx->get_pyfun(), pArgs, pKwargs);
   if(!pResult){
     process_python_exception();
     ret = OB_ERR_UNEXPECTED;
     LOG_WARN("execute error", K(ret));
     goto destruction;
   }
+  infer_end = rdtsc();
 
-  //根据类型从numpy数组中取出返回值并填入返回值
-  switch (expr.datum_meta_.type_)
-  {
-    case ObCharType:
-    case ObVarcharType:
-    case ObTinyTextType:
-    case ObTextType:
-    case ObMediumTextType:
-    case ObLongTextType: {
-      expr_datum.set_string(common::ObString(PyUnicode_AsUTF8(
-        PyArray_GETITEM((PyArrayObject *)pResult, (char *)PyArray_GETPTR1((PyArrayObject *)pResult, 0)))));
-      break;
-    }
-    case ObTinyIntType:
-    case ObSmallIntType:
-    case ObMediumIntType:
-    case ObInt32Type:
-    case ObIntType: {
-      expr_datum.set_int(PyLong_AsLong(
-        PyArray_GETITEM((PyArrayObject *)pResult, (char *)PyArray_GETPTR1((PyArrayObject *)pResult, 0))));
-      break;
-    }
-    case ObDoubleType:{
-      expr_datum.set_double(PyFloat_AsDouble(
-        PyArray_GETITEM((PyArrayObject *)pResult, (char *)PyArray_GETPTR1((PyArrayObject *)pResult, 0))));
-      break;
-    }
-    case ObNumberType: {
-      //error
-      ret = OB_ERR_UNEXPECTED;
-      LOG_WARN("not support ObNumberType", K(ret));
-      goto destruction;
-    }
-    default: {
-      //error
-      ret = OB_ERR_UNEXPECTED;
-      LOG_WARN("unknown result type", K(ret));
-      goto destruction;
-    }
+  //根据类型从numpy数组中取出返回值并填入返回值, 字符串在释放pResult前拷出
+  if (OB_FAIL(ObPythonUdfUtil::numpy_to_datums(expr.datum_meta_.type_, pResult,
+                                               sel, 1, &expr_datum, ret_size))) {
+    LOG_WARN("fail to convert numpy array to datum", K(ret));
+    goto destruction;
+  } else if (OB_FAIL(copy_str_results(expr, ctx, false, sel, ret_size, &expr_datum))) {
+    LOG_WARN("fail to copy string result", K(ret));
+    goto destruction;
+  } else {
+    stat.batch_cnt_ = 1;
+    stat.row_cnt_ = 1;
+    stat.ob2py_cycles_ = ob2py_end - begin_cycles;
+    stat.infer_cycles_ = infer_end - ob2py_end;
+    stat.py2ob_cycles_ = rdtsc() - infer_end;
+    stat.batch_size_ = 1;
+    udf_ctx->add_stat(*info, stat);
   }
 
   //释放资源
   destruction:
-  //释放运行时变量
+  //释放运行时变量, 函数参数由pArgs及pKwargs持有
   Py_XDECREF(pArgs);
-  //释放函数参数
-  for (int i = 0; i < expr.arg_cnt_; i++) {
-    if(OB_ISNULL(arrays[i]))
-      continue;
-    else
-      PyArray_XDECREF((PyArrayObject *)arrays[i]);
-  }
+  Py_XDECREF(pKwargs);
   //释放计算结果
-  if(pResult != NULL) {
-    Py_XDECREF(pResult);
-  }
+  Py_XDECREF(pResult);
 
   //PyGC_Enable();
   //PyGC_Collect();
-  
-  //release GIL
-  if(nStatus)
-    PyGILState_Release(gstate);
+
+  //release interpreter
+  interp_guard.release();
 
   return ret;
 }
@@ -442,17 +503,10 @@ int ObExprPythonUdf::eval_test_udf(const ObExpr &expr, ObEvalCtx &ctx, ObDatum &
 int ObExprPythonUdf::eval_test_udf_batch(const ObExpr &expr, ObEvalCtx &ctx,
                                          const ObBitVector &skip, const int64_t batch_size) {
   int ret = OB_SUCCESS;
-  
-  // 开始统计时间
-  struct timeval t1, t2, t3, t4, t5, t6;
-  double timeuse;
-  gettimeofday(&t1, NULL);
 
-  //extract pyfun handler
+  //udf info and cached python handles
   ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr.extra_info_);
-  std::string name(info->udf_meta_.name_.ptr());
-  name = name.substr(0, info->udf_meta_.name_.length());
-  std::string pyfun_handler = name.append("_pyfun");
+  ObPythonUdfExprCtx *udf_ctx = NULL;
 
   //返回值
   ObDatum *results = expr.locate_batch_datums(ctx);
@@ -460,393 +514,999 @@ int ObExprPythonUdf::eval_test_udf_batch(const ObExpr &expr, ObEvalCtx &ctx,
   //eval and check params
   ObBitVector &eval_flags = expr.get_evaluated_flags(ctx);
   ObBitVector &my_skip = expr.get_pvt_skip(ctx);
-  my_skip.deep_copy(skip, batch_size);
-  for (int i = 0; i < expr.arg_cnt_; i++) {
-    //do eval
-    if (OB_FAIL(expr.args_[i]->eval_batch(ctx, my_skip, batch_size))) {
-      ret = OB_ERR_UNEXPECTED;
-      LOG_WARN("failed to eval batch result args", K(ret));
-      return ret;
-    }
-    //do check
-    ObDatum *datum_array = expr.args_[i]->locate_batch_datums(ctx);
-    for (int j = 0; j < batch_size; j++) {
-      if (my_skip.at(j) || eval_flags.at(j))
-        continue;
-      else if (datum_array[j].is_null()) {
-        //存在null推理结果即为空
-        results[j].set_null();
-        my_skip.set(j);
-        eval_flags.set(j);
-      }
-    }
+  if (OB_FAIL(eval_args_batch(expr, ctx, skip, batch_size))) {
+    LOG_WARN("failed to eval batch result args", K(ret));
+    return ret;
+  } else if (OB_NOT_NULL(info) && info->udf_meta_.deterministic_
+             && OB_FAIL(probe_result_cache(expr, ctx, batch_size))) {
+    LOG_WARN("failed to probe python udf result cache", K(ret));
+    return ret;
   }
   int64_t real_param = 0;
-  for (int i = 0; i < batch_size; i++) {
-    if (my_skip.at(i) || eval_flags.at(i))
-      continue;
-    else
-      ++real_param;
-  }
-
-  //Ensure GIL
-  bool nStatus = PyGILState_Check();
-  PyGILState_STATE gstate;
-  if(!nStatus) {
-    gstate = PyGILState_Ensure();
-    nStatus = true;
-  }
 
-  //load numpy api
-  _import_array(); 
+  //interpreter running the udf, acquired in get_udf_ctx
+  ObPyInterpreterGuard interp_guard;
 
   //运行时变量
   ObEvalCtx::TempAllocGuard alloc_guard(ctx);
   ObIAllocator &tmp_alloc = alloc_guard.get_allocator(); 
-  //tmp_alloc.reset();
-  PyObject **arrays = (PyObject **)tmp_alloc.alloc(sizeof(PyObject *) * expr.arg_cnt_);
-  //PyObject **arrays = (PyObject **)ctx.allocator_.alloc(sizeof(PyObject *) * expr.arg_cnt_);
-  //PyObject **arrays = new PyObject* [expr.arg_cnt_];
-  if (arrays == nullptr) {
-    ret = OB_ERR_UNEXPECTED;
-    LOG_WARN("Fail to allocate numpy arrays", K(ret));
-    return ret;
-  } else {
-    for(int i = 0; i < expr.arg_cnt_; i++)
-      arrays[i] = NULL;
-  }
-
-  PyObject *pModule = NULL;
-  PyObject *pFunc = NULL;
-  PyObject *pArgs = PyTuple_New(expr.arg_cnt_);
-  PyObject *pKwargs = PyDict_New();
-  PyObject *pResult = NULL;
-  PyObject *numpyarray = NULL;
-  npy_intp elements[1] = {real_param}; // row size
-  ObDatum *argDatum = NULL;
-  
-  /*if(info->udf_meta_.init_) {
-  } else if (OB_FAIL(import_udf(info->udf_meta_))) {
-    ret = OB_ERR_UNEXPECTED;
-    LOG_WARN("Fail to import udf", K(ret));
+  ObPyBatchDedup dedup;
+  //selection vector of rows to be predicted
+  int32_t *sel = static_cast<int32_t *>(tmp_alloc.alloc(sizeof(int32_t) * (batch_size > 0 ? batch_size : 1)));
+  if (OB_ISNULL(sel)) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("Fail to allocate selection vector", K(ret), K(batch_size));
     goto destruction;
-  } else {
-    info->udf_meta_.init_ = true;
-  }*/
-
-  //获取udf实例并核验
-  pModule = PyImport_AddModule("__main__");
-  if (OB_ISNULL(pModule)) {
-    ret = OB_ERR_UNEXPECTED;
-    LOG_WARN("Fail to import main module", K(ret));
+  } else if (FALSE_IT(real_param = ObPythonUdfUtil::build_selection(my_skip, eval_flags, batch_size, sel))) {
+  } else if (0 == real_param) {
+    //all rows are skipped, null or cached, nothing to predict
     goto destruction;
-  }
-  
-  pFunc = PyObject_GetAttrString(pModule, pyfun_handler.c_str());
-  if (OB_ISNULL(pFunc) || !PyCallable_Check(pFunc)) {
-    ret = OB_ERR_UNEXPECTED;
-    LOG_WARN("Fail to get function handler", K(ret));
+  } else if (OB_FAIL(dedup_batch(expr, ctx, tmp_alloc, batch_size, dedup, sel, real_param))) {
+    LOG_WARN("fail to deduplicate python udf batch", K(ret));
     goto destruction;
-  }
-
-  gettimeofday(&t2, NULL);
-
-  int k;
-  int ret_size;
-  //传递udf运行时参数
-  for (int i = 0;i < expr.arg_cnt_;i++) {
-    k = 0;
-    argDatum = expr.args_[i]->locate_batch_datums(ctx);
-    //转换得到numpy array --> 单一元素
-    int j = 0, zero = 0;
-    int *index;
-    if (!expr.args_[i]->is_const_expr()) 
-      index = &j;
-    else 
-      index = &zero;
-    switch (expr.args_[i]->datum_meta_.type_) {
-      case ObCharType:
-      case ObVarcharType:
-      case ObTinyTextType:
-      case ObTextType:
-      case ObMediumTextType:
-      case ObLongTextType: {
-        numpyarray = PyArray_New(&PyArray_Type, 1, elements, NPY_OBJECT, NULL, NULL, 0, 0, NULL);
-        for (j = 0; j < batch_size; j++) {
-          if (my_skip.at(j) || eval_flags.at(j))
-            continue;
-          else {
-            //str in OB
-            ObString str = argDatum[*index].get_string();
-            //put str into numpy array
-            PyArray_SETITEM((PyArrayObject *)numpyarray, (char *)PyArray_GETPTR1((PyArrayObject *)numpyarray, k++), 
-              PyUnicode_FromStringAndSize(str.ptr(), str.length()));
-          }
-        }
-        break;
-      }
-      case ObTinyIntType:
-      case ObSmallIntType:
-      case ObMediumIntType:
-      case ObInt32Type:
-      case ObIntType: {
-        numpyarray = PyArray_EMPTY(1, elements, NPY_INT32, 0);
-        for (j = 0; j < batch_size; j++) {
-          if (my_skip.at(j) || eval_flags.at(j))
-            continue;
-          else
-            //put integer into numpy array
-            PyArray_SETITEM((PyArrayObject *)numpyarray, (char *)PyArray_GETPTR1((PyArrayObject *)numpyarray, k++), PyLong_FromLong(argDatum[*index].get_int()));
-        }
-        break;
-      }
-      case ObDoubleType: {
-        numpyarray = PyArray_EMPTY(1, elements, NPY_FLOAT64, 0);
-        for (j = 0; j < batch_size; j++) {
-          if (my_skip.at(j) || eval_flags.at(j))
-            continue;
-          else
-            //put double into numpy array
-            PyArray_SETITEM((PyArrayObject *)numpyarray, (char *)PyArray_GETPTR1((PyArrayObject *)numpyarray, k++), PyFloat_FromDouble(argDatum[*index].get_double()));
-        }
-        break;
-      }
-      case ObNumberType: {
-        ret = OB_ERR_UNEXPECTED;
-        LOG_WARN("number type, fail in obdatum2array", K(ret));
-        goto destruction;
-      }
-      default: {
-        //error
-        ret = OB_ERR_UNEXPECTED;
-        LOG_WARN("unknown arg type, fail in obdatum2array", K(ret));
-        goto destruction;
-      }
-    }
-    //插入pArg
-    if(PyTuple_SetItem(pArgs, i, numpyarray) != 0){
-      ret = OB_ERR_UNEXPECTED;
-      LOG_WARN("fail to set numpy array arg", K(ret));
-      goto destruction;
+  } else if (share::schema::ObPythonUDF::WORKER == info->udf_meta_.exec_mode_) {
+    //out-of-process execution, no interpreter of this process is involved
+    if (OB_FAIL(eval_udf_in_worker(expr, ctx, sel, real_param, true, results))) {
+      LOG_WARN("fail to run python udf in worker", K(ret));
+    } else if (info->udf_meta_.deterministic_
+               && OB_FAIL(fill_result_cache(expr, ctx, sel, real_param, results))) {
+      LOG_WARN("fail to fill python udf result cache", K(ret));
+    } else {
+      dedup.scatter(results);
     }
-    arrays[i] = numpyarray;
+    goto destruction;
   }
 
-  gettimeofday(&t3, NULL);
-
-  //执行Python Code并获取返回值
-  pResult = PyObject_CallObject(pFunc, pArgs);
-  if (!pResult) {
-    process_python_exception();
-    ret = OB_ERR_UNEXPECTED;
-    LOG_WARN("execute error", K(ret));
+  //获取udf实例并核验, pyfun及参数数组在一次执行内复用
+  if (OB_FAIL(get_udf_ctx(expr, ctx, interp_guard, udf_ctx))) {
+    LOG_WARN("Fail to get function handler", K(ret));
+    goto destruction;
+  } else if (OB_FAIL(ObPythonUdfUtil::import_numpy())) {
+    LOG_WARN("Fail to load numpy api", K(ret));
     goto destruction;
   }
 
-  gettimeofday(&t4, NULL);
-
-  //根据类型从numpy数组中取出返回值并填入返回值
-  ret_size = PyArray_SIZE((PyArrayObject *)pResult);
-  k = 0;
-  switch (expr.datum_meta_.type_)
-  {
-    case ObCharType:
-    case ObVarcharType:
-    case ObTinyTextType:
-    case ObTextType:
-    case ObMediumTextType:
-    case ObLongTextType: {
-      for (int j = 0; j < batch_size && k < ret_size; j++) {
-        if (my_skip.at(j) || eval_flags.at(j))
-          continue;
-        results[j].set_string(common::ObString(PyUnicode_AsUTF8(
-          PyArray_GETITEM((PyArrayObject *)pResult, (char *)PyArray_GETPTR1((PyArrayObject *)pResult, k++)))));
-      }
-      break;
-    }
-    case ObTinyIntType:
-    case ObSmallIntType:
-    case ObMediumIntType:
-    case ObInt32Type:
-    case ObIntType: {
-      for (int j = 0; j < batch_size && k < ret_size; j++) {
-        if (my_skip.at(j) || eval_flags.at(j))
-          continue;
-        results[j].set_int(PyLong_AsLong(
-          PyArray_GETITEM((PyArrayObject *)pResult, (char *)PyArray_GETPTR1((PyArrayObject *)pResult, k++))));
-      }
-      break;
-    }
-    case ObDoubleType:{
-      for (int j = 0; j < batch_size && k < ret_size; j++) {
-        if (my_skip.at(j) || eval_flags.at(j))
-          continue;
-        results[j].set_double(PyFloat_AsDouble(
-          PyArray_GETITEM((PyArrayObject *)pResult, (char *)PyArray_GETPTR1((PyArrayObject *)pResult, k++))));
-      }
-      break;
-    }
-    case ObNumberType: {
-      //error
-      ret = OB_ERR_UNEXPECTED;
-      LOG_WARN("not support ObNumberType", K(ret));
-      goto destruction;
-    }
-    default: {
-      //error
-      ret = OB_ERR_UNEXPECTED;
-      LOG_WARN("unknown result type", K(ret));
-      goto destruction;
-    }
+  //执行Python Code并获取返回值, 各阶段耗时计入udf_ctx
+  //按udf自身的batch size分次调用, 返回值由udf_ctx持有至下一批次
+  if (OB_FAIL(predict_batch(expr, ctx, *udf_ctx, sel, real_param, results, NULL))) {
+    LOG_WARN("fail to predict python udf batch", K(ret));
+    goto destruction;
+  } else if (OB_FAIL(copy_str_results(expr, ctx, true, sel, real_param, results))) {
+    //字符串结果指向python对象, 拷贝至表达式内存
+    LOG_WARN("fail to copy string results", K(ret));
+    goto destruction;
+  } else if (info->udf_meta_.deterministic_
+             && OB_FAIL(fill_result_cache(expr, ctx, sel, real_param, results))) {
+    LOG_WARN("fail to fill python udf result cache", K(ret));
+    goto destruction;
+  } else {
+    dedup.scatter(results);
   }
-  gettimeofday(&t5, NULL);
 
-  //释放资源
+  //释放资源, 计算结果由udf_ctx持有
   destruction:
-  //释放运行时变量
-  Py_XDECREF(pKwargs);
-  //释放函数参数
-  for (int i = 0; i < expr.arg_cnt_; i++) {
-    if(arrays[i] == NULL)
-      continue;
-    else {
-      PyArray_XDECREF((PyArrayObject *)arrays[i]);
-      //arrays[i] = NULL;
-    }
-  }
-  //arrays = NULL;
-  //delete[] arrays;
-  Py_XDECREF(pArgs);
-  //释放计算结果
-  if(pResult != NULL) {
-    PyArray_XDECREF((PyArrayObject *)pResult);
-    Py_XDECREF(pResult);
-  }
 
   //PyGC_Enable();
   //PyGC_Collect();
 
-  //release GIL
-  if(nStatus)
-    PyGILState_Release(gstate);
-  gettimeofday(&t6, NULL);
-  
-  // 计算运行时间，调整predict size | pjx
-  /*gettimeofday(&t6, NULL);
-  timeuse = (t6.tv_sec - t1.tv_sec) * 1000000 + (double)(t6.tv_usec - t1.tv_usec); // usec
-  double tps = real_param * 1000000 / timeuse; // current tuples per sec
-  if (info->tps_s == 0) { // 初始化
-    info->tps_s = tps;
-    info->predict_size += info->delta; // 尝试调整
-  } else if (info->round > info->round_limit || real_param != info->predict_size) { //超过轮次，停止调整batch size
-    // do nothing
-  } else if (tps > (1 + info->lambda) * info->tps_s) { 
-    // 提升阈值λ为10% 且 目前计算数量与给定batch size相符，重置轮次
-    info->tps_s = tps;
-    info->predict_size += info->delta;
-    info->round = 0;
-  } else if (tps < info->tps_s * (1 - 0.0)) { // 未达到阈值， 且差距较大 ，减小到达阈值的难度，提升轮次
-    // 降低阈值σ
-    info->tps_s = (1 - info->alpha) * info->tps_s + info->alpha * tps; // 平滑系数α
-    info->round++;
-  }*/
-  
-  // 计算运行时间，调整predict size | zcy
-  bool start_query = false;
-  gettimeofday(&t6, NULL);
-  timeuse = (t6.tv_sec - t1.tv_sec) * 1000000 + (double)(t6.tv_usec - t1.tv_usec); // usec
-  double tps = real_param * 1000000 / timeuse; // current tuples per sec
-  if (info->tps_s == 0) { // 初始化
-    info->tps_s = tps;
-    info->predict_size += info->delta; // 尝试调整
-    start_query = true;
-  } else if (info->round > info->round_limit || real_param != info->predict_size) { //超过轮次，停止调整batch size 或 不符合predict size
-    // do nothing
-  } else if (tps > info->tps_s) { 
-    // 提升阈值λ为10% 且 目前计算数量与给定batch size相符，进行调整
-    if (tps < (1 + info->lambda) * info->tps_s)
-      info->round++;
-    info->tps_s = tps;
-    info->predict_size += info->delta;
-  } else { //tps <= info->tps_s
-    // 未达到阈值
-    info->tps_s = (1 - info->alpha) * info->tps_s + info->alpha * tps; // 平滑系数α
-    if (tps > (1 - info->lambda) * info->tps_s)
-      info->round++;
-  }
-  
-  // 插桩 记录运行时间
-  /*double inference_time = (t4.tv_sec - t3.tv_sec) * 1000 + (double)(t4.tv_usec - t3.tv_usec) / 1000;
-  std::string file_name("/home/test/log/");
-  file_name.append(std::string(info->udf_meta_.name_.ptr(), info->udf_meta_.name_.length()));
-  file_name.append(".log");
-  std::fstream f;
-  f.open(file_name, std::ios::out | std::ios::app); // 追加写入
-  if (start_query)
-    f << "Start a new Query!" << std::endl;
-  f << "inference batch size: " << real_param << std::endl;
-  f << "execution time: " << timeuse/1000 << " ms" << std::endl;
-  f << "pre process time: " << (t2.tv_sec - t1.tv_sec) * 1000 + (double)(t2.tv_usec - t1.tv_usec) / 1000 << " ms" << std::endl;
-  f << "ob_py transformation time: " << (t3.tv_sec - t2.tv_sec) * 1000 + (double)(t3.tv_usec - t2.tv_usec) / 1000 << " ms" << std::endl;
-  f << "inference time: " << inference_time << " ms" << std::endl;
-  f << "py_ob transformation time: " << (t5.tv_sec - t4.tv_sec) * 1000 + (double)(t5.tv_usec - t4.tv_usec) / 1000 << " ms" << std::endl;
-  f << "after process time: " << (t6.tv_sec - t5.tv_sec) * 1000 + (double)(t6.tv_usec - t5.tv_usec) / 1000 << " ms" << std::endl;
-  f << "tuples per second: " << tps << std::endl;
-  f << "tps* : " << info->tps_s << std::endl;
-  f << std::endl;
-  f.close();*/
+  //release interpreter
+  interp_guard.release();
+
   return ret;
 }
 
-
-int ObExprPythonUdf::cg_expr(ObExprCGCtx& expr_cg_ctx, const ObRawExpr& raw_expr, ObExpr& rt_expr) const
+int ObExprPythonUdf::eval_tree_udf(const ObExpr &expr, ObEvalCtx &ctx, ObDatum &expr_datum)
 {
   int ret = OB_SUCCESS;
-  //Python UDF Extra Info
-  ObIAllocator &alloc = *expr_cg_ctx.allocator_;
-  const ObPythonUdfRawExpr &fun_sys = static_cast<const ObPythonUdfRawExpr &>(raw_expr);
-  ObPythonUdfInfo *info = OB_NEWx(ObPythonUdfInfo, (&alloc),
-                                   alloc, T_FUN_SYS_PYTHON_UDF);
-  if (NULL == info) {
-    ret = OB_ALLOCATE_MEMORY_FAILED;
-    LOG_WARN("allocate memory failed", K(ret));
-  } else {
-    OZ(info->from_raw_expr(fun_sys));
-    rt_expr.extra_info_ = info;
-  }
-  //绑定eval
-  rt_expr.eval_func_ = ObExprPythonUdf::eval_test_udf;
-  //绑定向量化eval
-  bool is_batch = true;
-  for(int i = 0; i < rt_expr.arg_cnt_; i++){
-    if(!rt_expr.args_[i]->is_batch_result() && !rt_expr.args_[i]->is_const_expr()) {
-      is_batch = false;
-      break;
+  const int32_t sel[1] = {0}; // single row
+  bool has_null = false;
+  ObDatum *arg_datum = NULL;
+  for (int64_t i = 0; OB_SUCC(ret) && !has_null && i < expr.arg_cnt_; i++) {
+    if (OB_FAIL(expr.args_[i]->eval(ctx, arg_datum))) {
+      LOG_WARN("fail to obtain arg", K(ret), K(i));
+    } else {
+      has_null = arg_datum->is_null();
     }
   }
-  if(is_batch) {
-    rt_expr.eval_batch_func_ = ObExprPythonUdf::eval_test_udf_batch;
-  } else {
-    rt_expr.extra_buf_.buf_flag_ = false;
+  if (OB_FAIL(ret)) {
+  } else if (has_null) {
+    expr_datum.set_null();
+  } else if (OB_FAIL(predict_trees(expr, ctx, false, sel, 1, &expr_datum))) {
+    LOG_WARN("fail to score tree model", K(ret));
   }
   return ret;
 }
 
-//异常输出
-void ObExprPythonUdf::message_error_dialog_show(char* buf) {
-  const char* folder_dir = "/home/obtest/log/";
-  if (access(folder_dir, 0) == -1) {
-    // 不存在该文件夹则创建
-    mkdir(folder_dir, S_IRWXU);
-  } else {
-    // 存在该文件夹则写入异常信息
-    std::ofstream ofile;
-    if (ofile) {
-      ofile.open("/home/obtest/log/python_error", std::ios::out);
-      ofile << buf;
-      ofile.close();
-    }
-  }
+int ObExprPythonUdf::eval_tree_udf_batch(const ObExpr &expr, ObEvalCtx &ctx,
+                                         const ObBitVector &skip, const int64_t batch_size)
+{
+  int ret = OB_SUCCESS;
+  ObDatum *results = expr.locate_batch_datums(ctx);
+  ObEvalCtx::TempAllocGuard alloc_guard(ctx);
+  int32_t *sel = NULL;
+  int64_t sel_cnt = 0;
+  if (OB_FAIL(eval_args_batch(expr, ctx, skip, batch_size))) {
+    LOG_WARN("failed to eval batch result args", K(ret));
+  } else if (OB_ISNULL(sel = static_cast<int32_t *>(
+      alloc_guard.get_allocator().alloc(sizeof(int32_t) * (batch_size > 0 ? batch_size : 1))))) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("Fail to allocate selection vector", K(ret), K(batch_size));
+  } else if (FALSE_IT(sel_cnt = ObPythonUdfUtil::build_selection(expr.get_pvt_skip(ctx),
+                                                                 expr.get_evaluated_flags(ctx),
+                                                                 batch_size, sel))) {
+  } else if (sel_cnt > 0 && OB_FAIL(predict_trees(expr, ctx, true, sel, sel_cnt, results))) {
+    LOG_WARN("fail to score tree model", K(ret));
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::predict_trees(const ObExpr &expr, ObEvalCtx &ctx, const bool is_batch,
+                                   const int32_t *sel, const int64_t sel_cnt, ObDatum *results)
+{
+  int ret = OB_SUCCESS;
+  const ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr.extra_info_);
+  ObEvalCtx::TempAllocGuard alloc_guard(ctx);
+  ObIAllocator &tmp_alloc = alloc_guard.get_allocator();
+  double *features = NULL;
+  double *scores = NULL;
+  if (OB_ISNULL(info) || OB_UNLIKELY(!info->tree_model_.is_inited())) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("tree model of the udf is not built", K(ret), KP(info));
+  } else if (OB_UNLIKELY(info->tree_model_.get_feature_cnt() > expr.arg_cnt_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("tree model uses more features than args", K(ret), K(info->tree_model_));
+  } else if (OB_ISNULL(features = static_cast<double *>(
+                 tmp_alloc.alloc(sizeof(double) * sel_cnt * (expr.arg_cnt_ > 0 ? expr.arg_cnt_ : 1))))
+             || OB_ISNULL(scores = static_cast<double *>(tmp_alloc.alloc(sizeof(double) * sel_cnt)))) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("fail to allocate tree model features", K(ret), K(sel_cnt));
+  } else {
+    // one column of features per arg, in the order of sel
+    for (int64_t i = 0; OB_SUCC(ret) && i < expr.arg_cnt_; i++) {
+      const ObExpr *arg = expr.args_[i];
+      const ObDatum *datums = is_batch ? arg->locate_batch_datums(ctx)
+                                       : &expr.locate_param_datum(ctx, i);
+      const bool is_const = !is_batch || !arg->is_batch_result();
+      double *col = features + i * sel_cnt;
+      if (ob_is_int_tc(arg->datum_meta_.type_)) {
+        for (int64_t k = 0; k < sel_cnt; k++) {
+          col[k] = static_cast<double>(datums[is_const ? 0 : sel[k]].get_int());
+        }
+      } else if (ObDoubleType == arg->datum_meta_.type_) {
+        for (int64_t k = 0; k < sel_cnt; k++) {
+          col[k] = datums[is_const ? 0 : sel[k]].get_double();
+        }
+      } else if (ObFloatType == arg->datum_meta_.type_) {
+        for (int64_t k = 0; k < sel_cnt; k++) {
+          col[k] = datums[is_const ? 0 : sel[k]].get_float();
+        }
+      } else {
+        ret = OB_NOT_SUPPORTED;
+        LOG_WARN("arg type of tree model udf is not supported", K(ret), K(i),
+                 K(arg->datum_meta_.type_));
+      }
+    }
+  }
+  if (OB_SUCC(ret)) {
+    info->tree_model_.score(features, sel_cnt, scores);
+    for (int64_t k = 0; k < sel_cnt; k++) {
+      results[sel[k]].set_double(scores[k]);
+    }
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::eval_args_batch(const ObExpr &expr, ObEvalCtx &ctx,
+                                     const ObBitVector &skip, const int64_t batch_size)
+{
+  int ret = OB_SUCCESS;
+  ObDatum *results = expr.locate_batch_datums(ctx);
+  ObBitVector &eval_flags = expr.get_evaluated_flags(ctx);
+  ObBitVector &my_skip = expr.get_pvt_skip(ctx);
+  my_skip.deep_copy(skip, batch_size);
+  for (int64_t i = 0; OB_SUCC(ret) && i < expr.arg_cnt_; i++) {
+    if (OB_FAIL(expr.args_[i]->eval_batch(ctx, my_skip, batch_size))) {
+      LOG_WARN("failed to eval batch result args", K(ret), K(i));
+    } else {
+      ObDatum *datum_array = expr.args_[i]->locate_batch_datums(ctx);
+      const bool is_batch = expr.args_[i]->is_batch_result();
+      for (int64_t j = 0; j < batch_size; j++) {
+        if (my_skip.at(j) || eval_flags.at(j)) {
+        } else if (datum_array[is_batch ? j : 0].is_null()) {
+          //存在null推理结果即为空
+          results[j].set_null();
+          my_skip.set(j);
+          eval_flags.set(j);
+        }
+      }
+    }
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::build_cache_key(const ObExpr &expr, ObEvalCtx &ctx, const int64_t row,
+                                     ObIAllocator &alloc, ObPyResultCacheKey &key)
+{
+  int ret = OB_SUCCESS;
+  const ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr.extra_info_);
+  int64_t len = 0;
+  int64_t pos = 0;
+  char *buf = NULL;
+  for (int64_t i = 0; i < expr.arg_cnt_; i++) {
+    const ObDatum *datums = expr.args_[i]->locate_batch_datums(ctx);
+    len += sizeof(int32_t) + datums[expr.args_[i]->is_batch_result() ? row : 0].len_;
+  }
+  if (OB_ISNULL(info)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python udf info is null", K(ret));
+  } else if (OB_ISNULL(buf = static_cast<char *>(alloc.alloc(len > 0 ? len : 1)))) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("fail to allocate result cache key", K(ret), K(len));
+  } else {
+    // arg types are fixed by the udf, the length prefix keeps the args apart
+    for (int64_t i = 0; i < expr.arg_cnt_; i++) {
+      const ObDatum *datums = expr.args_[i]->locate_batch_datums(ctx);
+      const ObDatum &arg = datums[expr.args_[i]->is_batch_result() ? row : 0];
+      const int32_t arg_len = static_cast<int32_t>(arg.len_);
+      MEMCPY(buf + pos, &arg_len, sizeof(arg_len));
+      pos += sizeof(arg_len);
+      MEMCPY(buf + pos, arg.ptr_, arg_len);
+      pos += arg_len;
+    }
+    key = ObPyResultCacheKey(MTL_ID(), info->udf_meta_.udf_id_, info->udf_meta_.schema_version_,
+                             ObString(pos, buf));
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::dedup_batch(const ObExpr &expr, ObEvalCtx &ctx, ObIAllocator &alloc,
+                                 const int64_t batch_size, ObPyBatchDedup &dedup,
+                                 int32_t *sel, int64_t &sel_cnt)
+{
+  int ret = OB_SUCCESS;
+  ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr.extra_info_);
+  const int64_t row_cnt = sel_cnt;
+  dedup.reuse();
+  if (OB_ISNULL(info)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python udf info is null", K(ret));
+  } else if (!info->dedup_stat_.need_dedup(row_cnt)) {
+  } else if (OB_FAIL(dedup.prepare(alloc, batch_size))) {
+    LOG_WARN("fail to prepare dedup buffers", K(ret), K(batch_size));
+  } else if (OB_FAIL(dedup.dedup(expr, ctx, sel, sel_cnt))) {
+    LOG_WARN("fail to deduplicate batch", K(ret), K(row_cnt));
+  } else {
+    info->dedup_stat_.add_batch(row_cnt, sel_cnt);
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::probe_result_cache(const ObExpr &expr, ObEvalCtx &ctx,
+                                        const int64_t batch_size)
+{
+  int ret = OB_SUCCESS;
+  ObPyResultCache &cache = ObPyResultCache::get_instance();
+  ObDatum *results = expr.locate_batch_datums(ctx);
+  ObBitVector &eval_flags = expr.get_evaluated_flags(ctx);
+  ObBitVector &my_skip = expr.get_pvt_skip(ctx);
+  ObEvalCtx::TempAllocGuard alloc_guard(ctx);
+  ObIAllocator &tmp_alloc = alloc_guard.get_allocator();
+  const ObPythonUdfUtil::PyColumnType col_type =
+      ObPythonUdfUtil::get_column_type(expr.datum_meta_.type_);
+  int64_t hit_cnt = 0;
+  int64_t miss_cnt = 0;
+  for (int64_t i = 0; OB_SUCC(ret) && cache.is_inited() && i < batch_size; i++) {
+    ObPyResultCacheKey key;
+    const ObPyResultCacheValue *value = NULL;
+    ObKVCacheHandle handle;
+    int tmp_ret = OB_SUCCESS;
+    char *buf = NULL;
+    if (my_skip.at(i) || eval_flags.at(i)) {
+    } else if (OB_FAIL(build_cache_key(expr, ctx, i, tmp_alloc, key))) {
+      LOG_WARN("fail to build result cache key", K(ret), K(i));
+    } else if (OB_SUCCESS != (tmp_ret = cache.get_result(key, value, handle))) {
+      ++miss_cnt;
+    } else if (value->datum_.is_null()) {
+      results[i].set_null();
+    } else if (ObPythonUdfUtil::PY_COL_INTEGER == col_type) {
+      results[i].set_int(value->datum_.get_int());
+    } else if (ObPythonUdfUtil::PY_COL_REAL == col_type) {
+      results[i].set_double(value->datum_.get_double());
+    } else if (ObPythonUdfUtil::PY_COL_STRING != col_type) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("unknown result type", K(ret), K(expr.datum_meta_.type_));
+    } else if (0 == value->datum_.len_) {
+      results[i].set_string(NULL, 0);
+    } else if (OB_ISNULL(buf = expr.get_str_res_mem(ctx, value->datum_.len_, i))) {
+      ret = OB_ALLOCATE_MEMORY_FAILED;
+      LOG_WARN("fail to allocate string result", K(ret), K(value->datum_.len_));
+    } else {
+      MEMCPY(buf, value->datum_.ptr_, value->datum_.len_);
+      results[i].set_string(buf, value->datum_.len_);
+    }
+    if (OB_SUCC(ret) && NULL != value) {
+      eval_flags.set(i);
+      ++hit_cnt;
+    }
+  }
+  if (hit_cnt + miss_cnt > 0) {
+    (void)cache.add_stat(MTL_ID(), hit_cnt, miss_cnt, 0);
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::fill_result_cache(const ObExpr &expr, ObEvalCtx &ctx, const int32_t *sel,
+                                       const int64_t sel_cnt, const ObDatum *results)
+{
+  int ret = OB_SUCCESS;
+  ObPyResultCache &cache = ObPyResultCache::get_instance();
+  ObEvalCtx::TempAllocGuard alloc_guard(ctx);
+  ObIAllocator &tmp_alloc = alloc_guard.get_allocator();
+  int64_t put_cnt = 0;
+  for (int64_t k = 0; OB_SUCC(ret) && cache.is_inited() && k < sel_cnt; k++) {
+    ObPyResultCacheKey key;
+    int tmp_ret = OB_SUCCESS;
+    if (results[sel[k]].is_null()) {
+      // not a result of the udf, the row was not returned
+    } else if (OB_FAIL(build_cache_key(expr, ctx, sel[k], tmp_alloc, key))) {
+      LOG_WARN("fail to build result cache key", K(ret), K(k));
+    } else if (OB_SUCCESS == (tmp_ret = cache.put_result(key, results[sel[k]]))) {
+      ++put_cnt;
+    } else if (OB_ENTRY_EXIST != tmp_ret) {
+      // no memory left for the cache, the rest of the batch would not fit either
+      break;
+    }
+  }
+  if (put_cnt > 0) {
+    (void)cache.add_stat(MTL_ID(), 0, 0, put_cnt);
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::predict(const ObExpr &expr, ObEvalCtx &ctx, ObPythonUdfExprCtx &udf_ctx,
+                             const int32_t *sel, const int64_t sel_cnt,
+                             ObDatum *results, PyObject *&result,
+                             ObPySharedArgs *shared_args)
+{
+  int ret = OB_SUCCESS;
+  ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr.extra_info_);
+  ObSEArray<PyObject *, 8> arrays;
+  PyObject *args = NULL;
+  int64_t ret_size = 0;
+  int64_t batch_size = 0;
+  const int64_t begin_cycles = rdtsc();
+  const int64_t begin_us = ObTimeUtility::current_monotonic_time();
+  int64_t ob2py_end = 0;
+  int64_t infer_end = 0;
+  result = NULL;
+  if (OB_ISNULL(info)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python udf info is null", K(ret));
+  } else if (FALSE_IT(batch_size = info->batch_tuner_.get_batch_size())) {
+  } else if (OB_FAIL(udf_ctx.prepare_arrays(expr, sel_cnt > batch_size ? sel_cnt : batch_size))) {
+    LOG_WARN("Fail to prepare numpy arrays", K(ret));
+  }
+  //传递udf运行时参数: 按列填充预分配的numpy数组, 同一次调用中其他udf已转换的参数直接复用
+  for (int64_t i = 0; OB_SUCC(ret) && i < expr.arg_cnt_; i++) {
+    PyObject *array = NULL;
+    // scalars of constant args are cheap and differ by ARG_PASSING, not shared
+    const bool shareable = NULL != shared_args && !udf_ctx.is_scalar_arg(*expr.args_[i]);
+    if (shareable && NULL != (array = shared_args->find(expr.args_[i], sel, sel_cnt))) {
+      shared_args->inc_reuse_cnt();
+    } else if (OB_FAIL(udf_ctx.fill_array(i, *expr.args_[i], ctx, sel, sel_cnt))) {
+      LOG_WARN("fail to convert datums to numpy array", K(ret), K(i));
+    } else if (FALSE_IT(array = udf_ctx.get_array(i))) {
+    } else if (shareable
+               && OB_FAIL(shared_args->add(expr.args_[i], array, sel, sel_cnt))) {
+      LOG_WARN("fail to share numpy array", K(ret), K(i));
+    }
+    if (OB_SUCC(ret) && OB_FAIL(arrays.push_back(array))) {
+      LOG_WARN("fail to push back numpy array", K(ret), K(i));
+    }
+  }
+  if (OB_FAIL(ret)) {
+  } else if (OB_FAIL(udf_ctx.build_args(sel_cnt, arrays.get_data(), args))) {
+    LOG_WARN("fail to build numpy array args", K(ret));
+  } else if (FALSE_IT(ob2py_end = rdtsc())) {
+  } else if (OB_ISNULL(result = PyObject_Call(udf_ctx.get_pyfun(), args,
+                                               udf_ctx.get_kwargs()))) {
+    process_python_exception();
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("execute error", K(ret));
+  } else if (FALSE_IT(infer_end = rdtsc())) {
+  } else if (OB_FAIL(ObPythonUdfUtil::numpy_to_datums(expr.datum_meta_.type_, result,
+                                                      sel, sel_cnt, results, ret_size))) {
+    LOG_WARN("fail to convert numpy array to datums", K(ret));
+  } else {
+    if (ObPythonUDF::POSITIONAL != udf_ctx.get_arg_passing() && 1 == ret_size && sel_cnt > 1
+        && ObPythonUdfUtil::is_scalar(result)) {
+      // a scalar result of a udf that broadcasts holds for every row
+      for (int64_t k = 1; k < sel_cnt; k++) {
+        results[sel[k]] = results[sel[0]];
+      }
+      ret_size = sel_cnt;
+    }
+    const int64_t end_cycles = rdtsc();
+    ObPyUdfStageStat stat;
+    stat.batch_cnt_ = 1;
+    stat.row_cnt_ = sel_cnt;
+    stat.ob2py_cycles_ = ob2py_end - begin_cycles;
+    stat.infer_cycles_ = infer_end - ob2py_end;
+    stat.py2ob_cycles_ = end_cycles - infer_end;
+    stat.batch_size_ = batch_size;
+    udf_ctx.add_stat(*info, stat);
+    info->batch_tuner_.add_sample(ObPyBatchSample(sel_cnt, end_cycles - begin_cycles,
+        ObTimeUtility::current_monotonic_time() - begin_us));
+    LOG_DEBUG("python udf batch converted", K(sel_cnt), K(ret_size), K(stat));
+  }
+  //释放参数引用, 参数数组及元组由udf_ctx持有
+  if (NULL != args) {
+    udf_ctx.release_args();
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::predict_arrow(const ObExpr &expr, ObEvalCtx &ctx,
+                                   ObPythonUdfExprCtx &udf_ctx, const bool is_batch,
+                                   const int32_t *sel, const int64_t sel_cnt,
+                                   ObDatum *results, PyObject *&result)
+{
+  int ret = OB_SUCCESS;
+  ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr.extra_info_);
+  ArrowSchema schema;
+  ArrowArray array;
+  ArrowSchema res_schema;
+  ArrowArray res_array;
+  PyObject *batch = NULL;
+  PyObject *ret_obj = NULL;
+  int64_t ret_size = 0;
+  const int64_t begin_cycles = rdtsc();
+  const int64_t begin_us = ObTimeUtility::current_monotonic_time();
+  int64_t ob2py_end = 0;
+  int64_t infer_end = 0;
+  MEMSET(&schema, 0, sizeof(schema));
+  MEMSET(&array, 0, sizeof(array));
+  MEMSET(&res_schema, 0, sizeof(res_schema));
+  MEMSET(&res_array, 0, sizeof(res_array));
+  bool has_null = false;
+  result = NULL;
+  // rows of a batch with a null arg are filtered by eval_args_batch
+  for (int64_t i = 0; !is_batch && !has_null && i < expr.arg_cnt_; i++) {
+    has_null = expr.locate_param_datum(ctx, i).is_null();
+  }
+  if (OB_ISNULL(info) || OB_ISNULL(udf_ctx.get_import_batch())) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python udf info or pyarrow handler is null", K(ret), KP(info));
+  } else if (has_null) {
+    results[sel[0]].set_null();
+  } else if (OB_FAIL(ObPyArrowBatch::export_batch(expr, ctx, is_batch, sel, sel_cnt,
+                                                  schema, array))) {
+    LOG_WARN("fail to export arrow batch", K(ret));
+  } else if (OB_ISNULL(batch = PyObject_CallFunction(udf_ctx.get_import_batch(), "KK",
+             static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(&array)),
+             static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(&schema))))) {
+    process_python_exception();
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("fail to import arrow batch into pyarrow", K(ret));
+  } else if (FALSE_IT(ob2py_end = rdtsc())) {
+  } else if (OB_ISNULL(result = PyObject_CallFunctionObjArgs(udf_ctx.get_pyfun(), batch, NULL))) {
+    process_python_exception();
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("execute error", K(ret));
+  } else if (FALSE_IT(infer_end = rdtsc())) {
+  } else if (PyObject_HasAttrString(result, "combine_chunks")) {
+    // pyarrow.ChunkedArray, e.g. a column of a pyarrow.Table
+    if (OB_ISNULL(ret_obj = PyObject_CallMethod(result, "combine_chunks", NULL))) {
+      process_python_exception();
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("fail to combine chunks of arrow result", K(ret));
+    } else {
+      Py_DECREF(result);
+      result = ret_obj;
+      ret_obj = NULL;
+    }
+  }
+  if (OB_FAIL(ret) || has_null) {
+  } else if (PyObject_HasAttrString(result, "_export_to_c")) {
+    // buffers of the exported array are kept alive by result, strings point into them
+    if (OB_ISNULL(ret_obj = PyObject_CallMethod(result, "_export_to_c", "KK",
+                static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(&res_array)),
+                static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(&res_schema))))) {
+      process_python_exception();
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("fail to export arrow result from pyarrow", K(ret));
+    } else if (OB_FAIL(ObPyArrowBatch::import_result(expr.datum_meta_.type_, res_schema,
+                                                     res_array, sel, sel_cnt, results,
+                                                     ret_size))) {
+      LOG_WARN("fail to import arrow result", K(ret));
+    }
+  } else if (OB_FAIL(ObPythonUdfUtil::numpy_to_datums(expr.datum_meta_.type_, result,
+                                                      sel, sel_cnt, results, ret_size))) {
+    LOG_WARN("fail to convert numpy array to datums", K(ret));
+  }
+  if (OB_SUCC(ret) && !has_null) {
+    for (int64_t k = ret_size; k < sel_cnt; k++) {
+      results[sel[k]].set_null();
+    }
+    if (!is_batch && OB_FAIL(copy_str_results(expr, ctx, false, sel, sel_cnt, results))) {
+      LOG_WARN("fail to copy string results", K(ret));
+    } else {
+      const int64_t end_cycles = rdtsc();
+      ObPyUdfStageStat stat;
+      stat.batch_cnt_ = 1;
+      stat.row_cnt_ = sel_cnt;
+      stat.ob2py_cycles_ = ob2py_end - begin_cycles;
+      stat.infer_cycles_ = infer_end - ob2py_end;
+      stat.py2ob_cycles_ = end_cycles - infer_end;
+      stat.batch_size_ = is_batch ? info->batch_tuner_.get_batch_size() : 1;
+      udf_ctx.add_stat(*info, stat);
+      info->batch_tuner_.add_sample(ObPyBatchSample(sel_cnt, end_cycles - begin_cycles,
+          ObTimeUtility::current_monotonic_time() - begin_us));
+      LOG_DEBUG("python udf arrow batch converted", K(sel_cnt), K(ret_size), K(stat));
+    }
+  }
+  // structures not moved into pyarrow are released here
+  if (NULL != res_array.release) {
+    res_array.release(&res_array);
+  }
+  if (NULL != res_schema.release) {
+    res_schema.release(&res_schema);
+  }
+  if (NULL != array.release) {
+    array.release(&array);
+  }
+  if (NULL != schema.release) {
+    schema.release(&schema);
+  }
+  Py_XDECREF(ret_obj);
+  Py_XDECREF(batch);
+  return ret;
+}
+
+int ObExprPythonUdf::predict_batch(const ObExpr &expr, ObEvalCtx &ctx,
+                                   ObPythonUdfExprCtx &udf_ctx,
+                                   const int32_t *sel, const int64_t sel_cnt,
+                                   ObDatum *results, ObPySharedArgs *shared_args)
+{
+  int ret = OB_SUCCESS;
+  ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr.extra_info_);
+  int64_t call_size = 0;
+  udf_ctx.release_pending_results();
+  if (OB_ISNULL(info)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python udf info is null", K(ret));
+  } else if (FALSE_IT(call_size = info->batch_tuner_.get_batch_size())) {
+  } else if (OB_UNLIKELY(call_size <= 0)) {
+    call_size = sel_cnt;
+  }
+  for (int64_t start = 0; OB_SUCC(ret) && start < sel_cnt; start += call_size) {
+    const int64_t cnt = std::min(call_size, sel_cnt - start);
+    PyObject *result = NULL;
+    int tmp_ret = OB_SUCCESS;
+    if (ObPythonUDF::ARROW == info->udf_meta_.batch_format_) {
+      if (OB_FAIL(predict_arrow(expr, ctx, udf_ctx, true, sel + start, cnt, results, result))) {
+        LOG_WARN("fail to predict python udf rows in arrow", K(ret), K(start), K(cnt));
+      }
+    } else if (OB_FAIL(predict(expr, ctx, udf_ctx, sel + start, cnt, results, result,
+                               shared_args))) {
+      LOG_WARN("fail to predict python udf rows", K(ret), K(start), K(cnt));
+    }
+    if (NULL != result && OB_SUCCESS != (tmp_ret = udf_ctx.add_pending_result(result))) {
+      LOG_WARN("fail to keep python udf result", K(tmp_ret));
+      Py_DECREF(result);
+      ret = OB_SUCC(ret) ? tmp_ret : ret;
+    }
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::get_expr_ctx(const ObExpr &expr, ObEvalCtx &ctx,
+                                  ObPythonUdfExprCtx *&udf_ctx)
+{
+  int ret = OB_SUCCESS;
+  const ObPhysicalPlanCtx *plan_ctx = NULL;
+  udf_ctx = static_cast<ObPythonUdfExprCtx *>(ctx.exec_ctx_.get_expr_op_ctx(expr.expr_ctx_id_));
+  if (NULL != udf_ctx) {
+  } else if (OB_FAIL(ctx.exec_ctx_.create_expr_op_ctx(expr.expr_ctx_id_, udf_ctx))) {
+    LOG_WARN("failed to create python udf ctx", K(ret));
+  } else if (OB_ISNULL(udf_ctx)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python udf ctx is null", K(ret));
+  } else if (NULL != (plan_ctx = ctx.exec_ctx_.get_physical_plan_ctx())
+             && NULL != plan_ctx->get_phy_plan()) {
+    udf_ctx->set_plan_id(plan_ctx->get_phy_plan()->get_plan_id());
+  }
+  if (OB_SUCC(ret) && OB_FAIL(udf_ctx->init_handles(expr, ctx.exec_ctx_.get_allocator()))) {
+    LOG_WARN("failed to init python udf handles", K(ret));
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::get_udf_ctx(const ObExpr &expr, ObEvalCtx &ctx, ObPyInterpreterGuard &guard,
+                                 ObPythonUdfExprCtx *&udf_ctx)
+{
+  int ret = OB_SUCCESS;
+  const ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr.extra_info_);
+  ObPyUdfStageStat stat;
+  int64_t begin_cycles = 0;
+  if (OB_ISNULL(info)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python udf info is null", K(ret));
+  } else if (OB_FAIL(get_expr_ctx(expr, ctx, udf_ctx))) {
+    LOG_WARN("failed to get python udf ctx", K(ret));
+  } else if (guard.is_acquired()) {
+  } else if (FALSE_IT(begin_cycles = rdtsc())) {
+  } else if (OB_FAIL(guard.acquire())) {
+    LOG_WARN("failed to acquire python interpreter", K(ret));
+  } else {
+    stat.gil_wait_cycles_ = rdtsc() - begin_cycles;
+    udf_ctx->add_stat(*info, stat);
+  }
+  if (OB_FAIL(ret)) {
+  } else if (udf_ctx->is_valid(info->udf_meta_)) {
+    // cached handles are still usable
+  } else if (OB_FAIL(udf_ctx->resolve(expr, *info, guard))) {
+    LOG_WARN("failed to resolve python udf handles", K(ret), KPC(udf_ctx));
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::build_worker_args(const ObExpr &expr, ObEvalCtx &ctx, const bool is_batch,
+                                       ObPyWorkerArg *args, bool &has_null)
+{
+  int ret = OB_SUCCESS;
+  has_null = false;
+  if (OB_UNLIKELY(expr.arg_cnt_ > ObPyWorkerBatchHeader::MAX_ARG_CNT)) {
+    ret = OB_NOT_SUPPORTED;
+    LOG_WARN("too many arguments for python worker", K(ret), K(expr.arg_cnt_));
+    LOG_USER_ERROR(OB_NOT_SUPPORTED, "python udf with more than 64 arguments in worker");
+  } else {
+    for (int64_t i = 0; i < expr.arg_cnt_; i++) {
+      const ObDatum *datums = is_batch ? expr.args_[i]->locate_batch_datums(ctx)
+                                       : &expr.locate_param_datum(ctx, i);
+      // null args are filtered out of sel in batch mode
+      has_null = has_null || (!is_batch && datums->is_null());
+      args[i] = ObPyWorkerArg(expr.args_[i]->datum_meta_.type_, datums,
+                              !is_batch || !expr.args_[i]->is_batch_result());
+    }
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::copy_str_results(const ObExpr &expr, ObEvalCtx &ctx, const bool is_batch,
+                                      const int32_t *sel, const int64_t sel_cnt, ObDatum *results)
+{
+  int ret = OB_SUCCESS;
+  int64_t total = 0;
+  char *buf = NULL;
+  for (int64_t k = 0; ob_is_string_type(expr.datum_meta_.type_) && k < sel_cnt; k++) {
+    const ObDatum &res = results[sel[k]];
+    total += res.is_null() ? 0 : res.len_;
+  }
+  // one chunk for the strings of all rows, the reserved buffer of the first row
+  if (0 == total) {
+  } else if (OB_ISNULL(buf = is_batch ? expr.get_str_res_mem(ctx, total, sel[0])
+                                      : expr.get_str_res_mem(ctx, total))) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("fail to allocate string results", K(ret), K(total), K(sel_cnt));
+  } else {
+    for (int64_t k = 0; k < sel_cnt; k++) {
+      ObDatum &res = results[sel[k]];
+      if (!res.is_null() && res.len_ > 0) {
+        MEMCPY(buf, res.ptr_, res.len_);
+        res.ptr_ = buf;
+        buf += res.len_;
+      }
+    }
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::eval_udf_in_worker(const ObExpr &expr, ObEvalCtx &ctx,
+                                        const int32_t *sel, const int64_t sel_cnt,
+                                        const bool is_batch, ObDatum *results)
+{
+  int ret = OB_SUCCESS;
+  ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr.extra_info_);
+  ObPyWorkerGuard guard(MTL(ObPyWorkerPool*));
+  ObPyWorkerChannel *channel = NULL;
+  ObPyWorkerArg args[ObPyWorkerBatchHeader::MAX_ARG_CNT];
+  ObPythonUdfExprCtx *udf_ctx = NULL;
+  ObPyUdfStageStat stat;
+  bool has_null = false;
+  int64_t call_size = sel_cnt;
+  int64_t acquire_begin = 0;
+  if (OB_ISNULL(info) || OB_ISNULL(sel) || OB_ISNULL(results)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("unexpected null", K(ret), KP(info), KP(sel), KP(results));
+  } else if (OB_FAIL(get_expr_ctx(expr, ctx, udf_ctx))) {
+    LOG_WARN("failed to get python udf ctx", K(ret));
+  } else if (OB_FAIL(build_worker_args(expr, ctx, is_batch, args, has_null))) {
+    LOG_WARN("fail to build python worker args", K(ret));
+  } else if (has_null) {
+    results[sel[0]].set_null();
+  } else if (FALSE_IT(acquire_begin = rdtsc())) {
+  } else if (OB_FAIL(guard.acquire())) {
+    LOG_WARN("fail to acquire python worker", K(ret));
+  } else if (FALSE_IT(stat.gil_wait_cycles_ = rdtsc() - acquire_begin)) {
+  } else if (OB_ISNULL(channel = guard.get_channel())) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python worker channel is null", K(ret));
+  } else if (is_batch && info->batch_tuner_.get_batch_size() > 0) {
+    // requests of the batch size of the udf, or less if the channel buffer is smaller
+    call_size = info->batch_tuner_.get_batch_size();
+  }
+  for (int64_t start = 0, write_cnt = 0, ret_cnt = 0;
+       OB_SUCC(ret) && NULL != channel && start < sel_cnt; start += write_cnt) {
+    const int64_t begin_cycles = rdtsc();
+    const int64_t begin_us = ObTimeUtility::current_monotonic_time();
+    if (OB_FAIL(channel->write_batch(info->udf_meta_, args, expr.arg_cnt_, expr.datum_meta_.type_,
+                                     sel + start, std::min(call_size, sel_cnt - start),
+                                     write_cnt))) {
+      LOG_WARN("fail to write batch to python worker", K(ret));
+    } else if (OB_FAIL(channel->run())) {
+      LOG_WARN("fail to run batch in python worker", K(ret));
+    } else if (OB_FAIL(channel->read_result(expr.datum_meta_.type_, sel + start, write_cnt,
+                                            results, ret_cnt))) {
+      LOG_WARN("fail to read python worker result", K(ret));
+    } else {
+      for (int64_t k = start + ret_cnt; k < start + write_cnt; k++) {
+        results[sel[k]].set_null();
+      }
+      // string results point into the channel buffer, copy them out before the next batch
+      if (OB_FAIL(copy_str_results(expr, ctx, is_batch, sel + start, ret_cnt, results))) {
+        LOG_WARN("fail to copy string results", K(ret));
+      } else {
+        const int64_t end_cycles = rdtsc();
+        stat.batch_cnt_ = 1;
+        stat.row_cnt_ = write_cnt;
+        stat.infer_cycles_ = end_cycles - begin_cycles;
+        stat.batch_size_ = call_size;
+        udf_ctx->add_stat(*info, stat);
+        stat.reset();
+        if (is_batch) {
+          info->batch_tuner_.add_sample(ObPyBatchSample(write_cnt, end_cycles - begin_cycles,
+              ObTimeUtility::current_monotonic_time() - begin_us));
+        }
+      }
+    }
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::eval_batch_async(const ObExpr &expr, ObEvalCtx &ctx, const ObBitVector &skip,
+                                      const int64_t batch_size, ObPyCallThread &call_thread,
+                                      ObPyUdfGroupTask *group_task)
+{
+  int ret = OB_SUCCESS;
+  const ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr.extra_info_);
+  ObPythonUdfExprCtx *udf_ctx = NULL;
+  ObPyWorkerArg args[ObPyWorkerBatchHeader::MAX_ARG_CNT];
+  bool has_null = false;
+  int64_t write_cnt = 0;
+  expr.get_evaluated_flags(ctx).reset(batch_size);
+  // args are evaluated here, the helper thread only reads their datums
+  if (OB_ISNULL(info)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python udf info is null", K(ret));
+  } else if (ObPythonUDF::TREES == info->udf_meta_.language_) {
+    // native scoring is cheaper than handing the batch over, nothing is left to wait for
+    if (OB_FAIL(eval_tree_udf_batch(expr, ctx, skip, batch_size))) {
+      LOG_WARN("fail to eval tree model udf", K(ret));
+    }
+  } else if (OB_FAIL(eval_args_batch(expr, ctx, skip, batch_size))) {
+    LOG_WARN("failed to eval batch result args", K(ret));
+  } else if (info->udf_meta_.deterministic_ && OB_FAIL(probe_result_cache(expr, ctx, batch_size))) {
+    LOG_WARN("failed to probe python udf result cache", K(ret));
+  } else if (OB_FAIL(get_expr_ctx(expr, ctx, udf_ctx))) {
+    LOG_WARN("failed to get python udf ctx", K(ret));
+  } else {
+    ObPyUdfBatchTask &task = udf_ctx->get_task();
+    if (OB_UNLIKELY(ObPyUdfBatchTask::IDLE != task.state_)) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("previous python udf batch is not waited", K(ret), K(task));
+    } else if (OB_FAIL(task.prepare_sel(ctx.exec_ctx_.get_allocator(), batch_size))) {
+      LOG_WARN("fail to prepare selection vector", K(ret), K(batch_size));
+    } else {
+      task.expr_ = &expr;
+      task.eval_ctx_ = &ctx;
+      task.udf_ctx_ = udf_ctx;
+      task.sel_cnt_ = ObPythonUdfUtil::build_selection(expr.get_pvt_skip(ctx),
+                                                       expr.get_evaluated_flags(ctx),
+                                                       batch_size, task.sel_);
+      if (task.sel_cnt_ > 0
+          && OB_FAIL(dedup_batch(expr, ctx, ctx.exec_ctx_.get_allocator(), batch_size,
+                                 task.dedup_, task.sel_, task.sel_cnt_))) {
+        LOG_WARN("fail to deduplicate python udf batch", K(ret));
+      }
+    }
+    if (OB_FAIL(ret) || 0 == task.sel_cnt_) {
+      //all rows are skipped, null or cached, nothing to predict
+    } else if (share::schema::ObPythonUDF::WORKER != info->udf_meta_.exec_mode_) {
+      task.run_ret_ = OB_SUCCESS;
+      if (NULL != group_task) {
+        if (OB_FAIL(group_task->add_task(task))) {
+          LOG_WARN("fail to add python udf batch to group", K(ret));
+        } else {
+          task.state_ = ObPyUdfBatchTask::EMBEDDED;
+        }
+      } else if (OB_FAIL(call_thread.submit_task(task))) {
+        LOG_WARN("fail to submit python udf batch", K(ret));
+      } else {
+        task.state_ = ObPyUdfBatchTask::EMBEDDED;
+      }
+    } else if (OB_ISNULL(task.worker_pool_ = MTL(ObPyWorkerPool*))) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("python worker pool is null", K(ret));
+    } else if (OB_FAIL(build_worker_args(expr, ctx, true, args, has_null))) {
+      LOG_WARN("fail to build python worker args", K(ret));
+    } else if (FALSE_IT(task.submit_cycles_ = rdtsc())) {
+    } else if (OB_FAIL(task.worker_pool_->try_borrow(task.channel_))) {
+      LOG_WARN("fail to acquire python worker", K(ret));
+    } else if (NULL == task.channel_) {
+      // all workers are busy, some maybe by batches of this thread: waiting here could
+      // deadlock, run it at wait time after this thread gave its workers back
+      task.state_ = ObPyUdfBatchTask::DEFERRED;
+    } else if (OB_FAIL(task.channel_->write_batch(info->udf_meta_, args, expr.arg_cnt_,
+                                                  expr.datum_meta_.type_, task.sel_,
+                                                  task.sel_cnt_, write_cnt))) {
+      LOG_WARN("fail to write batch to python worker", K(ret));
+    } else if (write_cnt < task.sel_cnt_) {
+      // the batch does not fit into one request, run it request by request at wait time
+      task.worker_pool_->give_back(task.channel_);
+      task.channel_ = NULL;
+      task.state_ = ObPyUdfBatchTask::DEFERRED;
+    } else if (OB_FAIL(task.channel_->submit())) {
+      LOG_WARN("fail to submit batch to python worker", K(ret));
+    } else {
+      task.state_ = ObPyUdfBatchTask::WORKER;
+    }
+    if (OB_FAIL(ret) && NULL != task.channel_) {
+      task.worker_pool_->give_back(task.channel_);
+      task.channel_ = NULL;
+    }
+  }
+  return ret;
+}
+
+bool ObExprPythonUdf::is_batch_deferred(const ObExpr &expr, ObEvalCtx &ctx)
+{
+  ObPythonUdfExprCtx *udf_ctx = static_cast<ObPythonUdfExprCtx *>(
+      ctx.exec_ctx_.get_expr_op_ctx(expr.expr_ctx_id_));
+  return NULL != udf_ctx && ObPyUdfBatchTask::DEFERRED == udf_ctx->get_task().state_;
+}
+
+int ObExprPythonUdf::wait_batch_async(const ObExpr &expr, ObEvalCtx &ctx, ObPyCallThread &call_thread)
+{
+  int ret = OB_SUCCESS;
+  ObPythonUdfExprCtx *udf_ctx = static_cast<ObPythonUdfExprCtx *>(
+      ctx.exec_ctx_.get_expr_op_ctx(expr.expr_ctx_id_));
+  const ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr.extra_info_);
+  const bool use_cache = NULL != info && info->udf_meta_.deterministic_;
+  ObDatum *results = expr.locate_batch_datums(ctx);
+  int64_t ret_cnt = 0;
+  if (OB_ISNULL(udf_ctx)) {
+    // eval_batch_async failed before creating the ctx, nothing started
+  } else {
+    ObPyUdfBatchTask &task = udf_ctx->get_task();
+    switch (task.state_) {
+      case ObPyUdfBatchTask::IDLE: {
+        break;
+      }
+      case ObPyUdfBatchTask::EMBEDDED: {
+        // string results point into the pending python result kept by udf_ctx,
+        // a batch run by a group task was waited with the group
+        if (OB_FAIL(call_thread.wait_task(task))) {
+          LOG_WARN("python udf batch failed", K(ret));
+        } else if (OB_FAIL(task.run_ret_)) {
+          LOG_WARN("python udf batch failed in group", K(ret));
+        } else if (OB_FAIL(copy_str_results(expr, ctx, true, task.sel_, task.sel_cnt_, results))) {
+          LOG_WARN("fail to copy string results", K(ret));
+        } else if (use_cache
+                   && OB_FAIL(fill_result_cache(expr, ctx, task.sel_, task.sel_cnt_, results))) {
+          LOG_WARN("fail to fill python udf result cache", K(ret));
+        }
+        break;
+      }
+      case ObPyUdfBatchTask::WORKER: {
+        if (OB_ISNULL(task.channel_)) {
+          ret = OB_ERR_UNEXPECTED;
+          LOG_WARN("python worker channel is null", K(ret));
+        } else if (OB_FAIL(task.channel_->wait())) {
+          LOG_WARN("fail to run batch in python worker", K(ret));
+        } else if (OB_FAIL(task.channel_->read_result(expr.datum_meta_.type_, task.sel_,
+                                                      task.sel_cnt_, results, ret_cnt))) {
+          LOG_WARN("fail to read python worker result", K(ret));
+        } else {
+          for (int64_t k = ret_cnt; k < task.sel_cnt_; k++) {
+            results[task.sel_[k]].set_null();
+          }
+          if (NULL != info) {
+            // borrowing the worker is not told apart from the round trip here
+            ObPyUdfStageStat stat;
+            stat.batch_cnt_ = 1;
+            stat.row_cnt_ = task.sel_cnt_;
+            stat.infer_cycles_ = rdtsc() - task.submit_cycles_;
+            udf_ctx->add_stat(*info, stat);
+          }
+          if (OB_FAIL(copy_str_results(expr, ctx, true, task.sel_, ret_cnt, results))) {
+            LOG_WARN("fail to copy string results", K(ret));
+          } else if (use_cache
+                     && OB_FAIL(fill_result_cache(expr, ctx, task.sel_, ret_cnt, results))) {
+            LOG_WARN("fail to fill python udf result cache", K(ret));
+          }
+        }
+        if (NULL != task.channel_) {
+          task.worker_pool_->give_back(task.channel_);
+          task.channel_ = NULL;
+        }
+        break;
+      }
+      case ObPyUdfBatchTask::DEFERRED: {
+        if (OB_FAIL(eval_udf_in_worker(expr, ctx, task.sel_, task.sel_cnt_, true, results))) {
+          LOG_WARN("fail to run python udf in worker", K(ret));
+        } else if (use_cache
+                   && OB_FAIL(fill_result_cache(expr, ctx, task.sel_, task.sel_cnt_, results))) {
+          LOG_WARN("fail to fill python udf result cache", K(ret));
+        }
+        break;
+      }
+      default: {
+        ret = OB_ERR_UNEXPECTED;
+        LOG_WARN("unexpected python udf batch state", K(ret), K(task));
+      }
+    }
+    if (OB_SUCC(ret)) {
+      task.dedup_.scatter(results);
+    } else {
+      task.dedup_.reuse();
+    }
+    task.state_ = ObPyUdfBatchTask::IDLE;
+  }
+  return ret;
+}
+
+int ObExprPythonUdf::cg_expr(ObExprCGCtx& expr_cg_ctx, const ObRawExpr& raw_expr, ObExpr& rt_expr) const
+{
+  int ret = OB_SUCCESS;
+  //Python UDF Extra Info
+  ObIAllocator &alloc = *expr_cg_ctx.allocator_;
+  const ObPythonUdfRawExpr &fun_sys = static_cast<const ObPythonUdfRawExpr &>(raw_expr);
+  ObPythonUdfInfo *info = OB_NEWx(ObPythonUdfInfo, (&alloc),
+                                   alloc, T_FUN_SYS_PYTHON_UDF);
+  if (NULL == info) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("allocate memory failed", K(ret));
+  } else {
+    OZ(info->from_raw_expr(fun_sys));
+    rt_expr.extra_info_ = info;
+  }
+  //绑定eval, LANGUAGE TREES udf不经过python
+  const bool is_trees = ObPythonUDF::TREES == fun_sys.get_udf_meta().language_;
+  rt_expr.eval_func_ = is_trees ? ObExprPythonUdf::eval_tree_udf : ObExprPythonUdf::eval_test_udf;
+  //绑定向量化eval. Args that are not batch results, such as the outer columns of a nested loop
+  //join, have one value for the whole batch and are broadcast to its rows, the udf is never
+  //called row at a time within a batch
+  rt_expr.eval_batch_func_ = is_trees ? ObExprPythonUdf::eval_tree_udf_batch
+                                      : ObExprPythonUdf::eval_test_udf_batch;
+  return ret;
+}
+
+//异常输出
+void ObExprPythonUdf::message_error_dialog_show(char* buf) {
+  const char* folder_dir = "/home/obtest/log/";
+  if (access(folder_dir, 0) == -1) {
+    // 不存在该文件夹则创建
+    mkdir(folder_dir, S_IRWXU);
+  } else {
+    // 存在该文件夹则写入异常信息
+    std::ofstream ofile;
+    if (ofile) {
+      ofile.open("/home/obtest/log/python_error", std::ios::out);
+      ofile << buf;
+      ofile.close();
+    }
+  }
   return;
 }
 //异常处理
@@ -886,6 +1546,482 @@ void ObExprPythonUdf::process_python_exception() {
   //Py_XDECREF(traceback_obj);
 }
 
+void ObPythonUdfExprCtx::reset()
+{
+  if (NULL != task_.channel_) {
+    // batch abandoned in the worker, the channel is restarted by its next borrower
+    task_.worker_pool_->give_back(task_.channel_);
+    task_.channel_ = NULL;
+  }
+  task_.state_ = ObPyUdfBatchTask::IDLE;
+  if ((NULL != pyfun_ || NULL != import_batch_ || NULL != args_ || NULL != kwargs_
+       || NULL != kw_names_ || NULL != arrays_ || !pending_results_.empty())
+      && Py_IsInitialized()) {
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    release_handles();
+    PyGILState_Release(gstate);
+  }
+  arrays_ = NULL;
+  arg_cnt_ = 0;
+  epoch_ = -1;
+}
+
+void ObPythonUdfExprCtx::release_handles()
+{
+  Py_XDECREF(pyfun_);
+  pyfun_ = NULL;
+  Py_XDECREF(import_batch_);
+  import_batch_ = NULL;
+  Py_XDECREF(args_);
+  args_ = NULL;
+  Py_XDECREF(kwargs_);
+  kwargs_ = NULL;
+  Py_XDECREF(kw_names_);
+  kw_names_ = NULL;
+  release_pending_results();
+  if (NULL != arrays_) {
+    for (int64_t i = 0; i < arg_cnt_; i++) {
+      Py_XDECREF(arrays_[i]);
+      arrays_[i] = NULL;
+    }
+  }
+  capacity_ = 0;
+}
+
+void ObPythonUdfExprCtx::release_pending_results()
+{
+  for (int64_t i = 0; i < pending_results_.count(); i++) {
+    Py_XDECREF(pending_results_.at(i));
+  }
+  pending_results_.reuse();
+}
+
+int ObPythonUdfExprCtx::init_handles(const ObExpr &expr, ObIAllocator &alloc)
+{
+  int ret = OB_SUCCESS;
+  if (NULL == arrays_ && expr.arg_cnt_ > 0) {
+    if (OB_ISNULL(arrays_ = static_cast<PyObject **>(alloc.alloc(sizeof(PyObject *) * expr.arg_cnt_)))) {
+      ret = OB_ALLOCATE_MEMORY_FAILED;
+      LOG_WARN("fail to allocate numpy array handles", K(ret));
+    } else {
+      MEMSET(arrays_, 0, sizeof(PyObject *) * expr.arg_cnt_);
+    }
+  }
+  return ret;
+}
+
+void ObPythonUdfExprCtx::add_stat(const ObPythonUdfInfo &info, const ObPyUdfStageStat &stat)
+{
+  int tmp_ret = OB_SUCCESS;
+  ObPyUdfStatMgr *mgr = MTL(ObPyUdfStatMgr*);
+  stat_.add(stat);
+  if (NULL != mgr
+      && OB_SUCCESS != (tmp_ret = mgr->add(ObPyUdfStatKey(info.udf_meta_.udf_id_, plan_id_),
+                                           info.udf_meta_.schema_version_,
+                                           info.udf_meta_.name_, stat))) {
+    LOG_WARN_RET(tmp_ret, "fail to add python udf stat", K(tmp_ret), K(stat));
+  }
+}
+
+int ObPythonUdfExprCtx::resolve(const ObExpr &expr, const ObPythonUdfInfo &info,
+                                ObPyInterpreterGuard &guard)
+{
+  int ret = OB_SUCCESS;
+  PyObject *pModule = NULL;
+  std::string pyfun_handler(info.udf_meta_.name_.ptr(), info.udf_meta_.name_.length());
+  pyfun_handler.append("_pyfun");
+  release_handles();
+  if (OB_UNLIKELY(NULL == arrays_ && expr.arg_cnt_ > 0)) {
+    ret = OB_NOT_INIT;
+    LOG_WARN("numpy array handles not init", K(ret));
+  } else if (OB_FAIL(guard.prepare_udf(info.udf_meta_))) {
+    LOG_WARN("Fail to load udf into python interpreter", K(ret));
+  } else if (OB_ISNULL(pModule = PyImport_AddModule("__main__"))) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("Fail to import main module", K(ret));
+  } else if (OB_ISNULL(pyfun_ = PyObject_GetAttrString(pModule, pyfun_handler.c_str()))
+             || !PyCallable_Check(pyfun_)) {
+    process_python_exception();
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("Fail to get function handler", K(ret));
+    Py_XDECREF(pyfun_);
+    pyfun_ = NULL;
+  } else if (ObPythonUDF::ARROW == info.udf_meta_.batch_format_ && OB_FAIL(resolve_arrow())) {
+    LOG_WARN("Fail to resolve pyarrow handlers", K(ret));
+    Py_DECREF(pyfun_);
+    pyfun_ = NULL;
+  } else if (ObPythonUDF::KEYWORD == info.udf_meta_.arg_passing_
+             && OB_FAIL(resolve_kw_names(expr, info.udf_meta_))) {
+    LOG_WARN("Fail to resolve keyword arg names", K(ret));
+    Py_DECREF(pyfun_);
+    pyfun_ = NULL;
+  } else {
+    arg_passing_ = info.udf_meta_.arg_passing_;
+    arg_cnt_ = expr.arg_cnt_;
+    udf_id_ = info.udf_meta_.udf_id_;
+    schema_version_ = info.udf_meta_.schema_version_;
+    epoch_ = ObExprPythonUdf::get_udf_epoch();
+  }
+  return ret;
+}
+
+int ObPythonUdfExprCtx::resolve_arrow()
+{
+  int ret = OB_SUCCESS;
+  PyObject *pyarrow = NULL;
+  PyObject *record_batch = NULL;
+  if (OB_ISNULL(pyarrow = PyImport_ImportModule("pyarrow"))
+      || OB_ISNULL(record_batch = PyObject_GetAttrString(pyarrow, "RecordBatch"))
+      || OB_ISNULL(import_batch_ = PyObject_GetAttrString(record_batch, "_import_from_c"))) {
+    ObExprPythonUdf::process_python_exception();
+    ret = OB_NOT_SUPPORTED;
+    LOG_WARN("pyarrow is not available in python interpreter", K(ret));
+    LOG_USER_ERROR(OB_NOT_SUPPORTED, "BATCH_FORMAT ARROW without pyarrow");
+  }
+  Py_XDECREF(record_batch);
+  Py_XDECREF(pyarrow);
+  return ret;
+}
+
+int ObPythonUdfExprCtx::resolve_kw_names(const ObExpr &expr, const share::schema::ObPythonUDFMeta &meta)
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(meta.udf_attributes_names_.count() != expr.arg_cnt_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("keyword arg names mismatch args", K(ret), K(meta.udf_attributes_names_),
+             K(expr.arg_cnt_));
+  } else if (OB_ISNULL(kw_names_ = PyTuple_New(expr.arg_cnt_))
+             || OB_ISNULL(kwargs_ = PyDict_New())) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("fail to allocate keyword args", K(ret));
+  }
+  for (int64_t i = 0; OB_SUCC(ret) && i < expr.arg_cnt_; i++) {
+    const ObString &name = meta.udf_attributes_names_.at(i);
+    PyObject *kw_name = PyUnicode_FromStringAndSize(name.ptr(), name.length());
+    if (OB_ISNULL(kw_name)) {
+      ObExprPythonUdf::process_python_exception();
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("fail to build keyword arg name", K(ret), K(name));
+    } else {
+      // interned so that dict lookups in the udf compare pointers
+      PyUnicode_InternInPlace(&kw_name);
+      PyTuple_SET_ITEM(kw_names_, i, kw_name);
+    }
+  }
+  if (OB_FAIL(ret)) {
+    Py_XDECREF(kw_names_);
+    kw_names_ = NULL;
+    Py_XDECREF(kwargs_);
+    kwargs_ = NULL;
+  }
+  return ret;
+}
+
+int ObPythonUdfExprCtx::prepare_arrays(const ObExpr &expr, const int64_t size)
+{
+  int ret = OB_SUCCESS;
+  const bool need_realloc = size > capacity_;
+  const int64_t capacity = need_realloc ? size : capacity_;
+  for (int64_t i = 0; OB_SUCC(ret) && i < arg_cnt_; i++) {
+    // reuse the array only if the model did not keep a reference to it,
+    // constant args get a scalar per call from fill_array
+    if (is_scalar_arg(*expr.args_[i])
+        || (!need_realloc && NULL != arrays_[i] && 1 == Py_REFCNT(arrays_[i]))) {
+      continue;
+    }
+    Py_XDECREF(arrays_[i]);
+    arrays_[i] = NULL;
+    if (OB_FAIL(ObPythonUdfUtil::alloc_numpy(expr.args_[i]->datum_meta_.type_, capacity, arrays_[i]))) {
+      LOG_WARN("fail to allocate numpy array", K(ret), K(i), K(capacity));
+    }
+  }
+  if (OB_SUCC(ret)) {
+    capacity_ = capacity;
+  }
+  return ret;
+}
+
+int ObPythonUdfExprCtx::fill_array(const int64_t idx, const ObExpr &arg, ObEvalCtx &ctx,
+                                   const int32_t *sel, const int64_t sel_cnt)
+{
+  int ret = OB_SUCCESS;
+  const ObObjType type = arg.datum_meta_.type_;
+  const ObDatum *datums = arg.locate_batch_datums(ctx);
+  PyObject *unicode = NULL;
+  PyObject *scalar = NULL;
+  if (OB_UNLIKELY(idx < 0 || idx >= arg_cnt_)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid arg index", K(ret), K(idx), K_(arg_cnt));
+  } else if (is_scalar_arg(arg)) {
+    // one boxed value instead of sel_cnt copies of the constant
+    if (OB_FAIL(ObPythonUdfUtil::datum_to_python(type, datums[0],
+                                                 ObPythonUDF::KEYWORD == arg_passing_, scalar))) {
+      LOG_WARN("fail to convert constant arg", K(ret), K(idx));
+    } else {
+      Py_XDECREF(arrays_[idx]);
+      arrays_[idx] = scalar;
+    }
+  } else if (ObPythonUdfUtil::PY_COL_STRING == ObPythonUdfUtil::get_column_type(type)
+             && OB_FAIL(ObPythonUdfUtil::strings_to_numpy(datums, !arg.is_batch_result(), sel,
+                                                          sel_cnt, unicode))) {
+    LOG_WARN("fail to build unicode numpy array", K(ret), K(idx));
+  } else if (NULL != unicode) {
+    Py_XDECREF(arrays_[idx]);
+    arrays_[idx] = unicode;
+  } else if (!ObPythonUdfUtil::is_reusable(type, arrays_[idx], sel_cnt)) {
+    // the unicode array of a previous batch
+    Py_XDECREF(arrays_[idx]);
+    arrays_[idx] = NULL;
+    if (OB_FAIL(ObPythonUdfUtil::alloc_numpy(type, std::max(capacity_, sel_cnt), arrays_[idx]))) {
+      LOG_WARN("fail to allocate numpy array", K(ret), K(idx), K_(capacity));
+    }
+  }
+  if (OB_FAIL(ret) || NULL != unicode || NULL != scalar) {
+  } else if (OB_FAIL(ObPythonUdfUtil::fill_numpy(type, datums, !arg.is_batch_result(), sel, sel_cnt,
+                                                 arrays_[idx]))) {
+    LOG_WARN("fail to convert datums to numpy array", K(ret), K(idx));
+  }
+  return ret;
+}
+
+int ObPythonUdfExprCtx::build_args(const int64_t size, PyObject *const *arrays, PyObject *&args)
+{
+  int ret = OB_SUCCESS;
+  args = NULL;
+  if (OB_UNLIKELY(size > capacity_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("numpy arrays are too small", K(ret), K(size), K_(capacity));
+  } else if (NULL == args_ || 1 != Py_REFCNT(args_)) {
+    // the tuple can be refilled only if nobody else holds it
+    Py_XDECREF(args_);
+    if (OB_ISNULL(args_ = PyTuple_New(ObPythonUDF::KEYWORD == arg_passing_ ? 0 : arg_cnt_))) {
+      ret = OB_ALLOCATE_MEMORY_FAILED;
+      LOG_WARN("fail to allocate python tuple", K(ret));
+    }
+  }
+  if (OB_FAIL(ret) || ObPythonUDF::KEYWORD != arg_passing_) {
+  } else if (OB_ISNULL(kwargs_) || OB_ISNULL(kw_names_)) {
+    ret = OB_NOT_INIT;
+    LOG_WARN("keyword args not resolved", K(ret));
+  } else if (1 != Py_REFCNT(kwargs_)) {
+    // kept by the model, the same applies as for the tuple
+    Py_DECREF(kwargs_);
+    if (OB_ISNULL(kwargs_ = PyDict_New())) {
+      ret = OB_ALLOCATE_MEMORY_FAILED;
+      LOG_WARN("fail to allocate python dict", K(ret));
+    }
+  }
+  for (int64_t i = 0; OB_SUCC(ret) && i < arg_cnt_; i++) {
+    PyObject *view = NULL;
+    int64_t row_cnt = 0;
+    if (OB_ISNULL(arrays[i])) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("numpy array is null", K(ret), K(i));
+    } else if (0 == (row_cnt = ObPythonUdfUtil::get_row_cnt(arrays[i])) || size == row_cnt) {
+      // scalars of constant args are passed as they are
+      view = arrays[i];
+      Py_INCREF(view);
+    } else if (OB_ISNULL(view = PySequence_GetSlice(arrays[i], 0, size))) {
+      // a slice of ndarray is a view sharing the buffer, no data copy
+      ObExprPythonUdf::process_python_exception();
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("fail to build numpy array view", K(ret), K(i), K(size));
+    }
+    if (OB_FAIL(ret)) {
+    } else if (ObPythonUDF::KEYWORD == arg_passing_) {
+      const int set_ret = PyDict_SetItem(kwargs_, get_kw_name(i), view);
+      Py_DECREF(view);
+      if (0 != set_ret) {
+        ObExprPythonUdf::process_python_exception();
+        ret = OB_ERR_UNEXPECTED;
+        LOG_WARN("fail to set keyword arg", K(ret), K(i));
+      }
+    } else if (0 != PyTuple_SetItem(args_, i, view)) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("fail to set numpy array arg", K(ret), K(i));
+    }
+  }
+  if (OB_SUCC(ret)) {
+    args = args_;
+  }
+  return ret;
+}
+
+void ObPythonUdfExprCtx::release_args()
+{
+  if (NULL != kwargs_ && 1 == Py_REFCNT(kwargs_)) {
+    PyDict_Clear(kwargs_);
+  }
+  if (NULL != args_ && 1 == Py_REFCNT(args_) && PyTuple_GET_SIZE(args_) == arg_cnt_) {
+    for (int64_t i = 0; i < arg_cnt_; i++) {
+      Py_INCREF(Py_None);
+      PyTuple_SetItem(args_, i, Py_None);
+    }
+  }
+}
+
+int ObPyUdfBatchTask::prepare_sel(ObIAllocator &alloc, const int64_t size)
+{
+  int ret = OB_SUCCESS;
+  if (size > sel_capacity_) {
+    int32_t *sel = static_cast<int32_t *>(alloc.alloc(sizeof(int32_t) * size));
+    if (OB_ISNULL(sel)) {
+      ret = OB_ALLOCATE_MEMORY_FAILED;
+      LOG_WARN("fail to allocate selection vector", K(ret), K(size));
+    } else {
+      sel_ = sel;
+      sel_capacity_ = size;
+    }
+  }
+  sel_cnt_ = 0;
+  return ret;
+}
+
+int ObPyInterpreterGuard::acquire()
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(acquired_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python interpreter already acquired", K(ret));
+  } else {
+    if (!PyGILState_Check()) {
+      gstate_ = PyGILState_Ensure();
+      gil_ensured_ = true;
+    }
+    acquired_ = true;
+  }
+  return ret;
+}
+
+void ObPyInterpreterGuard::release()
+{
+  if (gil_ensured_) {
+    PyGILState_Release(gstate_);
+  }
+  gil_ensured_ = false;
+  acquired_ = false;
+}
+
+int ObPyInterpreterGuard::prepare_udf(const share::schema::ObPythonUDFMeta &udf_meta)
+{
+  int ret = OB_SUCCESS;
+  ObPyModelRegistry *registry = NULL;
+  if (OB_UNLIKELY(!acquired_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python interpreter not acquired", K(ret));
+  } else if (NULL != (registry = MTL(ObPyModelRegistry*)) && OB_FAIL(registry->bind(udf_meta))) {
+    // the udf may have been unloaded from the main interpreter since the plan was generated
+    LOG_WARN("fail to bind python udf model", K(ret));
+  }
+  return ret;
+}
+
+int ObPyUdfBatchTask::process()
+{
+  int ret = OB_SUCCESS;
+  ObPyInterpreterGuard guard;
+  ret = run(guard, NULL);
+  guard.release();
+  return ret;
+}
+
+int ObPyUdfBatchTask::run(ObPyInterpreterGuard &guard, ObPySharedArgs *shared_args)
+{
+  int ret = OB_SUCCESS;
+  const ObPythonUdfInfo *info = NULL;
+  ObPyUdfStageStat stat;
+  int64_t begin_cycles = 0;
+  if (OB_ISNULL(expr_) || OB_ISNULL(eval_ctx_) || OB_ISNULL(udf_ctx_)
+      || OB_ISNULL(info = static_cast<ObPythonUdfInfo *>(expr_->extra_info_))) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python udf batch task not init", K(ret), KP_(expr), KP_(eval_ctx), KP_(udf_ctx));
+  } else if (guard.is_acquired()) {
+    // acquired for a previous udf of the group
+  } else if (FALSE_IT(begin_cycles = rdtsc())) {
+  } else if (OB_FAIL(guard.acquire())) {
+    LOG_WARN("failed to acquire python interpreter", K(ret));
+  } else {
+    stat.gil_wait_cycles_ = rdtsc() - begin_cycles;
+    udf_ctx_->add_stat(*info, stat);
+  }
+  if (OB_FAIL(ret)) {
+  } else if (!udf_ctx_->is_valid(info->udf_meta_)
+             && OB_FAIL(udf_ctx_->resolve(*expr_, *info, guard))) {
+    LOG_WARN("failed to resolve python udf handles", K(ret), KPC_(udf_ctx));
+  } else if (OB_FAIL(ObPythonUdfUtil::import_numpy())) {
+    LOG_WARN("Fail to load numpy api", K(ret));
+  } else if (OB_FAIL(ObExprPythonUdf::predict_batch(*expr_, *eval_ctx_, *udf_ctx_,
+                                                    sel_, sel_cnt_,
+                                                    expr_->locate_batch_datums(*eval_ctx_),
+                                                    shared_args))) {
+    // string results are copied out by the operator thread, results are kept until then
+    LOG_WARN("fail to predict python udf batch", K(ret));
+  }
+  run_ret_ = ret;
+  return ret;
+}
+
+int ObPyUdfGroupTask::add_task(ObPyUdfBatchTask &task)
+{
+  int ret = OB_SUCCESS;
+  if (OB_FAIL(tasks_.push_back(&task))) {
+    LOG_WARN("fail to push back python udf batch", K(ret));
+  } else {
+    task.run_ret_ = OB_CANCELED;
+  }
+  return ret;
+}
+
+int ObPyUdfGroupTask::process()
+{
+  int ret = OB_SUCCESS;
+  // the GIL is taken once for every udf of the group
+  ObPyInterpreterGuard guard;
+  shared_args_.reuse();
+  for (int64_t i = 0; OB_SUCC(ret) && i < tasks_.count(); i++) {
+    if (OB_ISNULL(tasks_.at(i))) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("python udf batch is null", K(ret), K(i));
+    } else if (OB_FAIL(tasks_.at(i)->run(guard, &shared_args_))) {
+      LOG_WARN("fail to run python udf batch", K(ret), K(i));
+    }
+  }
+  LOG_DEBUG("python udf group ran", K(ret), K(tasks_.count()), K(shared_args_.get_reuse_cnt()));
+  shared_args_.reuse();
+  guard.release();
+  return ret;
+}
+
+PyObject *ObPySharedArgs::find(const ObExpr *arg, const int32_t *sel, const int64_t sel_cnt) const
+{
+  PyObject *array = NULL;
+  for (int64_t i = 0; NULL == array && i < entries_.count(); i++) {
+    const Entry &entry = entries_.at(i);
+    if (entry.arg_ == arg && entry.sel_cnt_ == sel_cnt
+        && (entry.sel_ == sel || 0 == MEMCMP(entry.sel_, sel, sizeof(int32_t) * sel_cnt))) {
+      array = entry.array_;
+    }
+  }
+  return array;
+}
+
+int ObPySharedArgs::add(const ObExpr *arg, PyObject *array, const int32_t *sel,
+                        const int64_t sel_cnt)
+{
+  int ret = OB_SUCCESS;
+  Entry entry;
+  entry.arg_ = arg;
+  entry.array_ = array;
+  entry.sel_ = sel;
+  entry.sel_cnt_ = sel_cnt;
+  if (OB_FAIL(entries_.push_back(entry))) {
+    LOG_WARN("fail to push back shared arg", K(ret));
+  } else {
+    Py_INCREF(array);
+  }
+  return ret;
+}
+
 int ObPythonUdfInfo::deep_copy(common::ObIAllocator &allocator,
                                 const ObExprOperatorType type,
                                 ObIExprExtraInfo *&copied_info) const
@@ -894,6 +2030,8 @@ int ObPythonUdfInfo::deep_copy(common::ObIAllocator &allocator,
   OZ(ObExprExtraInfoFactory::alloc(allocator, type, copied_info));
   ObPythonUdfInfo &other = *static_cast<ObPythonUdfInfo *>(copied_info);
   OZ(ObExprPythonUdf::deep_copy_udf_meta(other.udf_meta_, allocator, udf_meta_));
+  OZ(other.batch_tuner_.assign(batch_tuner_));
+  OZ(other.init_tree_model());
   return ret;
 }
 
@@ -901,14 +2039,18 @@ int ObPythonUdfInfo::from_raw_expr(const ObPythonUdfRawExpr &raw_expr)
 {
   int ret = OB_SUCCESS;
   OZ(ObExprPythonUdf::deep_copy_udf_meta(udf_meta_, allocator_, raw_expr.get_udf_meta()));
-  //predict_size = 4096; // max
-  predict_size = 256; //default
-  tps_s = 0; // init
-  round = 0; // init
-  lambda = 0.1;
-  alpha = 0.25;
-  delta = 256;
-  round_limit = 10;
+  OX(batch_tuner_.set_udf(udf_meta_.udf_id_, udf_meta_.schema_version_));
+  OZ(init_tree_model());
+  return ret;
+}
+
+int ObPythonUdfInfo::init_tree_model()
+{
+  int ret = OB_SUCCESS;
+  if (ObPythonUDF::TREES != udf_meta_.language_ || tree_model_.is_inited()) {
+  } else if (OB_FAIL(tree_model_.init(allocator_, udf_meta_.pycall_))) {
+    LOG_WARN("fail to build tree model", K(ret), K(udf_meta_.name_));
+  }
   return ret;
 }
 
@@ -916,7 +2058,8 @@ OB_DEF_SERIALIZE(ObPythonUdfInfo)
 {
   int ret = OB_SUCCESS;
   LST_DO_CODE(OB_UNIS_ENCODE,
-              udf_meta_);
+              udf_meta_,
+              batch_tuner_);
   return ret;
 }
 
@@ -924,7 +2067,9 @@ OB_DEF_DESERIALIZE(ObPythonUdfInfo)
 {
   int ret = OB_SUCCESS;
   LST_DO_CODE(OB_UNIS_DECODE,
-              udf_meta_);
+              udf_meta_,
+              batch_tuner_);
+  OZ(init_tree_model());
   return ret;
 }
 
@@ -932,7 +2077,8 @@ OB_DEF_SERIALIZE_SIZE(ObPythonUdfInfo)
 {
   int64_t len = 0;
   LST_DO_CODE(OB_UNIS_ADD_LEN,
-              udf_meta_);
+              udf_meta_,
+              batch_tuner_);
   return len;
 }
 }  // namespace sql
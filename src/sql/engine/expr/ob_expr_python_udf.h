@@ -13,9 +13,23 @@
 #include <fstream>
 #include <sys/syscall.h>
 #include "share/datum/ob_datum_util.h"
+#include "sql/engine/python_udf_engine/ob_python_call_thread.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_batch_tuner.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_dedup.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_stat.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_tree_model.h"
 
 namespace  oceanbase {
 namespace  sql {
+class ObPythonUdfExprCtx;
+struct ObPythonUdfInfo;
+class ObPyUdfGroupTask;
+class ObPyInterpreterGuard;
+class ObPyWorkerChannel;
+class ObPyWorkerPool;
+struct ObPyWorkerArg;
+struct ObPyResultCacheKey;
+class ObPySharedArgs;
 class  ObExprPythonUdf : public  ObExprOperator {
 public:
   explicit  ObExprPythonUdf(common::ObIAllocator &alloc);
@@ -45,20 +59,150 @@ public:
 
   static int import_udf(const share::schema::ObPythonUDFMeta &udf_meta);
 
+  // run pycall and pyinitial in globals of their own and publish the handlers in __main__
+  // of the current interpreter, GIL must be held
+  static int load_udf(const share::schema::ObPythonUDFMeta &udf_meta);
+
+  // drop the handlers of the udf from __main__ of the current interpreter, GIL must be held
+  static void unload_udf(const common::ObString &name);
+
   static int eval_test_udf(const ObExpr& expr, ObEvalCtx& ctx, ObDatum& expr_datum);
 
   static int eval_test_udf_batch(const ObExpr &expr, ObEvalCtx &ctx,
                                  const ObBitVector &skip, const int64_t batch_size);
 
+  // LANGUAGE TREES udf, scored by the ObPyTreeModel of the expr without python
+  static int eval_tree_udf(const ObExpr &expr, ObEvalCtx &ctx, ObDatum &expr_datum);
+
+  static int eval_tree_udf_batch(const ObExpr &expr, ObEvalCtx &ctx,
+                                 const ObBitVector &skip, const int64_t batch_size);
+
+  // udf ctx of the execution, created at the first batch without resolving python handles
+  static int get_expr_ctx(const ObExpr &expr, ObEvalCtx &ctx, ObPythonUdfExprCtx *&udf_ctx);
+
+  // guard must hold the interpreter to run the udf in
+  static int get_udf_ctx(const ObExpr &expr, ObEvalCtx &ctx, ObPyInterpreterGuard &guard,
+                         ObPythonUdfExprCtx *&udf_ctx);
+
+  // run rows sel[0..sel_cnt) in a python worker process, for udf with EXECUTION = 'WORKER'
+  static int eval_udf_in_worker(const ObExpr &expr, ObEvalCtx &ctx,
+                                const int32_t *sel, const int64_t sel_cnt,
+                                const bool is_batch, ObDatum *results);
+
+  // pipelined batch evaluation used by ObPythonUDFOp: args are evaluated and the python call
+  // is started on the helper thread (or in a python worker), the caller can do other work
+  // until wait_batch_async() which fills the results of the expr. Every started batch must
+  // be waited, also on error. With group_task the embedded call is only added to the group,
+  // the caller submits the group and waits for it before wait_batch_async(). A deferred batch
+  // borrows a python worker when waited, so it is waited after all other started batches
+  static int eval_batch_async(const ObExpr &expr, ObEvalCtx &ctx, const ObBitVector &skip,
+                              const int64_t batch_size, ObPyCallThread &call_thread,
+                              ObPyUdfGroupTask *group_task = NULL);
+  static int wait_batch_async(const ObExpr &expr, ObEvalCtx &ctx, ObPyCallThread &call_thread);
+  static bool is_batch_deferred(const ObExpr &expr, ObEvalCtx &ctx);
+
+  // convert rows sel[0..sel_cnt) to numpy, call the udf and convert the result back,
+  // the interpreter of udf_ctx must be acquired. String results point into result,
+  // which is released by the caller. Args already converted for the same rows by another
+  // udf of shared_args are not converted again
+  static int predict(const ObExpr &expr, ObEvalCtx &ctx, ObPythonUdfExprCtx &udf_ctx,
+                     const int32_t *sel, const int64_t sel_cnt,
+                     ObDatum *results, PyObject *&result,
+                     ObPySharedArgs *shared_args = NULL);
+
+  // predict rows sel[0..sel_cnt) in python calls of the batch size of the udf, so that each
+  // udf of an operator runs at its own size whatever rows the operator loads. Results of the
+  // previous batch are released first, the new ones are kept by udf_ctx
+  static int predict_batch(const ObExpr &expr, ObEvalCtx &ctx, ObPythonUdfExprCtx &udf_ctx,
+                           const int32_t *sel, const int64_t sel_cnt,
+                           ObDatum *results, ObPySharedArgs *shared_args);
+
   static void message_error_dialog_show(char* buf);
 
   static void process_python_exception();
 
+  virtual bool need_rt_ctx() const override { return true; }
+
+  // bumped whenever a pycall is (re)loaded or a python udf is created/dropped,
+  // cached python handles resolved before the bump are re-resolved
+  static int64_t get_udf_epoch() { return ATOMIC_LOAD(&udf_epoch_); }
+  static void inc_udf_epoch() { (void)ATOMIC_AAF(&udf_epoch_, 1); }
+
+private:
+  // eval args in batch, rows with a null arg get a null result and are marked evaluated
+  static int eval_args_batch(const ObExpr &expr, ObEvalCtx &ctx,
+                             const ObBitVector &skip, const int64_t batch_size);
+  static int build_worker_args(const ObExpr &expr, ObEvalCtx &ctx, const bool is_batch,
+                               ObPyWorkerArg *args, bool &has_null);
+  // BATCH_FORMAT ARROW version of predict: rows sel[0..sel_cnt) are passed as one pyarrow
+  // RecordBatch exported by ObPyArrowBatch, a pyarrow (chunked) array result is imported back
+  // through the C data interface and any other result is taken as a numpy array
+  static int predict_arrow(const ObExpr &expr, ObEvalCtx &ctx, ObPythonUdfExprCtx &udf_ctx,
+                           const bool is_batch, const int32_t *sel, const int64_t sel_cnt,
+                           ObDatum *results, PyObject *&result);
+  // string results pointing into python or worker memory are copied into one chunk of the
+  // reserved result buffer of row sel[0], sized by the total length of the rows
+  static int copy_str_results(const ObExpr &expr, ObEvalCtx &ctx, const bool is_batch,
+                              const int32_t *sel, const int64_t sel_cnt, ObDatum *results);
+  // DETERMINISTIC udf: rows whose result is in ObPyResultCache get it and are marked evaluated,
+  // the others are left to python. Lookup failures count as misses
+  static int probe_result_cache(const ObExpr &expr, ObEvalCtx &ctx, const int64_t batch_size);
+  // put the results of rows sel[0..sel_cnt) computed by python, a full cache is not an error
+  static int fill_result_cache(const ObExpr &expr, ObEvalCtx &ctx, const int32_t *sel,
+                               const int64_t sel_cnt, const ObDatum *results);
+  static int build_cache_key(const ObExpr &expr, ObEvalCtx &ctx, const int64_t row,
+                             common::ObIAllocator &alloc, ObPyResultCacheKey &key);
+  // drop rows of sel[0..sel_cnt) whose args repeat those of another row when the distinct
+  // ratio of the udf is low, dedup scatters the results to them once python has returned
+  static int dedup_batch(const ObExpr &expr, ObEvalCtx &ctx, common::ObIAllocator &alloc,
+                         const int64_t batch_size, ObPyBatchDedup &dedup,
+                         int32_t *sel, int64_t &sel_cnt);
+  // score rows sel[0..sel_cnt) of non null args with the tree model of the expr
+  static int predict_trees(const ObExpr &expr, ObEvalCtx &ctx, const bool is_batch,
+                           const int32_t *sel, const int64_t sel_cnt, ObDatum *results);
+
 protected:
+  static int64_t udf_epoch_;
   common::ObIAllocator &allocator_;
   share::schema::ObPythonUDFMeta udf_meta_;
 };
 
+// numpy arrays of args converted in one python section, borrowed from the udf ctx that
+// converted them and reused by the other udfs of the section on the same arg and rows
+class ObPySharedArgs
+{
+public:
+  struct Entry
+  {
+    Entry() : arg_(NULL), array_(NULL), sel_(NULL), sel_cnt_(0) {}
+    TO_STRING_KV(KP_(arg), KP_(array), K_(sel_cnt));
+    const ObExpr *arg_;
+    PyObject *array_;
+    const int32_t *sel_;
+    int64_t sel_cnt_;
+  };
+  ObPySharedArgs() : entries_(), reuse_cnt_(0) {}
+  PyObject *find(const ObExpr *arg, const int32_t *sel, const int64_t sel_cnt) const;
+  // array is referenced until reuse(), so that its udf does not refill or replace it
+  int add(const ObExpr *arg, PyObject *array, const int32_t *sel, const int64_t sel_cnt);
+  void inc_reuse_cnt() { ++reuse_cnt_; }
+  int64_t get_reuse_cnt() const { return reuse_cnt_; }
+  // GIL must be held
+  void reuse()
+  {
+    for (int64_t i = 0; i < entries_.count(); i++) {
+      Py_XDECREF(entries_.at(i).array_);
+    }
+    entries_.reuse();
+    reuse_cnt_ = 0;
+  }
+  TO_STRING_KV(K_(entries), K_(reuse_cnt));
+
+private:
+  common::ObSEArray<Entry, 8> entries_;
+  int64_t reuse_cnt_; // arrays not converted again
+};
+
 struct ObPythonUdfInfo : public ObIExprExtraInfo
 {
   OB_UNIS_VERSION(1);
@@ -72,18 +216,176 @@ public:
                         ObIExprExtraInfo *&copied_info) const override;
 
   int from_raw_expr(const ObPythonUdfRawExpr &expr);
+  // parse the model dump of a LANGUAGE TREES udf, once per plan
+  int init_tree_model();
 
   common::ObIAllocator &allocator_;
   share::schema::ObPythonUDFMeta udf_meta_;
-  int predict_size;
-  //double best_effi;
-  double tps_s;
-  double lambda; // batch size increase percentage 𝜆
-  double alpha; // tps* decrease speed
-  int round;
-  int round_limit; // rounds of stoping batch size motification
-  int delta; // delta batch size
+  ObPyBatchTuner batch_tuner_; // rows per python call
+  ObPyDedupStat dedup_stat_; // distinct ratio of the batches
+  ObPyTreeModel tree_model_; // LANGUAGE TREES, built from udf_meta_ and not serialized
+};
+// Holds the GIL of the main interpreter for the scope of a batch, taken once for all udfs
+// of a group. Udfs run in the main interpreter, parallel inference is left to the python
+// worker processes of ObPyWorkerPool (EXECUTION = 'WORKER')
+class ObPyInterpreterGuard
+{
+public:
+  ObPyInterpreterGuard() : acquired_(false), gil_ensured_(false), gstate_(PyGILState_UNLOCKED) {}
+  ~ObPyInterpreterGuard() { release(); }
+  int acquire();
+  void release();
+  bool is_acquired() const { return acquired_; }
+  // bind the udf to its model loaded in the main interpreter, see ObPyModelRegistry
+  int prepare_udf(const share::schema::ObPythonUDFMeta &udf_meta);
+
+private:
+  bool acquired_;
+  bool gil_ensured_;
+  PyGILState_STATE gstate_;
+  DISALLOW_COPY_AND_ASSIGN(ObPyInterpreterGuard);
+};
+
+// one batch of a python udf expr started by ObExprPythonUdf::eval_batch_async
+class ObPyUdfBatchTask : public ObPyAsyncTask
+{
+public:
+  enum State
+  {
+    IDLE = 0,
+    EMBEDDED, // running on the helper thread
+    WORKER, // running in a python worker
+    DEFERRED // too large for one worker request or no worker free, run at wait time
+  };
+  ObPyUdfBatchTask()
+      : ObPyAsyncTask(), expr_(NULL), eval_ctx_(NULL), udf_ctx_(NULL), sel_(NULL),
+        sel_cnt_(0), sel_capacity_(0), dedup_(), channel_(NULL), worker_pool_(NULL),
+        submit_cycles_(0), state_(IDLE), run_ret_(common::OB_SUCCESS) {}
+  virtual ~ObPyUdfBatchTask() {}
+  // acquire the interpreter of udf_ctx and predict sel_, runs on the helper thread
+  virtual int process() override;
+  // predict sel_ in the interpreter of guard, acquired first if needed
+  int run(ObPyInterpreterGuard &guard, ObPySharedArgs *shared_args);
+  int prepare_sel(common::ObIAllocator &alloc, const int64_t size);
+
+  TO_STRING_KV(K_(sel_cnt), K_(sel_capacity), K_(dedup), KP_(channel), K_(state), K_(run_ret));
+
+  const ObExpr *expr_;
+  ObEvalCtx *eval_ctx_;
+  ObPythonUdfExprCtx *udf_ctx_;
+  int32_t *sel_;
+  int64_t sel_cnt_;
+  int64_t sel_capacity_;
+  ObPyBatchDedup dedup_; // rows removed from sel_
+  ObPyWorkerChannel *channel_; // borrowed for the WORKER batch
+  ObPyWorkerPool *worker_pool_;
+  int64_t submit_cycles_; // WORKER batch, rdtsc() before the worker was borrowed
+  State state_;
+  int run_ret_; // of the last run, OB_CANCELED until a group runs the batch
+};
+
+// embedded python udf batches of one operator batch run in one task: the interpreter is
+// acquired once for all of them and an arg shared by several udfs is converted once
+class ObPyUdfGroupTask : public ObPyAsyncTask
+{
+public:
+  ObPyUdfGroupTask() : ObPyAsyncTask(), tasks_(), shared_args_() {}
+  virtual ~ObPyUdfGroupTask() {}
+  virtual int process() override;
+  int add_task(ObPyUdfBatchTask &task);
+  int64_t count() const { return tasks_.count(); }
+  void reuse() { tasks_.reuse(); }
+
+  TO_STRING_KV(K(tasks_.count()), K_(shared_args));
+
+private:
+  common::ObSEArray<ObPyUdfBatchTask *, 4> tasks_;
+  ObPySharedArgs shared_args_;
 };
+
+// python handles of a python udf expr, resolved once per execution and reused by every batch
+class ObPythonUdfExprCtx : public ObExprOperatorCtx
+{
+public:
+  ObPythonUdfExprCtx()
+      : ObExprOperatorCtx(), udf_id_(common::OB_INVALID_ID),
+        schema_version_(common::OB_INVALID_VERSION), epoch_(-1),
+        arg_cnt_(0), capacity_(0), arg_passing_(share::schema::ObPythonUDF::POSITIONAL),
+        pyfun_(NULL), import_batch_(NULL), args_(NULL), kwargs_(NULL), kw_names_(NULL),
+        arrays_(NULL), pending_results_(), task_(), plan_id_(common::OB_INVALID_ID), stat_() {}
+  virtual ~ObPythonUdfExprCtx() { reset(); }
+
+  // release all python objects, acquire GIL inside
+  void reset();
+  // check whether cached handles still belong to the udf version of the expr
+  bool is_valid(const share::schema::ObPythonUDFMeta &meta) const
+  {
+    return NULL != pyfun_ && udf_id_ == meta.udf_id_
+           && schema_version_ == meta.schema_version_
+           && epoch_ == ObExprPythonUdf::get_udf_epoch();
+  }
+  // following functions must be called with the interpreter of guard acquired
+  int resolve(const ObExpr &expr, const ObPythonUdfInfo &info, ObPyInterpreterGuard &guard);
+  int prepare_arrays(const ObExpr &expr, const int64_t size);
+  // convert arg idx of rows sel[0..sel_cnt) into its array, strings fitting a fixed width
+  // unicode array get a new one in place of the preallocated object array
+  int fill_array(const int64_t idx, const ObExpr &arg, ObEvalCtx &ctx,
+                 const int32_t *sel, const int64_t sel_cnt);
+  // arrays[i] is the numpy array of arg i, either of this ctx or shared by another udf
+  int build_args(const int64_t size, PyObject *const *arrays, PyObject *&args);
+  // drop argument references after the call so that arrays can be refilled in place
+  void release_args();
+  // python results of the last batch, one per python call, alive until the string results
+  // pointing into them are copied out or the next batch starts
+  int add_pending_result(PyObject *result) { return pending_results_.push_back(result); }
+  void release_pending_results();
+  PyObject *get_pyfun() const { return pyfun_; }
+  PyObject *get_import_batch() const { return import_batch_; }
+  PyObject *get_array(const int64_t idx) const { return arrays_[idx]; }
+  // a constant arg is passed as one python scalar or 0-d array unless ARG_PASSING POSITIONAL
+  bool is_scalar_arg(const ObExpr &arg) const
+  {
+    return share::schema::ObPythonUDF::POSITIONAL != arg_passing_ && !arg.is_batch_result();
+  }
+  share::schema::ObPythonUDF::PyUdfArgPassing get_arg_passing() const { return arg_passing_; }
+  // keyword args of the call built by build_args, NULL unless ARG_PASSING KEYWORD
+  PyObject *get_kwargs() const { return kwargs_; }
+  PyObject *get_kw_name(const int64_t idx) const { return PyTuple_GET_ITEM(kw_names_, idx); }
+  ObPyUdfBatchTask &get_task() { return task_; }
+  // handle slots allocated once in the execution allocator, not thread safe
+  int init_handles(const ObExpr &expr, common::ObIAllocator &alloc);
+  void set_plan_id(const uint64_t plan_id) { plan_id_ = plan_id; }
+  // stages of python calls of this execution, also added to the tenant ObPyUdfStatMgr.
+  // Called by the thread running the call, the operator reads it between batches
+  void add_stat(const ObPythonUdfInfo &info, const ObPyUdfStageStat &stat);
+  const ObPyUdfStageStat &get_stat() const { return stat_; }
+
+  TO_STRING_KV(K_(udf_id), K_(schema_version), K_(epoch), K_(arg_cnt), K_(capacity),
+               K_(arg_passing), K_(task), K_(plan_id), K_(stat));
+
+private:
+  void release_handles();
+  int resolve_arrow();
+  int resolve_kw_names(const ObExpr &expr, const share::schema::ObPythonUDFMeta &meta);
+
+  uint64_t udf_id_;
+  int64_t schema_version_;
+  int64_t epoch_;
+  int64_t arg_cnt_;
+  int64_t capacity_; // rows the preallocated arrays can hold
+  share::schema::ObPythonUDF::PyUdfArgPassing arg_passing_;
+  PyObject *pyfun_; // strong reference to <name>_pyfun
+  PyObject *import_batch_; // pyarrow.RecordBatch._import_from_c, BATCH_FORMAT ARROW
+  PyObject *args_; // reusable argument tuple, empty for ARG_PASSING KEYWORD
+  PyObject *kwargs_; // reusable keyword argument dict, ARG_PASSING KEYWORD
+  PyObject *kw_names_; // tuple of parameter names, ARG_PASSING KEYWORD
+  PyObject **arrays_; // preallocated numpy arrays, one per argument
+  common::ObSEArray<PyObject *, 4> pending_results_;
+  ObPyUdfBatchTask task_;
+  uint64_t plan_id_;
+  ObPyUdfStageStat stat_;
+};
+
 } /* namespace sql */
 } /* namespace oceanbase */
 
@@ -289,7 +289,8 @@ int ObPxDistTransmitOp::do_bc2host_dist()
 int ObPxDistTransmitOp::do_random_dist()
 {
   int ret = OB_SUCCESS;
-  ObRandomSliceIdCalc slice_id_calc(ctx_.get_allocator(), task_channels_.count());
+  ObRandomSliceIdCalc slice_id_calc(ctx_.get_allocator(), task_channels_.count(),
+                                    MY_SPEC.random_chunk_rows_);
   if (OB_FAIL(send_rows(slice_id_calc))) {
     LOG_WARN("row distribution failed", K(ret));
   }
@@ -0,0 +1,133 @@
+#define USING_LOG_PREFIX SQL_ENG
+
+#include "sql/engine/python_udf_engine/ob_python_call_thread.h"
+#include "share/rc/ob_tenant_base.h"
+#include "lib/stat/ob_diagnose_info.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+ObPyCallThread::ObPyCallThread()
+    : cond_(), queue_(), head_(0), inited_(false)
+{
+}
+
+int ObPyCallThread::init()
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(inited_)) {
+    ret = OB_INIT_TWICE;
+    LOG_WARN("python call thread init twice", K(ret));
+  } else if (OB_FAIL(cond_.init(ObWaitEventIds::DEFAULT_COND_WAIT))) {
+    LOG_WARN("fail to init cond", K(ret));
+  } else if (FALSE_IT(set_run_wrapper(MTL_CTX()))) {
+  } else if (OB_FAIL(set_thread_count(1))) {
+    LOG_WARN("fail to set thread count", K(ret));
+  } else if (OB_FAIL(start())) {
+    LOG_WARN("fail to start python call thread", K(ret));
+  } else {
+    inited_ = true;
+  }
+  if (OB_FAIL(ret)) {
+    cond_.destroy();
+  }
+  return ret;
+}
+
+void ObPyCallThread::destroy()
+{
+  if (inited_) {
+    {
+      // submitted tasks reference their submitter, drain them before stopping
+      ObThreadCondGuard guard(cond_);
+      while (head_ < queue_.count()) {
+        cond_.wait_us(WAIT_TASK_INTERVAL_US);
+      }
+      share::ObThreadPool::stop();
+      cond_.broadcast();
+    }
+    share::ObThreadPool::wait();
+    share::ObThreadPool::destroy();
+    cond_.destroy();
+    queue_.reset();
+    head_ = 0;
+    inited_ = false;
+  }
+}
+
+int ObPyCallThread::submit_task(ObPyAsyncTask &task)
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(!inited_)) {
+    ret = OB_NOT_INIT;
+    LOG_WARN("python call thread not init", K(ret));
+  } else {
+    ObThreadCondGuard guard(cond_);
+    if (OB_UNLIKELY(task.submitted_)) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("python task is submitted twice", K(ret));
+    } else if (OB_FAIL(queue_.push_back(&task))) {
+      LOG_WARN("fail to push back python task", K(ret));
+    } else {
+      task.submitted_ = true;
+      task.done_ = false;
+      task.task_ret_ = OB_SUCCESS;
+      cond_.broadcast();
+    }
+  }
+  return ret;
+}
+
+int ObPyCallThread::wait_task(ObPyAsyncTask &task)
+{
+  int ret = OB_SUCCESS;
+  if (inited_) {
+    ObThreadCondGuard guard(cond_);
+    // python is not interruptible, always wait for the task to finish
+    while (task.submitted_ && !task.done_) {
+      cond_.wait_us(WAIT_TASK_INTERVAL_US);
+    }
+    if (task.submitted_) {
+      ret = task.task_ret_;
+      task.submitted_ = false;
+    }
+  }
+  return ret;
+}
+
+void ObPyCallThread::run1()
+{
+  lib::set_thread_name("PyUdfCall");
+  while (!has_set_stop()) {
+    ObPyAsyncTask *task = NULL;
+    {
+      ObThreadCondGuard guard(cond_);
+      while (!has_set_stop() && head_ >= queue_.count()) {
+        cond_.wait_us(WAIT_TASK_INTERVAL_US);
+      }
+      if (head_ < queue_.count()) {
+        task = queue_.at(head_);
+      }
+    }
+    if (NULL != task) {
+      int ret = task->process();
+      if (OB_FAIL(ret)) {
+        LOG_WARN("python task failed", K(ret));
+      }
+      ObThreadCondGuard guard(cond_);
+      task->task_ret_ = ret;
+      task->done_ = true;
+      if (++head_ >= queue_.count()) {
+        queue_.reuse();
+        head_ = 0;
+      }
+      cond_.broadcast();
+    }
+  }
+}
+
+} // end namespace sql
+} // end namespace oceanbase
@@ -0,0 +1,63 @@
+#ifndef OCEANBASE_PYTHON_UDF_OB_PYTHON_CALL_THREAD_H_
+#define OCEANBASE_PYTHON_UDF_OB_PYTHON_CALL_THREAD_H_
+
+#include "share/ob_thread_pool.h"
+#include "lib/container/ob_se_array.h"
+#include "lib/lock/ob_thread_cond.h"
+
+namespace oceanbase
+{
+namespace sql
+{
+
+// work handed to ObPyCallThread, process() runs on the helper thread
+class ObPyAsyncTask
+{
+public:
+  ObPyAsyncTask() : submitted_(false), done_(false), task_ret_(common::OB_SUCCESS) {}
+  virtual ~ObPyAsyncTask() {}
+  virtual int process() = 0;
+
+private:
+  friend class ObPyCallThread;
+  // protected by the cond of the thread the task is submitted to
+  bool submitted_;
+  bool done_;
+  int task_ret_;
+};
+
+/*
+ * Helper thread of a python udf operator, runs submitted tasks in order so that the
+ * operator can fetch the next child batch while the current batch is in python.
+ * Started under the tenant context of the operator, the task may use MTL.
+ */
+class ObPyCallThread : public share::ObThreadPool
+{
+public:
+  static const int64_t WAIT_TASK_INTERVAL_US = 100 * 1000;
+
+  ObPyCallThread();
+  virtual ~ObPyCallThread() { destroy(); }
+  int init();
+  void destroy();
+  bool is_inited() const { return inited_; }
+
+  // task must stay alive until wait_task() returns
+  int submit_task(ObPyAsyncTask &task);
+  // wait for the task and return its result, no-op if the task was not submitted
+  int wait_task(ObPyAsyncTask &task);
+
+  virtual void run1() override;
+
+private:
+  common::ObThreadCond cond_;
+  common::ObSEArray<ObPyAsyncTask *, 4> queue_;
+  int64_t head_; // next task to run in queue_
+  bool inited_;
+  DISALLOW_COPY_AND_ASSIGN(ObPyCallThread);
+};
+
+} // end namespace sql
+} // end namespace oceanbase
+
+#endif // OCEANBASE_PYTHON_UDF_OB_PYTHON_CALL_THREAD_H_
@@ -0,0 +1,371 @@
+#define USING_LOG_PREFIX SQL_ENG
+
+#define PY_SSIZE_T_CLEAN
+#include "sql/engine/python_udf_engine/ob_python_udf_util.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_arrow.h"
+#include <string.h>
+#include "lib/oblog/ob_log.h"
+#include "lib/allocator/ob_malloc.h"
+#include "lib/atomic/ob_atomic.h"
+#include "share/rc/ob_tenant_base.h"
+#include "sql/engine/expr/ob_expr.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+static inline bool is_arrow_null(const uint8_t *validity, const int64_t i)
+{
+  return NULL != validity && 0 == (validity[i >> 3] & (1 << (i & 7)));
+}
+
+int ObPyArrowBatch::export_batch(const ObExpr &expr, ObEvalCtx &ctx, const bool is_batch,
+                                 const int32_t *sel, const int64_t sel_cnt,
+                                 ArrowSchema &schema, ArrowArray &array)
+{
+  int ret = OB_SUCCESS;
+  const uint64_t tenant_id = MTL_ID();
+  const int64_t col_cnt = expr.arg_cnt_;
+  int64_t first = 0;
+  int64_t length = 0;
+  Holder *holder = NULL;
+  uint8_t *validity = NULL;
+  ArrowSchema *child_schemas = NULL;
+  ArrowSchema **schema_children = NULL;
+  ArrowArray *child_arrays = NULL;
+  ArrowArray **array_children = NULL;
+  const void **buffers = NULL;
+  MEMSET(&schema, 0, sizeof(schema));
+  MEMSET(&array, 0, sizeof(array));
+  if (OB_ISNULL(sel) || OB_UNLIKELY(sel_cnt <= 0)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid selection", K(ret), KP(sel), K(sel_cnt));
+  } else if (FALSE_IT(first = sel[0])) {
+  } else if (FALSE_IT(length = sel[sel_cnt - 1] - first + 1)) {
+  } else if (OB_ISNULL(holder = OB_NEW(Holder, ObMemAttr(tenant_id, "PyArrowBatch"), tenant_id))) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("fail to allocate arrow batch", K(ret));
+  } else if (OB_ISNULL(child_schemas = static_cast<ArrowSchema *>(
+                 holder->arena_.alloc(sizeof(ArrowSchema) * (col_cnt + 1))))
+             || OB_ISNULL(schema_children = static_cast<ArrowSchema **>(
+                 holder->arena_.alloc(sizeof(ArrowSchema *) * (col_cnt + 1))))
+             || OB_ISNULL(child_arrays = static_cast<ArrowArray *>(
+                 holder->arena_.alloc(sizeof(ArrowArray) * (col_cnt + 1))))
+             || OB_ISNULL(array_children = static_cast<ArrowArray **>(
+                 holder->arena_.alloc(sizeof(ArrowArray *) * (col_cnt + 1))))
+             || OB_ISNULL(buffers = static_cast<const void **>(
+                 holder->arena_.alloc(sizeof(void *))))) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("fail to allocate arrow structures", K(ret), K(col_cnt));
+  } else if (length > sel_cnt) {
+    // rows out of the selection are null
+    if (OB_ISNULL(validity = static_cast<uint8_t *>(holder->arena_.alloc((length + 7) / 8)))) {
+      ret = OB_ALLOCATE_MEMORY_FAILED;
+      LOG_WARN("fail to allocate validity bitmap", K(ret), K(length));
+    } else {
+      MEMSET(validity, 0, (length + 7) / 8);
+      for (int64_t k = 0; k < sel_cnt; k++) {
+        const int64_t pos = sel[k] - first;
+        validity[pos >> 3] |= static_cast<uint8_t>(1 << (pos & 7));
+      }
+    }
+  }
+  for (int64_t i = 0; OB_SUCC(ret) && i < col_cnt; i++) {
+    schema_children[i] = &child_schemas[i];
+    array_children[i] = &child_arrays[i];
+    if (OB_FAIL(export_column(*expr.args_[i], ctx, is_batch, sel, sel_cnt, length, validity, i,
+                              *holder, child_schemas[i], child_arrays[i]))) {
+      LOG_WARN("fail to export arrow column", K(ret), K(i));
+    }
+  }
+  if (OB_SUCC(ret)) {
+    // every structure holds a reference until it is released
+    holder->ref_cnt_ = 2 * (col_cnt + 1);
+    for (int64_t i = 0; i < col_cnt; i++) {
+      child_schemas[i].release = release_schema;
+      child_schemas[i].private_data = holder;
+      child_arrays[i].release = release_array;
+      child_arrays[i].private_data = holder;
+    }
+    buffers[0] = NULL; // no null struct
+    schema.format = "+s";
+    schema.name = "";
+    schema.n_children = col_cnt;
+    schema.children = schema_children;
+    schema.release = release_schema;
+    schema.private_data = holder;
+    array.length = length;
+    array.n_buffers = 1;
+    array.buffers = buffers;
+    array.n_children = col_cnt;
+    array.children = array_children;
+    array.release = release_array;
+    array.private_data = holder;
+  } else if (NULL != holder) {
+    OB_DELETE(Holder, "PyArrowBatch", holder);
+  }
+  return ret;
+}
+
+int ObPyArrowBatch::export_column(const ObExpr &arg, ObEvalCtx &ctx, const bool is_batch,
+                                  const int32_t *sel, const int64_t sel_cnt, const int64_t length,
+                                  const uint8_t *validity, const int64_t idx, Holder &holder,
+                                  ArrowSchema &schema, ArrowArray &array)
+{
+  int ret = OB_SUCCESS;
+  static const int64_t NAME_LEN = 32;
+  ObIAllocator &alloc = holder.arena_;
+  const ObDatum *datums = is_batch ? arg.locate_batch_datums(ctx) : &arg.locate_expr_datum(ctx);
+  // only the first datum is valid for an arg not evaluated in batch
+  const bool is_const = !is_batch || !arg.is_batch_result();
+  const int64_t first = sel[0];
+  const ObPythonUdfUtil::PyColumnType col_type = ObPythonUdfUtil::get_column_type(arg.datum_meta_.type_);
+  char *name = static_cast<char *>(alloc.alloc(NAME_LEN));
+  const void **buffers = static_cast<const void **>(alloc.alloc(sizeof(void *) * 3));
+  MEMSET(&schema, 0, sizeof(schema));
+  MEMSET(&array, 0, sizeof(array));
+  if (OB_ISNULL(name) || OB_ISNULL(buffers)) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("fail to allocate arrow column", K(ret), K(idx));
+  } else {
+    snprintf(name, NAME_LEN, "arg%ld", idx);
+    schema.name = name;
+    schema.flags = ARROW_FLAG_NULLABLE;
+    buffers[0] = validity;
+    array.length = length;
+    array.null_count = length - sel_cnt;
+    array.buffers = buffers;
+  }
+  if (OB_FAIL(ret)) {
+  } else if (ObPythonUdfUtil::PY_COL_INTEGER == col_type
+             || ObPythonUdfUtil::PY_COL_REAL == col_type) {
+    const bool is_int = ObPythonUdfUtil::PY_COL_INTEGER == col_type;
+    const char *base = datums[is_const ? 0 : first].ptr_;
+    bool in_place = !is_const && 0 == reinterpret_cast<uintptr_t>(base) % sizeof(int64_t);
+    for (int64_t k = 0; in_place && k < sel_cnt; k++) {
+      in_place = datums[sel[k]].ptr_ == base + (sel[k] - first) * sizeof(int64_t)
+                 && sizeof(int64_t) == datums[sel[k]].len_;
+    }
+    schema.format = is_int ? "l" : "g";
+    array.n_buffers = 2;
+    if (in_place) {
+      buffers[1] = base;
+    } else {
+      void *data = alloc.alloc(sizeof(int64_t) * length);
+      if (OB_ISNULL(data)) {
+        ret = OB_ALLOCATE_MEMORY_FAILED;
+        LOG_WARN("fail to allocate arrow column data", K(ret), K(length));
+      } else {
+        MEMSET(data, 0, sizeof(int64_t) * length);
+        for (int64_t k = 0; k < sel_cnt; k++) {
+          const ObDatum &d = datums[is_const ? 0 : sel[k]];
+          if (is_int) {
+            static_cast<int64_t *>(data)[sel[k] - first] = d.get_int();
+          } else {
+            static_cast<double *>(data)[sel[k] - first] = d.get_double();
+          }
+        }
+        buffers[1] = data;
+      }
+    }
+  } else if (ObPythonUdfUtil::PY_COL_STRING == col_type) {
+    int64_t total = 0;
+    int32_t *offsets = NULL;
+    char *data = NULL;
+    for (int64_t k = 0; k < sel_cnt; k++) {
+      total += datums[is_const ? 0 : sel[k]].len_;
+    }
+    if (OB_UNLIKELY(total > INT32_MAX)) {
+      ret = OB_SIZE_OVERFLOW;
+      LOG_WARN("strings of the batch exceed int32 offsets", K(ret), K(total));
+    } else if (OB_ISNULL(offsets = static_cast<int32_t *>(alloc.alloc(sizeof(int32_t) * (length + 1))))
+               || OB_ISNULL(data = static_cast<char *>(alloc.alloc(total > 0 ? total : 1)))) {
+      ret = OB_ALLOCATE_MEMORY_FAILED;
+      LOG_WARN("fail to allocate arrow string column", K(ret), K(length), K(total));
+    } else {
+      // rows out of the selection are empty
+      int64_t pos = 0;
+      int32_t off = 0;
+      for (int64_t k = 0; k < sel_cnt; k++) {
+        const ObDatum &d = datums[is_const ? 0 : sel[k]];
+        for (; pos <= sel[k] - first; pos++) {
+          offsets[pos] = off;
+        }
+        MEMCPY(data + off, d.ptr_, d.len_);
+        off += static_cast<int32_t>(d.len_);
+      }
+      for (; pos <= length; pos++) {
+        offsets[pos] = off;
+      }
+      schema.format = "u";
+      array.n_buffers = 3;
+      buffers[1] = offsets;
+      buffers[2] = data;
+    }
+  } else {
+    ret = OB_NOT_SUPPORTED;
+    LOG_WARN("arg type is not supported in arrow batch", K(ret), K(idx), K(arg.datum_meta_.type_));
+  }
+  return ret;
+}
+
+int ObPyArrowBatch::import_result(const ObObjType type, const ArrowSchema &schema,
+                                  const ArrowArray &array, const int32_t *sel,
+                                  const int64_t sel_cnt, ObDatum *results, int64_t &ret_cnt)
+{
+  int ret = OB_SUCCESS;
+  const ObPythonUdfUtil::PyColumnType col_type = ObPythonUdfUtil::get_column_type(type);
+  const char *format = schema.format;
+  const uint8_t *validity = NULL;
+  int64_t first = 0;
+  bool by_row = false;
+  ret_cnt = 0;
+  if (OB_ISNULL(format) || OB_ISNULL(results) || (OB_ISNULL(sel) && sel_cnt > 0)
+      || OB_ISNULL(array.buffers)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid argument", K(ret), KP(format), KP(results), KP(sel), KP(array.buffers));
+  } else if (NULL != schema.dictionary || 0 != array.n_children || array.n_buffers < 2) {
+    ret = OB_NOT_SUPPORTED;
+    LOG_WARN("arrow result is not a flat array", K(ret), K(format), K(array.n_children));
+    LOG_USER_ERROR(OB_NOT_SUPPORTED, "python udf result of nested arrow type");
+  } else if (sel_cnt > 0) {
+    first = sel[0];
+    by_row = array.length >= sel[sel_cnt - 1] - first + 1;
+    ret_cnt = by_row ? sel_cnt : std::min(array.length, sel_cnt);
+    validity = static_cast<const uint8_t *>(array.buffers[0]);
+  }
+  if (OB_FAIL(ret) || 0 == ret_cnt) {
+  } else if (ObPythonUdfUtil::PY_COL_STRING == col_type) {
+    // utf8 or binary, with int32 or int64 offsets
+    const bool is_large = 0 == strcmp(format, "U") || 0 == strcmp(format, "Z");
+    const char *data = NULL;
+    if (!is_large && 0 != strcmp(format, "u") && 0 != strcmp(format, "z")) {
+      ret = OB_NOT_SUPPORTED;
+      LOG_WARN("arrow result is not a string array", K(ret), K(format));
+      LOG_USER_ERROR(OB_NOT_SUPPORTED, "python udf string result of non string arrow type");
+    } else if (OB_UNLIKELY(array.n_buffers < 3)) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_WARN("arrow string array without data buffer", K(ret), K(array.n_buffers));
+    } else {
+      data = static_cast<const char *>(array.buffers[2]);
+    }
+    for (int64_t k = 0; OB_SUCC(ret) && k < ret_cnt; k++) {
+      const int64_t i = array.offset + (by_row ? sel[k] - first : k);
+      if (is_arrow_null(validity, i)) {
+        results[sel[k]].set_null();
+      } else if (is_large) {
+        const int64_t *offsets = static_cast<const int64_t *>(array.buffers[1]);
+        results[sel[k]].set_string(data + offsets[i], static_cast<int32_t>(offsets[i + 1] - offsets[i]));
+      } else {
+        const int32_t *offsets = static_cast<const int32_t *>(array.buffers[1]);
+        results[sel[k]].set_string(data + offsets[i], offsets[i + 1] - offsets[i]);
+      }
+    }
+  } else if (ObPythonUdfUtil::PY_COL_INTEGER == col_type
+             || ObPythonUdfUtil::PY_COL_REAL == col_type) {
+    const bool is_int = ObPythonUdfUtil::PY_COL_INTEGER == col_type;
+    const char *data = static_cast<const char *>(array.buffers[1]);
+    bool is_float = false;
+    int64_t width = 0;
+    if (OB_FAIL(get_numeric_width(format, is_float, width))) {
+      LOG_WARN("arrow result is not a numeric array", K(ret), K(format));
+    } else if (OB_UNLIKELY(is_int && is_float)) {
+      ret = OB_NOT_SUPPORTED;
+      LOG_WARN("floating arrow result of an integer udf", K(ret), K(format));
+      LOG_USER_ERROR(OB_NOT_SUPPORTED, "python udf INTEGER result of floating arrow type");
+    }
+    for (int64_t k = 0; OB_SUCC(ret) && k < ret_cnt; k++) {
+      const int64_t i = array.offset + (by_row ? sel[k] - first : k);
+      ObDatum &res = results[sel[k]];
+      if (is_arrow_null(validity, i)) {
+        res.set_null();
+      } else if (is_float) {
+        res.set_double(8 == width ? reinterpret_cast<const double *>(data)[i]
+                                  : reinterpret_cast<const float *>(data)[i]);
+      } else {
+        int64_t v = 0;
+        switch (width) {
+          case 1: v = reinterpret_cast<const int8_t *>(data)[i]; break;
+          case 2: v = reinterpret_cast<const int16_t *>(data)[i]; break;
+          case 4: v = reinterpret_cast<const int32_t *>(data)[i]; break;
+          default: v = reinterpret_cast<const int64_t *>(data)[i]; break;
+        }
+        if (is_int) {
+          res.set_int(v);
+        } else {
+          res.set_double(static_cast<double>(v));
+        }
+      }
+    }
+  } else {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("unknown result type", K(ret), K(type));
+  }
+  return ret;
+}
+
+int ObPyArrowBatch::get_numeric_width(const char *format, bool &is_float, int64_t &width)
+{
+  int ret = OB_SUCCESS;
+  is_float = false;
+  width = 0;
+  if (OB_ISNULL(format) || '\0' == format[0] || '\0' != format[1]) {
+    ret = OB_NOT_SUPPORTED;
+  } else {
+    switch (format[0]) {
+      case 'c': width = 1; break;
+      case 's': width = 2; break;
+      case 'i': width = 4; break;
+      case 'l': width = 8; break;
+      case 'f': width = 4; is_float = true; break;
+      case 'g': width = 8; is_float = true; break;
+      default: ret = OB_NOT_SUPPORTED; break;
+    }
+  }
+  if (OB_FAIL(ret)) {
+    LOG_WARN("arrow format is not a supported numeric type", K(ret), K(format));
+    LOG_USER_ERROR(OB_NOT_SUPPORTED, "python udf numeric result of this arrow type");
+  }
+  return ret;
+}
+
+void ObPyArrowBatch::release_schema(ArrowSchema *schema)
+{
+  if (NULL != schema && NULL != schema->release) {
+    // children not moved by the consumer are released with their parent
+    for (int64_t i = 0; i < schema->n_children; i++) {
+      ArrowSchema *child = schema->children[i];
+      if (NULL != child->release) {
+        child->release(child);
+      }
+    }
+    schema->release = NULL;
+    dec_ref(static_cast<Holder *>(schema->private_data));
+  }
+}
+
+void ObPyArrowBatch::release_array(ArrowArray *array)
+{
+  if (NULL != array && NULL != array->release) {
+    for (int64_t i = 0; i < array->n_children; i++) {
+      ArrowArray *child = array->children[i];
+      if (NULL != child->release) {
+        child->release(child);
+      }
+    }
+    array->release = NULL;
+    dec_ref(static_cast<Holder *>(array->private_data));
+  }
+}
+
+void ObPyArrowBatch::dec_ref(Holder *holder)
+{
+  if (NULL != holder && 0 == ATOMIC_AAF(&holder->ref_cnt_, -1)) {
+    OB_DELETE(Holder, "PyArrowBatch", holder);
+  }
+}
+
+} // end namespace sql
+} // end namespace oceanbase
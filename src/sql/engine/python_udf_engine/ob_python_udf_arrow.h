@@ -0,0 +1,112 @@
+#ifndef OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_ARROW_H_
+#define OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_ARROW_H_
+
+#include <stdint.h>
+#include "lib/allocator/page_arena.h"
+#include "common/object/ob_obj_type.h"
+#include "share/datum/ob_datum.h"
+
+// Arrow C data interface (https://arrow.apache.org/docs/format/CDataInterface.html), the ABI is
+// stable and declared by producers and consumers themselves, no arrow library is linked
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  // Array type description
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray {
+  // Array data description
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+namespace oceanbase
+{
+namespace sql
+{
+struct ObExpr;
+struct ObEvalCtx;
+
+/*
+ * Args of a python udf as an arrow record batch, for BATCH_FORMAT ARROW udfs.
+ *
+ * The batch spans rows sel[0] to sel[sel_cnt - 1] of the operator batch, row r at position
+ * r - sel[0], with one column "arg<i>" per arg. Rows out of the selection (skipped, null args,
+ * cached or deduplicated) are unset in the validity bitmap shared by the columns, which is
+ * left out when every row is selected. INTEGER and REAL args are int64 ("l") and float64 ("g")
+ * columns, used in place when the datums of the rows are 8 bytes apart in one buffer, as they
+ * are for args evaluated in batch, and gathered otherwise. String args are utf8 ("u") columns
+ * of int32 offsets and one data buffer.
+ *
+ * Buffers built here belong to the exported structures and are freed by their release
+ * callbacks whenever pyarrow drops the batch. Values used in place belong to the operator
+ * batch, the model must not read them after pyfun returns.
+ */
+class ObPyArrowBatch
+{
+public:
+  // schema and array are released by the consumer, or by the caller if not consumed
+  static int export_batch(const ObExpr &expr, ObEvalCtx &ctx, const bool is_batch,
+                          const int32_t *sel, const int64_t sel_cnt,
+                          ArrowSchema &schema, ArrowArray &array);
+  // result of pyfun exported by pyarrow -> results of the selected rows. An array of a value
+  // per row of the batch gives value r - sel[0] to row r, a shorter one value k to row sel[k].
+  // Strings point into the buffers of the array
+  static int import_result(const common::ObObjType type, const ArrowSchema &schema,
+                           const ArrowArray &array, const int32_t *sel, const int64_t sel_cnt,
+                           common::ObDatum *results, int64_t &ret_cnt);
+
+private:
+  // memory of an exported batch, freed when every structure of it is released
+  struct Holder
+  {
+    explicit Holder(const uint64_t tenant_id)
+        : arena_("PyArrowBatch", common::OB_MALLOC_NORMAL_BLOCK_SIZE, tenant_id), ref_cnt_(0) {}
+    common::ObArenaAllocator arena_;
+    int64_t ref_cnt_;
+  };
+  static int export_column(const ObExpr &arg, ObEvalCtx &ctx, const bool is_batch,
+                           const int32_t *sel, const int64_t sel_cnt, const int64_t length,
+                           const uint8_t *validity, const int64_t idx, Holder &holder,
+                           ArrowSchema &schema, ArrowArray &array);
+  static void release_schema(ArrowSchema *schema);
+  static void release_array(ArrowArray *array);
+  static void dec_ref(Holder *holder);
+  // value width in bytes of a fixed width numeric format
+  static int get_numeric_width(const char *format, bool &is_float, int64_t &width);
+};
+
+} // end namespace sql
+} // end namespace oceanbase
+
+#endif // OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_ARROW_H_
@@ -0,0 +1,525 @@
+#define USING_LOG_PREFIX SQL_ENG
+
+#include "sql/engine/python_udf_engine/ob_python_udf_batch_tuner.h"
+#include <math.h>
+#include "lib/oblog/ob_log.h"
+#include "share/rc/ob_tenant_base.h"
+#include "observer/omt/ob_tenant_config_mgr.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+static int64_t clamp_batch_size(const ObPyBatchTuneState &state, const double size)
+{
+  int64_t ret_size = static_cast<int64_t>(size + 0.5);
+  if (ret_size < state.min_size_) {
+    ret_size = state.min_size_;
+  } else if (ret_size > state.max_size_) {
+    ret_size = state.max_size_;
+  }
+  return ret_size;
+}
+
+void ObPyBatchTuneState::reset()
+{
+  policy_ = PY_BATCH_HILL_CLIMB;
+  started_ = false;
+  converged_ = false;
+  cur_size_ = DEFAULT_BATCH_SIZE;
+  best_size_ = DEFAULT_BATCH_SIZE;
+  best_tput_ = 0;
+  min_size_ = MIN_BATCH_SIZE;
+  max_size_ = MAX_BATCH_SIZE;
+  step_ = 0;
+  dir_ = 1;
+  lo_ = 0;
+  hi_ = 0;
+  x1_ = 0;
+  x2_ = 0;
+  f1_ = 0;
+  f2_ = 0;
+  probe_ = 0;
+  slo_us_ = 0;
+  us_per_row_ = 0;
+  sample_cnt_ = 0;
+  drift_cnt_ = 0;
+  acc_rows_ = 0;
+  acc_cycles_ = 0;
+}
+
+OB_SERIALIZE_MEMBER(ObPyBatchTuneState,
+                    policy_,
+                    started_,
+                    converged_,
+                    cur_size_,
+                    best_size_,
+                    best_tput_,
+                    min_size_,
+                    max_size_,
+                    step_,
+                    dir_,
+                    lo_,
+                    hi_,
+                    x1_,
+                    x2_,
+                    f1_,
+                    f2_,
+                    probe_,
+                    slo_us_,
+                    us_per_row_);
+
+/* ------------------------------------ policies ----------------------------------- */
+const ObPyBatchPolicy &ObPyBatchPolicy::get_policy(const int64_t type)
+{
+  static const ObPyHillClimbPolicy hill_climb;
+  static const ObPyGoldenSectionPolicy golden_section;
+  static const ObPyLatencySloPolicy latency_slo;
+  static const ObPyFixedPolicy fixed;
+  const ObPyBatchPolicy *policy = &hill_climb;
+  switch (type) {
+    case PY_BATCH_GOLDEN_SECTION: policy = &golden_section; break;
+    case PY_BATCH_LATENCY_SLO: policy = &latency_slo; break;
+    case PY_BATCH_FIXED: policy = &fixed; break;
+    default: break;
+  }
+  return *policy;
+}
+
+int64_t ObPyBatchPolicy::get_policy_type(const ObString &name)
+{
+  int64_t type = PY_BATCH_HILL_CLIMB;
+  if (0 == name.case_compare("GOLDEN_SECTION")) {
+    type = PY_BATCH_GOLDEN_SECTION;
+  } else if (0 == name.case_compare("LATENCY_SLO")) {
+    type = PY_BATCH_LATENCY_SLO;
+  } else if (0 != name.case_compare("HILL_CLIMB")) {
+    LOG_WARN_RET(OB_INVALID_ARGUMENT, "unknown python udf batch size policy, use HILL_CLIMB", K(name));
+  }
+  return type;
+}
+
+void ObPyHillClimbPolicy::start(ObPyBatchTuneState &state) const
+{
+  state.step_ = state.converged_ ? MIN_STEP : INIT_STEP;
+  state.dir_ = 1;
+}
+
+// probe best * (1 + step) ^ dir, reverse the direction and then halve the step on regression
+void ObPyHillClimbPolicy::update(ObPyBatchTuneState &state, const double tput) const
+{
+  if (tput > state.best_tput_ * (1 + MIN_GAIN) || state.best_tput_ <= 0) {
+    state.best_tput_ = tput;
+    state.best_size_ = state.cur_size_;
+  } else if (state.dir_ > 0 && state.best_size_ > state.min_size_) {
+    state.dir_ = -1;
+  } else {
+    state.dir_ = 1;
+    state.step_ /= 2;
+  }
+  if (state.step_ < MIN_STEP) {
+    state.converged_ = true;
+    state.cur_size_ = state.best_size_;
+  } else {
+    const double factor = state.dir_ > 0 ? 1 + state.step_ : 1 / (1 + state.step_);
+    const int64_t next = clamp_batch_size(state, state.best_size_ * factor);
+    if (next == state.best_size_) {
+      // bound reached in this direction
+      state.dir_ = -state.dir_;
+      state.step_ = state.dir_ > 0 ? state.step_ / 2 : state.step_;
+      state.cur_size_ = clamp_batch_size(state, state.best_size_ * (state.dir_ > 0 ? 1 + state.step_
+                                                                                  : 1 / (1 + state.step_)));
+      if (state.cur_size_ == state.best_size_) {
+        state.converged_ = true;
+      }
+    } else {
+      state.cur_size_ = next;
+    }
+  }
+}
+
+void ObPyGoldenSectionPolicy::start(ObPyBatchTuneState &state) const
+{
+  state.lo_ = log2(static_cast<double>(state.min_size_));
+  state.hi_ = log2(static_cast<double>(state.max_size_));
+  state.x1_ = state.hi_ - GOLDEN_RATIO * (state.hi_ - state.lo_);
+  state.x2_ = state.lo_ + GOLDEN_RATIO * (state.hi_ - state.lo_);
+  state.f1_ = 0;
+  state.f2_ = 0;
+  state.probe_ = 1;
+  state.cur_size_ = clamp_batch_size(state, exp2(state.x1_));
+}
+
+// maximize the throughput on [lo, hi], one new point per iteration
+void ObPyGoldenSectionPolicy::update(ObPyBatchTuneState &state, const double tput) const
+{
+  if (tput > state.best_tput_) {
+    state.best_tput_ = tput;
+    state.best_size_ = state.cur_size_;
+  }
+  if (1 == state.probe_ && 0 == state.f2_) {
+    // first measure of both inner points
+    state.f1_ = tput;
+    state.probe_ = 2;
+  } else {
+    if (1 == state.probe_) {
+      state.f1_ = tput;
+    } else {
+      state.f2_ = tput;
+    }
+    if (state.f1_ < state.f2_) {
+      state.lo_ = state.x1_;
+      state.x1_ = state.x2_;
+      state.f1_ = state.f2_;
+      state.x2_ = state.lo_ + GOLDEN_RATIO * (state.hi_ - state.lo_);
+      state.probe_ = 2;
+    } else {
+      state.hi_ = state.x2_;
+      state.x2_ = state.x1_;
+      state.f2_ = state.f1_;
+      state.x1_ = state.hi_ - GOLDEN_RATIO * (state.hi_ - state.lo_);
+      state.probe_ = 1;
+    }
+  }
+  if (state.hi_ - state.lo_ < MIN_INTERVAL) {
+    state.converged_ = true;
+    state.cur_size_ = state.best_size_;
+  } else {
+    state.cur_size_ = clamp_batch_size(state, exp2(1 == state.probe_ ? state.x1_ : state.x2_));
+  }
+}
+
+void ObPyLatencySloPolicy::start(ObPyBatchTuneState &state) const
+{
+  ObPyHillClimbPolicy::start(state);
+  state.us_per_row_ = 0;
+}
+
+// hill climbing with max_size_ following the rows one call can take within the slo
+void ObPyLatencySloPolicy::update(ObPyBatchTuneState &state, const double tput) const
+{
+  if (state.slo_us_ > 0 && state.us_per_row_ > 0) {
+    state.max_size_ = clamp_batch_size(state, SLO_HEADROOM * state.slo_us_ / state.us_per_row_);
+    if (state.best_size_ > state.max_size_) {
+      // best size is out of the slo now, search again below it
+      state.best_size_ = state.max_size_;
+      state.best_tput_ = 0;
+      state.converged_ = false;
+    }
+  }
+  ObPyHillClimbPolicy::update(state, tput);
+  if (state.cur_size_ > state.max_size_) {
+    state.cur_size_ = state.max_size_;
+  }
+}
+
+/* ------------------------------------ tuner ----------------------------------- */
+OB_SERIALIZE_MEMBER(ObPyBatchTuner, udf_id_, schema_version_, state_);
+
+int ObPyBatchTuner::assign(const ObPyBatchTuner &other)
+{
+  int ret = OB_SUCCESS;
+  if (this != &other) {
+    ObPyBatchTuneState state = other.get_state();
+    ObSpinLockGuard guard(lock_);
+    udf_id_ = other.udf_id_;
+    schema_version_ = other.schema_version_;
+    state_ = state;
+  }
+  return ret;
+}
+
+ObPyBatchTuneState ObPyBatchTuner::get_state() const
+{
+  ObSpinLockGuard guard(lock_);
+  return state_;
+}
+
+void ObPyBatchTuner::set_fixed_size(const int64_t size)
+{
+  ObSpinLockGuard guard(lock_);
+  state_.reset();
+  state_.policy_ = PY_BATCH_FIXED;
+  state_.cur_size_ = size;
+  state_.best_size_ = size;
+  state_.started_ = true;
+  state_.converged_ = true;
+}
+
+void ObPyBatchTuner::set_max_size(const int64_t size)
+{
+  ObSpinLockGuard guard(lock_);
+  if (!state_.started_) {
+    start();
+  }
+  state_.max_size_ = std::max(std::min(size, static_cast<int64_t>(ObPyBatchTuneState::MAX_BATCH_SIZE)),
+                              state_.min_size_);
+  if (state_.cur_size_ > state_.max_size_) {
+    state_.cur_size_ = state_.max_size_;
+  }
+  if (state_.best_size_ > state_.max_size_) {
+    state_.best_size_ = state_.max_size_;
+  }
+}
+
+void ObPyBatchTuner::start()
+{
+  int tmp_ret = OB_SUCCESS;
+  int64_t learned_size = 0;
+  ObPyBatchSizeCache *cache = MTL(ObPyBatchSizeCache*);
+  omt::ObTenantConfigGuard tenant_config(TENANT_CONF(MTL_ID()));
+  state_.reset();
+  if (tenant_config.is_valid()) {
+    state_.policy_ = ObPyBatchPolicy::get_policy_type(
+        ObString::make_string(tenant_config->_python_udf_batch_size_policy.str()));
+    state_.slo_us_ = tenant_config->_python_udf_batch_latency_slo;
+  }
+  if (NULL == cache) {
+  } else if (OB_SUCCESS != (tmp_ret = cache->get(udf_id_, schema_version_, learned_size))) {
+    if (OB_HASH_NOT_EXIST != tmp_ret) {
+      LOG_WARN_RET(tmp_ret, "fail to get learned python udf batch size", K_(udf_id));
+    }
+  } else {
+    // learned by a previous query, only watched for drift
+    state_.cur_size_ = learned_size;
+    state_.best_size_ = learned_size;
+    state_.converged_ = true;
+  }
+  ObPyBatchPolicy::get_policy(state_.policy_).start(state_);
+  state_.started_ = true;
+}
+
+int64_t ObPyBatchTuner::get_batch_size()
+{
+  ObSpinLockGuard guard(lock_);
+  if (!state_.started_) {
+    start();
+  }
+  return state_.cur_size_;
+}
+
+void ObPyBatchTuner::add_sample(const ObPyBatchSample &sample)
+{
+  bool converged = false;
+  int64_t best_size = 0;
+  double us_per_row = 0;
+  {
+    ObSpinLockGuard guard(lock_);
+    ObPyBatchTuneState &s = state_;
+    if (!s.started_) {
+      start();
+    }
+    // partial batches (end of scan, rows with null args) say little about the size
+    if (PY_BATCH_FIXED == s.policy_ || sample.rows_ <= 0 || sample.cycles_ <= 0
+        || sample.rows_ * 4 < s.cur_size_ * 3) {
+    } else {
+      const double row_us = static_cast<double>(sample.latency_us_) / sample.rows_;
+      s.us_per_row_ = s.us_per_row_ <= 0 ? row_us : 0.75 * s.us_per_row_ + 0.25 * row_us;
+      s.acc_rows_ += sample.rows_;
+      s.acc_cycles_ += sample.cycles_;
+      if (++s.sample_cnt_ >= SAMPLES_PER_PROBE) {
+        const double tput = static_cast<double>(s.acc_rows_) * 1000 / s.acc_cycles_;
+        s.sample_cnt_ = 0;
+        s.acc_rows_ = 0;
+        s.acc_cycles_ = 0;
+        if (!s.converged_) {
+          ObPyBatchPolicy::get_policy(s.policy_).update(s, tput);
+          converged = s.converged_;
+          best_size = s.best_size_;
+          us_per_row = s.us_per_row_;
+        } else if (s.best_tput_ <= 0) {
+          // converged size from the cache, measure it first
+          s.best_tput_ = tput;
+        } else if (tput < s.best_tput_ * DRIFT_RATIO) {
+          if (++s.drift_cnt_ >= DRIFT_SAMPLES) {
+            // data or model changed, search again from the current size
+            s.converged_ = false;
+            s.drift_cnt_ = 0;
+            s.best_tput_ = 0;
+            ObPyBatchPolicy::get_policy(s.policy_).start(s);
+          }
+        } else {
+          s.drift_cnt_ = 0;
+        }
+      }
+    }
+    if (converged) {
+      LOG_INFO("python udf batch size converged", K_(udf_id), K_(state));
+    }
+  }
+  if (converged && NULL != MTL(ObPyBatchSizeCache*)) {
+    int tmp_ret = MTL(ObPyBatchSizeCache*)->put(udf_id_, schema_version_, best_size, us_per_row);
+    if (OB_SUCCESS != tmp_ret) {
+      LOG_WARN_RET(tmp_ret, "fail to save learned python udf batch size", K_(udf_id));
+    }
+  }
+}
+
+/* ------------------------------------ cache ----------------------------------- */
+int ObPyBatchSizeCache::init(const uint64_t tenant_id)
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(inited_)) {
+    ret = OB_INIT_TWICE;
+    LOG_WARN("python udf batch size cache init twice", K(ret));
+  } else if (OB_FAIL(sizes_.create(BUCKET_NUM, ObMemAttr(tenant_id, "PyUdfBatchSize")))) {
+    LOG_WARN("fail to create hash map", K(ret));
+  } else {
+    inited_ = true;
+  }
+  return ret;
+}
+
+void ObPyBatchSizeCache::destroy()
+{
+  if (inited_) {
+    sizes_.destroy();
+    inited_ = false;
+  }
+}
+
+int ObPyBatchSizeCache::mtl_init(ObPyBatchSizeCache* &cache)
+{
+  int ret = OB_SUCCESS;
+  uint64_t tenant_id = lib::current_resource_owner_id();
+  cache = OB_NEW(ObPyBatchSizeCache, ObModIds::OB_SQL_EXECUTOR);
+  if (nullptr == cache) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("failed to alloc memory for ObPyBatchSizeCache", K(ret));
+  } else if (OB_FAIL(cache->init(tenant_id))) {
+    LOG_WARN("failed to init python udf batch size cache", K(ret));
+  }
+  if (OB_FAIL(ret) && cache != nullptr) {
+    // cleanup
+    ob_delete(cache);
+    cache = nullptr;
+  }
+  return ret;
+}
+
+void ObPyBatchSizeCache::mtl_destroy(ObPyBatchSizeCache* &cache)
+{
+  if (cache != nullptr) {
+    ob_delete(cache);
+    cache = nullptr;
+  }
+}
+
+int ObPyBatchSizeCache::get(const uint64_t udf_id, const int64_t schema_version, int64_t &batch_size)
+{
+  double us_per_row = 0;
+  return get(udf_id, schema_version, batch_size, us_per_row);
+}
+
+int ObPyBatchSizeCache::get(const uint64_t udf_id, const int64_t schema_version, int64_t &batch_size,
+                            double &us_per_row)
+{
+  int ret = OB_SUCCESS;
+  Entry entry;
+  if (OB_UNLIKELY(!inited_)) {
+    ret = OB_NOT_INIT;
+  } else if (OB_FAIL(sizes_.get_refactored(udf_id, entry))) {
+    // OB_HASH_NOT_EXIST
+  } else if (entry.schema_version_ != schema_version || entry.batch_size_ <= 0) {
+    // udf was replaced or only its selectivity is known, learned size does not apply
+    ret = OB_HASH_NOT_EXIST;
+  } else {
+    batch_size = entry.batch_size_;
+    us_per_row = entry.us_per_row_;
+  }
+  return ret;
+}
+
+int ObPyBatchSizeCache::get_selectivity(const uint64_t udf_id, const int64_t schema_version,
+                                        double &selectivity)
+{
+  int ret = OB_SUCCESS;
+  Entry entry;
+  if (OB_UNLIKELY(!inited_)) {
+    ret = OB_NOT_INIT;
+  } else if (OB_FAIL(sizes_.get_refactored(udf_id, entry))) {
+    // OB_HASH_NOT_EXIST
+  } else if (entry.schema_version_ != schema_version || entry.sel_rows_ <= 0) {
+    ret = OB_HASH_NOT_EXIST;
+  } else {
+    selectivity = entry.selectivity_;
+  }
+  return ret;
+}
+
+int ObPyBatchSizeCache::put(const uint64_t udf_id, const int64_t schema_version, const int64_t batch_size,
+                            const double us_per_row)
+{
+  int ret = OB_SUCCESS;
+  SizeUpdater updater(schema_version, batch_size, us_per_row);
+  if (OB_FAIL(update(udf_id, updater))) {
+    LOG_WARN("fail to set learned batch size", K(ret), K(udf_id), K(batch_size));
+  }
+  return ret;
+}
+
+int ObPyBatchSizeCache::add_selectivity(const uint64_t udf_id, const int64_t schema_version,
+                                        const int64_t input_rows, const int64_t output_rows)
+{
+  int ret = OB_SUCCESS;
+  SelectivityUpdater updater(schema_version, input_rows, output_rows);
+  if (OB_UNLIKELY(input_rows <= 0 || output_rows < 0 || output_rows > input_rows)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid selectivity sample", K(ret), K(input_rows), K(output_rows));
+  } else if (OB_FAIL(update(udf_id, updater))) {
+    LOG_WARN("fail to add learned selectivity", K(ret), K(udf_id), K(input_rows), K(output_rows));
+  }
+  return ret;
+}
+
+template <typename Updater>
+int ObPyBatchSizeCache::update(const uint64_t udf_id, Updater &updater)
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(!inited_)) {
+    ret = OB_NOT_INIT;
+  } else if (OB_SUCC(sizes_.atomic_refactored(udf_id, updater))) {
+  } else if (OB_HASH_NOT_EXIST != ret) {
+    LOG_WARN("fail to update entry", K(ret), K(udf_id));
+  } else {
+    Entry entry;
+    updater.apply(entry);
+    if (OB_SUCC(sizes_.set_refactored(udf_id, entry, 0 /* overwrite */))) {
+    } else if (OB_HASH_EXIST != ret) {
+      LOG_WARN("fail to set entry", K(ret), K(udf_id));
+    } else if (OB_FAIL(sizes_.atomic_refactored(udf_id, updater))) {
+      // set by another thread in between
+      LOG_WARN("fail to update entry", K(ret), K(udf_id));
+    }
+  }
+  return ret;
+}
+
+void ObPyBatchSizeCache::SizeUpdater::apply(Entry &entry) const
+{
+  if (entry.schema_version_ != schema_version_) {
+    entry = Entry();
+    entry.schema_version_ = schema_version_;
+  }
+  entry.batch_size_ = batch_size_;
+  entry.us_per_row_ = us_per_row_;
+}
+
+void ObPyBatchSizeCache::SelectivityUpdater::apply(Entry &entry) const
+{
+  if (entry.schema_version_ != schema_version_) {
+    entry = Entry();
+    entry.schema_version_ = schema_version_;
+  }
+  // weighted by rows, with the weight of the history capped so the estimate follows the data
+  const int64_t history_rows = std::min(entry.sel_rows_, SEL_HISTORY_ROWS);
+  entry.selectivity_ = (entry.selectivity_ * static_cast<double>(history_rows)
+                        + static_cast<double>(output_rows_))
+                       / static_cast<double>(history_rows + input_rows_);
+  entry.sel_rows_ = history_rows + input_rows_;
+}
+
+} // end namespace sql
+} // end namespace oceanbase
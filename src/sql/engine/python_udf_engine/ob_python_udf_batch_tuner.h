@@ -0,0 +1,254 @@
+#ifndef OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_BATCH_TUNER_H_
+#define OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_BATCH_TUNER_H_
+
+#include "lib/utility/ob_unify_serialize.h"
+#include "lib/utility/ob_print_utils.h"
+#include "lib/hash/ob_hashmap.h"
+#include "lib/lock/ob_spin_lock.h"
+#include "lib/string/ob_string.h"
+
+namespace oceanbase
+{
+namespace sql
+{
+
+/*
+ * Tuning of the number of rows per python call of a python udf.
+ *
+ * Every full batch is a sample (rows, cycles, latency) fed to the policy chosen by tenant
+ * config _python_udf_batch_size_policy, the policy moves the batch size of the next batches.
+ * Throughput is compared in rows per cycle of the monotonic cycle counter. The size a policy
+ * converged to is kept in the tenant ObPyBatchSizeCache and used as the starting point by
+ * later queries of the same udf. Hint PREDICT_BATCH(udf, size) fixes the size.
+ */
+
+enum ObPyBatchPolicyType
+{
+  PY_BATCH_HILL_CLIMB = 0,
+  PY_BATCH_GOLDEN_SECTION = 1,
+  PY_BATCH_LATENCY_SLO = 2, // hill climbing below the size meeting the latency SLO
+  PY_BATCH_FIXED = 3, // PREDICT_BATCH hint
+  PY_BATCH_POLICY_MAX
+};
+
+struct ObPyBatchSample
+{
+  ObPyBatchSample(const int64_t rows, const int64_t cycles, const int64_t latency_us)
+      : rows_(rows), cycles_(cycles), latency_us_(latency_us) {}
+  TO_STRING_KV(K_(rows), K_(cycles), K_(latency_us));
+  int64_t rows_;
+  int64_t cycles_;
+  int64_t latency_us_;
+};
+
+// tuning state of a python udf, copied and serialized with the udf expr so that
+// PX workers continue from the state of the coordinator
+struct ObPyBatchTuneState
+{
+  OB_UNIS_VERSION(1);
+public:
+  static const int64_t DEFAULT_BATCH_SIZE = 256;
+  static const int64_t MIN_BATCH_SIZE = 16;
+  static const int64_t MAX_BATCH_SIZE = 65536; // the operator may grant less, see set_max_size()
+
+  ObPyBatchTuneState() { reset(); }
+  void reset();
+  bool is_started() const { return started_; }
+
+  TO_STRING_KV(K_(policy), K_(started), K_(converged), K_(cur_size), K_(best_size),
+               K_(best_tput), K_(min_size), K_(max_size), K_(step), K_(dir), K_(lo), K_(hi),
+               K_(x1), K_(x2), K_(f1), K_(f2), K_(probe), K_(slo_us), K_(us_per_row),
+               K_(sample_cnt), K_(drift_cnt), K_(acc_rows), K_(acc_cycles));
+
+  int64_t policy_; // ObPyBatchPolicyType
+  bool started_;
+  bool converged_;
+  int64_t cur_size_; // rows per python call of the next batches
+  int64_t best_size_;
+  double best_tput_; // rows per kilo cycle at best_size_
+  int64_t min_size_;
+  int64_t max_size_;
+  // hill climbing
+  double step_; // relative size change of the next probe
+  int64_t dir_; // 1 grows, -1 shrinks
+  // golden section search, on log2 of the size
+  double lo_;
+  double hi_;
+  double x1_;
+  double x2_;
+  double f1_;
+  double f2_;
+  int64_t probe_; // 1: x1_ is being measured, 2: x2_ is being measured
+  // latency slo
+  int64_t slo_us_;
+  double us_per_row_;
+  // samples of the current probe, averaged to smooth noisy batches
+  int64_t sample_cnt_;
+  int64_t drift_cnt_;
+  int64_t acc_rows_;
+  int64_t acc_cycles_;
+};
+
+// a batch size policy, stateless, works on ObPyBatchTuneState
+class ObPyBatchPolicy
+{
+public:
+  virtual ~ObPyBatchPolicy() {}
+  virtual void start(ObPyBatchTuneState &state) const = 0;
+  // tput is the averaged throughput measured at state.cur_size_
+  virtual void update(ObPyBatchTuneState &state, const double tput) const = 0;
+  static const ObPyBatchPolicy &get_policy(const int64_t type);
+  static int64_t get_policy_type(const common::ObString &name);
+};
+
+class ObPyHillClimbPolicy : public ObPyBatchPolicy
+{
+public:
+  static constexpr double INIT_STEP = 1.0; // doubles the size at first
+  static constexpr double MIN_STEP = 0.0625;
+  static constexpr double MIN_GAIN = 0.05;
+  virtual void start(ObPyBatchTuneState &state) const override;
+  virtual void update(ObPyBatchTuneState &state, const double tput) const override;
+};
+
+class ObPyGoldenSectionPolicy : public ObPyBatchPolicy
+{
+public:
+  static constexpr double GOLDEN_RATIO = 0.6180339887;
+  static constexpr double MIN_INTERVAL = 0.25; // log2 of the size
+  virtual void start(ObPyBatchTuneState &state) const override;
+  virtual void update(ObPyBatchTuneState &state, const double tput) const override;
+};
+
+class ObPyLatencySloPolicy : public ObPyHillClimbPolicy
+{
+public:
+  static constexpr double SLO_HEADROOM = 0.9;
+  virtual void start(ObPyBatchTuneState &state) const override;
+  virtual void update(ObPyBatchTuneState &state, const double tput) const override;
+};
+
+class ObPyFixedPolicy : public ObPyBatchPolicy
+{
+public:
+  virtual void start(ObPyBatchTuneState &state) const override { state.converged_ = true; }
+  virtual void update(ObPyBatchTuneState &state, const double tput) const override {}
+};
+
+class ObPyBatchTuner
+{
+  OB_UNIS_VERSION(1);
+public:
+  static const int64_t SAMPLES_PER_PROBE = 3;
+  static constexpr double DRIFT_RATIO = 0.7; // a converged size is searched again below it
+  static const int64_t DRIFT_SAMPLES = 8;
+
+  ObPyBatchTuner() : lock_(), udf_id_(common::OB_INVALID_ID),
+                     schema_version_(common::OB_INVALID_VERSION), state_() {}
+  int assign(const ObPyBatchTuner &other);
+  void set_udf(const uint64_t udf_id, const int64_t schema_version)
+  {
+    udf_id_ = udf_id;
+    schema_version_ = schema_version;
+  }
+  // PREDICT_BATCH hint
+  void set_fixed_size(const int64_t size);
+  // rows the python udf operator can buffer with its work area
+  void set_max_size(const int64_t size);
+  // the policy is chosen by tenant config at the first call
+  int64_t get_batch_size();
+  // feed a finished python call
+  void add_sample(const ObPyBatchSample &sample);
+  ObPyBatchTuneState get_state() const;
+
+  TO_STRING_KV(K_(udf_id), K_(schema_version), K_(state));
+
+private:
+  // called with lock_ held
+  void start();
+
+private:
+  mutable common::ObSpinLock lock_;
+  uint64_t udf_id_;
+  int64_t schema_version_;
+  ObPyBatchTuneState state_;
+};
+
+/*
+ * Per-tenant cache of converged batch sizes, keyed by udf id and shared across queries.
+ * The inference time per row measured at that size and the selectivity observed for filters
+ * on the udf feed the optimizer, see ObLogPythonUDF.
+ */
+class ObPyBatchSizeCache
+{
+public:
+  static const int64_t BUCKET_NUM = 1024;
+  // rows of past executions weighing against a new selectivity sample, older ones fade out
+  static const int64_t SEL_HISTORY_ROWS = 1L << 20;
+
+  ObPyBatchSizeCache() : inited_(false) {}
+  ~ObPyBatchSizeCache() { destroy(); }
+  int init(const uint64_t tenant_id);
+  void destroy();
+  static int mtl_init(ObPyBatchSizeCache* &cache);
+  static void mtl_destroy(ObPyBatchSizeCache* &cache);
+
+  // OB_HASH_NOT_EXIST if nothing is learned for this version of the udf
+  int get(const uint64_t udf_id, const int64_t schema_version, int64_t &batch_size);
+  int get(const uint64_t udf_id, const int64_t schema_version, int64_t &batch_size,
+          double &us_per_row);
+  int put(const uint64_t udf_id, const int64_t schema_version, const int64_t batch_size,
+          const double us_per_row);
+  // OB_HASH_NOT_EXIST if no filter on this version of the udf was observed
+  int get_selectivity(const uint64_t udf_id, const int64_t schema_version, double &selectivity);
+  // rows entering and leaving the filters on the udf in one execution
+  int add_selectivity(const uint64_t udf_id, const int64_t schema_version,
+                      const int64_t input_rows, const int64_t output_rows);
+
+private:
+  struct Entry
+  {
+    Entry() : schema_version_(common::OB_INVALID_VERSION), batch_size_(0), us_per_row_(0),
+              selectivity_(0), sel_rows_(0) {}
+    TO_STRING_KV(K_(schema_version), K_(batch_size), K_(us_per_row), K_(selectivity),
+                 K_(sel_rows));
+    int64_t schema_version_;
+    int64_t batch_size_; // 0 if not converged yet
+    double us_per_row_;
+    double selectivity_;
+    int64_t sel_rows_; // rows selectivity_ was observed on, 0 if not observed
+  };
+  typedef common::hash::HashMapPair<uint64_t, Entry> EntryPair;
+  // callbacks of atomic_refactored(), an entry of another version of the udf is started over
+  struct SizeUpdater
+  {
+    SizeUpdater(const int64_t schema_version, const int64_t batch_size, const double us_per_row)
+        : schema_version_(schema_version), batch_size_(batch_size), us_per_row_(us_per_row) {}
+    void operator()(EntryPair &pair) { apply(pair.second); }
+    void apply(Entry &entry) const;
+    int64_t schema_version_;
+    int64_t batch_size_;
+    double us_per_row_;
+  };
+  struct SelectivityUpdater
+  {
+    SelectivityUpdater(const int64_t schema_version, const int64_t input_rows,
+                       const int64_t output_rows)
+        : schema_version_(schema_version), input_rows_(input_rows), output_rows_(output_rows) {}
+    void operator()(EntryPair &pair) { apply(pair.second); }
+    void apply(Entry &entry) const;
+    int64_t schema_version_;
+    int64_t input_rows_;
+    int64_t output_rows_;
+  };
+  template <typename Updater>
+  int update(const uint64_t udf_id, Updater &updater);
+  common::hash::ObHashMap<uint64_t, Entry> sizes_;
+  bool inited_;
+  DISALLOW_COPY_AND_ASSIGN(ObPyBatchSizeCache);
+};
+
+} // end namespace sql
+} // end namespace oceanbase
+
+#endif // OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_BATCH_TUNER_H_
@@ -0,0 +1,151 @@
+#define USING_LOG_PREFIX SQL_ENG
+
+#include "sql/engine/python_udf_engine/ob_python_udf_dedup.h"
+#include "lib/oblog/ob_log.h"
+#include "share/rc/ob_tenant_base.h"
+#include "observer/omt/ob_tenant_config_mgr.h"
+#include "sql/engine/expr/ob_expr.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+bool ObPyDedupStat::need_dedup(const int64_t sel_cnt)
+{
+  bool need = false;
+  ObSpinLockGuard guard(lock_);
+  if (!started_) {
+    omt::ObTenantConfigGuard tenant_config(TENANT_CONF(MTL_ID()));
+    if (tenant_config.is_valid()) {
+      max_ratio_ = tenant_config->_python_udf_dedup_distinct_ratio;
+    }
+    started_ = true;
+  }
+  if (max_ratio_ <= 0 || sel_cnt < MIN_ROWS) {
+  } else if (distinct_ratio_ <= max_ratio_) {
+    // also the first batch, nothing is known yet
+    need = true;
+  } else if (++skipped_cnt_ >= PROBE_INTERVAL) {
+    need = true;
+  }
+  return need;
+}
+
+void ObPyDedupStat::add_batch(const int64_t sel_cnt, const int64_t distinct_cnt)
+{
+  if (sel_cnt > 0) {
+    ObSpinLockGuard guard(lock_);
+    distinct_ratio_ = static_cast<double>(distinct_cnt) / static_cast<double>(sel_cnt);
+    skipped_cnt_ = 0;
+    ++batch_cnt_;
+    row_cnt_ += sel_cnt;
+    dedup_row_cnt_ += sel_cnt - distinct_cnt;
+  }
+}
+
+int ObPyBatchDedup::prepare(ObIAllocator &alloc, const int64_t size)
+{
+  int ret = OB_SUCCESS;
+  dup_cnt_ = 0;
+  if (size > capacity_) {
+    int64_t slot_cnt = 1;
+    while (slot_cnt < size * 2) {
+      slot_cnt <<= 1;
+    }
+    void *skip_buf = NULL;
+    uint64_t *hashes = static_cast<uint64_t *>(alloc.alloc(sizeof(uint64_t) * size));
+    int32_t *slots = static_cast<int32_t *>(alloc.alloc(sizeof(int32_t) * slot_cnt));
+    int32_t *dup_rows = static_cast<int32_t *>(alloc.alloc(sizeof(int32_t) * size));
+    int32_t *dup_srcs = static_cast<int32_t *>(alloc.alloc(sizeof(int32_t) * size));
+    if (OB_ISNULL(hashes) || OB_ISNULL(slots) || OB_ISNULL(dup_rows) || OB_ISNULL(dup_srcs)
+        || OB_ISNULL(skip_buf = alloc.alloc(ObBitVector::memory_size(size)))) {
+      ret = OB_ALLOCATE_MEMORY_FAILED;
+      LOG_WARN("fail to allocate dedup buffers", K(ret), K(size), K(slot_cnt));
+    } else {
+      capacity_ = size;
+      slot_cnt_ = slot_cnt;
+      hashes_ = hashes;
+      skip_ = to_bit_vector(skip_buf);
+      slots_ = slots;
+      dup_rows_ = dup_rows;
+      dup_srcs_ = dup_srcs;
+    }
+  }
+  return ret;
+}
+
+int ObPyBatchDedup::dedup(const ObExpr &expr, ObEvalCtx &ctx, int32_t *sel, int64_t &sel_cnt)
+{
+  int ret = OB_SUCCESS;
+  // rows are in increasing order in the selection
+  const int64_t size = sel_cnt > 0 ? sel[sel_cnt - 1] + 1 : 0;
+  const uint64_t seed = 0;
+  int64_t distinct_cnt = 0;
+  dup_cnt_ = 0;
+  if (OB_ISNULL(sel) || OB_UNLIKELY(size > capacity_)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid selection", K(ret), KP(sel), K(size), K_(capacity));
+  } else if (sel_cnt > 0) {
+    skip_->set_all(size);
+    for (int64_t k = 0; k < sel_cnt; k++) {
+      skip_->unset(sel[k]);
+      hashes_[sel[k]] = seed;
+    }
+    // const args are the same for every row
+    for (int64_t i = 0; i < expr.arg_cnt_; i++) {
+      const ObExpr *arg = expr.args_[i];
+      if (arg->is_batch_result()) {
+        arg->basic_funcs_->murmur_hash_v2_batch_(hashes_, arg->locate_batch_datums(ctx), true,
+                                                 *skip_, size, hashes_, true);
+      }
+    }
+    MEMSET(slots_, 0xFF, sizeof(int32_t) * slot_cnt_);
+    const uint64_t mask = slot_cnt_ - 1;
+    for (int64_t k = 0; k < sel_cnt; k++) {
+      const int32_t row = sel[k];
+      uint64_t pos = hashes_[row] & mask;
+      while (slots_[pos] >= 0
+             && (hashes_[slots_[pos]] != hashes_[row] || !is_equal(expr, ctx, slots_[pos], row))) {
+        pos = (pos + 1) & mask;
+      }
+      if (slots_[pos] < 0) {
+        slots_[pos] = row;
+        sel[distinct_cnt++] = row;
+      } else {
+        dup_rows_[dup_cnt_] = row;
+        dup_srcs_[dup_cnt_] = slots_[pos];
+        ++dup_cnt_;
+      }
+    }
+    LOG_DEBUG("python udf batch deduplicated", K(sel_cnt), K(distinct_cnt));
+    sel_cnt = distinct_cnt;
+  }
+  return ret;
+}
+
+void ObPyBatchDedup::scatter(ObDatum *results)
+{
+  // string results point into the buffer of the row kept, alive for the whole batch
+  for (int64_t i = 0; i < dup_cnt_; i++) {
+    results[dup_rows_[i]] = results[dup_srcs_[i]];
+  }
+  dup_cnt_ = 0;
+}
+
+bool ObPyBatchDedup::is_equal(const ObExpr &expr, ObEvalCtx &ctx, const int64_t l, const int64_t r)
+{
+  bool equal = true;
+  for (int64_t i = 0; equal && i < expr.arg_cnt_; i++) {
+    const ObExpr *arg = expr.args_[i];
+    if (arg->is_batch_result()) {
+      const ObDatum *datums = arg->locate_batch_datums(ctx);
+      equal = ObDatum::binary_equal(datums[l], datums[r]);
+    }
+  }
+  return equal;
+}
+
+} // end namespace sql
+} // end namespace oceanbase
@@ -0,0 +1,93 @@
+#ifndef OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_DEDUP_H_
+#define OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_DEDUP_H_
+
+#include "lib/allocator/ob_allocator.h"
+#include "lib/lock/ob_spin_lock.h"
+#include "share/datum/ob_datum.h"
+#include "sql/engine/ob_bit_vector.h"
+
+namespace oceanbase
+{
+namespace sql
+{
+struct ObExpr;
+struct ObEvalCtx;
+
+/*
+ * In-batch deduplication of the arguments of a python udf.
+ *
+ * Rows of a batch with the same argument values are given to python once. The argument
+ * columns of the selected rows are hashed with the batch hash functions of the args
+ * (murmur_hash_v2, as hash group by and hash partitioning do), rows of equal hash are compared
+ * by their datum bytes and the selection keeps the first row of each group. The rows removed
+ * are remembered and get the result of their first row once python has returned.
+ *
+ * Deduplication pays only for batches with few distinct rows. ObPyDedupStat keeps the distinct
+ * ratio of the last deduplicated batches of an expr: above tenant config
+ * _python_udf_dedup_distinct_ratio the batches are sent as they are and the ratio is measured
+ * again every PROBE_INTERVAL batches.
+ */
+class ObPyDedupStat
+{
+public:
+  static const int64_t MIN_ROWS = 16; // smaller batches are sent as they are
+  static const int64_t PROBE_INTERVAL = 16;
+  static constexpr double DEFAULT_MAX_RATIO = 0.5; // without tenant config
+
+  ObPyDedupStat() : lock_(), max_ratio_(DEFAULT_MAX_RATIO), distinct_ratio_(0), skipped_cnt_(0),
+                    batch_cnt_(0), row_cnt_(0), dedup_row_cnt_(0), started_(false) {}
+  // whether the next batch of sel_cnt rows is worth deduplicating,
+  // the threshold is read from tenant config at the first call
+  bool need_dedup(const int64_t sel_cnt);
+  void add_batch(const int64_t sel_cnt, const int64_t distinct_cnt);
+  double get_distinct_ratio() const { return distinct_ratio_; }
+
+  TO_STRING_KV(K_(max_ratio), K_(distinct_ratio), K_(skipped_cnt), K_(batch_cnt), K_(row_cnt),
+               K_(dedup_row_cnt), K_(started));
+
+private:
+  common::ObSpinLock lock_;
+  double max_ratio_; // 0 disables deduplication
+  double distinct_ratio_; // last deduplicated batch, 0 before the first one
+  int64_t skipped_cnt_; // batches sent as they are since the last deduplicated one
+  int64_t batch_cnt_;
+  int64_t row_cnt_; // rows of the deduplicated batches
+  int64_t dedup_row_cnt_; // rows removed from them
+  bool started_;
+  DISALLOW_COPY_AND_ASSIGN(ObPyDedupStat);
+};
+
+// buffers of one batch, reused by the batches of an execution
+class ObPyBatchDedup
+{
+public:
+  ObPyBatchDedup() : capacity_(0), slot_cnt_(0), hashes_(NULL), skip_(NULL), slots_(NULL),
+                     dup_rows_(NULL), dup_srcs_(NULL), dup_cnt_(0) {}
+  // rows of the batches are below size
+  int prepare(common::ObIAllocator &alloc, const int64_t size);
+  // remove the rows of sel whose args equal those of a previous row, in place
+  int dedup(const ObExpr &expr, ObEvalCtx &ctx, int32_t *sel, int64_t &sel_cnt);
+  // give the removed rows the result of the row kept for them
+  void scatter(common::ObDatum *results);
+  int64_t get_dup_cnt() const { return dup_cnt_; }
+  void reuse() { dup_cnt_ = 0; }
+
+  TO_STRING_KV(K_(capacity), K_(slot_cnt), K_(dup_cnt));
+
+private:
+  static bool is_equal(const ObExpr &expr, ObEvalCtx &ctx, const int64_t l, const int64_t r);
+
+  int64_t capacity_;
+  int64_t slot_cnt_; // power of 2, at least twice the capacity
+  uint64_t *hashes_; // by row
+  ObBitVector *skip_; // rows out of the selection
+  int32_t *slots_; // open addressing on the hash, row kept or -1
+  int32_t *dup_rows_;
+  int32_t *dup_srcs_; // row kept for dup_rows_[i]
+  int64_t dup_cnt_;
+};
+
+} // end namespace sql
+} // end namespace oceanbase
+
+#endif // OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_DEDUP_H_
@@ -0,0 +1,471 @@
+#define USING_LOG_PREFIX SQL_ENG
+
+#define PY_SSIZE_T_CLEAN
+#include "sql/engine/python_udf_engine/ob_python_udf_model_registry.h"
+#include "sql/engine/expr/ob_expr_python_udf.h"
+#include "lib/oblog/ob_log.h"
+#include "lib/time/ob_time_utility.h"
+#include "lib/allocator/page_arena.h"
+#include "share/rc/ob_tenant_base.h"
+#include "share/schema/ob_multi_version_schema_service.h"
+#include "observer/ob_server_struct.h"
+#include "observer/omt/ob_tenant_config_mgr.h"
+
+namespace oceanbase
+{
+using namespace common;
+using namespace share::schema;
+namespace sql
+{
+
+ObPyModelRegistry::ObPyModelRegistry()
+    : tenant_id_(OB_INVALID_TENANT_ID), mem_limit_(0), cond_(), entries_(), loading_(false),
+      need_sync_(true), loader_started_(false), inited_(false)
+{
+}
+
+int ObPyModelRegistry::init(const uint64_t tenant_id)
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(inited_)) {
+    ret = OB_INIT_TWICE;
+    LOG_WARN("python udf model registry init twice", K(ret));
+  } else if (OB_FAIL(cond_.init(ObWaitEventIds::DEFAULT_COND_WAIT))) {
+    LOG_WARN("failed to init cond", K(ret));
+  } else {
+    tenant_id_ = tenant_id;
+    need_sync_ = true;
+    inited_ = true;
+    refresh_mem_limit();
+  }
+  return ret;
+}
+
+int ObPyModelRegistry::start_loader()
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(!inited_)) {
+    ret = OB_NOT_INIT;
+    LOG_WARN("python udf model registry not init", K(ret));
+  } else if (FALSE_IT(set_run_wrapper(MTL_CTX()))) {
+  } else if (OB_FAIL(set_thread_count(1))) {
+    LOG_WARN("fail to set thread count", K(ret));
+  } else if (OB_FAIL(start())) {
+    LOG_WARN("fail to start python udf model loader", K(ret));
+  } else {
+    loader_started_ = true;
+  }
+  return ret;
+}
+
+void ObPyModelRegistry::destroy()
+{
+  if (loader_started_) {
+    {
+      ObThreadCondGuard guard(cond_);
+      share::ObThreadPool::stop();
+      cond_.broadcast();
+    }
+    share::ObThreadPool::wait();
+    share::ObThreadPool::destroy();
+    loader_started_ = false;
+  }
+  if (inited_) {
+    // the handlers stay in __main__ until the interpreter is finalized
+    entries_.reset();
+    cond_.destroy();
+    loading_ = false;
+    inited_ = false;
+  }
+}
+
+int ObPyModelRegistry::mtl_init(ObPyModelRegistry* &registry)
+{
+  int ret = OB_SUCCESS;
+  uint64_t tenant_id = lib::current_resource_owner_id();
+  registry = OB_NEW(ObPyModelRegistry, ObModIds::OB_SQL_EXECUTOR);
+  if (nullptr == registry) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("failed to alloc memory for ObPyModelRegistry", K(ret));
+  } else if (OB_FAIL(registry->init(tenant_id))) {
+    LOG_WARN("failed to init python udf model registry", K(ret));
+  } else if (OB_FAIL(registry->start_loader())) {
+    LOG_WARN("failed to start python udf model loader", K(ret));
+  }
+  if (OB_FAIL(ret) && registry != nullptr) {
+    // cleanup
+    ob_delete(registry);
+    registry = nullptr;
+  }
+  return ret;
+}
+
+void ObPyModelRegistry::mtl_destroy(ObPyModelRegistry* &registry)
+{
+  if (registry != nullptr) {
+    ob_delete(registry);
+    registry = nullptr;
+  }
+}
+
+void ObPyModelRegistry::refresh_mem_limit()
+{
+  omt::ObTenantConfigGuard tenant_config(TENANT_CONF(tenant_id_));
+  if (tenant_config.is_valid()) {
+    set_mem_limit(tenant_config->_python_udf_model_cache_size);
+  }
+}
+
+ObPyModelRegistry::Entry *ObPyModelRegistry::find_entry(const uint64_t udf_id)
+{
+  Entry *entry = NULL;
+  for (int64_t i = 0; NULL == entry && i < entries_.count(); i++) {
+    if (entries_.at(i).udf_id_ == udf_id) {
+      entry = &entries_.at(i);
+    }
+  }
+  return entry;
+}
+
+int ObPyModelRegistry::remove_entry(const uint64_t udf_id, Entry &removed)
+{
+  int ret = OB_ENTRY_NOT_EXIST;
+  for (int64_t i = 0; OB_ENTRY_NOT_EXIST == ret && i < entries_.count(); i++) {
+    if (entries_.at(i).udf_id_ == udf_id) {
+      removed = entries_.at(i);
+      ret = entries_.remove(i);
+    }
+  }
+  return ret;
+}
+
+int ObPyModelRegistry::bind(const ObPythonUDFMeta &udf_meta)
+{
+  int ret = OB_SUCCESS;
+  bool need_load = false;
+  bool done = false;
+  if (OB_UNLIKELY(!inited_)) {
+    ret = OB_NOT_INIT;
+    LOG_WARN("python udf model registry not init", K(ret));
+  }
+  while (OB_SUCC(ret) && !done) {
+    bool need_wait = false;
+    {
+      ObThreadCondGuard guard(cond_);
+      Entry *entry = find_entry(udf_meta.udf_id_);
+      if (NULL != entry && LOADED == entry->state_
+          && entry->schema_version_ == udf_meta.schema_version_) {
+        entry->last_used_ts_ = ObTimeUtility::current_time();
+        done = true;
+      } else if (loading_) {
+        need_wait = true;
+      } else if (NULL == entry && OB_FAIL(entries_.push_back(Entry()))) {
+        LOG_WARN("fail to add python udf model entry", K(ret));
+      } else {
+        // a new udf, a new version or a failed load
+        entry = NULL == entry ? &entries_.at(entries_.count() - 1) : entry;
+        entry->udf_id_ = udf_meta.udf_id_;
+        entry->schema_version_ = udf_meta.schema_version_;
+        entry->state_ = LOADING;
+        entry->mem_size_ = 0;
+        if (OB_FAIL(entry->name_.assign(udf_meta.name_))) {
+          LOG_WARN("fail to assign python udf name", K(ret), K(udf_meta.name_));
+          entry->state_ = FAILED;
+        } else {
+          loading_ = true;
+          need_load = true;
+          done = true;
+        }
+      }
+    }
+    if (need_wait) {
+      // the loader needs the GIL to finish
+      Py_BEGIN_ALLOW_THREADS
+      {
+        ObThreadCondGuard guard(cond_);
+        if (loading_) {
+          (void)cond_.wait_us(WAIT_LOAD_INTERVAL_US);
+        }
+      }
+      Py_END_ALLOW_THREADS
+    }
+  }
+  if (OB_SUCC(ret) && need_load && OB_FAIL(load(udf_meta))) {
+    LOG_WARN("fail to load python udf model", K(ret), K(udf_meta.udf_id_));
+  }
+  return ret;
+}
+
+int ObPyModelRegistry::load(const ObPythonUDFMeta &udf_meta)
+{
+  int ret = OB_SUCCESS;
+  int tmp_ret = OB_SUCCESS;
+  bool started = false;
+  int64_t traced_before = 0;
+  int64_t traced_after = 0;
+  const int64_t begin_ts = ObTimeUtility::current_time();
+  if (OB_SUCCESS != (tmp_ret = start_trace(started, traced_before))) {
+    LOG_WARN("fail to trace python memory, model size unknown", K(tmp_ret));
+  }
+  if (OB_FAIL(ObExprPythonUdf::load_udf(udf_meta))) {
+    LOG_WARN("fail to load python udf", K(ret), K(udf_meta.udf_id_));
+  } else {
+    // __main__ now holds a new definition of the udf handlers
+    ObExprPythonUdf::inc_udf_epoch();
+  }
+  if (OB_SUCCESS == tmp_ret && OB_SUCCESS != (tmp_ret = stop_trace(started, traced_after))) {
+    LOG_WARN("fail to trace python memory, model size unknown", K(tmp_ret));
+  }
+  {
+    ObThreadCondGuard guard(cond_);
+    Entry *entry = find_entry(udf_meta.udf_id_);
+    if (NULL != entry) {
+      entry->state_ = OB_SUCC(ret) ? LOADED : FAILED;
+      entry->mem_size_ = OB_SUCCESS == tmp_ret ? std::max(0L, traced_after - traced_before) : 0;
+      entry->load_time_ = ObTimeUtility::current_time() - begin_ts;
+      entry->last_used_ts_ = ObTimeUtility::current_time();
+      LOG_INFO("python udf model loaded", K(ret), K_(tenant_id), KPC(entry));
+    }
+    loading_ = false;
+    cond_.broadcast();
+  }
+  if (OB_SUCC(ret)) {
+    evict(udf_meta.udf_id_);
+  }
+  return ret;
+}
+
+void ObPyModelRegistry::evict(const uint64_t keep_udf_id)
+{
+  bool done = false;
+  int64_t evicted_cnt = 0;
+  while (!done) {
+    Entry victim;
+    {
+      ObThreadCondGuard guard(cond_);
+      const int64_t mem_limit = ATOMIC_LOAD(&mem_limit_);
+      int64_t mem_used = 0;
+      int64_t idx = -1;
+      for (int64_t i = 0; i < entries_.count(); i++) {
+        const Entry &entry = entries_.at(i);
+        if (LOADED == entry.state_) {
+          mem_used += entry.mem_size_;
+          if (entry.udf_id_ != keep_udf_id
+              && (-1 == idx || entry.last_used_ts_ < entries_.at(idx).last_used_ts_)) {
+            idx = i;
+          }
+        }
+      }
+      if (mem_limit <= 0 || mem_used <= mem_limit || -1 == idx) {
+        done = true;
+      } else {
+        victim = entries_.at(idx);
+        (void)entries_.remove(idx);
+        LOG_INFO("python udf model evicted", K_(tenant_id), K(mem_used), K(mem_limit), K(victim));
+      }
+    }
+    if (!done) {
+      ObExprPythonUdf::unload_udf(victim.name_.str());
+      ++evicted_cnt;
+    }
+  }
+  if (evicted_cnt > 0) {
+    // free models referencing themselves
+    (void)PyGC_Collect();
+  }
+}
+
+void ObPyModelRegistry::notify_schema_changed()
+{
+  if (inited_) {
+    ObThreadCondGuard guard(cond_);
+    need_sync_ = true;
+    cond_.broadcast();
+  }
+}
+
+int ObPyModelRegistry::get_entries(ObIArray<Entry> &entries)
+{
+  int ret = OB_SUCCESS;
+  ObThreadCondGuard guard(cond_);
+  if (OB_FAIL(entries.assign(entries_))) {
+    LOG_WARN("fail to copy python udf model entries", K(ret));
+  }
+  return ret;
+}
+
+int64_t ObPyModelRegistry::get_mem_used()
+{
+  int64_t mem_used = 0;
+  ObThreadCondGuard guard(cond_);
+  for (int64_t i = 0; i < entries_.count(); i++) {
+    if (LOADED == entries_.at(i).state_) {
+      mem_used += entries_.at(i).mem_size_;
+    }
+  }
+  return mem_used;
+}
+
+void ObPyModelRegistry::run1()
+{
+  lib::set_thread_name("PyUdfModelLoad");
+  while (!has_set_stop()) {
+    bool need_sync = false;
+    {
+      ObThreadCondGuard guard(cond_);
+      if (!has_set_stop() && !need_sync_) {
+        (void)cond_.wait_us(LOAD_CHECK_INTERVAL_US);
+      }
+      need_sync = need_sync_;
+      need_sync_ = false;
+    }
+    refresh_mem_limit();
+    if (has_set_stop() || !Py_IsInitialized()) {
+      // do nothing
+    } else if (need_sync) {
+      int ret = OB_SUCCESS;
+      if (OB_FAIL(sync_with_schema())) {
+        LOG_WARN("fail to load python udf models, retry later", K(ret), K_(tenant_id));
+        ObThreadCondGuard guard(cond_);
+        need_sync_ = true;
+        (void)cond_.wait_us(LOAD_CHECK_INTERVAL_US);
+      }
+    } else {
+      // the limit may have been lowered
+      PyGILState_STATE gstate = PyGILState_Ensure();
+      evict(OB_INVALID_ID);
+      PyGILState_Release(gstate);
+    }
+  }
+}
+
+int ObPyModelRegistry::sync_with_schema()
+{
+  int ret = OB_SUCCESS;
+  ObArenaAllocator allocator("PyUdfModel");
+  ObSEArray<ObPythonUDF *, 16> udf_infos;
+  ObSEArray<Entry, 16> dropped;
+  if (OB_ISNULL(GCTX.schema_service_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("schema service is null", K(ret));
+  } else if (OB_FAIL(GCTX.schema_service_->get_python_udf_infos(tenant_id_, allocator, udf_infos))) {
+    LOG_WARN("fail to get python udfs", K(ret), K_(tenant_id));
+  } else {
+    ObThreadCondGuard guard(cond_);
+    for (int64_t i = entries_.count() - 1; OB_SUCC(ret) && i >= 0; i--) {
+      bool found = false;
+      for (int64_t j = 0; !found && j < udf_infos.count(); j++) {
+        found = udf_infos.at(j)->get_udf_id() == entries_.at(i).udf_id_;
+      }
+      if (found || LOADING == entries_.at(i).state_) {
+        // keep
+      } else if (OB_FAIL(dropped.push_back(entries_.at(i)))) {
+        LOG_WARN("fail to push back dropped python udf", K(ret));
+      } else {
+        (void)entries_.remove(i);
+      }
+    }
+  }
+  if (OB_SUCC(ret)) {
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    for (int64_t i = 0; i < dropped.count(); i++) {
+      LOG_INFO("python udf model of a dropped udf unloaded", K_(tenant_id), K(dropped.at(i)));
+      ObExprPythonUdf::unload_udf(dropped.at(i).name_.str());
+    }
+    // udfs of the tenant are loaded ahead of their first query until the limit is reached,
+    // a udf failing to load is reported and left to its queries
+    for (int64_t i = 0; !has_set_stop() && i < udf_infos.count(); i++) {
+      const ObPythonUDF *udf_info = udf_infos.at(i);
+      ObPythonUDFMeta udf_meta;
+      const int64_t mem_limit = ATOMIC_LOAD(&mem_limit_);
+      if (ObPythonUDF::WORKER == udf_info->get_exec_mode()) {
+        // runs in python worker processes
+      } else if (ObPythonUDF::TREES == udf_info->get_language()) {
+        // scored natively, nothing to load into python
+      } else if (mem_limit > 0 && get_mem_used() >= mem_limit) {
+        LOG_INFO("python udf model cache is full, stop preloading", K_(tenant_id), K(mem_limit));
+        break;
+      } else {
+        int tmp_ret = OB_SUCCESS;
+        udf_meta.name_ = udf_info->get_name_str();
+        udf_meta.pycall_ = udf_info->get_pycall_str();
+        udf_meta.ret_ = udf_info->get_ret();
+        udf_meta.udf_id_ = udf_info->get_udf_id();
+        udf_meta.schema_version_ = udf_info->get_schema_version();
+        udf_meta.exec_mode_ = udf_info->get_exec_mode();
+        if (OB_SUCCESS != (tmp_ret = bind(udf_meta))) {
+          LOG_WARN("fail to preload python udf model", K(tmp_ret), K(udf_meta.udf_id_));
+        }
+      }
+    }
+    PyGILState_Release(gstate);
+  }
+  return ret;
+}
+
+int ObPyModelRegistry::start_trace(bool &started, int64_t &traced)
+{
+  int ret = OB_SUCCESS;
+  PyObject *module = NULL;
+  PyObject *tracing = NULL;
+  PyObject *memory = NULL;
+  started = false;
+  traced = 0;
+  if (OB_ISNULL(module = PyImport_ImportModule("tracemalloc"))) {
+    ret = OB_ERR_UNEXPECTED;
+  } else if (OB_ISNULL(tracing = PyObject_CallMethod(module, "is_tracing", NULL))) {
+    ret = OB_ERR_UNEXPECTED;
+  } else if (!PyObject_IsTrue(tracing)) {
+    PyObject *res = PyObject_CallMethod(module, "start", NULL);
+    if (OB_ISNULL(res)) {
+      ret = OB_ERR_UNEXPECTED;
+    } else {
+      started = true;
+      Py_DECREF(res);
+    }
+  }
+  if (OB_FAIL(ret)) {
+  } else if (OB_ISNULL(memory = PyObject_CallMethod(module, "get_traced_memory", NULL))
+             || !PyTuple_Check(memory) || PyTuple_Size(memory) < 1) {
+    ret = OB_ERR_UNEXPECTED;
+  } else {
+    traced = PyLong_AsLongLong(PyTuple_GetItem(memory, 0));
+  }
+  if (OB_FAIL(ret)) {
+    PyErr_Clear();
+  }
+  Py_XDECREF(memory);
+  Py_XDECREF(tracing);
+  Py_XDECREF(module);
+  return ret;
+}
+
+int ObPyModelRegistry::stop_trace(const bool started, int64_t &traced)
+{
+  int ret = OB_SUCCESS;
+  PyObject *module = NULL;
+  PyObject *memory = NULL;
+  traced = 0;
+  if (OB_ISNULL(module = PyImport_ImportModule("tracemalloc"))) {
+    ret = OB_ERR_UNEXPECTED;
+  } else if (OB_ISNULL(memory = PyObject_CallMethod(module, "get_traced_memory", NULL))
+             || !PyTuple_Check(memory) || PyTuple_Size(memory) < 1) {
+    ret = OB_ERR_UNEXPECTED;
+  } else {
+    traced = PyLong_AsLongLong(PyTuple_GetItem(memory, 0));
+  }
+  if (NULL != module && started) {
+    // tracing slows down every allocation, it only runs while loading
+    PyObject *res = PyObject_CallMethod(module, "stop", NULL);
+    Py_XDECREF(res);
+  }
+  if (OB_FAIL(ret) || PyErr_Occurred()) {
+    PyErr_Clear();
+  }
+  Py_XDECREF(memory);
+  Py_XDECREF(module);
+  return ret;
+}
+
+} // end namespace sql
+} // end namespace oceanbase
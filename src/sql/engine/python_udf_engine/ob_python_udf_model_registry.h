@@ -0,0 +1,110 @@
+#ifndef OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_MODEL_REGISTRY_H_
+#define OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_MODEL_REGISTRY_H_
+
+#include "share/ob_thread_pool.h"
+#include "share/schema/ob_python_udf.h"
+#include "lib/container/ob_se_array.h"
+#include "lib/string/ob_fixed_length_string.h"
+#include "lib/lock/ob_thread_cond.h"
+
+namespace oceanbase
+{
+namespace sql
+{
+
+/*
+ * Per-tenant registry of the python udfs loaded in __main__ of the main interpreter.
+ *
+ * Loading a udf runs its pycall and <name>_pyinitial, which usually deserializes a model.
+ * It is done once per udf version: code generation and executions bind to the loaded entry
+ * and only load when the entry is missing, of an older version or was unloaded. A loader
+ * thread loads every udf of the tenant when the tenant starts and after a CREATE PYTHON_UDF,
+ * and unloads dropped ones. Above tenant config _python_udf_model_cache_size the least
+ * recently bound udfs are unloaded. Running executions keep their own references to the
+ * handlers, the memory of an unloaded model is released once they finish.
+ *
+ * The memory of a model is the python memory allocated while loading it as traced by
+ * tracemalloc, allocations of native libraries bypassing the python allocator are not seen.
+ */
+class ObPyModelRegistry : public share::ObThreadPool
+{
+public:
+  static const int64_t LOAD_CHECK_INTERVAL_US = 10 * 1000 * 1000L;
+  static const int64_t WAIT_LOAD_INTERVAL_US = 10 * 1000L;
+
+  enum State
+  {
+    LOADING = 0,
+    LOADED = 1,
+    FAILED = 2
+  };
+  struct Entry
+  {
+    Entry() : udf_id_(common::OB_INVALID_ID), schema_version_(common::OB_INVALID_VERSION),
+              name_(), state_(LOADING), mem_size_(0), load_time_(0), last_used_ts_(0) {}
+    TO_STRING_KV(K_(udf_id), K_(schema_version), K_(name), K_(state), K_(mem_size),
+                 K_(load_time), K_(last_used_ts));
+    uint64_t udf_id_;
+    int64_t schema_version_;
+    common::ObFixedLengthString<common::OB_MAX_UDF_NAME_LENGTH + 1> name_;
+    State state_;
+    int64_t mem_size_; // bytes
+    int64_t load_time_; // us spent in pycall and pyinitial
+    int64_t last_used_ts_;
+  };
+
+  ObPyModelRegistry();
+  virtual ~ObPyModelRegistry() { destroy(); }
+  int init(const uint64_t tenant_id);
+  // start the loader thread, under the tenant context
+  int start_loader();
+  void destroy();
+  static int mtl_init(ObPyModelRegistry* &registry);
+  static void mtl_destroy(ObPyModelRegistry* &registry);
+
+  // make this version of the udf loaded in the main interpreter and mark it used,
+  // the GIL of the main interpreter must be held
+  int bind(const share::schema::ObPythonUDFMeta &udf_meta);
+  // python udfs were created or dropped, the loader catches up in the background
+  void notify_schema_changed();
+  int get_entries(common::ObIArray<Entry> &entries);
+  int64_t get_mem_used();
+  // 0 means unlimited, refreshed from tenant config by the loader
+  void set_mem_limit(const int64_t mem_limit) { ATOMIC_STORE(&mem_limit_, mem_limit); }
+
+  virtual void run1() override;
+
+  TO_STRING_KV(K_(tenant_id), K_(mem_limit), K_(loading), K_(need_sync), K_(inited));
+
+private:
+  // called with cond_ held
+  Entry *find_entry(const uint64_t udf_id);
+  int remove_entry(const uint64_t udf_id, Entry &removed);
+  // GIL held, the entry of the udf is LOADING and owned by the caller
+  int load(const share::schema::ObPythonUDFMeta &udf_meta);
+  // GIL held, unload least recently used udfs other than keep_udf_id down to the limit
+  void evict(const uint64_t keep_udf_id);
+  // loader thread: load new udfs of the tenant and unload dropped ones
+  int sync_with_schema();
+  void refresh_mem_limit();
+  // python memory currently traced, tracing is started if needed, GIL held
+  static int start_trace(bool &started, int64_t &traced);
+  static int stop_trace(const bool started, int64_t &traced);
+
+private:
+  uint64_t tenant_id_;
+  int64_t mem_limit_;
+  common::ObThreadCond cond_;
+  common::ObSEArray<Entry, 16> entries_; // guarded by cond_
+  // one udf is loaded at a time, the memory traced while loading is its own
+  bool loading_;
+  bool need_sync_;
+  bool loader_started_;
+  bool inited_;
+  DISALLOW_COPY_AND_ASSIGN(ObPyModelRegistry);
+};
+
+} // end namespace sql
+} // end namespace oceanbase
+
+#endif // OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_MODEL_REGISTRY_H_
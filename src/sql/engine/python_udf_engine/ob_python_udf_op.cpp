@@ -3,6 +3,12 @@
 #include "ob_python_udf_op.h"
 #include "sql/engine/ob_physical_plan.h"
 #include "sql/engine/ob_exec_context.h"
+#include "lib/allocator/ob_malloc.h"
+#include "share/rc/ob_tenant_base.h"
+#include "observer/omt/ob_tenant_config_mgr.h"
+#include "sql/resolver/dml/ob_hint.h"
+#include "sql/engine/basic/ob_limit_op.h"
+#include "observer/ob_server.h"
 
 namespace oceanbase
 {
@@ -10,78 +16,432 @@ using namespace common;
 namespace sql
 {
 
-static int max_buffer_size_ = 8192;
-
 ObPythonUDFSpec::ObPythonUDFSpec(ObIAllocator &alloc, const ObPhyOperatorType type)
-    : ObSubPlanScanSpec(alloc, type), col_exprs_(alloc) {}
+    : ObSubPlanScanSpec(alloc, type), col_exprs_(alloc), limit_expr_(NULL) {}
 
 ObPythonUDFSpec::~ObPythonUDFSpec() {}
 
 ObPythonUDFOp::ObPythonUDFOp(
     ObExecContext &exec_ctx, const ObOpSpec &spec, ObOpInput *input)
-  : ObSubPlanScanOp(exec_ctx, spec, input), buf_exprs_(exec_ctx.get_allocator())
+  : ObSubPlanScanOp(exec_ctx, spec, input), buf_exprs_(exec_ctx.get_allocator()),
+    result_width_(0), buf_results_(NULL), max_buffer_size_(0), mem_batch_size_(0),
+    buffers_inited_(false),
+    use_pipeline_(false), child_iter_end_(false), input_row_cnt_(0), limit_rows_(-1),
+    limit_output_cnt_(0), call_thread_(NULL),
+    mem_context_(nullptr),
+    profile_(ObSqlWorkAreaType::HASH_WORK_AREA), sql_mem_processor_(profile_, op_monitor_info_)
 {
-  int ret = OB_SUCCESS;
   brs_skip_size_ = MY_SPEC.max_batch_size_;
-  predict_size_ = 256;
-  //predict_size_ = MY_SPEC.max_batch_size_; //default
-
-  //max_buffer_size_ = 8192;
-  
+  predict_size_ = ObPyBatchTuneState::DEFAULT_BATCH_SIZE;
   use_input_buf_ = true;
   use_output_buf_ = true;
   use_fake_frame_ = true;
-  //if (predict_size_ > MY_SPEC.max_batch_size_)
-    //use_fake_frame_ = true;
-  //else
-    //predict_size_ += MY_SPEC.max_batch_size_;
-  if (use_input_buf_) {  
-    // init input buffer
-    input_buffer_.init(MY_SPEC.col_exprs_, exec_ctx, 2 * max_buffer_size_);
+  // the buffers are never dumped, MEMORY_DUMP set by sql_mem_processor_ gives way
+  op_monitor_info_.otherstat_1_id_ = ObSqlMonitorStatIds::PYTHON_UDF_BATCH_COUNT;
+  op_monitor_info_.otherstat_2_id_ = ObSqlMonitorStatIds::PYTHON_UDF_ROW_COUNT;
+  op_monitor_info_.otherstat_3_id_ = ObSqlMonitorStatIds::PYTHON_UDF_GIL_WAIT_TIME;
+  op_monitor_info_.otherstat_4_id_ = ObSqlMonitorStatIds::PYTHON_UDF_CONVERT_TIME;
+  op_monitor_info_.otherstat_5_id_ = ObSqlMonitorStatIds::PYTHON_UDF_INFER_TIME;
+  op_monitor_info_.otherstat_6_id_ = ObSqlMonitorStatIds::PYTHON_UDF_PREDICT_SIZE;
+}
+
+ObPythonUDFOp::~ObPythonUDFOp() {}
+
+int ObPythonUDFOp::inner_open()
+{
+  int ret = OB_SUCCESS;
+  use_pipeline_ = false;
+  child_iter_end_ = false;
+  input_row_cnt_ = 0;
+  udf_exprs_.reuse();
+  child_exprs_.reuse();
+  monitor_exprs_.reuse();
+  if (OB_FAIL(ObSubPlanScanOp::inner_open())) {
+    LOG_WARN("fail to inner open", K(ret));
+  } else if (OB_FAIL(init_limit())) {
+    LOG_WARN("fail to init limit", K(ret));
+  } else if (OB_FAIL(init_buffers())) {
+    LOG_WARN("fail to init python udf buffers", K(ret));
+  } else if (!use_input_buf_ || !use_fake_frame_ || !is_vectorized()) {
+    // pipelining works on the buffered batch path only
+  } else {
+    omt::ObTenantConfigGuard tenant_config(TENANT_CONF(MTL_ID()));
+    use_pipeline_ = tenant_config.is_valid() && tenant_config->_enable_python_udf_pipeline;
   }
-  if (use_output_buf_) {
-    // init output buffer
-    output_buffer_.init(MY_SPEC.output_, exec_ctx, 2 * max_buffer_size_);
-  }
-  if (use_fake_frame_) {
-    //extra buf_exprs_
-    result_width_ = MY_SPEC.col_exprs_.count() + MY_SPEC.calc_exprs_.count() + MY_SPEC.output_.count();
-    OZ(buf_exprs_.init(result_width_));
-    FOREACH_CNT_X(e, MY_SPEC.col_exprs_, OB_SUCC(ret)) 
+  FOREACH_CNT_X(e, MY_SPEC.calc_exprs_, OB_SUCC(ret))
+    OZ(find_all_udf_exprs(*e, monitor_exprs_));
+  FOREACH_CNT_X(e, MY_SPEC.output_, OB_SUCC(ret))
+    OZ(find_all_udf_exprs(*e, monitor_exprs_));
+  FOREACH_CNT_X(e, MY_SPEC.filters_, OB_SUCC(ret))
+    OZ(find_all_udf_exprs(*e, monitor_exprs_));
+  FOREACH_CNT_X(e, MY_SPEC.calc_exprs_, OB_SUCC(ret) && use_pipeline_)
+    OZ(find_udf_exprs(*e, udf_exprs_));
+  FOREACH_CNT_X(e, MY_SPEC.output_, OB_SUCC(ret) && use_pipeline_)
+    OZ(find_udf_exprs(*e, udf_exprs_));
+  for (int64_t i = 0; OB_SUCC(ret) && use_pipeline_ && i < MY_SPEC.col_exprs_.count(); i++) {
+    ObExpr *from = NULL;
+    for (int64_t j = 0; NULL == from && j < MY_SPEC.projector_.count(); j += 2) {
+      if (MY_SPEC.projector_.at(j + 1) == MY_SPEC.col_exprs_.at(i)) {
+        from = MY_SPEC.projector_.at(j);
+      }
+    }
+    if (OB_ISNULL(from)) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("no projector source of python udf input", K(ret), K(i));
+    } else if (OB_FAIL(child_exprs_.push_back(from))) {
+      LOG_WARN("fail to push back expr", K(ret));
+    }
+  }
+  if (OB_FAIL(ret) || !use_pipeline_ || udf_exprs_.empty()) {
+    use_pipeline_ = false;
+  } else if (NULL == call_thread_) {
+    if (OB_ISNULL(call_thread_ = OB_NEWx(ObPyCallThread, &ctx_.get_allocator()))) {
+      ret = OB_ALLOCATE_MEMORY_FAILED;
+      LOG_WARN("fail to allocate python call thread", K(ret));
+    } else if (OB_FAIL(call_thread_->init())) {
+      LOG_WARN("fail to init python call thread", K(ret));
+      destroy_call_thread();
+    }
+  }
+  return ret;
+}
+
+int ObPythonUDFOp::inner_rescan()
+{
+  int ret = OB_SUCCESS;
+  child_iter_end_ = false;
+  input_buffer_.reuse();
+  output_buffer_.reuse();
+  if (OB_FAIL(ObSubPlanScanOp::inner_rescan())) {
+    LOG_WARN("fail to inner rescan", K(ret));
+  } else if (OB_FAIL(init_limit())) {
+    LOG_WARN("fail to init limit", K(ret));
+  }
+  return ret;
+}
+
+int ObPythonUDFOp::inner_close()
+{
+  destroy_call_thread();
+  record_filter_selectivity();
+  update_monitor_stat();
+  return ObSubPlanScanOp::inner_close();
+}
+
+void ObPythonUDFOp::add_input_rows()
+{
+  if (brs_.size_ > 0) {
+    input_row_cnt_ += brs_.size_ - brs_.skip_->accumulate_bit_cnt(brs_.size_);
+  }
+}
+
+int ObPythonUDFOp::init_limit()
+{
+  int ret = OB_SUCCESS;
+  bool is_null = false;
+  limit_rows_ = -1;
+  limit_output_cnt_ = 0;
+  if (NULL == MY_SPEC.limit_expr_) {
+    // no limit above
+  } else if (OB_FAIL(ObLimitOp::get_int_val(MY_SPEC.limit_expr_, eval_ctx_, limit_rows_,
+                                            is_null))) {
+    LOG_WARN("fail to get limit value", K(ret));
+  } else if (is_null || limit_rows_ < 0) {
+    // left to the limit operator
+    limit_rows_ = -1;
+  }
+  return ret;
+}
+
+void ObPythonUDFOp::add_output_rows()
+{
+  if (limit_rows_ >= 0 && brs_.size_ > 0) {
+    limit_output_cnt_ += brs_.size_ - brs_.skip_->accumulate_bit_cnt(brs_.size_);
+  }
+}
+
+int64_t ObPythonUDFOp::get_limit_input_rows() const
+{
+  int64_t rows = INT64_MAX;
+  if (limit_rows_ < 0) {
+    // no limit
+  } else if (limit_output_cnt_ >= limit_rows_) {
+    rows = 0;
+  } else {
+    // every row passes until one is seen, rows read without output lower the estimate
+    const double sel = static_cast<double>(op_monitor_info_.output_row_count_ + 1)
+                       / static_cast<double>(input_row_cnt_ + 1);
+    const double need = std::ceil(static_cast<double>(limit_rows_ - limit_output_cnt_) / sel);
+    rows = need >= static_cast<double>(INT64_MAX) ? INT64_MAX : static_cast<int64_t>(need);
+  }
+  return rows;
+}
+
+void ObPythonUDFOp::record_filter_selectivity()
+{
+  int ret = OB_SUCCESS;
+  ObPyBatchSizeCache *cache = MTL(ObPyBatchSizeCache*);
+  const ObPythonUdfInfo *udf_info = NULL;
+  const int64_t output_row_cnt = op_monitor_info_.output_row_count_;
+  if (MY_SPEC.filters_.empty() || input_row_cnt_ < MIN_SEL_SAMPLE_ROWS
+      || output_row_cnt > input_row_cnt_ || NULL == cache) {
+    // nothing to learn from
+  } else {
+    // the rows out of the filters tell the selectivity of a udf only if every filter is on it
+    for (int64_t i = 0; OB_SUCC(ret) && i < MY_SPEC.filters_.count(); i++) {
+      ObSEArray<ObExpr *, 4> exprs;
+      if (OB_FAIL(find_udf_exprs(MY_SPEC.filters_.at(i), exprs))) {
+        LOG_WARN("fail to find python udf exprs", K(ret));
+      } else if (1 != exprs.count() || OB_ISNULL(exprs.at(0)->extra_info_)) {
+        udf_info = NULL;
+        break;
+      } else {
+        const ObPythonUdfInfo *info = static_cast<const ObPythonUdfInfo *>(exprs.at(0)->extra_info_);
+        if (NULL == udf_info) {
+          udf_info = info;
+        } else if (udf_info->udf_meta_.udf_id_ != info->udf_meta_.udf_id_) {
+          udf_info = NULL;
+          break;
+        }
+      }
+    }
+    if (OB_SUCC(ret) && NULL != udf_info
+        && OB_FAIL(cache->add_selectivity(udf_info->udf_meta_.udf_id_,
+                                          udf_info->udf_meta_.schema_version_,
+                                          input_row_cnt_, output_row_cnt))) {
+      LOG_WARN("fail to record python udf selectivity", K(ret));
+    }
+  }
+}
+
+void ObPythonUDFOp::update_monitor_stat()
+{
+  ObPyUdfStageStat stat;
+  const uint64_t cpu_khz = OBSERVER.get_cpu_frequency_khz();
+  for (int64_t i = 0; i < monitor_exprs_.count(); i++) {
+    const ObPythonUdfExprCtx *udf_ctx = static_cast<ObPythonUdfExprCtx *>(
+        ctx_.get_expr_op_ctx(monitor_exprs_.at(i)->expr_ctx_id_));
+    if (NULL != udf_ctx) {
+      stat.add(udf_ctx->get_stat());
+    }
+  }
+  op_monitor_info_.otherstat_1_value_ = stat.batch_cnt_;
+  op_monitor_info_.otherstat_2_value_ = stat.row_cnt_;
+  if (cpu_khz > 0) {
+    op_monitor_info_.otherstat_3_value_ = 1000 * stat.gil_wait_cycles_ / cpu_khz;
+    op_monitor_info_.otherstat_4_value_ =
+        1000 * (stat.ob2py_cycles_ + stat.py2ob_cycles_) / cpu_khz;
+    op_monitor_info_.otherstat_5_value_ = 1000 * stat.infer_cycles_ / cpu_khz;
+  }
+  op_monitor_info_.otherstat_6_value_ = predict_size_;
+}
+
+void ObPythonUDFOp::destroy()
+{
+  destroy_call_thread();
+  udf_exprs_.reset();
+  child_exprs_.reset();
+  monitor_exprs_.reset();
+  destroy_buffers();
+  ObSubPlanScanOp::destroy();
+}
+
+int64_t ObPythonUDFOp::get_buffer_row_size() const
+{
+  int64_t row_size = 0;
+  // ring slots of both buffers, two batches each
+  row_size += 2 * sizeof(ObDatum) * (MY_SPEC.col_exprs_.count() + MY_SPEC.output_.count());
+  // fake frames, one batch
+  for (int64_t i = 0; i < buf_exprs_.count(); i++) {
+    row_size += sizeof(ObDatum)
+        + std::max(ObDatum::get_reserved_size(buf_exprs_.at(i)->obj_datum_map_),
+                   static_cast<uint32_t>(sizeof(int64_t)));
+  }
+  // payload pages of both buffers
+  row_size += 2 * std::max(MY_SPEC.width_, static_cast<int64_t>(sizeof(int64_t)));
+  return row_size;
+}
+
+int ObPythonUDFOp::init_buffers()
+{
+  int ret = OB_SUCCESS;
+  const uint64_t tenant_id = MTL_ID();
+  int64_t row_size = 0;
+  int64_t want_size = 0;
+  int64_t mem_size = 0;
+  int32_t learned_size = 0;
+  if (buffers_inited_) {
+    // buffers are kept across rescans
+  } else if (use_fake_frame_ && OB_FAIL(buf_exprs_.init(
+      MY_SPEC.col_exprs_.count() + MY_SPEC.calc_exprs_.count() + MY_SPEC.output_.count()))) {
+    LOG_WARN("fail to init buf exprs", K(ret));
+  } else {
+    FOREACH_CNT_X(e, MY_SPEC.col_exprs_, OB_SUCC(ret) && use_fake_frame_)
       OZ(buf_exprs_.push_back((*e)));
-    FOREACH_CNT_X(e, MY_SPEC.calc_exprs_, OB_SUCC(ret)) 
+    FOREACH_CNT_X(e, MY_SPEC.calc_exprs_, OB_SUCC(ret) && use_fake_frame_)
       OZ(buf_exprs_.push_back((*e)));
-    FOREACH_CNT_X(e, MY_SPEC.output_, OB_SUCC(ret)) 
+    FOREACH_CNT_X(e, MY_SPEC.output_, OB_SUCC(ret) && use_fake_frame_)
       OZ(buf_exprs_.push_back((*e)));
-    
-    // construct predict buffers
-    buf_results_ = static_cast<ObDatum **>(exec_ctx.get_allocator().alloc(sizeof(ObDatum *) * result_width_));
-    for(int i = 0; i < result_width_; i++) {
-      ObExpr *e = buf_exprs_.at(i);
-      OZ(alloc_predict_buffer(exec_ctx.get_allocator(), (*e), buf_results_[i], max_buffer_size_));
+    result_width_ = buf_exprs_.count();
+    FOREACH_CNT_X(e, MY_SPEC.calc_exprs_, OB_SUCC(ret))
+      OZ(find_predict_size((*e), learned_size));
+    FOREACH_CNT_X(e, MY_SPEC.output_, OB_SUCC(ret))
+      OZ(find_predict_size((*e), learned_size));
+    row_size = get_buffer_row_size();
+    // room for the learned batch size to double
+    want_size = std::min(std::max(static_cast<int64_t>(learned_size) * 2,
+                                  static_cast<int64_t>(ObPyBatchTuneState::DEFAULT_BATCH_SIZE)),
+                         MAX_BUFFER_SIZE);
+  }
+  if (OB_FAIL(ret) || buffers_inited_) {
+  } else if (OB_ISNULL(mem_context_)) {
+    lib::ContextParam param;
+    param.set_mem_attr(tenant_id, "PyUdfBuffer", ObCtxIds::WORK_AREA)
+      .set_properties(lib::USE_TL_PAGE_OPTIONAL);
+    if (OB_FAIL(CURRENT_CONTEXT->CREATE_CONTEXT(mem_context_, param))) {
+      LOG_WARN("create entity failed", K(ret));
+    } else if (OB_ISNULL(mem_context_)) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("null memory entity returned", K(ret));
     }
-    if(!OB_SUCC(ret)) {
-      LOG_WARN("Fail to init Predict Operator", K(ret));
+  }
+  if (OB_FAIL(ret) || buffers_inited_) {
+  } else if (OB_FAIL(sql_mem_processor_.init(&mem_context_->get_malloc_allocator(), tenant_id,
+                                             2 * want_size * row_size, MY_SPEC.type_, MY_SPEC.id_,
+                                             &ctx_))) {
+    LOG_WARN("failed to init sql memory manager processor", K(ret));
+  } else {
+    ObIAllocator &alloc = mem_context_->get_malloc_allocator();
+    // a batch never exceeds the granted work area, but takes at least one child batch
+    max_buffer_size_ = std::min(want_size, sql_mem_processor_.get_mem_bound() / (2 * row_size));
+    max_buffer_size_ = std::max(max_buffer_size_, MY_SPEC.max_batch_size_);
+    mem_batch_size_ = max_buffer_size_;
+    if (use_input_buf_ && OB_FAIL(input_buffer_.init(MY_SPEC.col_exprs_, ctx_, alloc,
+                                                     &sql_mem_processor_, 2 * max_buffer_size_))) {
+      LOG_WARN("fail to init input buffer", K(ret));
+    } else if (use_output_buf_ && OB_FAIL(output_buffer_.init(MY_SPEC.output_, ctx_, alloc,
+                                                              &sql_mem_processor_,
+                                                              2 * max_buffer_size_))) {
+      LOG_WARN("fail to init output buffer", K(ret));
+    } else if (use_fake_frame_ && result_width_ > 0
+               && OB_ISNULL(buf_results_ = static_cast<ObDatum **>(
+                   alloc.alloc(sizeof(ObDatum *) * result_width_)))) {
+      ret = OB_ALLOCATE_MEMORY_FAILED;
+      LOG_WARN("fail to allocate predict buffers", K(ret), K_(result_width));
+    } else if (NULL != buf_results_) {
+      MEMSET(buf_results_, 0, sizeof(ObDatum *) * result_width_);
+      sql_mem_processor_.alloc(sizeof(ObDatum *) * result_width_);
+    }
+    for (int64_t i = 0; OB_SUCC(ret) && use_fake_frame_ && i < result_width_; i++) {
+      if (OB_FAIL(alloc_predict_buffer(alloc, *buf_exprs_.at(i), buf_results_[i],
+                                       static_cast<int>(max_buffer_size_), mem_size))) {
+        LOG_WARN("Fail to init Predict Operator", K(ret));
+      } else {
+        sql_mem_processor_.alloc(mem_size);
+      }
+    }
+    // tuners search below what the buffers can take
+    FOREACH_CNT_X(e, MY_SPEC.calc_exprs_, OB_SUCC(ret))
+      OZ(limit_predict_size(*e, max_buffer_size_));
+    FOREACH_CNT_X(e, MY_SPEC.output_, OB_SUCC(ret))
+      OZ(limit_predict_size(*e, max_buffer_size_));
+    if (OB_SUCC(ret)) {
+      buffers_inited_ = true;
+      LOG_TRACE("trace init python udf buffers", K_(max_buffer_size), K(want_size), K(row_size),
+                K(sql_mem_processor_.get_mem_bound()));
     }
   }
+  return ret;
 }
 
-ObPythonUDFOp::~ObPythonUDFOp() {}
+void ObPythonUDFOp::destroy_buffers()
+{
+  for (int64_t i = 0; NULL != buf_results_ && i < result_width_; i++) {
+    // the fake frame of the shared expr may belong to another execution by now
+    ObExpr *e = buf_exprs_.at(i);
+    if (e->extra_buf_.result_ == buf_results_[i]) {
+      e->extra_buf_.buf_flag_ = false;
+    }
+  }
+  buf_results_ = NULL;
+  input_buffer_.destroy();
+  output_buffer_.destroy();
+  sql_mem_processor_.unregister_profile_if_necessary();
+  if (nullptr != mem_context_) {
+    DESTROY_CONTEXT(mem_context_);
+    mem_context_ = nullptr;
+  }
+  buffers_inited_ = false;
+}
+
+void ObPythonUDFOp::destroy_call_thread()
+{
+  if (NULL != call_thread_) {
+    call_thread_->~ObPyCallThread();
+    ctx_.get_allocator().free(call_thread_);
+    call_thread_ = NULL;
+  }
+}
+
+int ObPythonUDFOp::find_udf_exprs(ObExpr *expr, ObIArray<ObExpr *> &udf_exprs)
+{
+  int ret = OB_SUCCESS;
+  if (OB_ISNULL(expr)) {
+  } else if (T_FUN_SYS_PYTHON_UDF == expr->type_) {
+    if (!has_exist_in_array(udf_exprs, expr) && OB_FAIL(udf_exprs.push_back(expr))) {
+      LOG_WARN("fail to push back python udf expr", K(ret));
+    }
+  } else {
+    for (int64_t i = 0; OB_SUCC(ret) && i < expr->arg_cnt_; i++) {
+      OZ(find_udf_exprs(expr->args_[i], udf_exprs));
+    }
+  }
+  return ret;
+}
+
+int ObPythonUDFOp::find_all_udf_exprs(ObExpr *expr, ObIArray<ObExpr *> &udf_exprs)
+{
+  int ret = OB_SUCCESS;
+  if (OB_ISNULL(expr)) {
+  } else {
+    if (T_FUN_SYS_PYTHON_UDF == expr->type_
+        && !has_exist_in_array(udf_exprs, expr) && OB_FAIL(udf_exprs.push_back(expr))) {
+      LOG_WARN("fail to push back python udf expr", K(ret));
+    }
+    for (int64_t i = 0; OB_SUCC(ret) && i < expr->arg_cnt_; i++) {
+      OZ(find_all_udf_exprs(expr->args_[i], udf_exprs));
+    }
+  }
+  return ret;
+}
 
 /* predict buffer allocation */
-int ObPythonUDFOp::alloc_predict_buffer(ObIAllocator &alloc, ObExpr &expr, ObDatum *&buf_result, int buffer_size)
+int ObPythonUDFOp::alloc_predict_buffer(ObIAllocator &alloc, ObExpr &expr, ObDatum *&buf_result,
+                                        int buffer_size, int64_t &mem_size)
 {
   int ret = OB_SUCCESS;
-  buf_result = static_cast<ObDatum *>(alloc.alloc(sizeof(ObDatum) * buffer_size));
-  for(int i = 0; i < buffer_size; i++) {
-    buf_result[i].ptr_ = static_cast<char *>(alloc.alloc(sizeof(int64_t)));
-    buf_result[i].set_null();
-  }
-  ObBitVector *buf_skip = static_cast<ObBitVector *>(alloc.alloc(ObBitVector::memory_size(buffer_size)));
-  ObBitVector *buf_eval_flag = static_cast<ObBitVector *>(alloc.alloc(ObBitVector::memory_size(buffer_size)));
-  buf_skip->init(buffer_size);
-  buf_eval_flag->init(buffer_size);
-  expr.extra_buf_ = {true, buffer_size, buf_result, buf_skip, buf_eval_flag};
+  const int64_t res_size = std::max(ObDatum::get_reserved_size(expr.obj_datum_map_),
+                                    static_cast<uint32_t>(sizeof(int64_t)));
+  const int64_t bit_size = ObBitVector::memory_size(buffer_size);
+  char *buf = NULL;
+  mem_size = (sizeof(ObDatum) + res_size) * buffer_size + 2 * bit_size;
+  if (OB_ISNULL(buf = static_cast<char *>(alloc.alloc(mem_size)))) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("allocate memory failed", K(ret), K(mem_size), K(buffer_size));
+  } else {
+    // [datums][reserved payload of every datum][skip][eval flags]
+    buf_result = reinterpret_cast<ObDatum *>(buf);
+    char *res_buf = buf + sizeof(ObDatum) * buffer_size;
+    for (int64_t i = 0; i < buffer_size; i++) {
+      buf_result[i].ptr_ = res_buf + i * res_size;
+      buf_result[i].set_null();
+    }
+    ObBitVector *buf_skip = to_bit_vector(res_buf + res_size * buffer_size);
+    ObBitVector *buf_eval_flag = to_bit_vector(res_buf + res_size * buffer_size + bit_size);
+    buf_skip->init(buffer_size);
+    buf_eval_flag->init(buffer_size);
+    expr.extra_buf_ = {true, buffer_size, buf_result, buf_skip, buf_eval_flag};
+  }
   return ret;
 }
 
@@ -89,10 +449,10 @@ int ObPythonUDFOp::alloc_predict_buffer(ObIAllocator &alloc, ObExpr &expr, ObDat
 int ObPythonUDFOp::find_predict_size(ObExpr *expr, int32_t &predict_size)
 {
   int ret = OB_SUCCESS;
-  int expr_size = 256; //default
+  int expr_size = 0;
   if (expr->type_ == T_FUN_SYS_PYTHON_UDF) {
-    int size = static_cast<ObPythonUdfInfo *>(expr->extra_info_)->predict_size;
-    expr_size = size > expr_size ? size : expr_size;
+    // largest batch size asked by the tuners of the udfs
+    expr_size = static_cast<int>(static_cast<ObPythonUdfInfo *>(expr->extra_info_)->batch_tuner_.get_batch_size());
   } else {
     for (int32_t i = 0; i < expr->arg_cnt_; i++) {
       find_predict_size(expr->args_[i], expr_size);
@@ -100,31 +460,218 @@ int ObPythonUDFOp::find_predict_size(ObExpr *expr, int32_t &predict_size)
   }
   if (predict_size < expr_size)
     predict_size = expr_size;
-  if (predict_size > max_buffer_size_)
-    predict_size = max_buffer_size_;
   return ret;
 }
 
+int ObPythonUDFOp::limit_predict_size(ObExpr *expr, const int64_t max_size)
+{
+  int ret = OB_SUCCESS;
+  if (OB_ISNULL(expr)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("expr is null", K(ret));
+  } else if (expr->type_ == T_FUN_SYS_PYTHON_UDF) {
+    static_cast<ObPythonUdfInfo *>(expr->extra_info_)->batch_tuner_.set_max_size(max_size);
+  } else {
+    for (int32_t i = 0; OB_SUCC(ret) && i < expr->arg_cnt_; i++) {
+      OZ(limit_predict_size(expr->args_[i], max_size));
+    }
+  }
+  return ret;
+}
+
+int ObPythonUDFOp::set_predict_batch_hint(ObExpr *expr, const ObGlobalHint &global_hint)
+{
+  int ret = OB_SUCCESS;
+  if (OB_ISNULL(expr)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("expr is null", K(ret));
+  } else if (expr->type_ == T_FUN_SYS_PYTHON_UDF) {
+    ObPythonUdfInfo *info = static_cast<ObPythonUdfInfo *>(expr->extra_info_);
+    int64_t batch_size = 0;
+    if (OB_ISNULL(info)) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("python udf info is null", K(ret));
+    } else if (0 < (batch_size = global_hint.get_predict_batch_hint(info->udf_meta_.name_))) {
+      batch_size = std::min(std::max(batch_size, ObPyBatchTuneState::MIN_BATCH_SIZE),
+                            MAX_BUFFER_SIZE);
+      info->batch_tuner_.set_fixed_size(batch_size);
+    }
+  }
+  for (int32_t i = 0; OB_SUCC(ret) && i < expr->arg_cnt_; i++) {
+    OZ(set_predict_batch_hint(expr->args_[i], global_hint));
+  }
+  return ret;
+}
+
+void ObPythonUDFOp::update_predict_size()
+{
+  int ret = OB_SUCCESS;
+  // 根据exprs的运行时间调整predict size
+  int32_t current_size = 0;
+  FOREACH_CNT_X(e, MY_SPEC.calc_exprs_, OB_SUCC(ret))
+    OZ(find_predict_size((*e), current_size));
+  FOREACH_CNT_X(e, MY_SPEC.output_, OB_SUCC(ret))
+    OZ(find_predict_size((*e), current_size));
+  predict_size_ = current_size > 0 ? current_size : ObPyBatchTuneState::DEFAULT_BATCH_SIZE;
+  if (predict_size_ > mem_batch_size_) {
+    predict_size_ = static_cast<int>(mem_batch_size_);
+  }
+  // no more than the limit above is expected to need
+  const int64_t limit_input_rows = get_limit_input_rows();
+  if (limit_input_rows < predict_size_) {
+    predict_size_ = static_cast<int>(std::min<int64_t>(
+        predict_size_, std::max(limit_input_rows, ObPyBatchTuneState::MIN_BATCH_SIZE)));
+  }
+}
+
+int ObPythonUDFOp::check_mem_bound()
+{
+  int ret = OB_SUCCESS;
+  bool updated = false;
+  if (OB_ISNULL(mem_context_)) {
+    // no buffers
+  } else if (OB_FAIL(sql_mem_processor_.update_max_available_mem_size_periodically(
+                     &mem_context_->get_malloc_allocator(),
+                     [&](int64_t cur_cnt){ return input_row_cnt_ > cur_cnt; },
+                     updated))) {
+    LOG_WARN("failed to update usable memory size periodically", K(ret));
+  } else if (sql_mem_processor_.get_data_size() <= sql_mem_processor_.get_mem_bound()
+             || mem_batch_size_ <= MY_SPEC.max_batch_size_) {
+    // within the work area, or a batch is down to one child batch
+  } else {
+    mem_batch_size_ = std::max(mem_batch_size_ / 2, MY_SPEC.max_batch_size_);
+    input_buffer_.free_unused_pages();
+    output_buffer_.free_unused_pages();
+    FOREACH_CNT_X(e, MY_SPEC.calc_exprs_, OB_SUCC(ret))
+      OZ(limit_predict_size(*e, mem_batch_size_));
+    FOREACH_CNT_X(e, MY_SPEC.output_, OB_SUCC(ret))
+      OZ(limit_predict_size(*e, mem_batch_size_));
+    LOG_TRACE("python udf buffers beyond the work area", K_(mem_batch_size),
+              K(sql_mem_processor_.get_data_size()), K(sql_mem_processor_.get_mem_bound()));
+  }
+  return ret;
+}
+
+int ObPythonUDFOp::fetch_child_batch(const int64_t max_row_cnt)
+{
+  int ret = OB_SUCCESS;
+  const ObBatchRows *child_brs = NULL;
+  if (OB_FAIL(child_->get_next_batch(max_row_cnt, child_brs))) {
+    LOG_WARN("get child next batch failed", K(ret));
+  } else if (FALSE_IT(child_iter_end_ = child_brs->end_)) {
+  } else if (0 == child_brs->size_) {
+  } else {
+    for (int64_t i = 0; OB_SUCC(ret) && i < child_exprs_.count(); i++) {
+      if (OB_FAIL(child_exprs_.at(i)->eval_batch(eval_ctx_, *child_brs->skip_, child_brs->size_))) {
+        LOG_WARN("eval batch failed", K(ret));
+      }
+    }
+    if (OB_FAIL(ret)) {
+    } else if (OB_FAIL(input_buffer_.save(eval_ctx_, child_exprs_, *child_brs))) {
+      LOG_WARN("fail to save input batchrows", K(ret));
+    }
+  }
+  return ret;
+}
+
+int ObPythonUDFOp::pipelined_get_next_batch(const int64_t max_row_cnt)
+{
+  int ret = OB_SUCCESS;
+  int tmp_ret = OB_SUCCESS;
+  int64_t started_cnt = 0;
+  update_predict_size();
+  // rows of this batch, usually fetched while the previous batch was in python
+  while (OB_SUCC(ret) && !child_iter_end_ && input_buffer_.get_size() < predict_size_
+         && input_buffer_.get_free_size() >= MY_SPEC.max_batch_size_) {
+    if (OB_FAIL(fetch_child_batch(max_row_cnt))) {
+      LOG_WARN("fail to fetch child batch", K(ret));
+    }
+  }
+  if (OB_FAIL(ret)) {
+  } else if (FALSE_IT(clear_evaluated_flag())) {
+  } else if (OB_FAIL(input_buffer_.load(eval_ctx_, brs_, brs_skip_size_, predict_size_))) {
+    LOG_WARN("fail to load input batchrows", K(ret));
+  } else if (OB_FAIL(clear_calc_exprs_evaluated_flags())) {
+    LOG_WARN("fail to clear calc_exprs evaluated flages", K(ret));
+  } else {
+    FOREACH_CNT(e, MY_SPEC.col_exprs_) {
+      ObEvalInfo &info = (*e)->get_eval_info(eval_ctx_);
+      info.projected_ = true;
+      info.point_to_frame_ = false;
+      info.cnt_ = brs_.size_;
+    }
+  }
+  // start python, then fetch rows of the next batch. Embedded udfs run together in
+  // group_task_, under one interpreter acquisition and converting shared args once
+  group_task_.reuse();
+  for (int64_t i = 0; OB_SUCC(ret) && brs_.size_ > 0 && i < udf_exprs_.count(); i++) {
+    ++started_cnt;
+    if (OB_FAIL(ObExprPythonUdf::eval_batch_async(*udf_exprs_.at(i), eval_ctx_, *brs_.skip_,
+                                                   brs_.size_, *call_thread_, &group_task_))) {
+      LOG_WARN("fail to start python udf batch", K(ret), K(i));
+    }
+  }
+  if (OB_SUCC(ret) && group_task_.count() > 0
+      && OB_FAIL(call_thread_->submit_task(group_task_))) {
+    LOG_WARN("fail to submit python udf group", K(ret));
+  }
+  // nothing is fetched ahead if this batch is expected to meet the limit
+  while (OB_SUCC(ret) && started_cnt > 0 && !child_iter_end_
+         && input_buffer_.get_size() < predict_size_
+         && input_buffer_.get_free_size() >= MY_SPEC.max_batch_size_
+         && get_limit_input_rows() > brs_.size_) {
+    if (OB_FAIL(fetch_child_batch(max_row_cnt))) {
+      LOG_WARN("fail to fetch child batch", K(ret));
+    }
+  }
+  // started batches are always waited, they reference the frames of this operator
+  if (OB_SUCCESS != (tmp_ret = call_thread_->wait_task(group_task_))) {
+    LOG_WARN("fail to run python udf group", K(tmp_ret));
+    ret = OB_SUCC(ret) ? tmp_ret : ret;
+  }
+  // deferred batches borrow a python worker, only after the others gave theirs back
+  for (int64_t pass = 0; pass < 2; pass++) {
+    for (int64_t i = 0; i < started_cnt; i++) {
+      ObExpr *expr = udf_exprs_.at(i);
+      if ((1 == pass) != ObExprPythonUdf::is_batch_deferred(*expr, eval_ctx_)) {
+      } else if (OB_SUCCESS != (tmp_ret = ObExprPythonUdf::wait_batch_async(*expr, eval_ctx_,
+                                                                            *call_thread_))) {
+        LOG_WARN("fail to wait python udf batch", K(tmp_ret), K(i));
+        ret = OB_SUCC(ret) ? tmp_ret : ret;
+      } else if (OB_SUCC(ret)) {
+        ObEvalInfo &info = expr->get_eval_info(eval_ctx_);
+        info.notnull_ = false;
+        info.point_to_frame_ = true;
+        info.cnt_ = brs_.size_;
+        info.evaluated_ = true;
+      }
+    }
+  }
+  if (OB_SUCC(ret)) {
+    brs_.end_ = child_iter_end_ && 0 == input_buffer_.get_size();
+  }
+  return ret;
+}
 
 /* override */
 int ObPythonUDFOp::inner_get_next_batch(const int64_t max_row_cnt)
 {
   int ret = OB_SUCCESS;
-  if (use_input_buf_) {
-    while (OB_SUCC(ret) && (input_buffer_.get_size() <= input_buffer_.get_max_size() - MY_SPEC.max_batch_size_) && !brs_.end_) {
+  if (use_input_buf_ && OB_FAIL(check_mem_bound())) {
+    LOG_WARN("fail to check work area", K(ret));
+  } else if (use_pipeline_) {
+    ret = pipelined_get_next_batch(max_row_cnt);
+  } else if (use_input_buf_) {
+    update_predict_size();
+    // with a limit above, read no more than the rows of the next prediction
+    while (OB_SUCC(ret) && (input_buffer_.get_free_size() >= MY_SPEC.max_batch_size_) && !brs_.end_
+           && (limit_rows_ < 0 || input_buffer_.get_size() < predict_size_)) {
       if (OB_FAIL(ObSubPlanScanOp::inner_get_next_batch(max_row_cnt))) {
         LOG_WARN("fail to inner get next batch", K(ret));
       } else if (OB_FAIL(input_buffer_.save(eval_ctx_, brs_))){
         LOG_WARN("fail to save input batchrows", K(ret));
       }
     }
-    // 根据exprs的运行时间调整predict size
-    int32_t current_size = 256; //default
-    FOREACH_CNT_X(e, MY_SPEC.calc_exprs_, OB_SUCC(ret)) 
-      OZ(find_predict_size((*e), current_size));
-    FOREACH_CNT_X(e, MY_SPEC.output_, OB_SUCC(ret)) 
-      OZ(find_predict_size((*e), current_size));
-    predict_size_ = current_size;
     // 取出参数
     if (OB_FAIL(input_buffer_.load(eval_ctx_, brs_, brs_skip_size_, predict_size_))) {
       LOG_WARN("fail to load input batchrows", K(ret));
@@ -134,6 +681,9 @@ int ObPythonUDFOp::inner_get_next_batch(const int64_t max_row_cnt)
   } else {
     ret = ObSubPlanScanOp::inner_get_next_batch(max_row_cnt);
   }
+  if (OB_SUCC(ret)) {
+    add_input_rows();
+  }
   return ret;
 }
 
@@ -142,21 +692,34 @@ int ObPythonUDFOp::get_next_batch(const int64_t max_row_cnt, const ObBatchRows *
 {
   int ret = OB_SUCCESS;
   if (use_output_buf_) {
-    while (OB_SUCC(ret) && (output_buffer_.get_size() <= output_buffer_.get_max_size() / 2) && !brs_.end_) {
+    // no more rows are produced once the limit above has enough
+    while (OB_SUCC(ret) && (output_buffer_.get_size() <= output_buffer_.get_max_size() / 2)
+           && output_buffer_.get_free_size() >= max_buffer_size_ && !brs_.end_
+           && !is_limit_reached()) {
       if (OB_FAIL(ObOperator::get_next_batch(max_row_cnt, batch_rows))) {
         LOG_WARN("fail to inner get next batch", K(ret));
+      } else if (FALSE_IT(add_output_rows())) {
       } else if (OB_FAIL(output_buffer_.save(eval_ctx_, brs_))){
         LOG_WARN("fail to save input batchrows", K(ret));
       }
     }
-    if (!output_buffer_.is_saved()) {
-      // do nothing
+    if (OB_FAIL(ret)) {
+    } else if (!output_buffer_.is_saved()) {
+      if (is_limit_reached()) {
+        brs_.size_ = 0;
+        brs_.end_ = true;
+      }
     } else if (OB_FAIL(output_buffer_.load(eval_ctx_, brs_, brs_skip_size_, MY_SPEC.max_batch_size_))) {
       LOG_WARN("fail to load input batchrows", K(ret));
     }
     batch_rows = &brs_;
+  } else if (OB_FAIL(ObOperator::get_next_batch(max_row_cnt, batch_rows))) {
+    LOG_WARN("fail to get next batch", K(ret));
   } else {
-    ret = ObOperator::get_next_batch(max_row_cnt, batch_rows);
+    add_output_rows();
+  }
+  if (OB_SUCC(ret)) {
+    update_monitor_stat();
   }
   return ret;
 }
@@ -170,7 +733,11 @@ int ObPythonUDFOp::clear_calc_exprs_evaluated_flags() {
 }
 
 /* ------------------------------------ buffer for python_udf ----------------------------------- */
-int ObVectorBuffer::init(const common::ObIArray<ObExpr *> &exprs, ObExecContext &exec_ctx, int64_t max_buffer_size)
+int ObVectorBuffer::init(const common::ObIArray<ObExpr *> &exprs,
+                         ObExecContext &exec_ctx,
+                         common::ObIAllocator &alloc,
+                         ObSqlMemMgrProcessor *sql_mem_processor,
+                         int64_t max_buffer_size)
 {
   int ret = OB_SUCCESS;
   if (OB_UNLIKELY(inited_)) {
@@ -180,46 +747,196 @@ int ObVectorBuffer::init(const common::ObIArray<ObExpr *> &exprs, ObExecContext
   } else {
     exprs_ = &exprs;
     exec_ctx_ = &exec_ctx;
-    max_size_ = max_buffer_size; 
-    datums_ = static_cast<ObDatum *>(exec_ctx.get_allocator().alloc(
-      max_size_ * exprs.count() * sizeof(ObDatum)));
+    alloc_ = &alloc;
+    sql_mem_processor_ = sql_mem_processor;
+    max_size_ = max_buffer_size;
+    // one ring per column, all columns in one allocation
+    const int64_t size = max_size_ * exprs.count() * sizeof(ObDatum);
+    datums_ = static_cast<ObDatum *>(alloc.alloc(size));
     if (OB_ISNULL(datums_)) {
       ret = OB_ALLOCATE_MEMORY_FAILED;
       LOG_WARN("allocate memory failed", K(ret), K(max_size_), K(exprs.count()));
+    } else if (NULL != sql_mem_processor_) {
+      sql_mem_processor_->alloc(size);
     }
     inited_ = true;
-    saved_size_ = 0;
+    reuse();
   }
   return ret;
 }
 
+void ObVectorBuffer::reuse()
+{
+  saved_size_ = 0;
+  head_ = 0;
+  loaded_size_ = 0;
+  head_seq_ = 0;
+  // every page is unused now
+  if (NULL != page_tail_) {
+    page_tail_->next_ = free_pages_;
+    free_pages_ = page_head_;
+  }
+  page_head_ = NULL;
+  page_tail_ = NULL;
+}
+
+void ObVectorBuffer::destroy()
+{
+  reuse();
+  free_page_list(free_pages_);
+  if (NULL != datums_ && NULL != alloc_) {
+    if (NULL != sql_mem_processor_) {
+      sql_mem_processor_->free(max_size_ * exprs_->count() * sizeof(ObDatum));
+    }
+    alloc_->free(datums_);
+  }
+  datums_ = NULL;
+  exprs_ = NULL;
+  alloc_ = NULL;
+  sql_mem_processor_ = NULL;
+  inited_ = false;
+}
+
+void ObVectorBuffer::free_page(Page *page)
+{
+  if (NULL != sql_mem_processor_) {
+    sql_mem_processor_->free(sizeof(Page) + page->size_);
+  }
+  alloc_->free(page);
+}
+
+void ObVectorBuffer::free_page_list(Page *&list)
+{
+  while (NULL != list) {
+    Page *next = list->next_;
+    free_page(list);
+    list = next;
+  }
+}
+
+int ObVectorBuffer::copy_payload(const ObDatum &src, const int64_t seq, ObDatum &dst)
+{
+  int ret = OB_SUCCESS;
+  dst = src;
+  if (src.is_null() || 0 == src.len_) {
+  } else {
+    if (NULL == page_tail_ || page_tail_->pos_ + src.len_ > page_tail_->size_) {
+      Page *page = NULL;
+      if (NULL != free_pages_ && src.len_ <= free_pages_->size_) {
+        page = free_pages_;
+        free_pages_ = page->next_;
+      } else {
+        const int64_t size = std::max(PAGE_SIZE, static_cast<int64_t>(src.len_));
+        void *mem = alloc_->alloc(sizeof(Page) + size);
+        if (OB_ISNULL(mem)) {
+          ret = OB_ALLOCATE_MEMORY_FAILED;
+          LOG_WARN("allocate memory failed", K(ret), K(size));
+        } else {
+          page = new (mem) Page();
+          page->size_ = size;
+          if (NULL != sql_mem_processor_) {
+            sql_mem_processor_->alloc(sizeof(Page) + size);
+          }
+        }
+      }
+      if (OB_SUCC(ret)) {
+        page->next_ = NULL;
+        page->pos_ = 0;
+        page->max_seq_ = seq;
+        if (NULL == page_tail_) {
+          page_head_ = page;
+        } else {
+          page_tail_->next_ = page;
+        }
+        page_tail_ = page;
+      }
+    }
+    if (OB_SUCC(ret)) {
+      char *buf = page_tail_->buf_ + page_tail_->pos_;
+      MEMCPY(buf, src.ptr_, src.len_);
+      dst.ptr_ = buf;
+      page_tail_->pos_ += src.len_;
+      page_tail_->max_seq_ = seq;
+    }
+  }
+  return ret;
+}
+
+void ObVectorBuffer::release_pages()
+{
+  // the page being filled is kept, it is appended by the next save
+  while (NULL != page_head_ && page_head_ != page_tail_ && page_head_->max_seq_ < head_seq_) {
+    Page *page = page_head_;
+    page_head_ = page->next_;
+    if (page->size_ > PAGE_SIZE) {
+      // pages of large payloads are not kept
+      free_page(page);
+    } else {
+      page->next_ = free_pages_;
+      free_pages_ = page;
+    }
+  }
+}
+
 int ObVectorBuffer::save(ObEvalCtx &eval_ctx, ObBatchRows &brs_) 
 {
   int ret = OB_SUCCESS;
-  int cnt = brs_.size_ - brs_.skip_->accumulate_bit_cnt(brs_.size_);
   if (NULL == exprs_) {
     // empty expr_: do nothing
-  } else if (NULL == datums_) {
+  } else {
+    ret = do_save(eval_ctx, *exprs_, brs_);
+  }
+  return ret;
+}
+
+int ObVectorBuffer::save(ObEvalCtx &eval_ctx, const common::ObIArray<ObExpr *> &src_exprs,
+                         const ObBatchRows &brs)
+{
+  int ret = OB_SUCCESS;
+  if (NULL == exprs_) {
+    // empty expr_: do nothing
+  } else if (OB_UNLIKELY(src_exprs.count() != exprs_->count())) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("source exprs mismatch", K(ret), K(src_exprs.count()), K(exprs_->count()));
+  } else {
+    ret = do_save(eval_ctx, src_exprs, brs);
+  }
+  return ret;
+}
+
+int ObVectorBuffer::do_save(ObEvalCtx &eval_ctx, const common::ObIArray<ObExpr *> &src_exprs,
+                            const ObBatchRows &brs)
+{
+  int ret = OB_SUCCESS;
+  int cnt = brs.size_ - brs.skip_->accumulate_bit_cnt(brs.size_);
+  if (NULL == datums_) {
     ret = OB_NOT_INIT;
-  } else if (saved_size_ + cnt <= max_size_) {
-    for (int64_t i = 0; i < exprs_->count(); i++) {
-      ObExpr *e = exprs_->at(i);
+  } else if (cnt <= get_free_size()) {
+    for (int64_t i = 0; OB_SUCC(ret) && i < src_exprs.count(); i++) {
+      ObExpr *e = src_exprs.at(i);
       ObDatum *src = e->locate_batch_datums(eval_ctx);
+      ObDatum *col = datums_ + i * max_size_;
+      const bool is_batch = e->is_batch_result();
       int64_t k = 0;
-      for (int64_t j = 0; j < brs_.size_; j++) {
+      for (int64_t j = 0; OB_SUCC(ret) && j < brs.size_; j++) {
         /* remove skipped rows */
-        if (!brs_.skip_->at(j)) {
-          /* deep copy */
-          datums_[i * max_size_ + saved_size_ + k].deep_copy(src[j], exec_ctx_->get_allocator());
+        if (!brs.skip_->at(j)) {
+          /* deep copy into pages, source frames are overwritten by the next batch */
+          const int64_t off = saved_size_ + k;
+          if (OB_FAIL(copy_payload(src[is_batch ? j : 0], head_seq_ + off,
+                                   col[(head_ + off) % max_size_]))) {
+            LOG_WARN("fail to copy datum", K(ret));
+          }
           ++k;
         }
       }
     }
-    saved_size_ += cnt;
-    //brs_.size_ = 0;
+    if (OB_SUCC(ret)) {
+      saved_size_ += cnt;
+    }
   } else {
     ret = OB_ERR_UNEXPECTED;
-    LOG_WARN("fail to save vector buffer", K(ret));
+    LOG_WARN("fail to save vector buffer", K(ret), K(cnt), K_(saved_size), K_(loaded_size));
   }
   return ret;
 }
@@ -231,19 +948,31 @@ int ObVectorBuffer::load(ObEvalCtx &eval_ctx, ObBatchRows &brs_, int64_t &brs_sk
     // empty expr_: do nothing
   } else if (NULL == datums_ || saved_size_ < 0) {
     ret = OB_NOT_INIT;
+  } else if (FALSE_IT(loaded_size_ = 0)) {
+    // rows of the previous load are consumed
+  } else if (FALSE_IT(release_pages())) {
   } else if (saved_size_ == 0) {
     brs_.size_ = 0;
     //brs_.end_ = true;
   } else {
     int64_t size = (saved_size_ < batch_size) ? saved_size_ : batch_size;
+    // a batch is copied in at most two slices, payloads stay in pages
+    const int64_t first = std::min(size, max_size_ - head_);
     for (int64_t i = 0; i < exprs_->count(); i++) {
       ObExpr *e = exprs_->at(i);
-      /* deep copy */
-      MEMCPY(e->locate_batch_datums(eval_ctx), datums_ + i * max_size_, sizeof(ObDatum) * size); 
+      ObDatum *dst = e->locate_batch_datums(eval_ctx);
+      const ObDatum *col = datums_ + i * max_size_;
+      MEMCPY(dst, col + head_, sizeof(ObDatum) * first);
+      if (size > first) {
+        MEMCPY(dst + first, col, sizeof(ObDatum) * (size - first));
+      }
       e->get_pvt_skip(eval_ctx).reset(size);
       e->get_evaluated_flags(eval_ctx).reset(size);
     }
-    move(size);
+    head_ = (head_ + size) % max_size_;
+    head_seq_ += size;
+    saved_size_ -= size;
+    loaded_size_ = size;
     brs_.size_ = size;
     brs_.end_ = false;
     if(size > brs_skip_size_) {
@@ -263,23 +992,6 @@ int ObVectorBuffer::load(ObEvalCtx &eval_ctx, ObBatchRows &brs_, int64_t &brs_sk
   }
   return ret;
 }
-
-int ObVectorBuffer::move(int64_t size) 
-{
-  int ret = OB_SUCCESS;
-  if (NULL == exprs_) {
-    // empty expr_: do nothing
-  } else if (NULL == datums_) {
-    ret = OB_NOT_INIT;
-  } else if (saved_size_ > 0) {
-    for (int64_t i = 0; i < exprs_->count(); i++) {
-      /* shallow copy */
-      MEMMOVE(datums_ + i * max_size_, datums_ + i * max_size_ + size, sizeof(ObDatum) * (saved_size_ - size)); 
-    }
-    saved_size_ -= size;
-  }
-  return ret;
-}
 /* --------------------------------------- end of buffer --------------------------------------*/
 
 } // end namespace sql
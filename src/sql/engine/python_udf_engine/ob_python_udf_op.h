@@ -4,34 +4,79 @@
 #include "sql/engine/ob_operator.h"
 #include "sql/engine/subquery/ob_subplan_scan_op.h"
 #include "sql/engine/expr/ob_expr_python_udf.h"
+#include "sql/engine/ob_sql_mem_mgr_processor.h"
 //#include <Python.h>
 
 namespace oceanbase
 {
 namespace sql
 {
+struct ObGlobalHint;
 
-// buffer for python_udf, based on VectorStore and BatchResultHolder
+// buffer for python_udf, based on VectorStore and BatchResultHolder.
+// Datums are kept in a ring of max_size_ slots per column, their payloads in pages which
+// are recycled once all rows pointing into them are loaded and consumed. Loaded rows are
+// referenced by the exprs until the next load, their slots and pages are kept until then.
+// Memory comes from the work area of the operator and is reported to its sql memory processor.
 struct ObVectorBuffer
 {
 public:
-  ObVectorBuffer() : exprs_(NULL), exec_ctx_(NULL), datums_(NULL),
-                     max_size_(0), saved_size_(0), inited_(false)
+  static const int64_t PAGE_SIZE = 64L << 10;
+  ObVectorBuffer() : exprs_(NULL), exec_ctx_(NULL), alloc_(NULL), sql_mem_processor_(NULL),
+                     datums_(NULL), max_size_(0), saved_size_(0), head_(0), loaded_size_(0),
+                     head_seq_(0), page_head_(NULL), page_tail_(NULL), free_pages_(NULL),
+                     inited_(false)
   {}
-  int init(const common::ObIArray<ObExpr *> &exprs, ObExecContext &exec_ctx, int64_t max_buffer_size);
+  ~ObVectorBuffer() { destroy(); }
+  int init(const common::ObIArray<ObExpr *> &exprs,
+           ObExecContext &exec_ctx,
+           common::ObIAllocator &alloc,
+           ObSqlMemMgrProcessor *sql_mem_processor,
+           int64_t max_buffer_size);
+  void destroy();
+  // drop all rows, pages are kept for reuse
+  void reuse();
   int save(ObEvalCtx &eval_ctx, ObBatchRows &brs_);
+  // save rows of src_exprs into the columns of exprs_, src_exprs are evaluated
+  int save(ObEvalCtx &eval_ctx, const common::ObIArray<ObExpr *> &src_exprs, const ObBatchRows &brs);
   bool is_saved() const { return saved_size_ > 0; }
   int get_size() const { return saved_size_; }
   int get_max_size() const { return max_size_; };
+  // slots a save can use, the loaded rows are still referenced
+  int get_free_size() const { return max_size_ - saved_size_ - loaded_size_; }
   int load(ObEvalCtx &eval_ctx, ObBatchRows &brs_, int64_t &brs_skip_size_, int64_t batch_size);
   int resize(int64_t size);
-  int move(int64_t size); // move datums and cut max_size_
+  // give the recycled pages back to the work area
+  void free_unused_pages() { free_page_list(free_pages_); }
+private:
+  struct Page
+  {
+    Page *next_;
+    int64_t size_;
+    int64_t pos_;
+    int64_t max_seq_; // last row with payload in this page
+    char buf_[0];
+  };
+  int do_save(ObEvalCtx &eval_ctx, const common::ObIArray<ObExpr *> &src_exprs, const ObBatchRows &brs);
+  int copy_payload(const ObDatum &src, const int64_t seq, ObDatum &dst);
+  // recycle pages of rows before head_seq_
+  void release_pages();
+  void free_page(Page *page);
+  void free_page_list(Page *&list);
 private:
   const common::ObIArray<ObExpr *> *exprs_;
   ObExecContext *exec_ctx_;
+  common::ObIAllocator *alloc_;
+  ObSqlMemMgrProcessor *sql_mem_processor_;
   ObDatum *datums_;
   int64_t max_size_;
   int64_t saved_size_;
+  int64_t head_; // slot of the first saved row
+  int64_t loaded_size_; // rows before head_ loaded by the last load
+  int64_t head_seq_; // sequence number of the first saved row, increases with every row
+  Page *page_head_; // oldest page in use
+  Page *page_tail_; // page being filled
+  Page *free_pages_;
   bool inited_;
 };
 
@@ -44,25 +89,84 @@ public:
   
   //void* _save; //for Python Interpreter Thread State
   ExprFixedArray col_exprs_; //input
+  ObExpr *limit_expr_; // rows needed by the limit above, limit + offset, NULL without limit
 };
 
 class ObPythonUDFOp : public ObSubPlanScanOp
 {
 public:
+  // rows of the largest python udf batch, the buffers hold two of them
+  static const int64_t MAX_BUFFER_SIZE = ObPyBatchTuneState::MAX_BATCH_SIZE;
+  // executions on fewer rows say little about the selectivity of a udf
+  static const int64_t MIN_SEL_SAMPLE_ROWS = 1024;
   ObPythonUDFOp(ObExecContext &exec_ctx, const ObOpSpec &spec, ObOpInput *input);
 
   ~ObPythonUDFOp();
 
-  static int alloc_predict_buffer(ObIAllocator &alloc, ObExpr &expr, ObDatum *&buf_result, int buffer_size);
+  // datums, their reserved payload and the bit vectors of a fake frame in one allocation
+  static int alloc_predict_buffer(ObIAllocator &alloc, ObExpr &expr, ObDatum *&buf_result,
+                                  int buffer_size, int64_t &mem_size);
 
+  // rows loaded per batch: the largest batch size of the udfs in expr, a udf of a smaller
+  // size calls python several times on the loaded rows
   static int find_predict_size(ObExpr *expr, int32_t &predict_size);
 
+  // cap the batch size tuners of the python udfs in expr
+  static int limit_predict_size(ObExpr *expr, const int64_t max_size);
+
+  // fix the batch size of the python udfs named in PREDICT_BATCH hints, called by code generator
+  static int set_predict_batch_hint(ObExpr *expr, const ObGlobalHint &global_hint);
+
+  virtual int inner_open() override;
+
+  virtual int inner_rescan() override;
+
+  virtual int inner_close() override;
+
+  virtual void destroy() override;
+
   virtual int inner_get_next_batch(const int64_t max_row_cnt) override;
 
   virtual int get_next_batch(const int64_t max_row_cnt, const ObBatchRows *&batch_rows) override;
 
   int clear_calc_exprs_evaluated_flags();
 
+private:
+  // size the buffers from the work area granted by the sql memory manager
+  int init_buffers();
+  // bytes a buffered row takes in the buffers and fake frames
+  int64_t get_buffer_row_size() const;
+  void destroy_buffers();
+  // top-most python udf exprs, a python udf in the args of another one is evaluated with it
+  static int find_udf_exprs(ObExpr *expr, common::ObIArray<ObExpr *> &udf_exprs);
+  // every python udf expr, also those in the args of another one
+  static int find_all_udf_exprs(ObExpr *expr, common::ObIArray<ObExpr *> &udf_exprs);
+  // stages of the python calls of this execution into the otherstat columns of
+  // GV$SQL_PLAN_MONITOR, see ObPyUdfStageStat
+  void update_monitor_stat();
+  void update_predict_size();
+  // payloads are not in the row size the buffers are sized by. While they take the buffers
+  // beyond the work area, batches get smaller instead of the rows being dumped: every
+  // buffered row is needed by the next python call
+  int check_mem_bound();
+  // fetch a child batch into input_buffer_ without touching col_exprs_
+  int fetch_child_batch(const int64_t max_row_cnt);
+  // python call of batch k runs while the rows of batch k + 1 are fetched from child
+  int pipelined_get_next_batch(const int64_t max_row_cnt);
+  void destroy_call_thread();
+  // rows in and out of filters_, learned by the optimizer when the filters are on a single udf
+  void record_filter_selectivity();
+  // active rows of brs_, before filters_
+  void add_input_rows();
+  // evaluate the rows needed by the limit above, at open and rescan
+  int init_limit();
+  // active rows of brs_ after filters_, counted towards the limit
+  void add_output_rows();
+  bool is_limit_reached() const { return limit_rows_ >= 0 && limit_output_cnt_ >= limit_rows_; }
+  // input rows expected to pass the rows the limit still needs through filters_, at the
+  // selectivity observed so far. INT64_MAX without limit
+  int64_t get_limit_input_rows() const;
+
 private:
   ExprFixedArray buf_exprs_; //all exprs with fake frames
   int64_t result_width_; //要进行拷贝的expr数
@@ -71,9 +175,25 @@ private:
   ObVectorBuffer output_buffer_;
   ObDatum **buf_results_; // for fake frame
   int predict_size_; //每次python udf计算的元组数
+  int64_t max_buffer_size_; // rows of the largest batch, granted by the sql memory manager
+  int64_t mem_batch_size_; // rows of a batch, lowered while payloads overrun the work area
+  bool buffers_inited_;
   bool use_input_buf_; 
   bool use_output_buf_;
   bool use_fake_frame_;
+  bool use_pipeline_;
+  bool child_iter_end_;
+  int64_t input_row_cnt_; // rows produced before filters_
+  int64_t limit_rows_; // rows needed by the limit above, -1 without limit
+  int64_t limit_output_cnt_; // rows out of filters_ since open or rescan
+  common::ObSEArray<ObExpr *, 4> udf_exprs_;
+  common::ObSEArray<ObExpr *, 4> monitor_exprs_; // python udfs evaluated by this operator
+  common::ObSEArray<ObExpr *, 8> child_exprs_; // projector_ sources, in col_exprs_ order
+  ObPyCallThread *call_thread_;
+  ObPyUdfGroupTask group_task_; // embedded udf batches of the current batch
+  lib::MemoryContext mem_context_;
+  ObSqlWorkAreaProfile profile_;
+  ObSqlMemMgrProcessor sql_mem_processor_;
 };
 
 } // end namespace sql
@@ -0,0 +1,179 @@
+#define USING_LOG_PREFIX SQL_ENG
+
+#include "sql/engine/python_udf_engine/ob_python_udf_result_cache.h"
+#include "lib/hash_func/murmur_hash.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+ObPyResultCacheKey::ObPyResultCacheKey(const uint64_t tenant_id, const uint64_t udf_id,
+                                       const int64_t schema_version, const ObString &args)
+    : tenant_id_(tenant_id), udf_id_(udf_id), schema_version_(schema_version), hash_(0),
+      args_(args)
+{
+  hash_ = murmurhash(&udf_id_, sizeof(udf_id_), 0);
+  hash_ = murmurhash(&schema_version_, sizeof(schema_version_), hash_);
+  hash_ = murmurhash(args_.ptr(), args_.length(), hash_);
+}
+
+bool ObPyResultCacheKey::operator ==(const ObIKVCacheKey &other) const
+{
+  const ObPyResultCacheKey &other_key = reinterpret_cast<const ObPyResultCacheKey &>(other);
+  return tenant_id_ == other_key.tenant_id_
+         && udf_id_ == other_key.udf_id_
+         && schema_version_ == other_key.schema_version_
+         && hash_ == other_key.hash_
+         && args_ == other_key.args_;
+}
+
+int ObPyResultCacheKey::deep_copy(char *buf, const int64_t buf_len, ObIKVCacheKey *&key) const
+{
+  int ret = OB_SUCCESS;
+  ObPyResultCacheKey *tmp = NULL;
+  if (OB_ISNULL(buf) || OB_UNLIKELY(buf_len < size())) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid argument", K(ret), KP(buf), K(buf_len), K(size()));
+  } else {
+    tmp = new (buf) ObPyResultCacheKey();
+    *tmp = *this;
+    MEMCPY(buf + sizeof(*this), args_.ptr(), args_.length());
+    tmp->args_.assign_ptr(buf + sizeof(*this), args_.length());
+    key = tmp;
+  }
+  return ret;
+}
+
+int ObPyResultCacheValue::deep_copy(char *buf, const int64_t buf_len, ObIKVCacheValue *&value) const
+{
+  int ret = OB_SUCCESS;
+  ObPyResultCacheValue *tmp = NULL;
+  if (OB_ISNULL(buf) || OB_UNLIKELY(buf_len < size())) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid argument", K(ret), KP(buf), K(buf_len), K(size()));
+  } else {
+    tmp = new (buf) ObPyResultCacheValue();
+    tmp->datum_.pack_ = datum_.pack_;
+    MEMCPY(buf + sizeof(*this), datum_.ptr_, datum_.len_);
+    tmp->datum_.ptr_ = buf + sizeof(*this);
+    value = tmp;
+  }
+  return ret;
+}
+
+ObPyResultCache &ObPyResultCache::get_instance()
+{
+  static ObPyResultCache instance;
+  return instance;
+}
+
+int ObPyResultCache::init()
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(inited_)) {
+    ret = OB_INIT_TWICE;
+    LOG_WARN("python udf result cache init twice", K(ret));
+  } else if (OB_FAIL(ObKVCache::init("python_udf_result_cache", DEFAULT_PRIORITY))) {
+    LOG_WARN("fail to init kv cache", K(ret));
+  } else if (OB_FAIL(stats_.create(BUCKET_NUM, "PyUdfResCache"))) {
+    LOG_WARN("fail to create hash map", K(ret));
+  } else {
+    inited_ = true;
+  }
+  return ret;
+}
+
+void ObPyResultCache::destroy()
+{
+  if (inited_) {
+    stats_.destroy();
+    ObKVCache::destroy();
+    inited_ = false;
+  }
+}
+
+int ObPyResultCache::get_result(const ObPyResultCacheKey &key, const ObPyResultCacheValue *&value,
+                                ObKVCacheHandle &handle)
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(!inited_)) {
+    ret = OB_NOT_INIT;
+  } else if (OB_FAIL(get(key, value, handle))) {
+    if (OB_ENTRY_NOT_EXIST != ret) {
+      LOG_WARN("fail to get python udf result", K(ret), K(key));
+    }
+  }
+  return ret;
+}
+
+int ObPyResultCache::put_result(const ObPyResultCacheKey &key, const ObDatum &result)
+{
+  int ret = OB_SUCCESS;
+  ObPyResultCacheValue value(result);
+  if (OB_UNLIKELY(!inited_)) {
+    ret = OB_NOT_INIT;
+  } else if (OB_FAIL(put(key, value, false /* overwrite */))) {
+    // OB_ENTRY_EXIST if the same row was put by another execution in between
+    if (OB_ENTRY_EXIST != ret) {
+      LOG_WARN("fail to put python udf result", K(ret), K(key));
+    }
+  }
+  return ret;
+}
+
+int ObPyResultCache::add_stat(const uint64_t tenant_id, const int64_t hit_cnt,
+                              const int64_t miss_cnt, const int64_t put_cnt)
+{
+  int ret = OB_SUCCESS;
+  StatUpdater updater(hit_cnt, miss_cnt, put_cnt);
+  if (OB_UNLIKELY(!inited_)) {
+    ret = OB_NOT_INIT;
+  } else if (OB_SUCC(stats_.atomic_refactored(tenant_id, updater))) {
+  } else if (OB_HASH_NOT_EXIST != ret) {
+    LOG_WARN("fail to update stat", K(ret), K(tenant_id));
+  } else {
+    ObPyResultCacheStat stat;
+    updater.apply(stat);
+    if (OB_SUCC(stats_.set_refactored(tenant_id, stat, 0 /* overwrite */))) {
+    } else if (OB_HASH_EXIST != ret) {
+      LOG_WARN("fail to set stat", K(ret), K(tenant_id));
+    } else if (OB_FAIL(stats_.atomic_refactored(tenant_id, updater))) {
+      // set by another thread in between
+      LOG_WARN("fail to update stat", K(ret), K(tenant_id));
+    }
+  }
+  return ret;
+}
+
+int ObPyResultCache::get_stat(const uint64_t tenant_id, ObPyResultCacheStat &stat)
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(!inited_)) {
+    ret = OB_NOT_INIT;
+  } else if (OB_FAIL(stats_.get_refactored(tenant_id, stat))) {
+    if (OB_HASH_NOT_EXIST == ret) {
+      // nothing cached for the tenant yet
+      stat = ObPyResultCacheStat();
+      ret = OB_SUCCESS;
+    } else {
+      LOG_WARN("fail to get stat", K(ret), K(tenant_id));
+    }
+  }
+  if (OB_SUCC(ret)) {
+    stat.kv_cnt_ = count(tenant_id);
+    stat.mem_size_ = store_size(tenant_id);
+  }
+  return ret;
+}
+
+void ObPyResultCache::StatUpdater::apply(ObPyResultCacheStat &stat) const
+{
+  stat.hit_cnt_ += hit_cnt_;
+  stat.miss_cnt_ += miss_cnt_;
+  stat.put_cnt_ += put_cnt_;
+}
+
+} // end namespace sql
+} // end namespace oceanbase
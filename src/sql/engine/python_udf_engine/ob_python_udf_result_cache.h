@@ -0,0 +1,109 @@
+#ifndef OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_RESULT_CACHE_H_
+#define OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_RESULT_CACHE_H_
+
+#include "share/cache/ob_kv_storecache.h"
+#include "lib/hash/ob_hashmap.h"
+#include "lib/string/ob_string.h"
+#include "share/datum/ob_datum.h"
+
+namespace oceanbase
+{
+namespace sql
+{
+
+/*
+ * Results of DETERMINISTIC python udfs, shared by the queries of a tenant.
+ *
+ * A result is keyed by the udf version and the bytes of its arguments, the hash of the
+ * arguments only selects the bucket. Replacing a udf changes its schema version, results of
+ * the old version are no longer hit and are washed out with the rest of the kv cache.
+ * Per-tenant hit, miss and put counters are shown in __all_virtual_python_udf_result_cache.
+ */
+struct ObPyResultCacheKey : public common::ObIKVCacheKey
+{
+  ObPyResultCacheKey() : tenant_id_(common::OB_INVALID_TENANT_ID), udf_id_(common::OB_INVALID_ID),
+                         schema_version_(common::OB_INVALID_VERSION), hash_(0), args_() {}
+  ObPyResultCacheKey(const uint64_t tenant_id, const uint64_t udf_id, const int64_t schema_version,
+                     const common::ObString &args);
+  virtual bool operator ==(const common::ObIKVCacheKey &other) const override;
+  virtual uint64_t hash() const override { return hash_; }
+  virtual uint64_t get_tenant_id() const override { return tenant_id_; }
+  virtual int64_t size() const override { return sizeof(*this) + args_.length(); }
+  virtual int deep_copy(char *buf, const int64_t buf_len, ObIKVCacheKey *&key) const override;
+  TO_STRING_KV(K_(tenant_id), K_(udf_id), K_(schema_version), K_(hash), K(args_.length()));
+
+  uint64_t tenant_id_;
+  uint64_t udf_id_;
+  int64_t schema_version_;
+  uint64_t hash_;
+  common::ObString args_; // length prefixed bytes of the argument datums
+};
+
+struct ObPyResultCacheValue : public common::ObIKVCacheValue
+{
+  ObPyResultCacheValue() : datum_() {}
+  explicit ObPyResultCacheValue(const common::ObDatum &datum) : datum_(datum) {}
+  virtual int64_t size() const override { return sizeof(*this) + datum_.len_; }
+  virtual int deep_copy(char *buf, const int64_t buf_len, ObIKVCacheValue *&value) const override;
+  TO_STRING_KV(K_(datum));
+
+  common::ObDatum datum_;
+};
+
+struct ObPyResultCacheStat
+{
+  ObPyResultCacheStat() : hit_cnt_(0), miss_cnt_(0), put_cnt_(0), kv_cnt_(0), mem_size_(0) {}
+  // results put and no longer in the cache, washed out or dropped with the tenant
+  int64_t get_evict_cnt() const { return put_cnt_ > kv_cnt_ ? put_cnt_ - kv_cnt_ : 0; }
+  TO_STRING_KV(K_(hit_cnt), K_(miss_cnt), K_(put_cnt), K_(kv_cnt), K_(mem_size));
+
+  int64_t hit_cnt_;
+  int64_t miss_cnt_;
+  int64_t put_cnt_;
+  int64_t kv_cnt_;
+  int64_t mem_size_;
+};
+
+class ObPyResultCache : public common::ObKVCache<ObPyResultCacheKey, ObPyResultCacheValue>
+{
+public:
+  static const int64_t DEFAULT_PRIORITY = 1;
+  static const int64_t BUCKET_NUM = 64;
+
+  ObPyResultCache() : stats_(), inited_(false) {}
+  virtual ~ObPyResultCache() { destroy(); }
+  static ObPyResultCache &get_instance();
+  int init();
+  void destroy();
+  bool is_inited() const { return inited_; }
+
+  // OB_ENTRY_NOT_EXIST on a miss, the value is valid as long as the handle
+  int get_result(const ObPyResultCacheKey &key, const ObPyResultCacheValue *&value,
+                 common::ObKVCacheHandle &handle);
+  int put_result(const ObPyResultCacheKey &key, const common::ObDatum &result);
+  // counted once per batch
+  int add_stat(const uint64_t tenant_id, const int64_t hit_cnt, const int64_t miss_cnt,
+               const int64_t put_cnt);
+  int get_stat(const uint64_t tenant_id, ObPyResultCacheStat &stat);
+
+private:
+  typedef common::hash::HashMapPair<uint64_t, ObPyResultCacheStat> StatPair;
+  struct StatUpdater
+  {
+    StatUpdater(const int64_t hit_cnt, const int64_t miss_cnt, const int64_t put_cnt)
+        : hit_cnt_(hit_cnt), miss_cnt_(miss_cnt), put_cnt_(put_cnt) {}
+    void operator()(StatPair &pair) { apply(pair.second); }
+    void apply(ObPyResultCacheStat &stat) const;
+    int64_t hit_cnt_;
+    int64_t miss_cnt_;
+    int64_t put_cnt_;
+  };
+  common::hash::ObHashMap<uint64_t, ObPyResultCacheStat> stats_;
+  bool inited_;
+  DISALLOW_COPY_AND_ASSIGN(ObPyResultCache);
+};
+
+} // end namespace sql
+} // end namespace oceanbase
+
+#endif // OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_RESULT_CACHE_H_
@@ -0,0 +1,113 @@
+#define USING_LOG_PREFIX SQL_ENG
+
+#include "sql/engine/python_udf_engine/ob_python_udf_stat.h"
+#include "lib/oblog/ob_log.h"
+#include "share/rc/ob_tenant_base.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+int ObPyUdfStatMgr::init(const uint64_t tenant_id)
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(inited_)) {
+    ret = OB_INIT_TWICE;
+    LOG_WARN("python udf stat mgr init twice", K(ret));
+  } else if (OB_FAIL(infos_.create(BUCKET_NUM, ObMemAttr(tenant_id, "PyUdfStat")))) {
+    LOG_WARN("fail to create hash map", K(ret));
+  } else {
+    inited_ = true;
+  }
+  return ret;
+}
+
+void ObPyUdfStatMgr::destroy()
+{
+  if (inited_) {
+    infos_.destroy();
+    inited_ = false;
+  }
+}
+
+int ObPyUdfStatMgr::mtl_init(ObPyUdfStatMgr* &mgr)
+{
+  int ret = OB_SUCCESS;
+  uint64_t tenant_id = lib::current_resource_owner_id();
+  mgr = OB_NEW(ObPyUdfStatMgr, ObModIds::OB_SQL_EXECUTOR);
+  if (nullptr == mgr) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("failed to alloc memory for ObPyUdfStatMgr", K(ret));
+  } else if (OB_FAIL(mgr->init(tenant_id))) {
+    LOG_WARN("failed to init python udf stat mgr", K(ret));
+  }
+  if (OB_FAIL(ret) && mgr != nullptr) {
+    // cleanup
+    ob_delete(mgr);
+    mgr = nullptr;
+  }
+  return ret;
+}
+
+void ObPyUdfStatMgr::mtl_destroy(ObPyUdfStatMgr* &mgr)
+{
+  if (mgr != nullptr) {
+    ob_delete(mgr);
+    mgr = nullptr;
+  }
+}
+
+int ObPyUdfStatMgr::add(const ObPyUdfStatKey &key, const int64_t schema_version,
+                        const ObString &name, const ObPyUdfStageStat &stat)
+{
+  int ret = OB_SUCCESS;
+  StatUpdater updater(schema_version, stat);
+  if (OB_UNLIKELY(!inited_)) {
+    ret = OB_NOT_INIT;
+  } else if (OB_SUCC(infos_.atomic_refactored(key, updater))) {
+  } else if (OB_HASH_NOT_EXIST != ret) {
+    LOG_WARN("fail to update python udf stat", K(ret), K(key));
+  } else if (infos_.size() >= MAX_ENTRY_CNT) {
+    // full, the udf is not shown for this plan
+    ret = OB_SUCCESS;
+  } else {
+    ObPyUdfStatInfo info;
+    info.key_ = key;
+    const int64_t name_len = std::min(static_cast<int64_t>(name.length()),
+                                      OB_MAX_UDF_NAME_LENGTH);
+    MEMCPY(info.name_, name.ptr(), name_len);
+    info.name_[name_len] = '\0';
+    updater.apply(info);
+    if (OB_SUCC(infos_.set_refactored(key, info, 0 /* overwrite */))) {
+    } else if (OB_HASH_EXIST != ret) {
+      LOG_WARN("fail to set python udf stat", K(ret), K(key));
+    } else if (OB_FAIL(infos_.atomic_refactored(key, updater))) {
+      // set by another thread in between
+      LOG_WARN("fail to update python udf stat", K(ret), K(key));
+    }
+  }
+  return ret;
+}
+
+int ObPyUdfStatMgr::get_all(ObIArray<ObPyUdfStatInfo> &infos)
+{
+  int ret = OB_SUCCESS;
+  InfoCollector collector(infos);
+  if (OB_UNLIKELY(!inited_)) {
+    ret = OB_NOT_INIT;
+  } else if (OB_FAIL(infos_.foreach_refactored(collector))) {
+    LOG_WARN("fail to collect python udf stats", K(ret));
+  }
+  return ret;
+}
+
+void ObPyUdfStatMgr::StatUpdater::apply(ObPyUdfStatInfo &info) const
+{
+  info.schema_version_ = schema_version_;
+  info.stat_.add(stat_);
+}
+
+} // end namespace sql
+} // end namespace oceanbase
@@ -0,0 +1,142 @@
+#ifndef OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_STAT_H_
+#define OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_STAT_H_
+
+#include "lib/utility/ob_print_utils.h"
+#include "lib/hash/ob_hashmap.h"
+#include "lib/hash_func/murmur_hash.h"
+#include "lib/container/ob_iarray.h"
+#include "lib/string/ob_string.h"
+
+namespace oceanbase
+{
+namespace sql
+{
+
+/*
+ * Where the time of python udf calls goes, per udf and plan.
+ *
+ * Every python call is split into stages timed with the cycle counter: waiting for an
+ * interpreter and its GIL (or for a python worker), ObDatum to python conversion, inference
+ * in python and the conversion of the result back. A udf run by a python worker has its
+ * whole round trip counted as inference. The stages of a call are added to the udf ctx of
+ * the execution, read by ObPythonUDFOp for GV$SQL_PLAN_MONITOR, and to the tenant
+ * ObPyUdfStatMgr shown in __all_virtual_python_udf_stat.
+ */
+struct ObPyUdfStageStat
+{
+  ObPyUdfStageStat() { reset(); }
+  void reset()
+  {
+    batch_cnt_ = 0;
+    row_cnt_ = 0;
+    gil_wait_cycles_ = 0;
+    ob2py_cycles_ = 0;
+    infer_cycles_ = 0;
+    py2ob_cycles_ = 0;
+    batch_size_ = 0;
+  }
+  void add(const ObPyUdfStageStat &other)
+  {
+    batch_cnt_ += other.batch_cnt_;
+    row_cnt_ += other.row_cnt_;
+    gil_wait_cycles_ += other.gil_wait_cycles_;
+    ob2py_cycles_ += other.ob2py_cycles_;
+    infer_cycles_ += other.infer_cycles_;
+    py2ob_cycles_ += other.py2ob_cycles_;
+    if (other.batch_size_ > 0) {
+      batch_size_ = other.batch_size_;
+    }
+  }
+  TO_STRING_KV(K_(batch_cnt), K_(row_cnt), K_(gil_wait_cycles), K_(ob2py_cycles),
+               K_(infer_cycles), K_(py2ob_cycles), K_(batch_size));
+
+  int64_t batch_cnt_; // python calls
+  int64_t row_cnt_;
+  int64_t gil_wait_cycles_;
+  int64_t ob2py_cycles_;
+  int64_t infer_cycles_;
+  int64_t py2ob_cycles_;
+  int64_t batch_size_; // rows per python call chosen by the batch size tuner, last call
+};
+
+struct ObPyUdfStatKey
+{
+  ObPyUdfStatKey() : udf_id_(common::OB_INVALID_ID), plan_id_(common::OB_INVALID_ID) {}
+  ObPyUdfStatKey(const uint64_t udf_id, const uint64_t plan_id)
+      : udf_id_(udf_id), plan_id_(plan_id) {}
+  uint64_t hash() const
+  {
+    uint64_t hash_val = common::murmurhash(&udf_id_, sizeof(udf_id_), 0);
+    return common::murmurhash(&plan_id_, sizeof(plan_id_), hash_val);
+  }
+  bool operator ==(const ObPyUdfStatKey &other) const
+  {
+    return udf_id_ == other.udf_id_ && plan_id_ == other.plan_id_;
+  }
+  TO_STRING_KV(K_(udf_id), K_(plan_id));
+
+  uint64_t udf_id_;
+  uint64_t plan_id_; // OB_INVALID_ID if the udf is not run by a cached plan
+};
+
+struct ObPyUdfStatInfo
+{
+  ObPyUdfStatInfo() : key_(), schema_version_(common::OB_INVALID_VERSION), stat_()
+  {
+    name_[0] = '\0';
+  }
+  common::ObString get_name() const { return common::ObString::make_string(name_); }
+  TO_STRING_KV(K_(key), K_(schema_version), K(get_name()), K_(stat));
+
+  ObPyUdfStatKey key_;
+  int64_t schema_version_; // of the last call
+  char name_[common::OB_MAX_UDF_NAME_LENGTH + 1];
+  ObPyUdfStageStat stat_;
+};
+
+class ObPyUdfStatMgr
+{
+public:
+  static const int64_t BUCKET_NUM = 1024;
+  // (udf, plan) pairs kept per tenant, pairs of plans evicted from the plan cache stay until
+  // the tenant is dropped, new pairs beyond it are not recorded
+  static const int64_t MAX_ENTRY_CNT = 8192;
+
+  ObPyUdfStatMgr() : inited_(false) {}
+  ~ObPyUdfStatMgr() { destroy(); }
+  int init(const uint64_t tenant_id);
+  void destroy();
+  static int mtl_init(ObPyUdfStatMgr* &mgr);
+  static void mtl_destroy(ObPyUdfStatMgr* &mgr);
+
+  int add(const ObPyUdfStatKey &key, const int64_t schema_version,
+          const common::ObString &name, const ObPyUdfStageStat &stat);
+  int get_all(common::ObIArray<ObPyUdfStatInfo> &infos);
+
+private:
+  typedef common::hash::HashMapPair<ObPyUdfStatKey, ObPyUdfStatInfo> InfoPair;
+  // callback of atomic_refactored()
+  struct StatUpdater
+  {
+    StatUpdater(const int64_t schema_version, const ObPyUdfStageStat &stat)
+        : schema_version_(schema_version), stat_(stat) {}
+    void operator()(InfoPair &pair) { apply(pair.second); }
+    void apply(ObPyUdfStatInfo &info) const;
+    int64_t schema_version_;
+    const ObPyUdfStageStat &stat_;
+  };
+  struct InfoCollector
+  {
+    explicit InfoCollector(common::ObIArray<ObPyUdfStatInfo> &infos) : infos_(infos) {}
+    int operator()(InfoPair &pair) { return infos_.push_back(pair.second); }
+    common::ObIArray<ObPyUdfStatInfo> &infos_;
+  };
+  common::hash::ObHashMap<ObPyUdfStatKey, ObPyUdfStatInfo> infos_;
+  bool inited_;
+  DISALLOW_COPY_AND_ASSIGN(ObPyUdfStatMgr);
+};
+
+} // end namespace sql
+} // end namespace oceanbase
+
+#endif // OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_STAT_H_
@@ -0,0 +1,419 @@
+#define USING_LOG_PREFIX SQL_ENG
+
+#include "sql/engine/python_udf_engine/ob_python_udf_tree_model.h"
+#include <cmath>
+#include <cstdlib>
+#include "lib/oblog/ob_log.h"
+#include "lib/allocator/page_arena.h"
+#include "lib/container/ob_se_array.h"
+#include "lib/json_type/ob_json_tree.h"
+#include "lib/json_type/ob_json_parse.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+namespace
+{
+// node of the json dump waiting for its place in the flattened tree
+struct ObPyPendingNode
+{
+  ObPyPendingNode() : json_(NULL), pos_(0), depth_(0) {}
+  ObPyPendingNode(const ObJsonNode *json, const int64_t pos, const int32_t depth)
+      : json_(json), pos_(pos), depth_(depth) {}
+  TO_STRING_KV(KP_(json), K_(pos), K_(depth));
+  const ObJsonNode *json_;
+  int64_t pos_;
+  int32_t depth_;
+};
+}
+
+int ObPyTreeModel::init(ObIAllocator &alloc, const ObString &dump)
+{
+  int ret = OB_SUCCESS;
+  ObArenaAllocator json_alloc("PyTreeModel");
+  ObJsonNode *root = NULL;
+  const ObJsonNode *trees = NULL;
+  bool is_lightgbm = false;
+  ObSEArray<Node, 256> nodes;
+  ObSEArray<int32_t, 64> roots;
+  ObSEArray<int32_t, 64> depths;
+  if (OB_UNLIKELY(is_inited())) {
+    ret = OB_INIT_TWICE;
+    LOG_WARN("tree model is inited twice", K(ret));
+  } else if (OB_FAIL(ObJsonParser::get_tree(&json_alloc, dump, root))) {
+    LOG_WARN("fail to parse tree model dump", K(ret));
+  } else if (OB_ISNULL(root)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("tree model dump is empty", K(ret));
+  } else if (ObJsonNodeType::J_ARRAY == root->json_type()) {
+    trees = root;
+  } else if (ObJsonNodeType::J_OBJECT != root->json_type()) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("tree model dump is neither a list of trees nor an object", K(ret));
+  } else if (NULL != (trees = get_member(*root, "tree_info"))) {
+    is_lightgbm = true;
+  } else if (OB_ISNULL(trees = get_member(*root, "trees"))) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("tree model dump has no trees", K(ret));
+  }
+  if (OB_FAIL(ret)) {
+  } else if (OB_UNLIKELY(ObJsonNodeType::J_ARRAY != trees->json_type()
+                         || 0 == trees->element_count())) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("trees of the model dump are not a non empty list", K(ret));
+  } else if (trees != root && OB_FAIL(parse_options(*root, is_lightgbm))) {
+    LOG_WARN("fail to parse tree model options", K(ret));
+  }
+  for (uint64_t i = 0; OB_SUCC(ret) && i < trees->element_count(); i++) {
+    const ObJsonNode *tree = (*static_cast<const ObJsonArray *>(trees))[i];
+    int32_t depth = 0;
+    if (OB_ISNULL(tree) || OB_UNLIKELY(ObJsonNodeType::J_OBJECT != tree->json_type())) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_WARN("tree of the model dump is not an object", K(ret), K(i));
+    } else if (OB_FAIL(roots.push_back(static_cast<int32_t>(nodes.count())))) {
+      LOG_WARN("fail to push back tree root", K(ret));
+    } else if (is_lightgbm && OB_FAIL(parse_lightgbm_tree(*tree, nodes, depth))) {
+      LOG_WARN("fail to parse lightgbm tree", K(ret), K(i));
+    } else if (!is_lightgbm && OB_FAIL(parse_xgboost_tree(*tree, nodes, depth))) {
+      LOG_WARN("fail to parse xgboost tree", K(ret), K(i));
+    } else if (OB_FAIL(depths.push_back(depth))) {
+      LOG_WARN("fail to push back tree depth", K(ret));
+    }
+  }
+  if (OB_SUCC(ret)) {
+    Node *node_buf = static_cast<Node *>(alloc.alloc(sizeof(Node) * nodes.count()));
+    int32_t *root_buf = static_cast<int32_t *>(alloc.alloc(sizeof(int32_t) * roots.count()));
+    int32_t *depth_buf = static_cast<int32_t *>(alloc.alloc(sizeof(int32_t) * depths.count()));
+    if (OB_ISNULL(node_buf) || OB_ISNULL(root_buf) || OB_ISNULL(depth_buf)) {
+      ret = OB_ALLOCATE_MEMORY_FAILED;
+      LOG_WARN("fail to allocate tree model", K(ret), K(nodes.count()), K(roots.count()));
+    } else {
+      MEMCPY(node_buf, nodes.get_data(), sizeof(Node) * nodes.count());
+      MEMCPY(root_buf, roots.get_data(), sizeof(int32_t) * roots.count());
+      MEMCPY(depth_buf, depths.get_data(), sizeof(int32_t) * depths.count());
+      nodes_ = node_buf;
+      roots_ = root_buf;
+      depths_ = depth_buf;
+      node_cnt_ = nodes.count();
+      tree_cnt_ = roots.count();
+      LOG_DEBUG("tree model loaded", KPC(this));
+    }
+  }
+  return ret;
+}
+
+int ObPyTreeModel::parse_options(const ObJsonNode &root, const bool is_lightgbm)
+{
+  int ret = OB_SUCCESS;
+  const ObJsonNode *objective = get_member(root, "objective");
+  const ObJsonNode *average = get_member(root, is_lightgbm ? "average_output" : "average");
+  const ObJsonNode *base_score = is_lightgbm ? NULL : get_member(root, "base_score");
+  if (NULL != base_score && OB_FAIL(get_number(base_score, base_score_))) {
+    LOG_WARN("invalid base_score", K(ret));
+  } else if (NULL != average && ObJsonNodeType::J_BOOLEAN != average->json_type()) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid average option", K(ret));
+  } else if (FALSE_IT(average_ = NULL != average && average->get_boolean())) {
+  } else if (NULL == objective) {
+    objective_ = RAW;
+  } else if (ObJsonNodeType::J_STRING != objective->json_type()) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid objective", K(ret));
+  } else {
+    const ObString name(objective->get_data_length(), objective->get_data());
+    // lightgbm writes the parameters of the objective after its name, as in "binary sigmoid:1"
+    if (name.prefix_match("binary:logistic") || name.prefix_match("reg:logistic")
+        || (is_lightgbm && name.prefix_match("binary sigmoid:1"))) {
+      objective_ = LOGISTIC;
+    } else if (name.prefix_match("reg:squarederror") || name.prefix_match("reg:linear")
+               || name.prefix_match("reg:absoluteerror") || name.prefix_match("binary:logitraw")
+               || (is_lightgbm && (name.prefix_match("regression") || name.prefix_match("huber")
+                                   || name.prefix_match("fair") || name.prefix_match("quantile")))) {
+      objective_ = RAW;
+    } else {
+      ret = OB_NOT_SUPPORTED;
+      LOG_WARN("objective of the tree model is not supported", K(ret), K(name));
+      LOG_USER_ERROR(OB_NOT_SUPPORTED, "objective of the tree model");
+    }
+  }
+  return ret;
+}
+
+int ObPyTreeModel::parse_xgboost_tree(const ObJsonNode &root, NodeArray &nodes, int32_t &depth)
+{
+  int ret = OB_SUCCESS;
+  ObSEArray<ObPyPendingNode, 64> pending;
+  depth = 0;
+  if (OB_FAIL(nodes.push_back(Node()))) {
+    LOG_WARN("fail to push back tree node", K(ret));
+  } else if (OB_FAIL(pending.push_back(ObPyPendingNode(&root, nodes.count() - 1, 0)))) {
+    LOG_WARN("fail to push back pending node", K(ret));
+  }
+  // breadth first, the children of a split are placed side by side at the end of nodes
+  for (int64_t head = 0; OB_SUCC(ret) && head < pending.count(); head++) {
+    const ObPyPendingNode cur = pending.at(head);
+    const ObJsonNode *leaf = get_member(*cur.json_, "leaf");
+    const ObJsonNode *split = get_member(*cur.json_, "split");
+    const ObJsonNode *yes = NULL;
+    const ObJsonNode *no = NULL;
+    double value = 0;
+    int64_t feature = 0;
+    int64_t yes_id = 0;
+    int64_t no_id = 0;
+    int64_t missing_id = -1;
+    const int64_t left = nodes.count();
+    if (NULL != leaf) {
+      if (OB_FAIL(get_number(leaf, nodes.at(cur.pos_).value_))) {
+        LOG_WARN("invalid leaf value", K(ret));
+      }
+    } else if (OB_ISNULL(split)) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_WARN("tree node is neither a split nor a leaf", K(ret), K(cur));
+    } else if (ObJsonNodeType::J_STRING == split->json_type()) {
+      // unnamed features are dumped as f0, f1, ...
+      const ObString name(split->get_data_length(), split->get_data());
+      char *endptr = NULL;
+      if (name.length() < 2 || 'f' != name.ptr()[0]
+          || FALSE_IT(feature = strtol(name.ptr() + 1, &endptr, 10))
+          || endptr != name.ptr() + name.length()) {
+        ret = OB_NOT_SUPPORTED;
+        LOG_WARN("feature of the tree model is not f<arg index>", K(ret), K(name));
+        LOG_USER_ERROR(OB_NOT_SUPPORTED, "named features in tree model, dump it with f<arg index>");
+      }
+    } else if (OB_FAIL(get_int(split, feature))) {
+      LOG_WARN("invalid split feature", K(ret));
+    }
+    if (OB_FAIL(ret) || NULL != leaf) {
+    } else if (OB_FAIL(add_feature(feature))) {
+      LOG_WARN("invalid split feature", K(ret), K(feature));
+    } else if (OB_FAIL(get_number(get_member(*cur.json_, "split_condition"), value))) {
+      LOG_WARN("invalid split condition", K(ret));
+    } else if (OB_FAIL(get_int(get_member(*cur.json_, "yes"), yes_id))
+               || OB_FAIL(get_int(get_member(*cur.json_, "no"), no_id))) {
+      LOG_WARN("invalid split children", K(ret));
+    } else if (NULL != get_member(*cur.json_, "missing")
+               && OB_FAIL(get_int(get_member(*cur.json_, "missing"), missing_id))) {
+      LOG_WARN("invalid split missing child", K(ret));
+    } else if (OB_ISNULL(yes = find_child(*cur.json_, yes_id))
+               || OB_ISNULL(no = find_child(*cur.json_, no_id))) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_WARN("children of the split are not in the dump", K(ret), K(yes_id), K(no_id));
+    } else if (OB_UNLIKELY(left + 2 > Node::INDEX_MASK)) {
+      ret = OB_NOT_SUPPORTED;
+      LOG_WARN("too many nodes in tree model", K(ret), K(left));
+      LOG_USER_ERROR(OB_NOT_SUPPORTED, "tree model of so many nodes");
+    } else if (OB_FAIL(nodes.push_back(Node())) || OB_FAIL(nodes.push_back(Node()))) {
+      LOG_WARN("fail to push back tree node", K(ret));
+    } else if (OB_FAIL(pending.push_back(ObPyPendingNode(yes, left, cur.depth_ + 1)))
+               || OB_FAIL(pending.push_back(ObPyPendingNode(no, left + 1, cur.depth_ + 1)))) {
+      LOG_WARN("fail to push back pending node", K(ret));
+    } else {
+      Node &node = nodes.at(cur.pos_);
+      node.value_ = value;
+      node.feature_ = static_cast<int32_t>(feature);
+      node.next_ = static_cast<uint32_t>(left)
+                   | (missing_id == yes_id ? Node::DEFAULT_LEFT_FLAG : 0);
+      depth = std::max(depth, cur.depth_ + 1);
+    }
+  }
+  return ret;
+}
+
+int ObPyTreeModel::parse_lightgbm_tree(const ObJsonNode &root, NodeArray &nodes, int32_t &depth)
+{
+  int ret = OB_SUCCESS;
+  ObSEArray<ObPyPendingNode, 64> pending;
+  const ObJsonNode *structure = get_member(root, "tree_structure");
+  depth = 0;
+  if (OB_ISNULL(structure)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("lightgbm tree has no tree_structure", K(ret));
+  } else if (OB_FAIL(nodes.push_back(Node()))) {
+    LOG_WARN("fail to push back tree node", K(ret));
+  } else if (OB_FAIL(pending.push_back(ObPyPendingNode(structure, nodes.count() - 1, 0)))) {
+    LOG_WARN("fail to push back pending node", K(ret));
+  }
+  for (int64_t head = 0; OB_SUCC(ret) && head < pending.count(); head++) {
+    const ObPyPendingNode cur = pending.at(head);
+    const ObJsonNode *leaf = get_member(*cur.json_, "leaf_value");
+    const ObJsonNode *decision = get_member(*cur.json_, "decision_type");
+    const ObJsonNode *missing = get_member(*cur.json_, "missing_type");
+    const ObJsonNode *default_left = get_member(*cur.json_, "default_left");
+    const ObJsonNode *left_child = get_member(*cur.json_, "left_child");
+    const ObJsonNode *right_child = get_member(*cur.json_, "right_child");
+    double threshold = 0;
+    int64_t feature = 0;
+    bool nan_left = false;
+    const int64_t left = nodes.count();
+    if (NULL != leaf) {
+      if (OB_FAIL(get_number(leaf, nodes.at(cur.pos_).value_))) {
+        LOG_WARN("invalid leaf value", K(ret));
+      }
+    } else if (OB_ISNULL(decision) || OB_ISNULL(left_child) || OB_ISNULL(right_child)) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_WARN("tree node is neither a split nor a leaf", K(ret), K(cur));
+    } else if (ObJsonNodeType::J_STRING != decision->json_type()
+               || 0 != ObString(decision->get_data_length(), decision->get_data()).compare(ObString::make_string("<="))) {
+      ret = OB_NOT_SUPPORTED;
+      LOG_WARN("categorical split is not supported", K(ret));
+      LOG_USER_ERROR(OB_NOT_SUPPORTED, "categorical split in tree model");
+    } else if (OB_FAIL(get_int(get_member(*cur.json_, "split_feature"), feature))) {
+      LOG_WARN("invalid split feature", K(ret));
+    } else if (OB_FAIL(add_feature(feature))) {
+      LOG_WARN("invalid split feature", K(ret), K(feature));
+    } else if (OB_FAIL(get_number(get_member(*cur.json_, "threshold"), threshold))) {
+      LOG_WARN("invalid split threshold", K(ret));
+    } else if (NULL == missing || ObJsonNodeType::J_STRING != missing->json_type()) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_WARN("invalid missing type", K(ret));
+    } else {
+      const ObString missing_type(missing->get_data_length(), missing->get_data());
+      if (0 == missing_type.compare(ObString::make_string("None"))) {
+        // lightgbm scores NaN as 0 without missing values in training
+        nan_left = 0 <= threshold;
+      } else if (0 == missing_type.compare(ObString::make_string("NaN"))) {
+        nan_left = NULL != default_left && ObJsonNodeType::J_BOOLEAN == default_left->json_type()
+                   && default_left->get_boolean();
+      } else {
+        ret = OB_NOT_SUPPORTED;
+        LOG_WARN("missing type is not supported", K(ret), K(missing_type));
+        LOG_USER_ERROR(OB_NOT_SUPPORTED, "missing type Zero in tree model");
+      }
+    }
+    if (OB_FAIL(ret) || NULL != leaf) {
+    } else if (OB_UNLIKELY(left + 2 > Node::INDEX_MASK)) {
+      ret = OB_NOT_SUPPORTED;
+      LOG_WARN("too many nodes in tree model", K(ret), K(left));
+      LOG_USER_ERROR(OB_NOT_SUPPORTED, "tree model of so many nodes");
+    } else if (OB_FAIL(nodes.push_back(Node())) || OB_FAIL(nodes.push_back(Node()))) {
+      LOG_WARN("fail to push back tree node", K(ret));
+    } else if (OB_FAIL(pending.push_back(ObPyPendingNode(left_child, left, cur.depth_ + 1)))
+               || OB_FAIL(pending.push_back(ObPyPendingNode(right_child, left + 1,
+                                                            cur.depth_ + 1)))) {
+      LOG_WARN("fail to push back pending node", K(ret));
+    } else {
+      Node &node = nodes.at(cur.pos_);
+      // x <= threshold is x < the next double
+      node.value_ = std::nextafter(threshold, INFINITY);
+      node.feature_ = static_cast<int32_t>(feature);
+      node.next_ = static_cast<uint32_t>(left) | (nan_left ? Node::DEFAULT_LEFT_FLAG : 0);
+      depth = std::max(depth, cur.depth_ + 1);
+    }
+  }
+  return ret;
+}
+
+void ObPyTreeModel::score(const double *features, const int64_t row_cnt, double *scores) const
+{
+  uint32_t idx[ROW_LANES];
+  double sums[ROW_LANES];
+  for (int64_t start = 0; start < row_cnt; start += ROW_LANES) {
+    const int64_t lanes = std::min(ROW_LANES, row_cnt - start);
+    const double *rows = features + start;
+    for (int64_t l = 0; l < lanes; l++) {
+      sums[l] = 0;
+    }
+    for (int64_t t = 0; t < tree_cnt_; t++) {
+      const int32_t depth = depths_[t];
+      for (int64_t l = 0; l < lanes; l++) {
+        idx[l] = static_cast<uint32_t>(roots_[t]);
+      }
+      // every lane takes one step per round, no branch depends on the row
+      for (int32_t d = 0; d < depth; d++) {
+        for (int64_t l = 0; l < lanes; l++) {
+          const Node &node = nodes_[idx[l]];
+          const double x = rows[node.feature_ * row_cnt + l];
+          const bool go_left = std::isnan(x) ? 0 != (node.next_ & Node::DEFAULT_LEFT_FLAG)
+                                             : x < node.value_;
+          const uint32_t child = (node.next_ & Node::INDEX_MASK) + (go_left ? 0 : 1);
+          idx[l] = node.is_leaf() ? idx[l] : child;
+        }
+      }
+      for (int64_t l = 0; l < lanes; l++) {
+        sums[l] += nodes_[idx[l]].value_;
+      }
+    }
+    for (int64_t l = 0; l < lanes; l++) {
+      double s = (average_ ? sums[l] / static_cast<double>(tree_cnt_) : sums[l]) + base_score_;
+      scores[start + l] = LOGISTIC == objective_ ? 1.0 / (1.0 + std::exp(-s)) : s;
+    }
+  }
+}
+
+int ObPyTreeModel::add_feature(const int64_t feature)
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(feature < 0 || feature >= MAX_FEATURE_CNT)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("feature of the tree model out of range", K(ret), K(feature));
+  } else {
+    feature_cnt_ = std::max(feature_cnt_, feature + 1);
+  }
+  return ret;
+}
+
+const ObJsonNode *ObPyTreeModel::get_member(const ObJsonNode &obj, const char *key)
+{
+  return ObJsonNodeType::J_OBJECT == obj.json_type()
+         ? static_cast<const ObJsonObject &>(obj).get_value(ObString::make_string(key))
+         : NULL;
+}
+
+int ObPyTreeModel::get_number(const ObJsonNode *node, double &value)
+{
+  int ret = OB_SUCCESS;
+  if (OB_ISNULL(node)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("number is missing", K(ret));
+  } else if (ObJsonNodeType::J_DOUBLE == node->json_type()) {
+    value = node->get_double();
+  } else if (ObJsonNodeType::J_INT == node->json_type()) {
+    value = static_cast<double>(node->get_int());
+  } else if (ObJsonNodeType::J_UINT == node->json_type()) {
+    value = static_cast<double>(node->get_uint());
+  } else {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("json node is not a number", K(ret), KPC(node));
+  }
+  return ret;
+}
+
+int ObPyTreeModel::get_int(const ObJsonNode *node, int64_t &value)
+{
+  int ret = OB_SUCCESS;
+  if (OB_ISNULL(node)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("integer is missing", K(ret));
+  } else if (ObJsonNodeType::J_INT == node->json_type()) {
+    value = node->get_int();
+  } else if (ObJsonNodeType::J_UINT == node->json_type()) {
+    value = static_cast<int64_t>(node->get_uint());
+  } else {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("json node is not an integer", K(ret), KPC(node));
+  }
+  return ret;
+}
+
+const ObJsonNode *ObPyTreeModel::find_child(const ObJsonNode &split, const int64_t node_id)
+{
+  const ObJsonNode *child = NULL;
+  const ObJsonNode *children = get_member(split, "children");
+  if (NULL != children && ObJsonNodeType::J_ARRAY == children->json_type()) {
+    const ObJsonArray &arr = static_cast<const ObJsonArray &>(*children);
+    for (uint64_t i = 0; NULL == child && i < arr.element_count(); i++) {
+      int64_t id = -1;
+      if (NULL != arr[i] && OB_SUCCESS == get_int(get_member(*arr[i], "nodeid"), id)
+          && id == node_id) {
+        child = arr[i];
+      }
+    }
+  }
+  return child;
+}
+
+} // end namespace sql
+} // end namespace oceanbase
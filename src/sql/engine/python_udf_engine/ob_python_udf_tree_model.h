@@ -0,0 +1,103 @@
+#ifndef OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_TREE_MODEL_H_
+#define OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_TREE_MODEL_H_
+
+#include "lib/allocator/ob_allocator.h"
+#include "lib/container/ob_iarray.h"
+#include "lib/string/ob_string.h"
+#include "lib/utility/ob_print_utils.h"
+
+namespace oceanbase
+{
+namespace common
+{
+class ObJsonNode;
+}
+namespace sql
+{
+
+/*
+ * Tree ensemble of a LANGUAGE TREES udf, scored natively without the python interpreter.
+ *
+ * The code of the udf is the JSON dump of a GBDT or random forest model, one of
+ *   - the trees of xgboost Booster.get_dump(dump_format='json') in a JSON list, or an object
+ *     {"trees": [...], "base_score": 0, "objective": "binary:logistic", "average": false}.
+ *     Split nodes are {"split", "split_condition", "yes", "no", "missing", "children"} and
+ *     leaves {"leaf"}, rows go to "yes" when the feature is below split_condition;
+ *   - lightgbm Booster.dump_model() with numerical splits, rows go to "left_child" when the
+ *     feature is at most "threshold".
+ * Feature i is the i-th argument of the udf, named "f<i>" in xgboost dumps. NaN goes the way
+ * of missing values. The score is base_score plus the sum of the leaves, or their mean for a
+ * random forest, passed through the sigmoid for logistic objectives.
+ *
+ * Nodes of all trees are flattened into one array of 16 bytes nodes, breadth-first per tree
+ * with the two children of a split side by side. ROW_LANES rows walk a tree together for the
+ * depth of the tree, each step is the same branch-free loop over the lanes so that the loads
+ * of different rows overlap and the compiler can vectorise it. Rows reaching a leaf before
+ * the last step stay on it.
+ */
+class ObPyTreeModel
+{
+public:
+  static const int64_t ROW_LANES = 16;
+  static const int64_t MAX_FEATURE_CNT = 4096;
+
+  enum Objective
+  {
+    RAW = 0, // regression, the score as it is
+    LOGISTIC = 1 // binary classification, the probability of the positive class
+  };
+  struct Node
+  {
+    static const uint32_t LEAF_FLAG = 1U << 31;
+    static const uint32_t DEFAULT_LEFT_FLAG = 1U << 30; // missing values go left
+    static const uint32_t INDEX_MASK = DEFAULT_LEFT_FLAG - 1;
+    Node() : value_(0), feature_(0), next_(LEAF_FLAG) {}
+    bool is_leaf() const { return 0 != (next_ & LEAF_FLAG); }
+    TO_STRING_KV(K_(value), K_(feature), K_(next));
+    double value_; // split threshold or leaf value
+    int32_t feature_;
+    uint32_t next_; // index of the left child, the right one follows
+  };
+
+  ObPyTreeModel() : nodes_(NULL), roots_(NULL), depths_(NULL), node_cnt_(0), tree_cnt_(0),
+                    feature_cnt_(0), base_score_(0), objective_(RAW), average_(false) {}
+  // parse the dump into memory of alloc, the json tree is built in a temporary arena
+  int init(common::ObIAllocator &alloc, const common::ObString &dump);
+  bool is_inited() const { return NULL != nodes_; }
+  // features are column major, feature f of row r at features[f * row_cnt + r]
+  void score(const double *features, const int64_t row_cnt, double *scores) const;
+  int64_t get_feature_cnt() const { return feature_cnt_; }
+  int64_t get_tree_cnt() const { return tree_cnt_; }
+  int64_t get_node_cnt() const { return node_cnt_; }
+
+  TO_STRING_KV(K_(node_cnt), K_(tree_cnt), K_(feature_cnt), K_(base_score), K_(objective),
+               K_(average));
+
+private:
+  typedef common::ObIArray<Node> NodeArray;
+  int parse_xgboost_tree(const common::ObJsonNode &root, NodeArray &nodes, int32_t &depth);
+  int parse_lightgbm_tree(const common::ObJsonNode &root, NodeArray &nodes, int32_t &depth);
+  int parse_options(const common::ObJsonNode &root, const bool is_lightgbm);
+  int add_feature(const int64_t feature);
+  static const common::ObJsonNode *get_member(const common::ObJsonNode &obj, const char *key);
+  static int get_number(const common::ObJsonNode *node, double &value);
+  static int get_int(const common::ObJsonNode *node, int64_t &value);
+  // child of an xgboost split by its nodeid
+  static const common::ObJsonNode *find_child(const common::ObJsonNode &split,
+                                              const int64_t node_id);
+
+  Node *nodes_;
+  int32_t *roots_;
+  int32_t *depths_; // steps to reach every leaf of the tree
+  int64_t node_cnt_;
+  int64_t tree_cnt_;
+  int64_t feature_cnt_; // largest feature referenced plus one
+  double base_score_;
+  Objective objective_;
+  bool average_; // random forest
+};
+
+} // end namespace sql
+} // end namespace oceanbase
+
+#endif // OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_TREE_MODEL_H_
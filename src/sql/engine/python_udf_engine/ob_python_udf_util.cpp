@@ -0,0 +1,552 @@
+#define USING_LOG_PREFIX SQL_ENG
+
+#define PY_SSIZE_T_CLEAN
+#include "sql/engine/python_udf_engine/ob_python_udf_util.h"
+#include <algorithm>
+#include "lib/oblog/ob_log.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+ObPythonUdfUtil::PyColumnType ObPythonUdfUtil::get_column_type(const ObObjType type)
+{
+  PyColumnType col_type = PY_COL_INVALID;
+  switch (type) {
+    case ObCharType:
+    case ObVarcharType:
+    case ObTinyTextType:
+    case ObTextType:
+    case ObMediumTextType:
+    case ObLongTextType: {
+      col_type = PY_COL_STRING;
+      break;
+    }
+    case ObTinyIntType:
+    case ObSmallIntType:
+    case ObMediumIntType:
+    case ObInt32Type:
+    case ObIntType: {
+      col_type = PY_COL_INTEGER;
+      break;
+    }
+    case ObDoubleType: {
+      col_type = PY_COL_REAL;
+      break;
+    }
+    default: {
+      col_type = PY_COL_INVALID;
+    }
+  }
+  return col_type;
+}
+
+int ObPythonUdfUtil::import_numpy()
+{
+  int ret = OB_SUCCESS;
+  if (OB_UNLIKELY(NULL == PyArray_API) && _import_array() < 0) {
+    ObExprPythonUdf::process_python_exception();
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("fail to import numpy c api", K(ret));
+  }
+  return ret;
+}
+
+int64_t ObPythonUdfUtil::build_selection(const ObBitVector &skip,
+                                         const ObBitVector &eval_flags,
+                                         const int64_t batch_size,
+                                         int32_t *sel)
+{
+  int64_t sel_cnt = 0;
+  for (int64_t i = 0; i < batch_size; i++) {
+    if (skip.at(i) || eval_flags.at(i)) {
+      continue;
+    } else {
+      sel[sel_cnt++] = static_cast<int32_t>(i);
+    }
+  }
+  return sel_cnt;
+}
+
+int ObPythonUdfUtil::alloc_numpy(const ObObjType type,
+                                 const int64_t length,
+                                 PyObject *&array)
+{
+  int ret = OB_SUCCESS;
+  npy_intp elements[1] = {length};
+  array = NULL;
+  switch (get_column_type(type)) {
+    case PY_COL_STRING: {
+      // object array is zero filled (NULL items) by numpy
+      array = PyArray_New(&PyArray_Type, 1, elements, NPY_OBJECT, NULL, NULL, 0, 0, NULL);
+      break;
+    }
+    case PY_COL_INTEGER: {
+      array = PyArray_EMPTY(1, elements, NPY_INT64, 0);
+      break;
+    }
+    case PY_COL_REAL: {
+      array = PyArray_EMPTY(1, elements, NPY_FLOAT64, 0);
+      break;
+    }
+    default: {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("unknown arg type, fail in obdatum2array", K(ret), K(type));
+    }
+  }
+  if (OB_SUCC(ret) && OB_ISNULL(array)) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("fail to allocate numpy array", K(ret), K(length));
+  }
+  return ret;
+}
+
+int ObPythonUdfUtil::datums_to_numpy(const ObObjType type,
+                                     const ObDatum *datums,
+                                     const bool is_const,
+                                     const int32_t *sel,
+                                     const int64_t sel_cnt,
+                                     PyObject *&array)
+{
+  int ret = OB_SUCCESS;
+  array = NULL;
+  if (PY_COL_STRING == get_column_type(type)
+      && OB_FAIL(strings_to_numpy(datums, is_const, sel, sel_cnt, array))) {
+    LOG_WARN("fail to build unicode numpy array", K(ret));
+  } else if (NULL != array) {
+    // strings fit a fixed width array
+  } else if (OB_FAIL(alloc_numpy(type, sel_cnt, array))) {
+    LOG_WARN("fail to allocate numpy array", K(ret));
+  } else if (OB_FAIL(fill_numpy(type, datums, is_const, sel, sel_cnt, array))) {
+    LOG_WARN("fail to fill numpy array", K(ret));
+    Py_DECREF(array);
+    array = NULL;
+  }
+  return ret;
+}
+
+int ObPythonUdfUtil::strings_to_numpy(const ObDatum *datums,
+                                      const bool is_const,
+                                      const int32_t *sel,
+                                      const int64_t sel_cnt,
+                                      PyObject *&array)
+{
+  int ret = OB_SUCCESS;
+  int64_t total_chars = 0;
+  int64_t max_chars = 0;
+  int64_t width = 0;
+  array = NULL;
+  if (OB_ISNULL(datums) || (OB_ISNULL(sel) && sel_cnt > 0)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid argument", K(ret), KP(datums), KP(sel));
+  } else {
+    // code points of a string are its bytes other than utf8 continuation bytes
+    for (int64_t k = 0; k < (is_const ? std::min(sel_cnt, 1L) : sel_cnt); k++) {
+      const ObDatum &d = datums[is_const ? 0 : sel[k]];
+      int64_t chars = 0;
+      for (int64_t j = 0; j < d.len_; j++) {
+        chars += (0x80 != (static_cast<uint8_t>(d.ptr_[j]) & 0xC0));
+      }
+      total_chars += chars;
+      max_chars = std::max(max_chars, chars);
+    }
+    total_chars = is_const ? total_chars * sel_cnt : total_chars;
+    width = std::max(max_chars, 1L);
+  }
+  if (OB_FAIL(ret) || sel_cnt <= 0) {
+  } else if (width * sel_cnt > MAX_UNICODE_ARRAY_CHARS
+             || width * sel_cnt > MAX_UNICODE_PAD_RATIO * (total_chars + sel_cnt)) {
+    // a few long strings, the object array is smaller
+  } else {
+    npy_intp elements[1] = {sel_cnt};
+    bool valid = true;
+    if (OB_ISNULL(array = PyArray_New(&PyArray_Type, 1, elements, NPY_UNICODE, NULL, NULL,
+                                      static_cast<int>(width * sizeof(uint32_t)), 0, NULL))) {
+      ObExprPythonUdf::process_python_exception();
+      ret = OB_ALLOCATE_MEMORY_FAILED;
+      LOG_WARN("fail to allocate unicode numpy array", K(ret), K(sel_cnt), K(width));
+    } else {
+      uint32_t *data = static_cast<uint32_t *>(PyArray_DATA(reinterpret_cast<PyArrayObject *>(array)));
+      MEMSET(data, 0, sizeof(uint32_t) * width * sel_cnt);
+      for (int64_t k = 0; valid && k < sel_cnt; k++) {
+        const ObDatum &d = datums[is_const ? 0 : sel[k]];
+        valid = decode_utf8(d.ptr_, d.len_, data + k * width);
+      }
+      if (!valid) {
+        // left to the object array, which reports invalid strings as python does
+        Py_DECREF(array);
+        array = NULL;
+      }
+    }
+  }
+  return ret;
+}
+
+bool ObPythonUdfUtil::decode_utf8(const char *str, const int64_t len, uint32_t *out)
+{
+  bool valid = true;
+  const uint8_t *s = reinterpret_cast<const uint8_t *>(str);
+  int64_t i = 0;
+  while (valid && i < len) {
+    const uint8_t c = s[i];
+    uint32_t cp = 0;
+    uint32_t min_cp = 0;
+    int64_t n = 0; // continuation bytes
+    if (c < 0x80) {
+      cp = c;
+    } else if (0xC0 == (c & 0xE0)) {
+      cp = c & 0x1F;
+      min_cp = 0x80;
+      n = 1;
+    } else if (0xE0 == (c & 0xF0)) {
+      cp = c & 0x0F;
+      min_cp = 0x800;
+      n = 2;
+    } else if (0xF0 == (c & 0xF8)) {
+      cp = c & 0x07;
+      min_cp = 0x10000;
+      n = 3;
+    } else {
+      valid = false;
+    }
+    valid = valid && i + n < len;
+    for (int64_t j = 1; valid && j <= n; j++) {
+      valid = 0x80 == (s[i + j] & 0xC0);
+      cp = (cp << 6) | (s[i + j] & 0x3F);
+    }
+    // overlong forms and surrogates are rejected as python does
+    valid = valid && 0 != cp && cp >= min_cp && cp <= 0x10FFFF && (cp < 0xD800 || cp > 0xDFFF);
+    if (valid) {
+      *out++ = cp;
+      i += n + 1;
+    }
+  }
+  return valid;
+}
+
+int ObPythonUdfUtil::datum_to_python(const ObObjType type,
+                                     const ObDatum &datum,
+                                     const bool as_scalar,
+                                     PyObject *&obj)
+{
+  int ret = OB_SUCCESS;
+  PyObject *scalar = NULL;
+  npy_intp *no_dims = NULL;
+  obj = NULL;
+  switch (get_column_type(type)) {
+    case PY_COL_STRING: {
+      if (OB_NOT_NULL(scalar = PyUnicode_FromStringAndSize(datum.ptr_, datum.len_))) {
+        // 0-d fixed width unicode array
+        obj = as_scalar ? scalar : PyArray_FROM_O(scalar);
+      }
+      break;
+    }
+    case PY_COL_INTEGER: {
+      if (as_scalar) {
+        obj = PyLong_FromLongLong(datum.get_int());
+      } else if (OB_NOT_NULL(obj = PyArray_SimpleNew(0, no_dims, NPY_INT64))) {
+        *static_cast<int64_t *>(PyArray_DATA(reinterpret_cast<PyArrayObject *>(obj))) =
+            datum.get_int();
+      }
+      break;
+    }
+    case PY_COL_REAL: {
+      if (as_scalar) {
+        obj = PyFloat_FromDouble(datum.get_double());
+      } else if (OB_NOT_NULL(obj = PyArray_SimpleNew(0, no_dims, NPY_FLOAT64))) {
+        *static_cast<double *>(PyArray_DATA(reinterpret_cast<PyArrayObject *>(obj))) =
+            datum.get_double();
+      }
+      break;
+    }
+    default: {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("unknown arg type", K(ret), K(type));
+    }
+  }
+  if (NULL != scalar && scalar != obj) {
+    Py_DECREF(scalar);
+  }
+  if (OB_SUCC(ret) && OB_ISNULL(obj)) {
+    ObExprPythonUdf::process_python_exception();
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("fail to convert constant arg to python", K(ret), K(type), K(as_scalar));
+  }
+  return ret;
+}
+
+bool ObPythonUdfUtil::is_scalar(PyObject *obj)
+{
+  return NULL != obj && (PyArray_IsAnyScalar(obj) || PyArray_IsZeroDim(obj));
+}
+
+int64_t ObPythonUdfUtil::get_row_cnt(PyObject *obj)
+{
+  int64_t row_cnt = 0;
+  PyArrayObject *np = reinterpret_cast<PyArrayObject *>(obj);
+  if (NULL != obj && PyArray_Check(obj) && PyArray_NDIM(np) > 0) {
+    row_cnt = PyArray_DIM(np, 0);
+  }
+  return row_cnt;
+}
+
+bool ObPythonUdfUtil::is_reusable(const ObObjType type, PyObject *array, const int64_t length)
+{
+  PyArrayObject *np = reinterpret_cast<PyArrayObject *>(array);
+  int npy_type = NPY_NOTYPE;
+  switch (get_column_type(type)) {
+    case PY_COL_STRING: {
+      npy_type = NPY_OBJECT;
+      break;
+    }
+    case PY_COL_INTEGER: {
+      npy_type = NPY_INT64;
+      break;
+    }
+    case PY_COL_REAL: {
+      npy_type = NPY_FLOAT64;
+      break;
+    }
+    default: {
+      npy_type = NPY_NOTYPE;
+    }
+  }
+  return NULL != array && NPY_NOTYPE != npy_type && npy_type == PyArray_TYPE(np)
+         && PyArray_SIZE(np) >= length && PyArray_IS_C_CONTIGUOUS(np);
+}
+
+int ObPythonUdfUtil::fill_numpy(const ObObjType type,
+                                const ObDatum *datums,
+                                const bool is_const,
+                                const int32_t *sel,
+                                const int64_t sel_cnt,
+                                PyObject *array)
+{
+  int ret = OB_SUCCESS;
+  PyArrayObject *np = reinterpret_cast<PyArrayObject *>(array);
+  if (OB_ISNULL(array) || OB_ISNULL(datums) || (OB_ISNULL(sel) && sel_cnt > 0)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid argument", K(ret), KP(array), KP(datums), KP(sel));
+  } else if (OB_UNLIKELY(!is_reusable(type, array, sel_cnt))) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("numpy array can not hold the batch", K(ret), K(sel_cnt));
+  } else {
+    switch (get_column_type(type)) {
+      case PY_COL_STRING: {
+        PyObject **data = static_cast<PyObject **>(PyArray_DATA(np));
+        for (int64_t k = 0; OB_SUCC(ret) && k < sel_cnt; k++) {
+          const ObDatum &d = datums[is_const ? 0 : sel[k]];
+          PyObject *str = PyUnicode_FromStringAndSize(d.ptr_, d.len_);
+          if (OB_ISNULL(str)) {
+            ObExprPythonUdf::process_python_exception();
+            ret = OB_ERR_UNEXPECTED;
+            LOG_WARN("fail to build python string", K(ret), K(k));
+          } else {
+            // the item slot owns the new reference
+            Py_XDECREF(data[k]);
+            data[k] = str;
+          }
+        }
+        break;
+      }
+      case PY_COL_INTEGER: {
+        int64_t *data = static_cast<int64_t *>(PyArray_DATA(np));
+        if (is_const) {
+          const int64_t v = datums[0].get_int();
+          for (int64_t k = 0; k < sel_cnt; k++) {
+            data[k] = v;
+          }
+        } else {
+          for (int64_t k = 0; k < sel_cnt; k++) {
+            data[k] = datums[sel[k]].get_int();
+          }
+        }
+        break;
+      }
+      case PY_COL_REAL: {
+        double *data = static_cast<double *>(PyArray_DATA(np));
+        if (is_const) {
+          const double v = datums[0].get_double();
+          for (int64_t k = 0; k < sel_cnt; k++) {
+            data[k] = v;
+          }
+        } else {
+          for (int64_t k = 0; k < sel_cnt; k++) {
+            data[k] = datums[sel[k]].get_double();
+          }
+        }
+        break;
+      }
+      default: {
+        ret = OB_ERR_UNEXPECTED;
+        LOG_WARN("unknown arg type, fail in obdatum2array", K(ret), K(type));
+      }
+    }
+  }
+  return ret;
+}
+
+int ObPythonUdfUtil::numpy_to_datums(const ObObjType type,
+                                     PyObject *result,
+                                     const int32_t *sel,
+                                     const int64_t sel_cnt,
+                                     ObDatum *results,
+                                     int64_t &ret_cnt)
+{
+  int ret = OB_SUCCESS;
+  PyArrayObject *np = NULL;
+  bool done = false;
+  ret_cnt = 0;
+  if (OB_ISNULL(result) || OB_ISNULL(results)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid argument", K(ret), KP(result), KP(results));
+  } else if (PY_COL_STRING == get_column_type(type)
+             && (OB_FAIL(fixed_width_to_datums(result, sel, sel_cnt, results, ret_cnt, done))
+                 || done)) {
+    // fixed width strings read in place
+  } else {
+    // cast the result into a contiguous array of the expected dtype,
+    // no copy happens if the model already returned one
+    switch (get_column_type(type)) {
+      case PY_COL_STRING: {
+        np = reinterpret_cast<PyArrayObject *>(PyArray_FROM_OTF(result, NPY_OBJECT, NPY_ARRAY_IN_ARRAY));
+        break;
+      }
+      case PY_COL_INTEGER: {
+        np = reinterpret_cast<PyArrayObject *>(PyArray_FROM_OTF(result, NPY_INT64, NPY_ARRAY_IN_ARRAY));
+        break;
+      }
+      case PY_COL_REAL: {
+        np = reinterpret_cast<PyArrayObject *>(PyArray_FROM_OTF(result, NPY_FLOAT64, NPY_ARRAY_IN_ARRAY));
+        break;
+      }
+      default: {
+        ret = OB_ERR_UNEXPECTED;
+        LOG_WARN("unknown result type", K(ret), K(type));
+      }
+    }
+  }
+  if (OB_FAIL(ret) || done) {
+  } else if (OB_ISNULL(np)) {
+    ObExprPythonUdf::process_python_exception();
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("fail to convert python result to numpy array", K(ret));
+  } else {
+    ret_cnt = PyArray_SIZE(np) < sel_cnt ? PyArray_SIZE(np) : sel_cnt;
+    switch (get_column_type(type)) {
+      case PY_COL_STRING: {
+        PyObject **data = static_cast<PyObject **>(PyArray_DATA(np));
+        for (int64_t k = 0; OB_SUCC(ret) && k < ret_cnt; k++) {
+          Py_ssize_t len = 0;
+          const char *str = NULL;
+          if (OB_ISNULL(data[k]) || OB_ISNULL(str = PyUnicode_AsUTF8AndSize(data[k], &len))) {
+            ObExprPythonUdf::process_python_exception();
+            ret = OB_ERR_UNEXPECTED;
+            LOG_WARN("python udf result is not a string", K(ret), K(k));
+          } else {
+            results[sel[k]].set_string(str, static_cast<int32_t>(len));
+          }
+        }
+        break;
+      }
+      case PY_COL_INTEGER: {
+        const int64_t *data = static_cast<const int64_t *>(PyArray_DATA(np));
+        for (int64_t k = 0; k < ret_cnt; k++) {
+          results[sel[k]].set_int(data[k]);
+        }
+        break;
+      }
+      case PY_COL_REAL: {
+        const double *data = static_cast<const double *>(PyArray_DATA(np));
+        for (int64_t k = 0; k < ret_cnt; k++) {
+          results[sel[k]].set_double(data[k]);
+        }
+        break;
+      }
+      default: {
+        ret = OB_ERR_UNEXPECTED;
+        LOG_WARN("unknown result type", K(ret), K(type));
+      }
+    }
+  }
+  Py_XDECREF(np);
+  return ret;
+}
+
+int ObPythonUdfUtil::fixed_width_to_datums(PyObject *result,
+                                           const int32_t *sel,
+                                           const int64_t sel_cnt,
+                                           ObDatum *results,
+                                           int64_t &ret_cnt,
+                                           bool &done)
+{
+  int ret = OB_SUCCESS;
+  PyArrayObject *np = reinterpret_cast<PyArrayObject *>(result);
+  done = false;
+  if (!PyArray_Check(result) || 1 != PyArray_NDIM(np)) {
+  } else if (NPY_STRING == PyArray_TYPE(np)) {
+    // bytes are read where they are, without the NUL padding
+    const char *data = PyArray_BYTES(np);
+    const npy_intp stride = PyArray_STRIDE(np, 0);
+    const int64_t item_size = PyArray_ITEMSIZE(np);
+    ret_cnt = std::min(static_cast<int64_t>(PyArray_DIM(np, 0)), sel_cnt);
+    for (int64_t k = 0; k < ret_cnt; k++) {
+      const char *item = data + k * stride;
+      int64_t len = item_size;
+      while (len > 0 && '\0' == item[len - 1]) {
+        len--;
+      }
+      results[sel[k]].set_string(item, static_cast<int32_t>(len));
+    }
+    done = true;
+  } else if (NPY_UNICODE == PyArray_TYPE(np) && 1 == Py_REFCNT(result)
+             && NULL == PyArray_BASE(np) && PyArray_ISNOTSWAPPED(np)
+             && PyArray_CHKFLAGS(np, NPY_ARRAY_OWNDATA | NPY_ARRAY_WRITEABLE | NPY_ARRAY_ALIGNED)) {
+    // nobody else sees the array, each item is encoded into utf8 over its own code points,
+    // the bytes written never pass the code point read next
+    char *data = PyArray_BYTES(np);
+    const npy_intp stride = PyArray_STRIDE(np, 0);
+    const int64_t width = PyArray_ITEMSIZE(np) / sizeof(uint32_t);
+    ret_cnt = std::min(static_cast<int64_t>(PyArray_DIM(np, 0)), sel_cnt);
+    for (int64_t k = 0; OB_SUCC(ret) && k < ret_cnt; k++) {
+      uint8_t *item = reinterpret_cast<uint8_t *>(data + k * stride);
+      const uint32_t *cps = reinterpret_cast<const uint32_t *>(item);
+      int64_t chars = width;
+      int64_t len = 0;
+      while (chars > 0 && 0 == cps[chars - 1]) {
+        chars--;
+      }
+      for (int64_t j = 0; OB_SUCC(ret) && j < chars; j++) {
+        const uint32_t cp = cps[j];
+        if (cp < 0x80) {
+          item[len++] = static_cast<uint8_t>(cp);
+        } else if (cp < 0x800) {
+          item[len++] = static_cast<uint8_t>(0xC0 | (cp >> 6));
+          item[len++] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000 && (cp < 0xD800 || cp > 0xDFFF)) {
+          item[len++] = static_cast<uint8_t>(0xE0 | (cp >> 12));
+          item[len++] = static_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+          item[len++] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+        } else if (cp >= 0x10000 && cp <= 0x10FFFF) {
+          item[len++] = static_cast<uint8_t>(0xF0 | (cp >> 18));
+          item[len++] = static_cast<uint8_t>(0x80 | ((cp >> 12) & 0x3F));
+          item[len++] = static_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+          item[len++] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+        } else {
+          ret = OB_ERR_UNEXPECTED;
+          LOG_WARN("python udf result is not valid unicode", K(ret), K(k), K(cp));
+        }
+      }
+      if (OB_SUCC(ret)) {
+        results[sel[k]].set_string(reinterpret_cast<const char *>(item), static_cast<int32_t>(len));
+      }
+    }
+    done = true;
+  }
+  return ret;
+}
+
+} // end namespace sql
+} // end namespace oceanbase
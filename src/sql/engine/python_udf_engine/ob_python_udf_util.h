@@ -0,0 +1,117 @@
+#ifndef OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_UTIL_H_
+#define OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_UTIL_H_
+
+#include "sql/engine/expr/ob_expr_python_udf.h"
+
+namespace oceanbase
+{
+namespace sql
+{
+
+/*
+ * Columnar conversion layer between ObDatum batches and numpy arrays.
+ * Rows to be converted are given by a selection vector (indexes of the non-skipped rows),
+ * INTEGER/REAL columns are gathered into contiguous NPY_INT64/NPY_FLOAT64 buffers
+ * without creating any per-row python object. String columns are decoded in one pass into
+ * fixed width NPY_UNICODE arrays, or into object arrays when padding to the longest string
+ * would waste too much memory. Fixed width string results are read without per-row objects.
+ * All functions must be called with the GIL held.
+ */
+class ObPythonUdfUtil
+{
+public:
+  enum PyColumnType {
+    PY_COL_INVALID,
+    PY_COL_STRING,
+    PY_COL_INTEGER,
+    PY_COL_REAL
+  };
+
+  static PyColumnType get_column_type(const common::ObObjType type);
+
+  // load numpy c api for this translation unit. The table is static per translation unit,
+  // numpy functions and macros needing it (PyArray_Check, PyArray_Type...) are called in
+  // ob_python_udf_util.cpp only
+  static int import_numpy();
+
+  // build selection vector of rows which are neither skipped nor evaluated
+  static int64_t build_selection(const ObBitVector &skip,
+                                 const ObBitVector &eval_flags,
+                                 const int64_t batch_size,
+                                 int32_t *sel);
+
+  // new contiguous 1-D numpy array able to hold a column of the given type
+  static int alloc_numpy(const common::ObObjType type,
+                         const int64_t length,
+                         PyObject *&array);
+
+  // datums[sel[0..sel_cnt)] -> new 1-D numpy array of length sel_cnt
+  static int datums_to_numpy(const common::ObObjType type,
+                             const common::ObDatum *datums,
+                             const bool is_const,
+                             const int32_t *sel,
+                             const int64_t sel_cnt,
+                             PyObject *&array);
+
+  // datums[sel[0..sel_cnt)] of a string column -> new fixed width NPY_UNICODE array of length
+  // sel_cnt, array is NULL if the strings do not fit one, the caller uses an object array then
+  static int strings_to_numpy(const common::ObDatum *datums,
+                              const bool is_const,
+                              const int32_t *sel,
+                              const int64_t sel_cnt,
+                              PyObject *&array);
+
+  // datum of an arg constant in the call -> python int, float or str when as_scalar, a 0-d
+  // numpy array otherwise. Built once per call whatever the number of rows, numpy broadcasts it
+  static int datum_to_python(const common::ObObjType type,
+                             const common::ObDatum &datum,
+                             const bool as_scalar,
+                             PyObject *&obj);
+
+  // whether a udf result is one value for all rows: a python or numpy scalar or a 0-d array
+  static bool is_scalar(PyObject *obj);
+
+  // rows of the numpy array of an arg, 0 for the scalar or 0-d array of a constant arg
+  static int64_t get_row_cnt(PyObject *obj);
+
+  // whether array is a contiguous array of the dtype of alloc_numpy holding length rows
+  static bool is_reusable(const common::ObObjType type, PyObject *array, const int64_t length);
+
+  // fill an existing contiguous numpy array whose length is sel_cnt
+  static int fill_numpy(const common::ObObjType type,
+                        const common::ObDatum *datums,
+                        const bool is_const,
+                        const int32_t *sel,
+                        const int64_t sel_cnt,
+                        PyObject *array);
+
+  // result[0..min(size(result), sel_cnt)) -> results[sel[i]]. String results point into
+  // result, an NPY_UNICODE array owned by nobody else is encoded into utf8 in place
+  static int numpy_to_datums(const common::ObObjType type,
+                             PyObject *result,
+                             const int32_t *sel,
+                             const int64_t sel_cnt,
+                             common::ObDatum *results,
+                             int64_t &ret_cnt);
+
+private:
+  // padding of a fixed width unicode arg beyond which an object array is used
+  static const int64_t MAX_UNICODE_PAD_RATIO = 4;
+  static const int64_t MAX_UNICODE_ARRAY_CHARS = 4L << 20;
+
+  // utf8 -> ucs4, false on an invalid or NUL code point, numpy strips trailing NULs
+  static bool decode_utf8(const char *str, const int64_t len, uint32_t *out);
+  // NPY_STRING or NPY_UNICODE result read without python objects, done is false if the
+  // result can not be read in place
+  static int fixed_width_to_datums(PyObject *result,
+                                   const int32_t *sel,
+                                   const int64_t sel_cnt,
+                                   common::ObDatum *results,
+                                   int64_t &ret_cnt,
+                                   bool &done);
+};
+
+} // end namespace sql
+} // end namespace oceanbase
+
+#endif // OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_UTIL_H_
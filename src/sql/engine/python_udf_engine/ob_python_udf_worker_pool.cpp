@@ -0,0 +1,802 @@
+#define USING_LOG_PREFIX SQL_ENG
+
+#include "sql/engine/python_udf_engine/ob_python_udf_worker_pool.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "lib/oblog/ob_log.h"
+#include "lib/time/ob_time_utility.h"
+#include "lib/worker.h"
+#include "share/config/ob_server_config.h"
+#include "share/rc/ob_tenant_base.h"
+#include "observer/omt/ob_tenant_config_mgr.h"
+
+extern char **environ;
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+static_assert(sizeof(ObPyWorkerBatchHeader) == 14 * 8 + ObPyWorkerBatchHeader::MAX_ARG_CNT * 3 * 8,
+              "python worker script depends on the batch header layout");
+
+// python side of a channel, run by "<executable> -c" with the buffer path and size as arguments
+static const char *PY_WORKER_SCRIPT = R"PYWORKER(
+import mmap, os, signal, struct, sys, traceback
+import numpy as np
+
+HEAD = struct.Struct('<QQ' + 'q' * 12)
+COL = struct.Struct('<qqq')
+STATUS_POS, RESULT_LENGTH_POS, RESULT_CNT_POS = 72, 88, 96
+STATUS_OK, STATUS_ERROR, STATUS_OVERFLOW = 0, 1, 2
+COL_STRING, COL_INTEGER, COL_REAL = 1, 2, 3
+REQ_FD, RESP_FD = 3, 4
+
+def read_column(mm, typ, off, n):
+    if typ == COL_INTEGER:
+        return np.frombuffer(mm, dtype=np.int64, count=n, offset=off)
+    if typ == COL_REAL:
+        return np.frombuffer(mm, dtype=np.float64, count=n, offset=off)
+    offs = np.frombuffer(mm, dtype=np.int64, count=n + 1, offset=off).tolist()
+    base = off + 8 * (n + 1)
+    raw = mm[base:base + offs[n]]
+    col = np.empty(n, dtype=object)
+    for i in range(n):
+        col[i] = raw[offs[i]:offs[i + 1]].decode('utf-8')
+    return col
+
+def write_result(mm, off, cap, typ, res, n):
+    if typ == COL_INTEGER or typ == COL_REAL:
+        dt = np.int64 if typ == COL_INTEGER else np.float64
+        arr = np.asarray(res).reshape(-1).astype(dt, copy=False)
+        cnt = min(arr.shape[0], n)
+        if 8 * cnt > cap:
+            return STATUS_OVERFLOW, 0, 0
+        np.frombuffer(mm, dtype=dt, count=cnt, offset=off)[:] = arr[:cnt]
+        return STATUS_OK, cnt, 8 * cnt
+    items = [str(x).encode('utf-8') for x in np.asarray(res, dtype=object).reshape(-1)[:n]]
+    cnt = len(items)
+    offs = [0] * (cnt + 1)
+    for i in range(cnt):
+        offs[i + 1] = offs[i] + len(items[i])
+    length = 8 * (cnt + 1) + offs[cnt]
+    if length > cap:
+        return STATUS_OVERFLOW, 0, 0
+    struct.pack_into('<%dq' % (cnt + 1), mm, off, *offs)
+    mm[off + 8 * (cnt + 1):off + length] = b''.join(items)
+    return STATUS_OK, cnt, length
+
+def main():
+    signal.signal(signal.SIGINT, signal.SIG_IGN)
+    path, size = sys.argv[1], int(sys.argv[2])
+    fd = os.open(path, os.O_RDWR)
+    mm = mmap.mmap(fd, size)
+    os.close(fd)
+    funs = {}
+    while True:
+        if not os.read(REQ_FD, 1):
+            break
+        (magic, udf_id, schema_version, n, arg_cnt, ret_type, code_off, code_len,
+         name_len, _, res_off, _, _, cap) = HEAD.unpack_from(mm, 0)
+        try:
+            if code_len > 0:
+                name = mm[code_off:code_off + name_len].decode('utf-8')
+                code = mm[code_off + name_len:code_off + code_len].decode('utf-8')
+                ns = {'__name__': '__main__', '__builtins__': __builtins__}
+                exec(compile(code, name, 'exec'), ns)
+                ns['pyinitial']()
+                funs[udf_id] = (schema_version, ns['pyfun'])
+            fun = funs.get(udf_id)
+            if fun is None or fun[0] != schema_version:
+                raise RuntimeError('python udf %d is not loaded' % udf_id)
+            args = []
+            for i in range(arg_cnt):
+                typ, off, _ = COL.unpack_from(mm, HEAD.size + i * COL.size)
+                args.append(read_column(mm, typ, off, n))
+            status, cnt, length = write_result(mm, res_off, cap, ret_type, fun[1](*args), n)
+        except BaseException:
+            msg = traceback.format_exc().encode('utf-8')[:max(cap, 0)]
+            mm[res_off:res_off + len(msg)] = msg
+            status, cnt, length = STATUS_ERROR, 0, len(msg)
+        struct.pack_into('<q', mm, STATUS_POS, status)
+        struct.pack_into('<q', mm, RESULT_LENGTH_POS, length)
+        struct.pack_into('<q', mm, RESULT_CNT_POS, cnt)
+        os.write(RESP_FD, b'\x01')
+
+main()
+)PYWORKER";
+
+static inline int64_t align8(const int64_t pos)
+{
+  return (pos + 7) & ~(static_cast<int64_t>(7));
+}
+
+ObPyWorkerChannel::ObPyWorkerChannel()
+    : shm_fd_(-1), buf_(NULL), size_(0), pid_(-1), req_fd_(-1), resp_fd_(-1),
+      loading_udf_id_(OB_INVALID_ID), loading_schema_version_(OB_INVALID_VERSION), running_(false)
+{
+  shm_name_[0] = '\0';
+}
+
+int ObPyWorkerChannel::init(const uint64_t tenant_id, const int64_t idx, const int64_t size)
+{
+  int ret = OB_SUCCESS;
+  static int64_t seq = 0;
+  if (OB_UNLIKELY(is_inited())) {
+    ret = OB_INIT_TWICE;
+    LOG_WARN("python worker channel init twice", K(ret), KPC(this));
+  } else if (OB_UNLIKELY(size <= static_cast<int64_t>(sizeof(ObPyWorkerBatchHeader)) * 2)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("python worker buffer is too small", K(ret), K(size));
+  } else if (FALSE_IT(snprintf(shm_name_, sizeof(shm_name_), "/ob_pyudf_%d_%lu_%ld_%ld",
+                               getpid(), tenant_id, idx, ATOMIC_AAF(&seq, 1)))) {
+  } else if ((shm_fd_ = shm_open(shm_name_, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR)) < 0) {
+    ret = OB_ERR_SYS;
+    LOG_WARN("fail to create python worker buffer", K(ret), K(errno), K_(shm_name));
+  } else if (0 != ftruncate(shm_fd_, size)) {
+    ret = OB_ERR_SYS;
+    LOG_WARN("fail to resize python worker buffer", K(ret), K(errno), K_(shm_name), K(size));
+  } else if (MAP_FAILED == (buf_ = static_cast<char *>(mmap(NULL, size, PROT_READ | PROT_WRITE,
+                                                            MAP_SHARED, shm_fd_, 0)))) {
+    buf_ = NULL;
+    ret = OB_ERR_SYS;
+    LOG_WARN("fail to map python worker buffer", K(ret), K(errno), K_(shm_name), K(size));
+  } else {
+    size_ = size;
+    MEMSET(buf_, 0, sizeof(ObPyWorkerBatchHeader));
+  }
+  if (OB_FAIL(ret)) {
+    destroy();
+  }
+  return ret;
+}
+
+void ObPyWorkerChannel::destroy()
+{
+  stop_worker(false);
+  if (NULL != buf_) {
+    munmap(buf_, size_);
+    buf_ = NULL;
+  }
+  if (shm_fd_ >= 0) {
+    close(shm_fd_);
+    shm_fd_ = -1;
+  }
+  if ('\0' != shm_name_[0]) {
+    shm_unlink(shm_name_);
+    shm_name_[0] = '\0';
+  }
+  size_ = 0;
+}
+
+int ObPyWorkerChannel::start_worker(const char *executable)
+{
+  int ret = OB_SUCCESS;
+  int req_pipe[2] = {-1, -1};
+  int resp_pipe[2] = {-1, -1};
+  char shm_path[MAX_SHM_NAME_LEN + 16];
+  char size_buf[32];
+  posix_spawn_file_actions_t actions;
+  posix_spawnattr_t attr;
+  bool actions_inited = false;
+  bool attr_inited = false;
+  sigset_t sig_mask;
+  sigset_t sig_default;
+  int err = 0;
+  snprintf(shm_path, sizeof(shm_path), "/dev/shm%s", shm_name_);
+  snprintf(size_buf, sizeof(size_buf), "%ld", size_);
+  char *argv[] = {const_cast<char *>(executable), const_cast<char *>("-c"),
+                  const_cast<char *>(PY_WORKER_SCRIPT), shm_path, size_buf, NULL};
+  if (OB_UNLIKELY(!is_inited()) || OB_ISNULL(executable)) {
+    ret = OB_NOT_INIT;
+    LOG_WARN("python worker channel not init", K(ret), KP(executable));
+  } else if (is_worker_alive()) {
+    // already running
+  } else if (0 != pipe2(req_pipe, O_CLOEXEC) || 0 != pipe2(resp_pipe, O_CLOEXEC)) {
+    ret = OB_ERR_SYS;
+    LOG_WARN("fail to create python worker pipes", K(ret), K(errno));
+  } else if (0 != posix_spawn_file_actions_init(&actions)) {
+    ret = OB_ERR_SYS;
+    LOG_WARN("fail to init spawn file actions", K(ret));
+  } else if (FALSE_IT(actions_inited = true)) {
+  } else if (0 != posix_spawnattr_init(&attr)) {
+    ret = OB_ERR_SYS;
+    LOG_WARN("fail to init spawn attr", K(ret));
+  } else if (FALSE_IT(attr_inited = true)) {
+  } else if (0 != sigemptyset(&sig_mask) || 0 != sigfillset(&sig_default)
+             || 0 != posix_spawnattr_setsigmask(&attr, &sig_mask)
+             || 0 != posix_spawnattr_setsigdefault(&attr, &sig_default)
+             || 0 != posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF)) {
+    ret = OB_ERR_SYS;
+    LOG_WARN("fail to set spawn signal attr", K(ret));
+  } else if (0 != posix_spawn_file_actions_adddup2(&actions, req_pipe[0], WORKER_REQ_FD)
+             || 0 != posix_spawn_file_actions_adddup2(&actions, resp_pipe[1], WORKER_RESP_FD)) {
+    ret = OB_ERR_SYS;
+    LOG_WARN("fail to set spawn file actions", K(ret));
+  } else if (0 != (err = posix_spawnp(&pid_, executable, &actions, &attr, argv, environ))) {
+    pid_ = -1;
+    ret = OB_ERR_SYS;
+    LOG_WARN("fail to start python worker", K(ret), K(err), K(executable));
+  } else {
+    req_fd_ = req_pipe[1];
+    resp_fd_ = resp_pipe[0];
+    req_pipe[1] = -1;
+    resp_pipe[0] = -1;
+    loaded_udfs_.reuse();
+    LOG_INFO("python worker started", KPC(this), K(executable));
+  }
+  if (actions_inited) {
+    posix_spawn_file_actions_destroy(&actions);
+  }
+  if (attr_inited) {
+    posix_spawnattr_destroy(&attr);
+  }
+  for (int64_t i = 0; i < 2; i++) {
+    if (req_pipe[i] >= 0) {
+      close(req_pipe[i]);
+    }
+    if (resp_pipe[i] >= 0) {
+      close(resp_pipe[i]);
+    }
+  }
+  return ret;
+}
+
+void ObPyWorkerChannel::stop_worker(const bool force)
+{
+  // the worker exits by itself once the request pipe is closed
+  if (req_fd_ >= 0) {
+    close(req_fd_);
+    req_fd_ = -1;
+  }
+  if (resp_fd_ >= 0) {
+    close(resp_fd_);
+    resp_fd_ = -1;
+  }
+  if (pid_ > 0) {
+    int status = 0;
+    if (force) {
+      kill(pid_, SIGKILL);
+    }
+    for (int64_t i = 0; i < 100 && 0 == waitpid(pid_, &status, WNOHANG); i++) {
+      ob_usleep(1000);
+    }
+    if (0 == waitpid(pid_, &status, WNOHANG)) {
+      kill(pid_, SIGKILL);
+      waitpid(pid_, &status, 0);
+    }
+    LOG_INFO("python worker stopped", K_(pid), K(force), K(status));
+    pid_ = -1;
+  }
+  running_ = false;
+  loaded_udfs_.reuse();
+}
+
+bool ObPyWorkerChannel::is_udf_loaded(const share::schema::ObPythonUDFMeta &udf_meta) const
+{
+  bool loaded = false;
+  for (int64_t i = 0; !loaded && i < loaded_udfs_.count(); i++) {
+    loaded = loaded_udfs_.at(i).udf_id_ == udf_meta.udf_id_
+             && loaded_udfs_.at(i).schema_version_ == udf_meta.schema_version_;
+  }
+  return loaded;
+}
+
+int ObPyWorkerChannel::mark_udf_loaded(const uint64_t udf_id, const int64_t schema_version)
+{
+  int ret = OB_SUCCESS;
+  bool found = false;
+  for (int64_t i = 0; !found && i < loaded_udfs_.count(); i++) {
+    if (loaded_udfs_.at(i).udf_id_ == udf_id) {
+      loaded_udfs_.at(i).schema_version_ = schema_version;
+      found = true;
+    }
+  }
+  if (!found && OB_FAIL(loaded_udfs_.push_back(LoadedUdf(udf_id, schema_version)))) {
+    LOG_WARN("fail to record loaded python udf", K(ret));
+  }
+  return ret;
+}
+
+int ObPyWorkerChannel::write_column(const ObPyWorkerArg &arg,
+                                    const int32_t *sel,
+                                    const int64_t row_cnt,
+                                    int64_t &pos,
+                                    ObPyWorkerBatchHeader::Column &col)
+{
+  int ret = OB_SUCCESS;
+  const ObPythonUdfUtil::PyColumnType type = ObPythonUdfUtil::get_column_type(arg.type_);
+  col.type_ = type;
+  col.offset_ = pos;
+  col.length_ = 0;
+  switch (type) {
+    case ObPythonUdfUtil::PY_COL_INTEGER: {
+      int64_t *dst = reinterpret_cast<int64_t *>(buf_ + pos);
+      for (int64_t k = 0; k < row_cnt; k++) {
+        dst[k] = arg.datums_[arg.is_const_ ? 0 : sel[k]].get_int();
+      }
+      col.length_ = row_cnt * sizeof(int64_t);
+      break;
+    }
+    case ObPythonUdfUtil::PY_COL_REAL: {
+      double *dst = reinterpret_cast<double *>(buf_ + pos);
+      for (int64_t k = 0; k < row_cnt; k++) {
+        dst[k] = arg.datums_[arg.is_const_ ? 0 : sel[k]].get_double();
+      }
+      col.length_ = row_cnt * sizeof(double);
+      break;
+    }
+    case ObPythonUdfUtil::PY_COL_STRING: {
+      int64_t *offsets = reinterpret_cast<int64_t *>(buf_ + pos);
+      char *data = buf_ + pos + (row_cnt + 1) * sizeof(int64_t);
+      int64_t offset = 0;
+      for (int64_t k = 0; k < row_cnt; k++) {
+        const ObDatum &d = arg.datums_[arg.is_const_ ? 0 : sel[k]];
+        offsets[k] = offset;
+        MEMCPY(data + offset, d.ptr_, d.len_);
+        offset += d.len_;
+      }
+      offsets[row_cnt] = offset;
+      col.length_ = (row_cnt + 1) * sizeof(int64_t) + offset;
+      break;
+    }
+    default: {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("unknown arg type", K(ret), K(arg));
+    }
+  }
+  pos = align8(pos + col.length_);
+  return ret;
+}
+
+int ObPyWorkerChannel::write_batch(const share::schema::ObPythonUDFMeta &udf_meta,
+                                   const ObPyWorkerArg *args,
+                                   const int64_t arg_cnt,
+                                   const ObObjType ret_type,
+                                   const int32_t *sel,
+                                   const int64_t sel_cnt,
+                                   int64_t &write_cnt)
+{
+  int ret = OB_SUCCESS;
+  ObPyWorkerBatchHeader *head = header();
+  int64_t pos = align8(sizeof(ObPyWorkerBatchHeader));
+  // inputs take at most half of the buffer, the rest is left to the result
+  const int64_t input_limit = size_ / 2;
+  write_cnt = 0;
+  if (OB_UNLIKELY(!is_inited() || !is_worker_alive())) {
+    ret = OB_NOT_INIT;
+    LOG_WARN("python worker channel not ready", K(ret), KPC(this));
+  } else if (OB_UNLIKELY((arg_cnt > 0 && OB_ISNULL(args)) || OB_ISNULL(sel) || sel_cnt <= 0)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid argument", K(ret), KP(args), KP(sel), K(sel_cnt));
+  } else if (OB_UNLIKELY(arg_cnt > ObPyWorkerBatchHeader::MAX_ARG_CNT)) {
+    ret = OB_NOT_SUPPORTED;
+    LOG_WARN("too many arguments for python worker", K(ret), K(arg_cnt));
+  } else if (ObPythonUdfUtil::PY_COL_INVALID == ObPythonUdfUtil::get_column_type(ret_type)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("unknown result type", K(ret), K(ret_type));
+  } else {
+    head->code_offset_ = 0;
+    head->code_length_ = 0;
+    head->name_length_ = 0;
+    loading_udf_id_ = OB_INVALID_ID;
+    if (!is_udf_loaded(udf_meta)) {
+      const int64_t name_len = udf_meta.name_.length();
+      const int64_t code_len = name_len + udf_meta.pycall_.length();
+      if (pos + code_len > input_limit) {
+        ret = OB_SIZE_OVERFLOW;
+        LOG_WARN("pycall does not fit into python worker buffer", K(ret), K(code_len), K_(size));
+      } else {
+        MEMCPY(buf_ + pos, udf_meta.name_.ptr(), name_len);
+        MEMCPY(buf_ + pos + name_len, udf_meta.pycall_.ptr(), udf_meta.pycall_.length());
+        head->code_offset_ = pos;
+        head->code_length_ = code_len;
+        head->name_length_ = name_len;
+        loading_udf_id_ = udf_meta.udf_id_;
+        loading_schema_version_ = udf_meta.schema_version_;
+        pos = align8(pos + code_len);
+      }
+    }
+  }
+  if (OB_SUCC(ret)) {
+    // count the rows fitting into the input part of the buffer
+    int64_t used = pos;
+    for (int64_t i = 0; i < arg_cnt; i++) {
+      // alignment padding, plus the leading offset of string columns
+      used += 2 * sizeof(int64_t);
+    }
+    for (bool full = false; !full && write_cnt < sel_cnt; ) {
+      int64_t row_size = 0;
+      for (int64_t i = 0; i < arg_cnt; i++) {
+        row_size += sizeof(int64_t);
+        if (ObPythonUdfUtil::PY_COL_STRING == ObPythonUdfUtil::get_column_type(args[i].type_)) {
+          row_size += args[i].datums_[args[i].is_const_ ? 0 : sel[write_cnt]].len_;
+        }
+      }
+      if (used + row_size > input_limit) {
+        full = true;
+      } else {
+        used += row_size;
+        write_cnt++;
+      }
+    }
+    if (0 == write_cnt) {
+      ret = OB_SIZE_OVERFLOW;
+      LOG_WARN("one row does not fit into python worker buffer", K(ret), K_(size));
+    }
+  }
+  for (int64_t i = 0; OB_SUCC(ret) && i < arg_cnt; i++) {
+    if (OB_FAIL(write_column(args[i], sel, write_cnt, pos, head->args_[i]))) {
+      LOG_WARN("fail to write column", K(ret), K(i));
+    }
+  }
+  if (OB_SUCC(ret)) {
+    head->magic_ = ObPyWorkerBatchHeader::MAGIC;
+    head->udf_id_ = udf_meta.udf_id_;
+    head->schema_version_ = udf_meta.schema_version_;
+    head->row_cnt_ = write_cnt;
+    head->arg_cnt_ = arg_cnt;
+    head->ret_type_ = ObPythonUdfUtil::get_column_type(ret_type);
+    head->status_ = -1;
+    head->result_offset_ = pos;
+    head->result_length_ = 0;
+    head->result_cnt_ = 0;
+    head->capacity_ = size_ - pos;
+  }
+  return ret;
+}
+
+int ObPyWorkerChannel::run()
+{
+  int ret = OB_SUCCESS;
+  if (OB_FAIL(submit())) {
+    LOG_WARN("fail to submit batch to python worker", K(ret));
+  } else if (OB_FAIL(wait())) {
+    LOG_WARN("fail to wait python worker", K(ret));
+  }
+  return ret;
+}
+
+int ObPyWorkerChannel::submit()
+{
+  int ret = OB_SUCCESS;
+  char c = 1;
+  ssize_t n = 0;
+  if (OB_UNLIKELY(running_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python worker is running another batch", K(ret), KPC(this));
+  } else {
+    do {
+      n = write(req_fd_, &c, 1);
+    } while (n < 0 && EINTR == errno);
+    if (1 != n) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("python worker is gone", K(ret), K(errno), KPC(this));
+      stop_worker(true);
+    } else {
+      running_ = true;
+    }
+  }
+  return ret;
+}
+
+int ObPyWorkerChannel::wait()
+{
+  int ret = OB_SUCCESS;
+  char c = 0;
+  ssize_t n = 0;
+  bool done = false;
+  if (OB_UNLIKELY(!running_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("no batch submitted to python worker", K(ret), KPC(this));
+  }
+  while (OB_SUCC(ret) && !done) {
+    struct pollfd pfd;
+    pfd.fd = resp_fd_;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int pr = poll(&pfd, 1, WAIT_RESPONSE_INTERVAL_MS);
+    if (pr > 0) {
+      n = read(resp_fd_, &c, 1);
+      if (1 == n) {
+        done = true;
+      } else if (n < 0 && (EINTR == errno || EAGAIN == errno)) {
+        // retry
+      } else {
+        ret = OB_ERR_UNEXPECTED;
+        LOG_WARN("python worker exited while running batch", K(ret), K(errno), KPC(this));
+        stop_worker(true);
+      }
+    } else if (pr < 0 && EINTR != errno) {
+      ret = OB_ERR_SYS;
+      LOG_WARN("fail to wait python worker", K(ret), K(errno));
+      stop_worker(true);
+    } else if (OB_FAIL(THIS_WORKER.check_status())) {
+      // the worker is still busy with the batch, it can not be reused
+      LOG_WARN("interrupted while waiting python worker", K(ret));
+      stop_worker(true);
+    }
+  }
+  if (done) {
+    running_ = false;
+  }
+  if (OB_SUCC(ret)) {
+    const ObPyWorkerBatchHeader *head = header();
+    if (ObPyWorkerBatchHeader::STATUS_OK == head->status_) {
+      if (OB_INVALID_ID != loading_udf_id_
+          && OB_FAIL(mark_udf_loaded(loading_udf_id_, loading_schema_version_))) {
+        LOG_WARN("fail to mark udf loaded", K(ret));
+      }
+    } else if (ObPyWorkerBatchHeader::STATUS_ERROR == head->status_) {
+      ret = OB_ERR_UNEXPECTED;
+      int64_t len = head->result_length_;
+      len = head->result_offset_ + len > size_ ? 0 : len;
+      LOG_WARN("python udf raise an exception in worker", K(ret),
+               "message", ObString(static_cast<int32_t>(len), buf_ + head->result_offset_));
+    } else if (ObPyWorkerBatchHeader::STATUS_OVERFLOW == head->status_) {
+      ret = OB_SIZE_OVERFLOW;
+      LOG_WARN("python udf result does not fit into worker buffer", K(ret), K_(size));
+    } else {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("unexpected python worker status", K(ret), K(head->status_));
+    }
+  }
+  loading_udf_id_ = OB_INVALID_ID;
+  return ret;
+}
+
+int ObPyWorkerChannel::read_result(const ObObjType ret_type,
+                                   const int32_t *sel,
+                                   const int64_t sel_cnt,
+                                   ObDatum *results,
+                                   int64_t &ret_cnt)
+{
+  int ret = OB_SUCCESS;
+  const ObPyWorkerBatchHeader *head = header();
+  const char *base = buf_ + head->result_offset_;
+  ret_cnt = head->result_cnt_ < sel_cnt ? head->result_cnt_ : sel_cnt;
+  if (OB_ISNULL(sel) || OB_ISNULL(results)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid argument", K(ret), KP(sel), KP(results));
+  } else if (OB_UNLIKELY(head->result_offset_ + head->result_length_ > size_ || ret_cnt < 0)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("python worker result is out of buffer", K(ret), K(head->result_offset_),
+             K(head->result_length_), K_(size));
+  } else {
+    switch (ObPythonUdfUtil::get_column_type(ret_type)) {
+      case ObPythonUdfUtil::PY_COL_INTEGER: {
+        const int64_t *src = reinterpret_cast<const int64_t *>(base);
+        for (int64_t k = 0; k < ret_cnt; k++) {
+          results[sel[k]].set_int(src[k]);
+        }
+        break;
+      }
+      case ObPythonUdfUtil::PY_COL_REAL: {
+        const double *src = reinterpret_cast<const double *>(base);
+        for (int64_t k = 0; k < ret_cnt; k++) {
+          results[sel[k]].set_double(src[k]);
+        }
+        break;
+      }
+      case ObPythonUdfUtil::PY_COL_STRING: {
+        const int64_t *offsets = reinterpret_cast<const int64_t *>(base);
+        const char *data = base + (head->result_cnt_ + 1) * sizeof(int64_t);
+        for (int64_t k = 0; k < ret_cnt; k++) {
+          results[sel[k]].set_string(data + offsets[k], static_cast<int32_t>(offsets[k + 1] - offsets[k]));
+        }
+        break;
+      }
+      default: {
+        ret = OB_ERR_UNEXPECTED;
+        LOG_WARN("unknown result type", K(ret), K(ret_type));
+      }
+    }
+  }
+  return ret;
+}
+
+ObPyWorkerPool::ObPyWorkerPool()
+    : tenant_id_(OB_INVALID_TENANT_ID), pool_size_(0), buffer_size_(0), last_refresh_ts_(0),
+      next_(0), use_tenant_config_(false), cond_(), inited_(false)
+{
+  executable_[0] = '\0';
+  MEMSET(busy_, 0, sizeof(busy_));
+}
+
+ObPyWorkerPool::~ObPyWorkerPool()
+{
+  destroy();
+}
+
+int ObPyWorkerPool::init(const uint64_t tenant_id)
+{
+  int ret = OB_SUCCESS;
+  if (inited_) {
+    ret = OB_INIT_TWICE;
+    LOG_WARN("python worker pool init twice", K(ret));
+  } else if (OB_FAIL(cond_.init(ObWaitEventIds::DEFAULT_COND_WAIT))) {
+    LOG_WARN("failed to init cond", K(ret));
+  } else {
+    tenant_id_ = tenant_id;
+    use_tenant_config_ = true;
+    inited_ = true;
+    // workers are started lazily by the first borrowers
+    refresh_config();
+  }
+  return ret;
+}
+
+int ObPyWorkerPool::init(const uint64_t tenant_id,
+                         const int64_t pool_size,
+                         const int64_t buffer_size,
+                         const char *executable)
+{
+  int ret = OB_SUCCESS;
+  if (inited_) {
+    ret = OB_INIT_TWICE;
+    LOG_WARN("python worker pool init twice", K(ret));
+  } else if (OB_UNLIKELY(pool_size <= 0 || pool_size > MAX_POOL_SIZE
+                         || OB_ISNULL(executable) || STRLEN(executable) >= MAX_EXECUTABLE_LEN)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid argument", K(ret), K(pool_size), KP(executable));
+  } else if (OB_FAIL(cond_.init(ObWaitEventIds::DEFAULT_COND_WAIT))) {
+    LOG_WARN("failed to init cond", K(ret));
+  } else {
+    tenant_id_ = tenant_id;
+    pool_size_ = pool_size;
+    buffer_size_ = buffer_size;
+    STRCPY(executable_, executable);
+    use_tenant_config_ = false;
+    inited_ = true;
+  }
+  return ret;
+}
+
+void ObPyWorkerPool::destroy()
+{
+  if (inited_) {
+    for (int64_t i = 0; i < MAX_POOL_SIZE; i++) {
+      channels_[i].destroy();
+      busy_[i] = false;
+    }
+    cond_.destroy();
+    inited_ = false;
+  }
+}
+
+int ObPyWorkerPool::mtl_init(ObPyWorkerPool* &pool)
+{
+  int ret = OB_SUCCESS;
+  uint64_t tenant_id = lib::current_resource_owner_id();
+  pool = OB_NEW(ObPyWorkerPool, ObModIds::OB_SQL_EXECUTOR);
+  if (nullptr == pool) {
+    ret = OB_ALLOCATE_MEMORY_FAILED;
+    LOG_WARN("failed to alloc memory for ObPyWorkerPool", K(ret));
+  } else if (OB_FAIL(pool->init(tenant_id))) {
+    LOG_WARN("failed to init python worker pool", K(ret));
+  }
+  if (OB_FAIL(ret) && pool != nullptr) {
+    // cleanup
+    ob_delete(pool);
+    pool = nullptr;
+  }
+  return ret;
+}
+
+void ObPyWorkerPool::mtl_destroy(ObPyWorkerPool* &pool)
+{
+  if (pool != nullptr) {
+    ob_delete(pool);
+    pool = nullptr;
+  }
+}
+
+// called with cond_ locked
+void ObPyWorkerPool::refresh_config()
+{
+  if (use_tenant_config_) {
+    omt::ObTenantConfigGuard tenant_config(TENANT_CONF(tenant_id_));
+    if (tenant_config.is_valid()) {
+      int64_t pool_size = tenant_config->_python_udf_worker_pool_size;
+      pool_size_ = pool_size > MAX_POOL_SIZE ? MAX_POOL_SIZE : pool_size;
+      buffer_size_ = tenant_config->_python_udf_worker_buffer_size;
+    }
+    snprintf(executable_, sizeof(executable_), "%s", GCONF._python_udf_worker_executable.str());
+    last_refresh_ts_ = ObTimeUtility::current_time();
+  }
+}
+
+int ObPyWorkerPool::prepare_channel(const int64_t idx)
+{
+  int ret = OB_SUCCESS;
+  ObPyWorkerChannel &channel = channels_[idx];
+  int64_t buffer_size = 0;
+  char executable[MAX_EXECUTABLE_LEN];
+  {
+    ObThreadCondGuard guard(cond_);
+    buffer_size = buffer_size_;
+    STRCPY(executable, executable_);
+  }
+  if (channel.is_inited() && channel.get_size() != buffer_size) {
+    // buffer size changed, restart the channel
+    channel.destroy();
+  }
+  if (!channel.is_inited() && OB_FAIL(channel.init(tenant_id_, idx, buffer_size))) {
+    LOG_WARN("fail to init python worker channel", K(ret), K(idx), K(buffer_size));
+  } else if (!channel.is_worker_alive() && OB_FAIL(channel.start_worker(executable))) {
+    LOG_WARN("fail to start python worker", K(ret), K(idx));
+  }
+  return ret;
+}
+
+int ObPyWorkerPool::inner_borrow(const bool wait, ObPyWorkerChannel *&channel)
+{
+  int ret = OB_SUCCESS;
+  int64_t idx = -1;
+  bool give_up = false;
+  channel = NULL;
+  if (!inited_) {
+    ret = OB_NOT_INIT;
+    LOG_WARN("python worker pool not init", K(ret));
+  }
+  while (OB_SUCC(ret) && -1 == idx && !give_up) {
+    ObThreadCondGuard guard(cond_);
+    if (use_tenant_config_
+        && ObTimeUtility::current_time() - last_refresh_ts_ > REFRESH_CONFIG_INTERVAL_US) {
+      refresh_config();
+    }
+    // walk the ring from the cursor, so that load spreads over all workers
+    for (int64_t i = 0; -1 == idx && i < pool_size_; i++) {
+      const int64_t j = (next_ + i) % pool_size_;
+      if (!busy_[j]) {
+        idx = j;
+      }
+    }
+    if (-1 != idx) {
+      busy_[idx] = true;
+      next_ = (idx + 1) % pool_size_;
+    } else if (!wait) {
+      give_up = true;
+    } else {
+      (void)cond_.wait_us(WAIT_CHANNEL_INTERVAL_US);
+      if (OB_FAIL(THIS_WORKER.check_status())) {
+        LOG_WARN("worker interrupted while waiting for python worker", K(ret));
+      }
+    }
+  }
+  if (OB_SUCC(ret) && -1 != idx) {
+    if (OB_FAIL(prepare_channel(idx))) {
+      LOG_WARN("fail to prepare python worker channel", K(ret), K(idx));
+      ObThreadCondGuard guard(cond_);
+      busy_[idx] = false;
+      cond_.signal();
+    } else {
+      channel = &channels_[idx];
+    }
+  }
+  return ret;
+}
+
+void ObPyWorkerPool::give_back(ObPyWorkerChannel *channel)
+{
+  const int64_t idx = channel - channels_;
+  if (NULL != channel && idx >= 0 && idx < MAX_POOL_SIZE) {
+    if (channel->is_running()) {
+      // abandoned in-flight batch, the response would be read by the next borrower
+      channel->stop_worker(true);
+    }
+    ObThreadCondGuard guard(cond_);
+    busy_[idx] = false;
+    cond_.signal();
+  }
+}
+
+} // end namespace sql
+} // end namespace oceanbase
@@ -0,0 +1,239 @@
+#ifndef OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_WORKER_POOL_H_
+#define OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_WORKER_POOL_H_
+
+#include "sql/engine/python_udf_engine/ob_python_udf_util.h"
+#include "lib/container/ob_se_array.h"
+#include "lib/lock/ob_thread_cond.h"
+
+namespace oceanbase
+{
+namespace sql
+{
+
+/*
+ * Out-of-process execution of python udf.
+ *
+ * A tenant owns a ring of channels, each one made of a python worker process and a
+ * shared memory buffer (/dev/shm). A batch is written into the buffer column by column
+ * (int64/double arrays, strings as offsets + bytes), the worker maps the columns as
+ * numpy arrays without copy, runs <pyfun> and writes the result column back behind the
+ * inputs. A pair of pipes is only used as doorbell, one byte per request and response.
+ *
+ * Model crashes or memory blow-ups kill the worker and not the observer, the broken
+ * channel is restarted by its next borrower.
+ */
+
+// head of a channel buffer, the layout is shared with the worker script
+struct ObPyWorkerBatchHeader
+{
+  static const uint64_t MAGIC = 0x4f42505955444621ULL;
+  static const int64_t MAX_ARG_CNT = 64;
+  enum Status
+  {
+    STATUS_OK = 0,
+    STATUS_ERROR = 1, // python exception, message at result_offset_
+    STATUS_OVERFLOW = 2 // result does not fit into the buffer
+  };
+  struct Column
+  {
+    int64_t type_; // ObPythonUdfUtil::PyColumnType
+    int64_t offset_;
+    int64_t length_;
+  };
+
+  uint64_t magic_;
+  uint64_t udf_id_;
+  int64_t schema_version_;
+  int64_t row_cnt_;
+  int64_t arg_cnt_;
+  int64_t ret_type_; // ObPythonUdfUtil::PyColumnType
+  int64_t code_offset_; // udf name followed by pycall, only sent when not loaded yet
+  int64_t code_length_;
+  int64_t name_length_;
+  // filled by worker
+  int64_t status_;
+  int64_t result_offset_;
+  int64_t result_length_;
+  int64_t result_cnt_;
+  int64_t capacity_; // bytes the result can take from result_offset_
+  Column args_[MAX_ARG_CNT];
+};
+
+struct ObPyWorkerArg
+{
+  ObPyWorkerArg() : type_(common::ObNullType), datums_(NULL), is_const_(false) {}
+  ObPyWorkerArg(common::ObObjType type, const common::ObDatum *datums, bool is_const)
+      : type_(type), datums_(datums), is_const_(is_const) {}
+  TO_STRING_KV(K_(type), KP_(datums), K_(is_const));
+  common::ObObjType type_;
+  const common::ObDatum *datums_;
+  bool is_const_;
+};
+
+class ObPyWorkerChannel
+{
+public:
+  static const int WORKER_REQ_FD = 3;
+  static const int WORKER_RESP_FD = 4;
+  static const int64_t WAIT_RESPONSE_INTERVAL_MS = 100;
+  static const int64_t MAX_SHM_NAME_LEN = 64;
+
+  ObPyWorkerChannel();
+  ~ObPyWorkerChannel() { destroy(); }
+  int init(const uint64_t tenant_id, const int64_t idx, const int64_t size);
+  void destroy();
+  bool is_inited() const { return NULL != buf_; }
+  int64_t get_size() const { return size_; }
+
+  int start_worker(const char *executable);
+  // force kills the worker instead of letting it drain the request pipe
+  void stop_worker(const bool force);
+  bool is_worker_alive() const { return pid_ > 0; }
+
+  // write as many rows of sel[0..sel_cnt) as the buffer can hold, at least one
+  int write_batch(const share::schema::ObPythonUDFMeta &udf_meta,
+                  const ObPyWorkerArg *args,
+                  const int64_t arg_cnt,
+                  const common::ObObjType ret_type,
+                  const int32_t *sel,
+                  const int64_t sel_cnt,
+                  int64_t &write_cnt);
+  // ring the worker and wait for the result
+  int run();
+  // run() in two steps, the caller may do something else while the worker is busy
+  int submit();
+  int wait();
+  bool is_running() const { return running_; }
+  // string results point into the channel buffer, valid until the next batch
+  int read_result(const common::ObObjType ret_type,
+                  const int32_t *sel,
+                  const int64_t sel_cnt,
+                  common::ObDatum *results,
+                  int64_t &ret_cnt);
+
+  TO_STRING_KV(K_(shm_name), K_(size), K_(pid), K_(req_fd), K_(resp_fd), K_(loaded_udfs));
+
+private:
+  struct LoadedUdf
+  {
+    LoadedUdf() : udf_id_(common::OB_INVALID_ID), schema_version_(common::OB_INVALID_VERSION) {}
+    LoadedUdf(uint64_t udf_id, int64_t schema_version)
+        : udf_id_(udf_id), schema_version_(schema_version) {}
+    TO_STRING_KV(K_(udf_id), K_(schema_version));
+    uint64_t udf_id_;
+    int64_t schema_version_;
+  };
+
+  ObPyWorkerBatchHeader *header() const { return reinterpret_cast<ObPyWorkerBatchHeader *>(buf_); }
+  bool is_udf_loaded(const share::schema::ObPythonUDFMeta &udf_meta) const;
+  int mark_udf_loaded(const uint64_t udf_id, const int64_t schema_version);
+  int write_column(const ObPyWorkerArg &arg,
+                   const int32_t *sel,
+                   const int64_t row_cnt,
+                   int64_t &pos,
+                   ObPyWorkerBatchHeader::Column &col);
+
+private:
+  char shm_name_[MAX_SHM_NAME_LEN];
+  int shm_fd_;
+  char *buf_;
+  int64_t size_;
+  pid_t pid_;
+  int req_fd_; // write end of worker request pipe
+  int resp_fd_; // read end of worker response pipe
+  // udf being sent with its code in the pending request
+  uint64_t loading_udf_id_;
+  int64_t loading_schema_version_;
+  bool running_; // a submitted batch is not waited yet
+  common::ObSEArray<LoadedUdf, 8> loaded_udfs_;
+  DISALLOW_COPY_AND_ASSIGN(ObPyWorkerChannel);
+};
+
+/*
+ * Per-tenant pool of python worker channels, sized by tenant config
+ * _python_udf_worker_pool_size and _python_udf_worker_buffer_size. Workers are started
+ * lazily by the first borrower of a channel with cluster config _python_udf_worker_executable.
+ */
+class ObPyWorkerPool
+{
+public:
+  static const int64_t MAX_POOL_SIZE = 64;
+  static const int64_t MAX_EXECUTABLE_LEN = 512;
+  static const int64_t WAIT_CHANNEL_INTERVAL_US = 1000;
+  static const int64_t REFRESH_CONFIG_INTERVAL_US = 1000000;
+
+  ObPyWorkerPool();
+  ~ObPyWorkerPool();
+  // sized by tenant config
+  int init(const uint64_t tenant_id);
+  // fixed size, used when no tenant config is available
+  int init(const uint64_t tenant_id,
+           const int64_t pool_size,
+           const int64_t buffer_size,
+           const char *executable);
+  void destroy();
+  static int mtl_init(ObPyWorkerPool* &pool);
+  static void mtl_destroy(ObPyWorkerPool* &pool);
+
+  // take the next free channel of the ring with a running worker, blocks until one is free.
+  // Never called while the thread holds another channel, the holders could wait on each other
+  int borrow(ObPyWorkerChannel *&channel) { return inner_borrow(true, channel); }
+  // as borrow, channel is NULL if all are busy
+  int try_borrow(ObPyWorkerChannel *&channel) { return inner_borrow(false, channel); }
+  void give_back(ObPyWorkerChannel *channel);
+
+  TO_STRING_KV(K_(tenant_id), K_(pool_size), K_(buffer_size), K_(next), K_(use_tenant_config));
+
+private:
+  void refresh_config();
+  int prepare_channel(const int64_t idx);
+  int inner_borrow(const bool wait, ObPyWorkerChannel *&channel);
+
+private:
+  uint64_t tenant_id_;
+  int64_t pool_size_;
+  int64_t buffer_size_;
+  char executable_[MAX_EXECUTABLE_LEN];
+  int64_t last_refresh_ts_;
+  int64_t next_; // ring cursor
+  bool use_tenant_config_;
+  common::ObThreadCond cond_;
+  bool busy_[MAX_POOL_SIZE];
+  ObPyWorkerChannel channels_[MAX_POOL_SIZE];
+  bool inited_;
+  DISALLOW_COPY_AND_ASSIGN(ObPyWorkerPool);
+};
+
+class ObPyWorkerGuard
+{
+public:
+  explicit ObPyWorkerGuard(ObPyWorkerPool *pool) : pool_(pool), channel_(NULL) {}
+  ~ObPyWorkerGuard()
+  {
+    if (NULL != pool_ && NULL != channel_) {
+      pool_->give_back(channel_);
+      channel_ = NULL;
+    }
+  }
+  int acquire()
+  {
+    int ret = common::OB_SUCCESS;
+    if (OB_ISNULL(pool_)) {
+      ret = common::OB_NOT_INIT;
+    } else if (NULL == channel_) {
+      ret = pool_->borrow(channel_);
+    }
+    return ret;
+  }
+  ObPyWorkerChannel *get_channel() const { return channel_; }
+
+private:
+  ObPyWorkerPool *pool_;
+  ObPyWorkerChannel *channel_;
+  DISALLOW_COPY_AND_ASSIGN(ObPyWorkerGuard);
+};
+
+} // end namespace sql
+} // end namespace oceanbase
+
+#endif // OCEANBASE_PYTHON_UDF_OB_PYTHON_UDF_WORKER_POOL_H_
@@ -658,7 +658,7 @@ int ObRandomSliceIdCalc::get_slice_idx(
     ret = OB_ERR_UNEXPECTED;
     LOG_WARN("invalid slice count", K(ret), K(slice_cnt_));
   } else {
-    slice_idx = idx_ % slice_cnt_;
+    slice_idx = (idx_ / chunk_rows_) % slice_cnt_;
     idx_++;
   }
   return ret;
@@ -553,8 +553,11 @@ private:
 class ObRandomSliceIdCalc : public ObSliceIdxCalc
 {
 public:
-  ObRandomSliceIdCalc(common::ObIAllocator &alloc, const uint64_t slice_cnt)
-      : ObSliceIdxCalc(alloc, ObNullDistributeMethod::NONE), idx_(0), slice_cnt_(slice_cnt)
+  // chunk_rows consecutive rows go to the same slice, python udf workers get whole batches
+  ObRandomSliceIdCalc(common::ObIAllocator &alloc, const uint64_t slice_cnt,
+                      const uint64_t chunk_rows = 1)
+      : ObSliceIdxCalc(alloc, ObNullDistributeMethod::NONE), idx_(0), slice_cnt_(slice_cnt),
+        chunk_rows_(chunk_rows > 1 ? chunk_rows : 1)
   {}
 
   virtual int get_slice_idx(
@@ -563,6 +566,7 @@ public:
 private:
   uint64_t idx_;
   uint64_t slice_cnt_;
+  uint64_t chunk_rows_;
 };
 
 class ObBroadcastSliceIdCalc : public ObMultiSliceIdxCalc
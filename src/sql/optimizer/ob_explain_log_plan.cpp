@@ -16,6 +16,7 @@
 #include "sql/optimizer/ob_log_operator_factory.h"
 #include "sql/optimizer/ob_log_plan_factory.h"
 #include "sql/optimizer/ob_log_values.h"
+#include "sql/optimizer/ob_log_python_udf.h"
 #include "sql/code_generator/ob_code_generator.h"
 #include "sql/monitor/ob_sql_plan.h"
 
@@ -56,6 +57,9 @@ int ObExplainLogPlan::generate_normal_raw_plan()
       LOG_WARN("failed to generate plan tree for explain", K(ret));
     } else if (OB_FAIL(ObCodeGenerator::detect_batch_size(*child_plan, batch_size))) {
       LOG_WARN("detect batch size failed", K(ret));
+    } else if (OB_FAIL(ObLogPythonUDF::add_row_mode_notes(child_plan->get_optimizer_context(),
+                                                          batch_size))) {
+      LOG_WARN("failed to add python udf row mode notes", K(ret));
     } else if (OB_FAIL(allocate_values_as_top(top))) {
       LOG_WARN("failed to allocate expr values_op as top", K(ret));
     } else if (OB_ISNULL(top) || OB_UNLIKELY(LOG_VALUES != top->get_type())) {
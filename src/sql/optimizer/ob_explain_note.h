@@ -33,6 +33,8 @@ namespace sql
 #define PARALLEL_DISABLED_BY_PL_UDF_DAS  "Degree of Parallelisim is %ld because stmt contain pl_udf which force das scan"
 #define DIRECT_MODE_INSERT_INTO_SELECT  "Direct-mode is enabled in insert into select"
 #define PARALLEL_DISABLED_BY_DBLINK  "Degree of Parallelisim is %ld because stmt contain dblink which force das scan"
+#define PYTHON_UDF_ROW_MODE_BY_PLAN "Python udf %.*s is called once per row because the plan is not vectorized"
+#define PYTHON_UDF_ROW_MODE_BY_ARGS "Python udf %.*s is called once per row because none of its arguments is a column"
 
 }
 }
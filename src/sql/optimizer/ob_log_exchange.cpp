@@ -233,6 +233,9 @@ int ObLogExchange::get_plan_special_expr_info(PlanText &plan_text,
         OB_PHY_PLAN_REMOTE != get_plan()->get_optimizer_context().get_phy_plan_type()) {
       ret = BUF_PRINTF("dop=%d", parallel);
     }
+    if (OB_SUCC(ret) && is_pq_random() && random_chunk_rows_ > 1) {
+      ret = BUF_PRINTF(", chunk=%ld", random_chunk_rows_);
+    }
     if (OB_SUCC(ret) && EXPLAIN_EXTENDED == type && popular_values_.count() > 0) {
       if (OB_FAIL(BUF_PRINTF(",\n      "))) {
         LOG_WARN("BUF_PRINTF fails", K(ret));
@@ -397,7 +400,8 @@ int ObLogExchange::compute_op_parallel_and_server_info()
       }
     }
   } else {
-    set_parallel(child->get_parallel());
+    set_parallel(is_consumer() && consumer_parallel_ > 0 ? consumer_parallel_
+                                                        : child->get_parallel());
     set_server_cnt(child->get_server_cnt());
     if (dist_method_ == ObPQDistributeMethod::HASH) {
       common::ObAddr all_server_list;
@@ -559,6 +563,7 @@ int ObLogExchange::set_exchange_info(const ObExchangeInfo &exch_info)
   slave_mapping_type_ = exch_info.slave_mapping_type_;
   if (is_producer()) {
     slice_count_ = exch_info.slice_count_;
+    random_chunk_rows_ = exch_info.random_chunk_rows_;
     repartition_type_ = exch_info.repartition_type_;
     repartition_ref_table_id_ = exch_info.repartition_ref_table_id_;
     repartition_table_id_ = exch_info.repartition_table_id_;
@@ -593,6 +598,7 @@ int ObLogExchange::set_exchange_info(const ObExchangeInfo &exch_info)
       }
     }
   } else { // consumer
+    consumer_parallel_ = exch_info.parallel_;
     if ((exch_info.is_merge_sort_
          || (dist_method_ != ObPQDistributeMethod::RANGE
              && dist_method_ != ObPQDistributeMethod::PARTITION_RANGE))
@@ -58,7 +58,9 @@ public:
       random_expr_(NULL),
       need_null_aware_shuffle_(false),
       is_old_unblock_mode_(true),
-      sample_type_(NOT_INIT_SAMPLE_TYPE)
+      sample_type_(NOT_INIT_SAMPLE_TYPE),
+      consumer_parallel_(0),
+      random_chunk_rows_(1)
   {
     repartition_table_id_ = 0;
   }
@@ -169,6 +171,8 @@ public:
   void set_sample_type(ObPxSampleType type) { sample_type_ = type; }
   ObPxSampleType get_sample_type() { return sample_type_; }
 
+  int64_t get_random_chunk_rows() const { return random_chunk_rows_; }
+
   void set_random_expr(ObRawExpr *expr) { random_expr_ = expr; }
   ObRawExpr *get_random_expr() const { return random_expr_; }
   virtual int get_plan_item_info(PlanText &plan_text,
@@ -258,6 +262,9 @@ private:
   // -for pkey range/range
   ObPxSampleType sample_type_;
   // -end pkey range/range
+  // dop of the consumer when it differs from the producer, see ObExchangeInfo::parallel_
+  int64_t consumer_parallel_;
+  int64_t random_chunk_rows_;
   DISALLOW_COPY_AND_ASSIGN(ObLogExchange);
 };
 } // end of namespace sql
@@ -39,6 +39,7 @@
 #include "sql/optimizer/ob_log_set.h"
 #include "sql/optimizer/ob_log_subplan_scan.h"
 #include "sql/optimizer/ob_log_subplan_filter.h"
+#include "sql/optimizer/ob_log_python_udf.h"
 #include "sql/optimizer/ob_log_material.h"
 #include "sql/optimizer/ob_log_select_into.h"
 #include "sql/optimizer/ob_log_count.h"
@@ -5375,6 +5376,8 @@ int ObLogPlan::allocate_pyudf_subquery_path(SubQueryPath *subpath,
   ObLogicalOperator *root = NULL;
   ObLogPythonUDF *pyudf_op = NULL;
   const TableItem *table_item = NULL;
+  ObSEArray<ObRawExpr*, 8> project_exprs;
+  bool is_redistributed = false;
   if (OB_ISNULL(subpath) || OB_ISNULL(root = subpath->root_) || OB_ISNULL(get_stmt()) ||
       OB_ISNULL(table_item = get_stmt()->get_table_item_by_id(subpath->subquery_id_))) {
     ret = OB_ERR_UNEXPECTED;
@@ -5383,6 +5386,14 @@ int ObLogPlan::allocate_pyudf_subquery_path(SubQueryPath *subpath,
                       (get_log_op_factory().allocate(*this, LOG_PYTHON_UDF)))) {
     ret = OB_ALLOCATE_MEMORY_FAILED;
     LOG_ERROR("failed to allocate subquery operator", K(ret));
+  } else if (get_stmt()->is_select_stmt() &&
+             OB_FAIL(static_cast<const ObSelectStmt *>(get_stmt())->get_select_exprs(project_exprs))) {
+    LOG_WARN("failed to get select exprs", K(ret));
+  } else if (OB_FAIL(pyudf_op->init_predict_cost(subpath->filter_, project_exprs))) {
+    LOG_WARN("failed to init python udf predict cost", K(ret));
+  } else if (OB_FAIL(allocate_predict_exchange_as_top(*subpath, *pyudf_op, root,
+                                                      is_redistributed))) {
+    LOG_WARN("failed to allocate exchange for python udf", K(ret));
   } else {
     ObLogSubPlanScan *subplan_scan = static_cast<ObLogSubPlanScan*>(pyudf_op);
     subplan_scan->set_subquery_id(subpath->subquery_id_);
@@ -5396,6 +5407,27 @@ int ObLogPlan::allocate_pyudf_subquery_path(SubQueryPath *subpath,
       LOG_WARN("failed to append pushdown filters", K(ret));
     } else if (OB_FAIL(subplan_scan->compute_property(subpath))) {
       LOG_WARN("failed to compute property", K(ret));
+    } else if (is_redistributed) {
+      // distribution and ordering come from the exchange instead of the subquery path
+      pyudf_op->set_strong_sharding(root->get_strong_sharding());
+      pyudf_op->set_exchange_allocated(true);
+      pyudf_op->set_phy_plan_type(root->get_phy_plan_type());
+      pyudf_op->set_location_type(root->get_location_type());
+      pyudf_op->set_parallel(root->get_parallel());
+      pyudf_op->set_server_cnt(root->get_server_cnt());
+      pyudf_op->set_is_local_order(false);
+      pyudf_op->set_is_range_order(false);
+      pyudf_op->reset_op_ordering();
+      pyudf_op->set_cost(root->get_cost() + pyudf_op->get_op_cost());
+      if (OB_FAIL(pyudf_op->set_weak_sharding(root->get_weak_sharding()))) {
+        LOG_WARN("failed to set weak sharding", K(ret));
+      } else if (OB_FAIL(pyudf_op->get_server_list().assign(root->get_server_list()))) {
+        LOG_WARN("failed to assign server list", K(ret));
+      }
+    }
+    if (OB_FAIL(ret)) {
+    } else if (OB_FAIL(pyudf_op->add_predict_cost())) {
+      LOG_WARN("failed to add predict cost", K(ret));
     } else {
       out_pyudf_subquery_path_op = pyudf_op;
     }
@@ -5403,6 +5435,62 @@ int ObLogPlan::allocate_pyudf_subquery_path(SubQueryPath *subpath,
   return ret;
 }
 
+/*
+ * Python udf is compute bound, it should run at the dop its inference cost asks for rather
+ * than at the dop of the subquery, which is 1 for a single partition scan. Rows are
+ * redistributed round-robin in chunks of the learned batch size so that every PX worker
+ * feeds whole batches to the udf.
+ * Only done when the subquery is the whole FROM: a join above could rely on the ordering or
+ * rescan the subquery path. Nor when the subquery has ORDER BY: the pull-up rewrite keeps the
+ * ORDER BY of the statement in the view and the parent relies on the order of its rows.
+ */
+int ObLogPlan::allocate_predict_exchange_as_top(const SubQueryPath &subpath,
+                                                const ObLogPythonUDF &pyudf_op,
+                                                ObLogicalOperator *&top,
+                                                bool &is_redistributed)
+{
+  int ret = OB_SUCCESS;
+  bool enabled = false;
+  int64_t dop = 1;
+  const ObSQLSessionInfo *session_info = get_optimizer_context().get_session_info();
+  const TableItem *table_item = NULL;
+  is_redistributed = false;
+  if (OB_ISNULL(top) || OB_ISNULL(session_info) || OB_ISNULL(get_stmt())
+      || OB_ISNULL(table_item = get_stmt()->get_table_item_by_id(subpath.subquery_id_))
+      || OB_ISNULL(table_item->ref_query_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("get unexpected null", K(top), K(session_info), K(table_item), K(ret));
+  } else {
+    omt::ObTenantConfigGuard tenant_config(TENANT_CONF(session_info->get_effective_tenant_id()));
+    if (tenant_config.is_valid()) {
+      enabled = tenant_config->_enable_python_udf_px_redistribute;
+    }
+  }
+  if (OB_FAIL(ret)) {
+  } else if (!enabled || !get_optimizer_context().use_intra_parallel() ||
+             subpath.parent_ != join_order_ || top->is_match_all()) {
+    /* do nothing */
+  } else if (table_item->ref_query_->has_order_by()) {
+    /* a random exchange would lose the order the parent relies on */
+  } else if ((dop = pyudf_op.get_predict_dop(top->get_card(),
+                                             get_optimizer_context().get_parallel()))
+             <= top->get_parallel()) {
+    /* the subquery already runs at the dop */
+  } else {
+    ObExchangeInfo exch_info;
+    exch_info.dist_method_ = ObPQDistributeMethod::RANDOM;
+    exch_info.parallel_ = dop;
+    exch_info.random_chunk_rows_ = pyudf_op.get_predict_batch_rows();
+    if (OB_FAIL(allocate_exchange_as_top(top, exch_info))) {
+      LOG_WARN("failed to allocate exchange as top", K(ret));
+    } else {
+      is_redistributed = true;
+      OPT_TRACE("redistribute rows in front of python udf, dop:", dop);
+    }
+  }
+  return ret;
+}
+
 int ObLogPlan::allocate_material_as_top(ObLogicalOperator *&old_top)
 {
   int ret = OB_SUCCESS;
@@ -8468,6 +8556,9 @@ int ObLogPlan::create_limit_plan(ObLogicalOperator *&top,
     bool is_pushed = false;
     // for normal limit-offset case
     if (NULL != limit_expr && !is_calc_found_rows && !is_fetch_with_ties &&
+        OB_FAIL(try_push_limit_into_python_udf(top, pushed_expr))) {
+      LOG_WARN("failed to push limit into python udf", K(ret));
+    } else if (NULL != limit_expr && !is_calc_found_rows && !is_fetch_with_ties &&
         OB_FAIL(try_push_limit_into_table_scan(top,
                                                limit_expr,
                                                pushed_expr,
@@ -8551,6 +8642,23 @@ int ObLogPlan::try_push_limit_into_table_scan(ObLogicalOperator *top,
   return ret;
 }
 
+/*
+ * Python udf operator reads ahead of the rows it predicts and buffers its output, it would
+ * run inference on far more rows than a small limit needs. The limit + offset count tells it
+ * when to stop, the limit operator is still allocated on top.
+ */
+int ObLogPlan::try_push_limit_into_python_udf(ObLogicalOperator *top, ObRawExpr *pushed_expr)
+{
+  int ret = OB_SUCCESS;
+  if (OB_ISNULL(top) || OB_ISNULL(pushed_expr)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("get unexpected null", K(top), K(pushed_expr), K(ret));
+  } else if (log_op_def::LOG_PYTHON_UDF == top->get_type()) {
+    static_cast<ObLogPythonUDF *>(top)->set_limit_expr(pushed_expr);
+  } else { /*do nothing*/ }
+  return ret;
+}
+
 /*
  * A plan is reliable if it does not make any uniform assumption during the cost re-estimation phase.
  * In other words, it should satisfy the following two requirements:
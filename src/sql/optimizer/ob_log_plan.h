@@ -667,6 +667,12 @@ public:
   int allocate_pyudf_subquery_path(SubQueryPath *subpath,
                                    ObLogicalOperator *&out_pyudf_subquery_path_op);
 
+  /** @brief Allocate a random exchange running python udf at the dop of its inference cost */
+  int allocate_predict_exchange_as_top(const SubQueryPath &subpath,
+                                       const ObLogPythonUDF &pyudf_op,
+                                       ObLogicalOperator *&top,
+                                       bool &is_redistributed);
+
   /** @brief Allcoate a ,aterial operator as parent of a path */
   int allocate_material_as_top(ObLogicalOperator *&old_top);
 
@@ -910,6 +916,9 @@ public:
                                       ObRawExpr *offset_expr,
                                       bool &is_pushed);
 
+  // tell a python udf operator below the limit how many rows are needed
+  int try_push_limit_into_python_udf(ObLogicalOperator *top, ObRawExpr *pushed_expr);
+
    int allocate_limit_as_top(ObLogicalOperator *&old_top,
                              ObRawExpr *limit_expr,
                              ObRawExpr *offset_expr,
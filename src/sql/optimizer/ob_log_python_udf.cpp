@@ -4,6 +4,9 @@
 #include "sql/optimizer/ob_opt_est_cost.h"
 #include "sql/optimizer/ob_join_order.h"
 #include "common/ob_smart_call.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_batch_tuner.h"
+#include "sql/rewrite/ob_transform_utils.h"
+#include "sql/optimizer/ob_explain_note.h"
 using namespace oceanbase::sql;
 using namespace oceanbase::common;
 
@@ -33,13 +36,16 @@ int ObLogPythonUDF::get_plan_item_info(PlanText &plan_text,
   } else {
     for (int64_t i = 0; OB_SUCC(ret) && i < N; ++i) {
       ObPythonUDFMeta meta = metas.at(i);
+      // the model dump of a tree udf is too long to be printed
+      const bool is_trees = share::schema::ObPythonUDF::TREES == meta.language_;
       if(OB_FAIL(BUF_PRINTF("["))) { /* Do nothing */
       } else if (OB_FAIL(BUF_PRINTF("name: "))) { 
       } else if (OB_FAIL(BUF_PRINTF("%.*s", meta.name_.length(), meta.name_.ptr()))) { 
       //} else if (OB_FAIL(BUF_PRINTF(", ret: "))) { 
       //} else if (OB_FAIL(BUF_PRINTF(PyUdfRetType_to_string(meta.ret_)))) { 
-      } else if (OB_FAIL(BUF_PRINTF(", pycall: "))) { 
-      } else if (OB_FAIL(BUF_PRINTF("%.*s", meta.pycall_.length(), meta.pycall_.ptr()))) {
+      } else if (is_trees && OB_FAIL(BUF_PRINTF(", language: TREES"))) {
+      } else if (!is_trees && OB_FAIL(BUF_PRINTF(", pycall: "))) { 
+      } else if (!is_trees && OB_FAIL(BUF_PRINTF("%.*s", meta.pycall_.length(), meta.pycall_.ptr()))) {
       } else if (OB_FAIL(BUF_PRINTF("]"))) { 
       } else if (i < N - 1) {                                                               
         ret = BUF_PRINTF(", ");    
@@ -52,6 +58,14 @@ int ObLogPythonUDF::get_plan_item_info(PlanText &plan_text,
 
   END_BUF_PRINT(plan_item.pyudf_metadata_,
                 plan_item.pyudf_metadata_len_);
+  // rows the limit above needs, including its offset
+  if (OB_SUCC(ret) && NULL != limit_expr_) {
+    ObRawExpr *limit = limit_expr_;
+    BEGIN_BUF_PRINT;
+    EXPLAIN_PRINT_EXPR(limit, type);
+    END_BUF_PRINT(plan_item.special_predicates_,
+                  plan_item.special_predicates_len_);
+  }
   return ret;
 }
 
@@ -68,3 +82,246 @@ int ObLogPythonUDF::collect_expr_metadata(
   }
   return ret;
 }
+
+int ObLogPythonUDF::init_predict_cost(const ObIArray<ObRawExpr *> &filters,
+                                      const ObIArray<ObRawExpr *> &projections)
+{
+  int ret = OB_SUCCESS;
+  ObSEArray<ObPythonUDFMeta, 4> udf_metas;
+  int64_t filter_udf_cnt = 0;
+  predict_row_cost_ = 0;
+  project_row_cost_ = 0;
+  predict_batch_rows_ = ObPyBatchTuneState::DEFAULT_BATCH_SIZE;
+  if (OB_ISNULL(get_plan())) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("get unexpected null", K(ret));
+  }
+  FOREACH_CNT_X(e, filters, OB_SUCC(ret)) {
+    if (OB_ISNULL(*e)) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("get unexpected null", K(ret));
+    } else if (OB_FAIL(collect_expr_metadata(*e, udf_metas))) {
+      LOG_WARN("failed to collect python udf metadata", K(ret));
+    }
+  }
+  filter_udf_cnt = udf_metas.count();
+  FOREACH_CNT_X(e, projections, OB_SUCC(ret)) {
+    if (OB_ISNULL(*e)) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("get unexpected null", K(ret));
+    } else if (OB_FAIL(collect_expr_metadata(*e, udf_metas))) {
+      LOG_WARN("failed to collect python udf metadata", K(ret));
+    }
+  }
+  for (int64_t i = 0; OB_SUCC(ret) && i < udf_metas.count(); ++i) {
+    const ObPythonUDFMeta &meta = udf_metas.at(i);
+    ObPyBatchSizeCache *cache = MTL(ObPyBatchSizeCache*);
+    int64_t batch_size = get_plan()->get_optimizer_context().get_global_hint()
+                         .get_predict_batch_hint(meta.name_);
+    int64_t learned_size = 0;
+    const double row_cost = get_udf_row_cost(meta);
+    if (0 != batch_size || NULL == cache
+        || OB_SUCCESS != cache->get(meta.udf_id_, meta.schema_version_, learned_size)) {
+      // hinted, or nothing learned for this udf yet
+    } else {
+      batch_size = learned_size;
+    }
+    predict_row_cost_ += row_cost;
+    project_row_cost_ += i < filter_udf_cnt ? 0 : row_cost;
+    predict_batch_rows_ = std::max(predict_batch_rows_, batch_size);
+  }
+  LOG_TRACE("python udf predict cost", K(predict_row_cost_), K(project_row_cost_),
+            K(predict_batch_rows_), K(udf_metas));
+  return ret;
+}
+
+int ObLogPythonUDF::collect_udf_exprs(const ObRawExpr *expr,
+                                      ObIArray<const ObPythonUdfRawExpr *> &udf_exprs)
+{
+  int ret = OB_SUCCESS;
+  if (OB_ISNULL(expr)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("get unexpected null", K(ret));
+  } else if (T_FUN_SYS_PYTHON_UDF == expr->get_expr_type()
+             && OB_FAIL(udf_exprs.push_back(static_cast<const ObPythonUdfRawExpr *>(expr)))) {
+    LOG_WARN("failed to push back python udf expr", K(ret));
+  }
+  for (int64_t i = 0; OB_SUCC(ret) && i < expr->get_param_count(); i++) {
+    if (OB_FAIL(SMART_CALL(collect_udf_exprs(expr->get_param_expr(i), udf_exprs)))) {
+      LOG_WARN("failed to collect python udf exprs", K(ret));
+    }
+  }
+  return ret;
+}
+
+int ObLogPythonUDF::add_row_mode_notes(ObOptimizerContext &opt_ctx, const int64_t batch_size)
+{
+  int ret = OB_SUCCESS;
+  ObSEArray<const ObPythonUdfRawExpr *, 4> udf_exprs;
+  const ObIArray<ObRawExpr *> &all_exprs = opt_ctx.get_all_exprs().get_expr_array();
+  for (int64_t i = 0; OB_SUCC(ret) && i < all_exprs.count(); i++) {
+    ObSEArray<const ObPythonUdfRawExpr *, 4> exprs;
+    if (OB_ISNULL(all_exprs.at(i))) {
+    } else if (OB_FAIL(collect_udf_exprs(all_exprs.at(i), exprs))) {
+      LOG_WARN("failed to collect python udf exprs", K(ret));
+    } else if (OB_FAIL(append_array_no_dup(udf_exprs, exprs))) {
+      LOG_WARN("failed to append python udf exprs", K(ret));
+    }
+  }
+  for (int64_t i = 0; OB_SUCC(ret) && i < udf_exprs.count(); i++) {
+    const ObPythonUdfRawExpr *udf = udf_exprs.at(i);
+    const ObString &name = udf->get_udf_meta().name_;
+    const char *fmt = NULL;
+    char buf[256];
+    int64_t pos = 0;
+    bool noted = false;
+    if (udf->is_const_expr() || share::schema::ObPythonUDF::TREES == udf->get_udf_meta().language_) {
+      // evaluated once, or scored natively
+    } else if (batch_size <= 0) {
+      fmt = PYTHON_UDF_ROW_MODE_BY_PLAN;
+    } else if (!udf->is_vectorize_result()) {
+      fmt = PYTHON_UDF_ROW_MODE_BY_ARGS;
+    }
+    if (NULL != fmt && (pos = snprintf(buf, sizeof(buf), fmt, name.length(), name.ptr())) > 0) {
+      const ObString note(std::min(pos, static_cast<int64_t>(sizeof(buf) - 1)), buf);
+      // notes of the explained plan are added again by its code generation
+      for (int64_t j = 0; !noted && j < opt_ctx.get_plan_notes().count(); j++) {
+        noted = 0 == opt_ctx.get_plan_notes().at(j).compare(note);
+      }
+      if (!noted) {
+        opt_ctx.add_plan_note(note);
+        LOG_TRACE("python udf is called row at a time", K(name), K(batch_size));
+      }
+    }
+  }
+  return ret;
+}
+
+double ObLogPythonUDF::get_udf_row_cost(const ObPythonUDFMeta &meta)
+{
+  double row_cost = DEFAULT_PREDICT_ROW_COST;
+  int64_t learned_size = 0;
+  double us_per_row = 0;
+  ObPyBatchSizeCache *cache = MTL(ObPyBatchSizeCache*);
+  if (NULL != cache
+      && OB_SUCCESS == cache->get(meta.udf_id_, meta.schema_version_, learned_size, us_per_row)
+      && us_per_row > 0) {
+    row_cost = us_per_row;
+  } else if (meta.row_cost_ > 0) {
+    row_cost = meta.row_cost_;
+  }
+  return row_cost;
+}
+
+double ObLogPythonUDF::get_expr_predict_cost(const ObRawExpr *expr)
+{
+  int ret = OB_SUCCESS;
+  double row_cost = 0;
+  ObSEArray<const ObPythonUdfRawExpr *, 2> udf_exprs;
+  if (OB_ISNULL(expr) || !ObTransformUtils::expr_contain_type(const_cast<ObRawExpr *>(expr),
+                                                               T_FUN_SYS_PYTHON_UDF)) {
+    // no inference
+  } else if (OB_FAIL(collect_udf_exprs(expr, udf_exprs))) {
+    LOG_WARN("failed to collect python udf exprs", K(ret));
+  } else {
+    for (int64_t i = 0; i < udf_exprs.count(); i++) {
+      row_cost += get_udf_row_cost(udf_exprs.at(i)->get_udf_meta());
+    }
+  }
+  return row_cost;
+}
+
+int ObLogPythonUDF::get_udf_selectivity(const ObRawExpr *qual, double &selectivity, bool &found)
+{
+  int ret = OB_SUCCESS;
+  ObSEArray<const ObPythonUdfRawExpr *, 2> udf_exprs;
+  ObPyBatchSizeCache *cache = MTL(ObPyBatchSizeCache*);
+  found = false;
+  if (OB_ISNULL(qual)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("get unexpected null", K(ret));
+  } else if (T_OP_AND == qual->get_expr_type() || T_OP_OR == qual->get_expr_type()
+             || T_OP_NOT == qual->get_expr_type()
+             || !ObTransformUtils::expr_contain_type(const_cast<ObRawExpr *>(qual),
+                                                     T_FUN_SYS_PYTHON_UDF)) {
+    // combined from the selectivity of the children
+  } else if (OB_FAIL(collect_udf_exprs(qual, udf_exprs))) {
+    LOG_WARN("failed to collect python udf exprs", K(ret));
+  } else if (1 != udf_exprs.count()) {
+    // statistics are kept for predicates on a single udf
+  } else {
+    const ObPythonUDFMeta &meta = udf_exprs.at(0)->get_udf_meta();
+    double learned_sel = 0;
+    if (NULL != cache
+        && OB_SUCCESS == cache->get_selectivity(meta.udf_id_, meta.schema_version_, learned_sel)) {
+      selectivity = learned_sel;
+      found = true;
+    } else if (meta.selectivity_ > 0) {
+      selectivity = meta.selectivity_;
+      found = true;
+    }
+  }
+  return ret;
+}
+
+int64_t ObLogPythonUDF::get_predict_dop(const double card, const int64_t max_dop) const
+{
+  const int64_t dop = static_cast<int64_t>(std::ceil(card * predict_row_cost_ / MIN_PREDICT_COST_PER_DOP));
+  return std::max(static_cast<int64_t>(1), std::min(max_dop, dop));
+}
+
+double ObLogPythonUDF::get_predict_cost(const double rows) const
+{
+  return rows * project_row_cost_ / std::max(static_cast<int64_t>(1), get_parallel());
+}
+
+int ObLogPythonUDF::re_est_cost(EstimateCostInfo &param, double &card, double &cost)
+{
+  int ret = OB_SUCCESS;
+  ObLogicalOperator *child = NULL;
+  const double old_card = get_card();
+  if (OB_FAIL(ObLogSubPlanScan::re_est_cost(param, card, cost))) {
+    LOG_WARN("failed to re est subplan scan cost", K(ret));
+  } else if (OB_ISNULL(child = get_child(ObLogicalOperator::first_child))) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("get unexpected null", K(ret));
+  } else {
+    // every input row is predicted, scaled down when only part of the output is needed,
+    // udfs in filters are in the filter cost of the subplan scan already
+    const double rows = old_card > 0 ? child->get_card() * std::min(1.0, card / old_card)
+                                     : child->get_card();
+    const double predict_cost = get_predict_cost(rows);
+    cost += predict_cost;
+    if (param.override_) {
+      set_op_cost(get_op_cost() + predict_cost);
+      set_cost(cost);
+    }
+  }
+  return ret;
+}
+
+int ObLogPythonUDF::add_predict_cost()
+{
+  int ret = OB_SUCCESS;
+  ObLogicalOperator *child = NULL;
+  if (OB_ISNULL(child = get_child(ObLogicalOperator::first_child))) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("get unexpected null", K(ret));
+  } else {
+    const double predict_cost = get_predict_cost(child->get_card());
+    set_op_cost(get_op_cost() + predict_cost);
+    set_cost(get_cost() + predict_cost);
+  }
+  return ret;
+}
+
+int ObLogPythonUDF::get_op_exprs(ObIArray<ObRawExpr*> &all_exprs)
+{
+  int ret = OB_SUCCESS;
+  if (NULL != limit_expr_ && OB_FAIL(all_exprs.push_back(limit_expr_))) {
+    LOG_WARN("failed to push back expr", K(ret));
+  } else if (OB_FAIL(ObLogSubPlanScan::get_op_exprs(all_exprs))) {
+    LOG_WARN("failed to get op exprs", K(ret));
+  } else { /*do nothing*/ }
+  return ret;
+}
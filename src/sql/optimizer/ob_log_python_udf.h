@@ -11,8 +11,17 @@ namespace sql
 class ObLogPythonUDF : public ObLogSubPlanScan
 {
 public:
+  // inference cost of a row in us of a udf nothing is learned for
+  static constexpr double DEFAULT_PREDICT_ROW_COST = 10.0;
+  // the least inference time in us worth a PX worker
+  static constexpr double MIN_PREDICT_COST_PER_DOP = 100000.0;
+
   ObLogPythonUDF(ObLogPlan &plan)
-      : ObLogSubPlanScan(plan)
+      : ObLogSubPlanScan(plan),
+        predict_row_cost_(0),
+        project_row_cost_(0),
+        predict_batch_rows_(0),
+        limit_expr_(NULL)
   {}
 
   ~ObLogPythonUDF() {};
@@ -22,9 +31,52 @@ public:
                                 
   virtual int collect_expr_metadata(ObRawExpr *expr,
                                     ObIArray<ObPythonUDFMeta> &metas);
-  
+
+  // inference cost per row and batch size of the python udfs in filters and projections, from
+  // the throughput learned by previous queries (ObPyBatchSizeCache) or the PREDICT_BATCH hint.
+  // Filters are costed with the quals, see ObOptEstCostModel::cost_quals()
+  int init_predict_cost(const ObIArray<ObRawExpr *> &filters,
+                        const ObIArray<ObRawExpr *> &projections);
+  // dop at which every worker predicts at least MIN_PREDICT_COST_PER_DOP
+  int64_t get_predict_dop(const double card, const int64_t max_dop) const;
+  double get_predict_row_cost() const { return predict_row_cost_; }
+  int64_t get_predict_batch_rows() const { return predict_batch_rows_; }
+  // filter cost of the subplan scan plus the inference of the input rows
+  virtual int re_est_cost(EstimateCostInfo &param, double &card, double &cost) override;
+  // called once the operator is allocated, compute_property() takes the cost of the subquery path
+  int add_predict_cost();
+  // rows the limit above needs, limit + offset. The operator stops reading ahead of them, the
+  // limit itself stays on top
+  void set_limit_expr(ObRawExpr *limit_expr) { limit_expr_ = limit_expr; }
+  ObRawExpr *get_limit_expr() const { return limit_expr_; }
+  virtual int get_op_exprs(ObIArray<ObRawExpr*> &all_exprs) override;
+
+  // python udf exprs in expr, a python udf in the args of another one included
+  static int collect_udf_exprs(const ObRawExpr *expr,
+                               ObIArray<const ObPythonUdfRawExpr *> &udf_exprs);
+  // inference cost per row in us of a python udf: learned by previous queries, else declared
+  // by the COST option of CREATE PYTHON_UDF, else DEFAULT_PREDICT_ROW_COST
+  static double get_udf_row_cost(const ObPythonUDFMeta &meta);
+  // inference cost per row of all python udfs in expr, 0 without python udf
+  static double get_expr_predict_cost(const ObRawExpr *expr);
+  // selectivity of a predicate on a single python udf: observed by previous queries, else
+  // declared by the SELECTIVITY option of CREATE PYTHON_UDF. found is false if unknown
+  static int get_udf_selectivity(const ObRawExpr *qual, double &selectivity, bool &found);
+  // python udfs of the plan still called row at a time at batch_size, as plan notes. Args that
+  // are not batch results are broadcast to the rows of a batch, rows are only left alone
+  // without vectorization or when no arg varies within a batch, e.g. a udf of the outer
+  // columns of a nested loop join, evaluated at every rescan
+  static int add_row_mode_notes(ObOptimizerContext &opt_ctx, const int64_t batch_size);
+
+private:
+  double get_predict_cost(const double rows) const;
+
 private:
   ObSEArray<ObPythonUDFMeta, 4> metas;
+  double predict_row_cost_; // of all udfs, sizes the dop
+  double project_row_cost_; // of udfs out of filters, costed by the operator
+  int64_t predict_batch_rows_;
+  ObRawExpr *limit_expr_;
   DISALLOW_COPY_AND_ASSIGN(ObLogPythonUDF);
 };
 
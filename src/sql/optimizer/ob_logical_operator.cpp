@@ -28,6 +28,7 @@
 #include "ob_log_set.h"
 #include "ob_log_sort.h"
 #include "ob_log_subplan_scan.h"
+#include "ob_log_python_udf.h"
 #include "ob_log_table_scan.h"
 #include "ob_log_limit.h"
 #include "ob_log_window_function.h"
@@ -193,6 +194,8 @@ int ObExchangeInfo::assign(ObExchangeInfo &other)
     null_row_dist_method_ = other.null_row_dist_method_;
     slave_mapping_type_ = other.slave_mapping_type_;
     strong_sharding_ = other.strong_sharding_;
+    parallel_ = other.parallel_;
+    random_chunk_rows_ = other.random_chunk_rows_;
   }
   return ret;
 }
@@ -432,6 +435,11 @@ double FilterCompare::get_selectivity(ObRawExpr *expr)
   return selectivity;
 }
 
+double FilterCompare::get_rank(ObRawExpr *expr)
+{
+  return (get_selectivity(expr) - 1) / (QUAL_ROW_COST + ObLogPythonUDF::get_expr_predict_cost(expr));
+}
+
 // Add a child to the end of the array
 int ObLogicalOperator::add_child(ObLogicalOperator *child_op)
 {
@@ -2152,7 +2160,20 @@ int ObLogicalOperator::reorder_filter_exprs()
     LOG_WARN("Get unexpeced null", K(ret), K(get_plan()));
   } else {
     FilterCompare filter_compare(get_plan()->get_predicate_selectivities());
-    std::sort(filter_exprs_.begin(), filter_exprs_.end(), filter_compare);
+    ObSEArray<FilterCompare::RankedFilter, 8> ranked_filters;
+    for (int64_t i = 0; OB_SUCC(ret) && i < filter_exprs_.count(); i++) {
+      ObRawExpr *expr = filter_exprs_.at(i);
+      if (OB_FAIL(ranked_filters.push_back(
+                  FilterCompare::RankedFilter(filter_compare.get_rank(expr), expr)))) {
+        LOG_WARN("failed to push back ranked filter", K(ret));
+      }
+    }
+    if (OB_SUCC(ret)) {
+      std::sort(ranked_filters.begin(), ranked_filters.end(), filter_compare);
+      for (int64_t i = 0; i < ranked_filters.count(); i++) {
+        filter_exprs_.at(i) = ranked_filters.at(i).second;
+      }
+    }
   }
   return ret;
 }
@@ -258,15 +258,23 @@ struct partition_location
 
 struct FilterCompare
 {
+  typedef std::pair<double, ObRawExpr *> RankedFilter;
   FilterCompare(common::ObIArray<ObExprSelPair> &predicate_selectivities)
       : predicate_selectivities_(predicate_selectivities)
   {
   }
-  bool operator()(ObRawExpr *left, ObRawExpr *right)
+  // evaluation cost per row of a qual without python udf, in us
+  static constexpr double QUAL_ROW_COST = 0.1;
+  // ranks are computed once before sorting, the learned python udf costs behind them are
+  // updated by other sessions and must not change during the sort
+  bool operator()(const RankedFilter &left, const RankedFilter &right) const
   {
-    return (get_selectivity(left) < get_selectivity(right));
+    return (left.first < right.first);
   }
   double get_selectivity(ObRawExpr *expr);
+  // (selectivity - 1) / cost per row, cheap and selective quals first. Without python udf
+  // the cost is the same and the quals are in the order of their selectivity
+  double get_rank(ObRawExpr *expr);
 
   common::ObIArray<ObExprSelPair> &predicate_selectivities_;
 };
@@ -447,7 +455,9 @@ struct ObExchangeInfo
     wf_hybrid_aggr_status_expr_(NULL),
     wf_hybrid_pby_exprs_cnt_array_(),
     may_add_interval_part_(MayAddIntervalPart::NO),
-    sample_type_(NOT_INIT_SAMPLE_TYPE)
+    sample_type_(NOT_INIT_SAMPLE_TYPE),
+    parallel_(0),
+    random_chunk_rows_(1)
   {
     repartition_table_id_ = 0;
   }
@@ -507,6 +517,10 @@ struct ObExchangeInfo
   MayAddIntervalPart may_add_interval_part_;
   // sample type for range distribution or partition range distribution
   ObPxSampleType sample_type_;
+  // dop of the consumer, 0 for the dop of the producer
+  int64_t parallel_;
+  // for random distribution, consecutive rows sent to the same consumer
+  int64_t random_chunk_rows_;
 
   TO_STRING_KV(K_(is_remote),
                K_(is_task_order),
@@ -530,7 +544,9 @@ struct ObExchangeInfo
                K_(is_wf_hybrid),
                K_(wf_hybrid_pby_exprs_cnt_array),
                K_(may_add_interval_part),
-               K_(sample_type));
+               K_(sample_type),
+               K_(parallel),
+               K_(random_chunk_rows));
 private:
   DISALLOW_COPY_AND_ASSIGN(ObExchangeInfo);
 };
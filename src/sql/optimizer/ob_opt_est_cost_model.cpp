@@ -19,6 +19,7 @@
 #include "sql/optimizer/ob_join_order.h"
 #include "sql/optimizer/ob_optimizer.h"
 #include "sql/optimizer/ob_opt_selectivity.h"
+#include "sql/optimizer/ob_log_python_udf.h"
 #include <math.h>
 using namespace oceanbase::common;
 using namespace oceanbase::share;
@@ -2178,7 +2179,9 @@ double ObOptEstCostModel::cost_quals(double rows, const ObIArray<ObRawExpr *> &q
       if (OB_UNLIKELY(comparison_params_[calc_type] < 0)) {
         LOG_WARN_RET(OB_NOT_SUPPORTED, "comparison type not supported, skipped", K(calc_type));
       } else {
-        cost_per_row += comparison_params_[calc_type] * factor;
+        // python udf inference dominates the comparison
+        cost_per_row += (comparison_params_[calc_type]
+                         + ObLogPythonUDF::get_expr_predict_cost(qual)) * factor;
         if (need_scale) {
           factor /= 10.0;
         }
@@ -27,6 +27,7 @@
 #include "share/stat/ob_opt_column_stat_cache.h"
 #include "sql/optimizer/ob_logical_operator.h"
 #include "sql/optimizer/ob_join_order.h"
+#include "sql/optimizer/ob_log_python_udf.h"
 #include "common/ob_smart_call.h"
 
 using namespace oceanbase::common;
@@ -645,8 +646,13 @@ int ObOptSelectivity::calculate_qual_selectivity(const OptTableMetas &table_meta
                                                  ObIArray<ObExprSelPair> &all_predicate_sel)
 {
   int ret = OB_SUCCESS;
+  bool is_udf_sel = false;
   selectivity = 1.0;
-  if (qual.has_flag(CNT_AGG)) {
+  if (OB_FAIL(ObLogPythonUDF::get_udf_selectivity(&qual, selectivity, is_udf_sel))) {
+    LOG_WARN("failed to get python udf selectivity", K(ret), K(qual));
+  } else if (is_udf_sel) {
+    // observed by previous queries or declared at CREATE PYTHON_UDF
+  } else if (qual.has_flag(CNT_AGG)) {
     if (OB_FAIL(get_agg_sel(table_metas, ctx, qual, selectivity))) {
       LOG_WARN("failed to get agg expr selectivity", K(ret), K(qual));
     }
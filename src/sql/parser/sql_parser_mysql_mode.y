@@ -153,6 +153,7 @@ FROZEN_VERSION TOPK QUERY_TIMEOUT READ_CONSISTENCY LOG_LEVEL USE_PLAN_CACHE
 TRACE_LOG LOAD_BATCH_SIZE TRANS_PARAM OPT_PARAM OB_DDL_SCHEMA_VERSION FORCE_REFRESH_LOCATION_CACHE
 DISABLE_PARALLEL_DML ENABLE_PARALLEL_DML MONITOR NO_PARALLEL CURSOR_SHARING_EXACT
 MAX_CONCURRENT DOP TRACING NO_QUERY_TRANSFORMATION NO_COST_BASED_QUERY_TRANSFORMATION
+PREDICT_BATCH
 // transform hint
 NO_REWRITE MERGE_HINT NO_MERGE_HINT NO_EXPAND USE_CONCAT UNNEST NO_UNNEST
 PLACE_GROUP_BY NO_PLACE_GROUP_BY INLINE MATERIALIZE SEMI_TO_INNER NO_SEMI_TO_INNER
@@ -499,6 +500,7 @@ END_P SET_VAR DELIMITER
 /*新增*/ 
 %type <node> create_python_udf_stmt drop_python_udf_stmt
 %type <node> function_element_list function_element param_name param_type
+%type <node> opt_python_udf_option_list python_udf_option_list python_udf_option python_udf_option_value
 %start sql_stmt
 %%
 ////////////////////////////////////////////////////////////////
@@ -4413,18 +4415,65 @@ NUMERIC
 ;
 
 create_python_udf_stmt:
-CREATE PYTHON_UDF NAME_OB '(' function_element_list ')' RETURNS ret_type '{' STRING_VALUE '}'
+CREATE PYTHON_UDF NAME_OB '(' function_element_list ')' RETURNS ret_type opt_python_udf_option_list '{' STRING_VALUE '}'
 {
   ParseNode *function_elements = NULL;
   merge_nodes(function_elements, result, T_FUNCTION_ELEMENT_LIST, $5);
-  malloc_non_terminal_node($$, result->malloc_pool_, T_CREATE_PYTHON_UDF, 4, 
+  malloc_non_terminal_node($$, result->malloc_pool_, T_CREATE_PYTHON_UDF, 5, 
                            $3,                             /* udf name */
                            function_elements,              /* function parameter */
                            $8,                             /* return type */
-                           $10);                           /* python code */
+                           $11,                            /* python code */
+                           $9);                            /* udf options */
 }
 ;
 
+opt_python_udf_option_list:
+python_udf_option_list
+{
+  merge_nodes($$, result, T_PYTHON_UDF_OPTION_LIST, $1);
+}
+| /*EMPTY*/
+{
+  $$ = NULL;
+}
+;
+
+python_udf_option_list:
+python_udf_option
+{
+  $$ = $1;
+}
+| python_udf_option_list opt_comma python_udf_option
+{
+  malloc_non_terminal_node($$, result->malloc_pool_, T_LINK_NODE, 2, $1, $3);
+}
+;
+
+python_udf_option:
+relation_name opt_equal_mark python_udf_option_value
+{
+  (void)($2);
+  malloc_non_terminal_node($$, result->malloc_pool_, T_PYTHON_UDF_OPTION, 2, $1, $3);
+}
+| DETERMINISTIC
+{
+  ParseNode *name_node = NULL;
+  ParseNode *value_node = NULL;
+  make_name_node(name_node, result->malloc_pool_, "DETERMINISTIC");
+  malloc_terminal_node(value_node, result->malloc_pool_, T_BOOL);
+  value_node->value_ = 1;
+  malloc_non_terminal_node($$, result->malloc_pool_, T_PYTHON_UDF_OPTION, 2, name_node, value_node);
+}
+;
+
+python_udf_option_value:
+STRING_VALUE { $$ = $1; }
+| INTNUM { $$ = $1; }
+| DECIMAL_VAL { $$ = $1; }
+| NAME_OB { $$ = $1; }
+;
+
 drop_python_udf_stmt:
 DROP PYTHON_UDF opt_if_exists NAME_OB
 {
@@ -8491,6 +8540,11 @@ READ_CONSISTENCY '(' consistency_level ')'
 {
   malloc_non_terminal_node($$, result->malloc_pool_, T_DOP, 2, $3, $5);
 }
+| PREDICT_BATCH '(' relation_name opt_comma INTNUM ')'
+{
+  (void) $4;
+  malloc_non_terminal_node($$, result->malloc_pool_, T_PREDICT_BATCH, 2, $3, $5);
+}
 | TRANS_PARAM '(' trans_param_name opt_comma trans_param_value ')'
 {
   (void) $4;
@@ -12,6 +12,7 @@
 
 #define USING_LOG_PREFIX SQL_RESV
 #include "sql/resolver/ddl/ob_create_python_udf_resolver.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_tree_model.h"
 
 namespace oceanbase
 {
@@ -33,7 +34,7 @@ int ObCreatePythonUdfResolver::resolve(const ParseNode &parse_tree)
     ParseNode *create_python_udf_node = const_cast<ParseNode*>(&parse_tree);
     if (OB_ISNULL(create_python_udf_node)
         || T_CREATE_PYTHON_UDF != create_python_udf_node->type_
-        || 4 != create_python_udf_node->num_child_         //语法树根节点的孩子数不正确
+        || 5 != create_python_udf_node->num_child_         //语法树根节点的孩子数不正确
         || OB_ISNULL(create_python_udf_node->children_)) {
       ret = OB_INVALID_ARGUMENT;
       SQL_RESV_LOG(WARN, "invalid argument.", K(ret));
@@ -59,6 +60,7 @@ int ObCreatePythonUdfResolver::resolve(const ParseNode &parse_tree)
         create_python_udf_arg.python_udf_.set_arg_num(arg_num);
         std::string arg_names = "";
         std::string arg_types = "";
+        bool numeric_args = true;
         for (int32_t i = 0; i < arg_num; ++i) {
             //T_PARAM_DEFINITION
             ParseNode *element = function_element_list_node->children_[i];
@@ -70,6 +72,7 @@ int ObCreatePythonUdfResolver::resolve(const ParseNode &parse_tree)
             if (i != arg_num - 1) arg_names += ",";
             //get arg type
             ParseNode *type_node = element->children_[1];
+            numeric_args = numeric_args && (2 == type_node->value_ || 3 == type_node->value_);
             switch (type_node->value_) {
                 case 1:
                     arg_types += "STRING";
@@ -109,10 +112,193 @@ int ObCreatePythonUdfResolver::resolve(const ParseNode &parse_tree)
         create_python_udf_arg.python_udf_.set_pycall(ObString(create_python_udf_node->children_[3]->str_len_, create_python_udf_node->children_[3]->str_value_));
         //set tenant_id
         create_python_udf_arg.python_udf_.set_tenant_id(params_.session_info_->get_effective_tenant_id());
+        //set udf options
+        if (OB_FAIL(resolve_udf_options(create_python_udf_node->children_[4],
+                                        create_python_udf_arg.python_udf_))) {
+          LOG_WARN("failed to resolve python udf options", K(ret));
+        } else if (schema::ObPythonUDF::TREES == create_python_udf_arg.python_udf_.get_language()
+                   && OB_FAIL(check_tree_udf(create_python_udf_arg.python_udf_, numeric_args))) {
+          LOG_WARN("invalid tree model udf", K(ret));
+        } else if (schema::ObPythonUDF::ARROW == create_python_udf_arg.python_udf_.get_batch_format()
+                   && schema::ObPythonUDF::WORKER == create_python_udf_arg.python_udf_.get_exec_mode()) {
+          // batches of the worker protocol are numpy arrays
+          ret = OB_NOT_SUPPORTED;
+          LOG_WARN("arrow batch format in python worker", K(ret));
+          LOG_USER_ERROR(OB_NOT_SUPPORTED, "BATCH_FORMAT ARROW with EXECUTION WORKER");
+        } else if (schema::ObPythonUDF::POSITIONAL != create_python_udf_arg.python_udf_.get_arg_passing()
+                   && (schema::ObPythonUDF::ARROW == create_python_udf_arg.python_udf_.get_batch_format()
+                       || schema::ObPythonUDF::WORKER == create_python_udf_arg.python_udf_.get_exec_mode())) {
+          // a record batch and the worker protocol carry full columns only
+          ret = OB_NOT_SUPPORTED;
+          LOG_WARN("arg passing with arrow batch format or python worker", K(ret));
+          LOG_USER_ERROR(OB_NOT_SUPPORTED, "ARG_PASSING with BATCH_FORMAT ARROW or EXECUTION WORKER");
+        }
       }
     }            
     return ret;
 }
 
+int ObCreatePythonUdfResolver::resolve_udf_options(const ParseNode *option_list_node,
+                                                   schema::ObPythonUDF &python_udf)
+{
+  int ret = OB_SUCCESS;
+  if (NULL == option_list_node) {
+    // no option
+  } else if (OB_UNLIKELY(T_PYTHON_UDF_OPTION_LIST != option_list_node->type_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("unexpected option list node", K(ret), K(option_list_node->type_));
+  } else {
+    for (int64_t i = 0; OB_SUCC(ret) && i < option_list_node->num_child_; ++i) {
+      const ParseNode *option_node = option_list_node->children_[i];
+      if (OB_ISNULL(option_node)
+          || OB_UNLIKELY(T_PYTHON_UDF_OPTION != option_node->type_ || 2 != option_node->num_child_)
+          || OB_ISNULL(option_node->children_[0]) || OB_ISNULL(option_node->children_[1])) {
+        ret = OB_ERR_UNEXPECTED;
+        LOG_WARN("unexpected option node", K(ret), K(i));
+      } else if (OB_FAIL(resolve_udf_option(*option_node, python_udf))) {
+        LOG_WARN("failed to resolve python udf option", K(ret), K(i));
+      }
+    }
+  }
+  return ret;
+}
+
+int ObCreatePythonUdfResolver::resolve_udf_option(const ParseNode &option_node,
+                                                  schema::ObPythonUDF &python_udf)
+{
+  int ret = OB_SUCCESS;
+  const ParseNode *name_node = option_node.children_[0];
+  const ParseNode *value_node = option_node.children_[1];
+  const ObString name(name_node->str_len_, name_node->str_value_);
+  const ObString str_value(value_node->str_len_, value_node->str_value_);
+  if (0 == name.case_compare("EXECUTION")) {
+    if (T_VARCHAR != value_node->type_) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_USER_ERROR(OB_INVALID_ARGUMENT, "EXECUTION, expect 'EMBEDDED' or 'WORKER'");
+    } else if (0 == str_value.case_compare("EMBEDDED")) {
+      python_udf.set_exec_mode(schema::ObPythonUDF::EMBEDDED);
+    } else if (0 == str_value.case_compare("WORKER")) {
+      python_udf.set_exec_mode(schema::ObPythonUDF::WORKER);
+    } else {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_USER_ERROR(OB_INVALID_ARGUMENT, "EXECUTION, expect 'EMBEDDED' or 'WORKER'");
+    }
+  } else if (0 == name.case_compare("COST")) {
+    // inference time per row in microseconds
+    double row_cost = 0;
+    if (OB_FAIL(resolve_number_option(*value_node, row_cost)) || row_cost <= 0) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_USER_ERROR(OB_INVALID_ARGUMENT, "COST, expect a positive number of microseconds per row");
+    } else {
+      python_udf.set_row_cost(row_cost);
+    }
+  } else if (0 == name.case_compare("SELECTIVITY")) {
+    double selectivity = 0;
+    if (OB_FAIL(resolve_number_option(*value_node, selectivity))
+        || selectivity <= 0 || selectivity > 1) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_USER_ERROR(OB_INVALID_ARGUMENT, "SELECTIVITY, expect a number in (0, 1]");
+    } else {
+      python_udf.set_selectivity(selectivity);
+    }
+  } else if (0 == name.case_compare("DETERMINISTIC")) {
+    // results of the udf may be cached across queries
+    if (OB_UNLIKELY(T_BOOL != value_node->type_)) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_USER_ERROR(OB_INVALID_ARGUMENT, "DETERMINISTIC, expect no value");
+    } else {
+      python_udf.set_deterministic(0 != value_node->value_);
+    }
+  } else if (0 == name.case_compare("LANGUAGE")) {
+    // PYTHON code or a TREES model dump scored without python
+    if (T_VARCHAR != value_node->type_ && T_IDENT != value_node->type_) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_USER_ERROR(OB_INVALID_ARGUMENT, "LANGUAGE, expect PYTHON or TREES");
+    } else if (0 == str_value.case_compare("PYTHON")) {
+      python_udf.set_language(schema::ObPythonUDF::PYTHON);
+    } else if (0 == str_value.case_compare("TREES")) {
+      python_udf.set_language(schema::ObPythonUDF::TREES);
+    } else {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_USER_ERROR(OB_INVALID_ARGUMENT, "LANGUAGE, expect PYTHON or TREES");
+    }
+  } else if (0 == name.case_compare("BATCH_FORMAT")) {
+    // NUMPY arrays or an ARROW record batch passed to pyfun
+    if (T_VARCHAR != value_node->type_ && T_IDENT != value_node->type_) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_USER_ERROR(OB_INVALID_ARGUMENT, "BATCH_FORMAT, expect NUMPY or ARROW");
+    } else if (0 == str_value.case_compare("NUMPY")) {
+      python_udf.set_batch_format(schema::ObPythonUDF::NUMPY);
+    } else if (0 == str_value.case_compare("ARROW")) {
+      python_udf.set_batch_format(schema::ObPythonUDF::ARROW);
+    } else {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_USER_ERROR(OB_INVALID_ARGUMENT, "BATCH_FORMAT, expect NUMPY or ARROW");
+    }
+  } else if (0 == name.case_compare("ARG_PASSING")) {
+    // POSITIONAL arrays, BROADCAST constant args as 0-d arrays or KEYWORD args with constant
+    // args as python scalars
+    if (T_VARCHAR != value_node->type_ && T_IDENT != value_node->type_) {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_USER_ERROR(OB_INVALID_ARGUMENT, "ARG_PASSING, expect POSITIONAL, BROADCAST or KEYWORD");
+    } else if (0 == str_value.case_compare("POSITIONAL")) {
+      python_udf.set_arg_passing(schema::ObPythonUDF::POSITIONAL);
+    } else if (0 == str_value.case_compare("BROADCAST")) {
+      python_udf.set_arg_passing(schema::ObPythonUDF::BROADCAST);
+    } else if (0 == str_value.case_compare("KEYWORD")) {
+      python_udf.set_arg_passing(schema::ObPythonUDF::KEYWORD);
+    } else {
+      ret = OB_INVALID_ARGUMENT;
+      LOG_USER_ERROR(OB_INVALID_ARGUMENT, "ARG_PASSING, expect POSITIONAL, BROADCAST or KEYWORD");
+    }
+  } else {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("unknown python udf option", K(ret), K(name));
+    LOG_USER_ERROR(OB_INVALID_ARGUMENT, "python udf option");
+  }
+  return ret;
+}
+
+int ObCreatePythonUdfResolver::resolve_number_option(const ParseNode &value_node, double &value)
+{
+  int ret = OB_SUCCESS;
+  char *endptr = NULL;
+  int err = 0;
+  if (T_INT != value_node.type_ && T_NUMBER != value_node.type_) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("python udf option expects a number", K(ret), K(value_node.type_));
+  } else if (FALSE_IT(value = ObCharset::strntod(value_node.str_value_, value_node.str_len_,
+                                                 &endptr, &err))) {
+  } else if (OB_UNLIKELY(0 != err)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("invalid number", K(ret), K(err), K(ObString(value_node.str_len_, value_node.str_value_)));
+  }
+  return ret;
+}
+
+int ObCreatePythonUdfResolver::check_tree_udf(const schema::ObPythonUDF &python_udf,
+                                              const bool numeric_args)
+{
+  int ret = OB_SUCCESS;
+  ObArenaAllocator tmp_alloc("PyTreeModel");
+  ObPyTreeModel model;
+  if (schema::ObPythonUDF::REAL != python_udf.get_ret() || !numeric_args) {
+    ret = OB_NOT_SUPPORTED;
+    LOG_WARN("tree model udf takes numbers and returns a real", K(ret), K(python_udf));
+    LOG_USER_ERROR(OB_NOT_SUPPORTED, "LANGUAGE TREES udf with args not INTEGER or REAL or return type not REAL");
+  } else if (OB_FAIL(model.init(tmp_alloc, python_udf.get_pycall_str()))) {
+    LOG_WARN("fail to parse tree model dump", K(ret), K(python_udf.get_name_str()));
+    if (OB_INVALID_ARGUMENT == ret) {
+      LOG_USER_ERROR(OB_INVALID_ARGUMENT, "LANGUAGE TREES, expect a xgboost or lightgbm json dump");
+    }
+  } else if (model.get_feature_cnt() > python_udf.get_arg_num()) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("tree model uses more features than args", K(ret), K(model),
+             K(python_udf.get_arg_num()));
+    LOG_USER_ERROR(OB_INVALID_ARGUMENT, "LANGUAGE TREES, model uses more features than args");
+  }
+  return ret;
+}
+
 }
 }
\ No newline at end of file
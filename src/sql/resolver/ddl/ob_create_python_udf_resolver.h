@@ -30,6 +30,15 @@ public:
   virtual ~ObCreatePythonUdfResolver();
 
   virtual int resolve(const ParseNode &parse_tree);
+
+private:
+  // options between RETURNS and the python code, e.g. EXECUTION = 'WORKER'
+  int resolve_udf_options(const ParseNode *option_list_node, share::schema::ObPythonUDF &python_udf);
+  int resolve_udf_option(const ParseNode &option_node, share::schema::ObPythonUDF &python_udf);
+  // INTNUM or DECIMAL_VAL, e.g. COST = 120, SELECTIVITY = 0.05
+  int resolve_number_option(const ParseNode &value_node, double &value);
+  // a LANGUAGE TREES udf takes numbers, returns a REAL and its code is a model dump
+  int check_tree_udf(const share::schema::ObPythonUDF &python_udf, const bool numeric_args);
 };
 
 }
@@ -21,6 +21,7 @@
 #include "sql/resolver/dml/ob_merge_stmt.h"
 #include "sql/resolver/dml/ob_insert_all_stmt.h"
 #include "sql/rewrite/ob_transform_utils.h"
+#include "sql/engine/expr/ob_expr_column_conv.h"
 #include "sql/resolver/ob_stmt_type.h"
 #include "pl/ob_pl_resolver.h"
 #include "sql/parser/parse_malloc.h"
@@ -722,6 +723,10 @@ int ObDelUpdResolver::add_assignment(common::ObIArray<ObTableAssignment> &assign
       LOG_WARN("failed to copy on replace expr", K(ret));
     }
   }
+  if (OB_SUCC(ret) && assign.is_implicit_ && assign.column_expr_->is_stored_generated_column()
+      && OB_FAIL(keep_unchanged_python_udf_column(*table_assign, assign))) {
+    LOG_WARN("failed to keep unchanged python udf column", K(ret));
+  }
   bool found = false;
   if (OB_SUCC(ret)) {
     if (get_stmt()->get_query_ctx()->is_prepare_stmt()) {
@@ -745,6 +750,69 @@ int ObDelUpdResolver::add_assignment(common::ObIArray<ObTableAssignment> &assign
   return ret;
 }
 
+// A stored generated column computed by a python udf is updated with
+//   CASE WHEN dep1 <=> new_dep1 AND ... THEN column ELSE udf(new_dep1, ...) END
+// so that the rows whose updated cascaded columns keep their value do not call the udf.
+int ObDelUpdResolver::keep_unchanged_python_udf_column(const ObTableAssignment &table_assign,
+                                                       ObAssignment &assign)
+{
+  int ret = OB_SUCCESS;
+  ObRawExpr *value_expr = NULL;
+  ObSEArray<ObRawExpr *, 4> dep_columns;
+  ObSEArray<ObRawExpr *, 4> unchanged_conds;
+  if (OB_ISNULL(params_.expr_factory_) || OB_ISNULL(assign.column_expr_)
+      || OB_ISNULL(assign.expr_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("get unexpected null", K(ret), K(params_.expr_factory_), K(assign));
+  } else if (T_FUN_COLUMN_CONV != assign.expr_->get_expr_type()
+             || assign.expr_->get_param_count() <= ObExprColumnConv::VALUE_EXPR) {
+    // wrapped for trigger
+  } else if (OB_ISNULL(value_expr = assign.expr_->get_param_expr(ObExprColumnConv::VALUE_EXPR))) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("column conv value is null", K(ret), KPC(assign.expr_));
+  } else if (!ObTransformUtils::expr_contain_type(value_expr, T_FUN_SYS_PYTHON_UDF)) {
+    // do nothing
+  } else if (OB_FAIL(ObRawExprUtils::extract_column_exprs(assign.column_expr_->get_dependant_expr(),
+                                                          dep_columns))) {
+    LOG_WARN("failed to extract dependant columns", K(ret));
+  }
+  for (int64_t i = 0; OB_SUCC(ret) && !dep_columns.empty()
+                      && i < table_assign.assignments_.count(); ++i) {
+    const ObAssignment &dep_assign = table_assign.assignments_.at(i);
+    ObRawExpr *cond = NULL;
+    if (!ObOptimizerUtil::find_item(dep_columns, dep_assign.column_expr_)) {
+      // do nothing
+    } else if (OB_FAIL(ObRawExprUtils::build_common_binary_op_expr(*params_.expr_factory_,
+                                                                   T_OP_NSEQ,
+                                                                   dep_assign.column_expr_,
+                                                                   dep_assign.expr_,
+                                                                   cond))) {
+      LOG_WARN("failed to build null safe equal expr", K(ret));
+    } else if (OB_FAIL(unchanged_conds.push_back(cond))) {
+      LOG_WARN("failed to push back", K(ret));
+    }
+  }
+  if (OB_SUCC(ret) && !unchanged_conds.empty()) {
+    ObRawExpr *when_expr = NULL;
+    ObRawExpr *case_expr = NULL;
+    if (OB_FAIL(ObRawExprUtils::build_and_expr(*params_.expr_factory_, unchanged_conds,
+                                               when_expr))) {
+      LOG_WARN("failed to build and expr", K(ret));
+    } else if (OB_FAIL(ObRawExprUtils::build_case_when_expr(*params_.expr_factory_,
+                                                            when_expr,
+                                                            assign.column_expr_,
+                                                            value_expr,
+                                                            case_expr))) {
+      LOG_WARN("failed to build case when expr", K(ret));
+    } else if (OB_FAIL(case_expr->formalize(session_info_))) {
+      LOG_WARN("failed to formalize case when expr", K(ret));
+    } else {
+      assign.expr_->get_param_expr(ObExprColumnConv::VALUE_EXPR) = case_expr;
+    }
+  }
+  return ret;
+}
+
 int ObDelUpdResolver::check_need_assignment(const common::ObIArray<ObAssignment> &assigns,
                                             uint64_t table_id,
                                             bool before_update_row_trigger_exist,
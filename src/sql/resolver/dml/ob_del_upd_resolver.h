@@ -76,6 +76,8 @@ protected:
                              const TableItem *table_item,
                              const ColumnItem *col_item,
                              ObAssignment &assign);
+  int keep_unchanged_python_udf_column(const ObTableAssignment &table_assign,
+                                       ObAssignment &assign);
   int check_need_assignment(const common::ObIArray<ObAssignment> &assigns,
                             uint64_t table_id,
                             bool before_update_row_trigger_exist,
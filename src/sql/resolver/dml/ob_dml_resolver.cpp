@@ -11780,6 +11780,17 @@ int ObDMLResolver::resolve_global_hint(const ParseNode &hint_node,
       }
       break;
     }
+    case T_PREDICT_BATCH: {
+      CHECK_HINT_PARAM(hint_node, 2) {
+        if (child1->value_ <= 0) {
+          LOG_TRACE("ignore invalid predict batch hint", K(child1->value_));
+        } else if (OB_FAIL(global_hint.merge_predict_batch_hint(
+                       ObString(child0->str_len_, child0->str_value_), child1->value_))) {
+          LOG_WARN("Failed to add predict batch hint", K(ret));
+        }
+      }
+      break;
+    }
     case T_CURSOR_SHARING_EXACT: {
       global_hint.merge_param_option_hint(ObParamOption::EXACT);
       break;
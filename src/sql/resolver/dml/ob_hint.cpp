@@ -115,6 +115,49 @@ int ObGlobalHint::merge_dop_hint(const ObIArray<ObDopHint> &dop_hints)
   return ret;
 }
 
+int ObGlobalHint::merge_predict_batch_hint(const ObString &udf_name, int64_t batch_size)
+{
+  int ret = OB_SUCCESS;
+  bool find = false;
+  for (int64_t i = 0; !find && i < predict_batches_.count(); ++i) {
+    // the first hint of a udf wins
+    find = 0 == predict_batches_.at(i).udf_name_.case_compare(udf_name);
+  }
+  if (!find) {
+    ObPredictBatchHint hint;
+    hint.udf_name_ = udf_name;
+    hint.batch_size_ = batch_size;
+    if (OB_FAIL(predict_batches_.push_back(hint))) {
+      LOG_WARN("Failed to push back predict batch", K(ret));
+    }
+  }
+  LOG_DEBUG("add predict batch hint", K(predict_batches_));
+  return ret;
+}
+
+int ObGlobalHint::merge_predict_batch_hint(const ObIArray<ObPredictBatchHint> &predict_batch_hints)
+{
+  int ret = OB_SUCCESS;
+  for (int64_t i = 0; OB_SUCC(ret) && i < predict_batch_hints.count(); ++i) {
+    if (OB_FAIL(merge_predict_batch_hint(predict_batch_hints.at(i).udf_name_,
+                                         predict_batch_hints.at(i).batch_size_))) {
+      LOG_WARN("failed to add predict batch hint", K(predict_batches_));
+    }
+  }
+  return ret;
+}
+
+int64_t ObGlobalHint::get_predict_batch_hint(const ObString &udf_name) const
+{
+  int64_t batch_size = 0;
+  for (int64_t i = 0; 0 == batch_size && i < predict_batches_.count(); ++i) {
+    if (0 == predict_batches_.at(i).udf_name_.case_compare(udf_name)) {
+      batch_size = predict_batches_.at(i).batch_size_;
+    }
+  }
+  return batch_size;
+}
+
 void ObGlobalHint::merge_query_timeout_hint(int64_t hint_time)
 {
   if (hint_time > 0) {
@@ -272,6 +315,7 @@ bool ObGlobalHint::has_hint_exclude_concurrent() const
          || ObParamOption::NOT_SPECIFIED != param_option_
          || !monitoring_ids_.empty()
          || !dops_.empty()
+         || !predict_batches_.empty()
          || !opt_params_.empty()
          || !ob_ddl_schema_versions_.empty();
 }
@@ -297,6 +341,7 @@ void ObGlobalHint::reset()
   param_option_ = ObParamOption::NOT_SPECIFIED;
   monitoring_ids_.reuse();
   dops_.reuse();
+  predict_batches_.reuse();
   opt_features_version_ = UNSET_OPT_FEATURES_VERSION;
   disable_transform_ = false;
   disable_cost_based_transform_ = false;
@@ -335,6 +380,8 @@ int ObGlobalHint::merge_global_hint(const ObGlobalHint &other)
     LOG_WARN("failed to merge monitor hints", K(ret));
   } else if (OB_FAIL(merge_dop_hint(other.dops_))) {
     LOG_WARN("failed to merge dop hints", K(ret));
+  } else if (OB_FAIL(merge_predict_batch_hint(other.predict_batches_))) {
+    LOG_WARN("failed to merge predict batch hints", K(ret));
   } else if (OB_FAIL(opt_params_.merge_opt_param_hint(other.opt_params_))) {
     LOG_WARN("failed to merge opt param hint", K(ret));
   } else if (OB_FAIL(append(ob_ddl_schema_versions_, other.ob_ddl_schema_versions_))) {
@@ -392,6 +439,16 @@ int ObGlobalHint::print_global_hint(PlanText &plan_text, const bool ignore_paral
     }
   }
 
+  //PREDICT_BATCH
+  for (int64_t i = 0; OB_SUCC(ret) && i < predict_batches_.count(); ++i) {
+    if (OB_FAIL(BUF_PRINTF("%sPREDICT_BATCH(%.*s, %ld)", outline_indent,
+                           predict_batches_.at(i).udf_name_.length(),
+                           predict_batches_.at(i).udf_name_.ptr(),
+                           predict_batches_.at(i).batch_size_))) {
+      LOG_WARN("failed to print predict batch hint", K(ret));
+    }
+  }
+
   //READ_CONSISTENCY && FROZEN_VERSION
   if (OB_SUCC(ret) && (read_consistency_ != UNSET_CONSISTENCY)) {
     if (FROZEN == read_consistency_ && frozen_version_ != -1) {
@@ -61,6 +61,16 @@ struct ObDopHint
   TO_STRING_KV(K_(dfo), K_(dop));
 };
 
+// PREDICT_BATCH(udf_name, batch_size), rows per call of a python udf
+struct ObPredictBatchHint
+{
+  ObPredictBatchHint(): udf_name_(), batch_size_(0) {};
+  ~ObPredictBatchHint() = default;
+  common::ObString udf_name_;
+  int64_t batch_size_;
+  TO_STRING_KV(K_(udf_name), K_(batch_size));
+};
+
 // hint relate to optimizer statistics gathering.
 struct ObOptimizerStatisticsGatheringHint
 {
@@ -132,6 +142,10 @@ struct ObGlobalHint {
   int merge_monitor_hints(const ObIArray<ObMonitorHint> &monitoring_ids);
   int merge_dop_hint(uint64_t dfo, uint64_t dop);
   int merge_dop_hint(const ObIArray<ObDopHint> &dop_hints);
+  int merge_predict_batch_hint(const ObString &udf_name, int64_t batch_size);
+  int merge_predict_batch_hint(const ObIArray<ObPredictBatchHint> &predict_batch_hints);
+  // 0 if no PREDICT_BATCH hint for the udf
+  int64_t get_predict_batch_hint(const ObString &udf_name) const;
   void merge_query_timeout_hint(int64_t hint_time);
   void reset_query_timeout_hint() { query_timeout_ = -1; }
   void merge_dblink_info_hint(int64_t tx_id, int64_t tm_sessid);
@@ -213,6 +227,7 @@ struct ObGlobalHint {
                K_(param_option),
                K_(monitoring_ids),
                K_(dops),
+               K_(predict_batches),
                K_(opt_features_version),
                K_(disable_transform),
                K_(disable_cost_based_transform),
@@ -240,6 +255,7 @@ struct ObGlobalHint {
   ObParamOption param_option_;
   common::ObSArray<ObMonitorHint> monitoring_ids_;
   common::ObSArray<ObDopHint> dops_;
+  common::ObSArray<ObPredictBatchHint> predict_batches_;
   uint64_t opt_features_version_;
   bool disable_transform_;
   bool disable_cost_based_transform_;
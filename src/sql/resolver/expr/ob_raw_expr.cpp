@@ -4234,6 +4234,15 @@ int ObPythonUdfRawExpr::set_udf_meta(share::schema::ObPythonUDF &udf)
   int ret = OB_SUCCESS;
   udf_meta_.init_ = false;
   udf_meta_.ret_ = udf.get_ret();
+  udf_meta_.udf_id_ = udf.get_udf_id();
+  udf_meta_.schema_version_ = udf.get_schema_version();
+  udf_meta_.exec_mode_ = udf.get_exec_mode();
+  udf_meta_.row_cost_ = udf.get_row_cost();
+  udf_meta_.selectivity_ = udf.get_selectivity();
+  udf_meta_.deterministic_ = udf.is_deterministic();
+  udf_meta_.language_ = udf.get_language();
+  udf_meta_.batch_format_ = udf.get_batch_format();
+  udf_meta_.arg_passing_ = udf.get_arg_passing();
   /* data from schame, deep copy maybe a better choices */
   if (OB_ISNULL(inner_alloc_)) {
     ret = OB_ERR_UNEXPECTED;
@@ -4247,6 +4256,12 @@ int ObPythonUdfRawExpr::set_udf_meta(share::schema::ObPythonUDF &udf)
   } else if (OB_FAIL(udf.get_arg_names_arr(udf_meta_.udf_attributes_names_))){ 
     LOG_WARN("fail to insert attributes names", K(udf.get_pycall_str()), K(ret));
   }
+  for (int64_t i = 0; OB_SUCC(ret) && i < udf_meta_.udf_attributes_names_.count(); i++) {
+    ObString name = udf_meta_.udf_attributes_names_.at(i);
+    if (OB_FAIL(ob_write_string(*inner_alloc_, name, udf_meta_.udf_attributes_names_.at(i)))) {
+      LOG_WARN("fail to write attribute name", K(name), K(ret));
+    }
+  }
   return ret;
 }
 
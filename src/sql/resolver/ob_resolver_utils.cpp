@@ -4225,6 +4225,9 @@ int ObResolverUtils::resolve_generated_column_expr(ObResolverParams &params,
       OZ (real_exprs.push_back(q_name.ref_expr_));
     }
   }
+  if (OB_SUCC(ret) && OB_FAIL(check_python_udf_generated_column(expr, generated_column))) {
+    LOG_WARN("check python udf in generated column failed", K(ret));
+  }
 
   if (OB_SUCC(ret)) {
     if (lib::is_oracle_mode()) {
@@ -4353,6 +4356,37 @@ int ObResolverUtils::resolve_generated_column_expr(ObResolverParams &params,
   return ret;
 }
 
+// A python udf is called only when the row is written, reads scan the stored value. The column
+// must be stored, and the udf deterministic so that the stored value of a row stays valid as
+// long as its cascaded columns are not updated.
+int ObResolverUtils::check_python_udf_generated_column(const ObRawExpr *expr,
+                                                       const ObColumnSchemaV2 &generated_column)
+{
+  int ret = OB_SUCCESS;
+  if (OB_ISNULL(expr)) {
+    ret = OB_INVALID_ARGUMENT;
+    LOG_WARN("expr is null", K(ret));
+  } else if (T_FUN_SYS_PYTHON_UDF == expr->get_expr_type()) {
+    const ObPythonUdfRawExpr *udf_expr = static_cast<const ObPythonUdfRawExpr *>(expr);
+    if (!generated_column.is_stored_generated_column()) {
+      ret = OB_NOT_SUPPORTED;
+      LOG_WARN("python udf in virtual generated column", K(ret), K(udf_expr->get_udf_meta()));
+      LOG_USER_ERROR(OB_NOT_SUPPORTED, "python udf in virtual generated column");
+    } else if (!udf_expr->get_udf_meta().deterministic_) {
+      ret = OB_NOT_SUPPORTED;
+      LOG_WARN("python udf is not deterministic", K(ret), K(udf_expr->get_udf_meta()));
+      LOG_USER_ERROR(OB_NOT_SUPPORTED, "non deterministic python udf in generated column");
+    }
+  }
+  for (int64_t i = 0; OB_SUCC(ret) && i < expr->get_param_count(); ++i) {
+    if (OB_FAIL(SMART_CALL(check_python_udf_generated_column(expr->get_param_expr(i),
+                                                             generated_column)))) {
+      LOG_WARN("check python udf in generated column failed", K(ret), K(i));
+    }
+  }
+  return ret;
+}
+
 // This function is used to resolve the dependent columns of generated column when retrieve schema.
 // We use this function instead of build_generated_column_expr because there is not a thread-safe
 // mem_context and the expr is not necessary.
@@ -4443,6 +4477,52 @@ int ObResolverUtils::resolve_column_info_recursively(const ParseNode *node,
   return ret;
 }
 
+int ObResolverUtils::check_generated_column_use_python_udf(const ObString &expr_str,
+                                                           const ObString &udf_name,
+                                                           ObIAllocator &allocator,
+                                                           bool &is_used)
+{
+  int ret = OB_SUCCESS;
+  const ParseNode *node = NULL;
+  is_used = false;
+  if (OB_FAIL(ObRawExprUtils::parse_expr_node_from_str(
+              expr_str, CS_TYPE_UTF8MB4_BIN,
+              allocator, node))) {
+    LOG_WARN("parse expr node from string failed", K(ret), K(expr_str));
+  } else if (OB_ISNULL(node)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("node is null", K(ret));
+  } else if (OB_FAIL(SMART_CALL(find_python_udf_recursively(node, udf_name, is_used)))) {
+    LOG_WARN("failed to find python udf", K(ret), K(expr_str));
+  }
+  return ret;
+}
+
+int ObResolverUtils::find_python_udf_recursively(const ParseNode *node,
+                                                 const ObString &udf_name,
+                                                 bool &is_used)
+{
+  int ret = OB_SUCCESS;
+  if (OB_ISNULL(node)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("node is null", K(ret));
+  } else if (T_FUN_SYS_PYTHON_UDF == node->type_
+             && node->num_child_ > 0 && NULL != node->children_ && NULL != node->children_[0]) {
+    ObString name(static_cast<int32_t>(node->children_[0]->str_len_),
+                  node->children_[0]->str_value_);
+    is_used = (0 == name.case_compare(udf_name));
+  }
+  for (int64_t i = 0; OB_SUCC(ret) && !is_used && i < node->num_child_; ++i) {
+    const ParseNode *child_node = node->children_[i];
+    if (NULL == child_node) {
+      // do nothing
+    } else if (OB_FAIL(SMART_CALL(find_python_udf_recursively(child_node, udf_name, is_used)))) {
+      LOG_WARN("recursive find python udf failed", K(ret));
+    }
+  }
+  return ret;
+}
+
 ObColumnSchemaV2* ObResolverUtils::get_column_schema_from_array(
                                      ObIArray<ObColumnSchemaV2 *> &resolved_cols,
                                      const ObString &column_name)
@@ -458,12 +458,22 @@ public:
                                            ObRawExpr *&expr,
                                            const PureFunctionCheckStatus
                                              check_status = DISABLE_CHECK);
+  static int check_python_udf_generated_column(const ObRawExpr *expr,
+                                               const share::schema::ObColumnSchemaV2 &generated_column);
   static int resolve_generated_column_info(const common::ObString &expr_str,
                                            ObIAllocator &allocator,
                                            ObItemType &root_expr_type,
                                            common::ObIArray<common::ObString> &column_names);
   static int resolve_column_info_recursively(const ParseNode *node,
                                              common::ObIArray<common::ObString> &column_names);
+  // whether generated column expr_str calls python udf udf_name, parsed without schema
+  static int check_generated_column_use_python_udf(const common::ObString &expr_str,
+                                                   const common::ObString &udf_name,
+                                                   ObIAllocator &allocator,
+                                                   bool &is_used);
+  static int find_python_udf_recursively(const ParseNode *node,
+                                         const common::ObString &udf_name,
+                                         bool &is_used);
   static share::schema::ObColumnSchemaV2* get_column_schema_from_array(
     ObIArray<share::schema::ObColumnSchemaV2 *> &resolved_cols,
     const common::ObString &column_name);
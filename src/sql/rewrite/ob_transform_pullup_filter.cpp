@@ -16,6 +16,8 @@
 #include "sql/resolver/expr/ob_raw_expr.h"
 
 #include "sql/ob_select_stmt_printer.h"
+#include "sql/optimizer/ob_log_python_udf.h"
+#include "observer/omt/ob_tenant_config_mgr.h"
 #include "deps/oblib/src/lib/json/ob_json_print_utils.h"
 
 using namespace oceanbase::sql;
@@ -38,9 +40,8 @@ int ObTransformPullUpFilter::transform_one_stmt(
   LOG_TRACE("Run transform pull up filter ObTransformPullUpFilter", K(ret));
 
   ObSelectStmt *select_stmt = NULL;
-  ObSelectStmt *sub_stmt = NULL;
-  ObSEArray<ObRawExpr *, 4> target_exprs;
   bool allowed = false;
+  bool pulled_up = false;
 
   if (OB_ISNULL(stmt) || OB_ISNULL(ctx_)) {
     ret = OB_ERR_UNEXPECTED;
@@ -57,12 +58,12 @@ int ObTransformPullUpFilter::transform_one_stmt(
   } else if (FALSE_IT(select_stmt = static_cast<ObSelectStmt*>(stmt))) {
     //准备进行改写
     LOG_WARN("select stmt is NULL", K(ret));
-  } else if (OB_FAIL(generate_child_level_stmt(select_stmt, 
-                                               sub_stmt))) {
-    LOG_WARN("failed to generate child level sub stmt", K(ret));
-  } else if (OB_FAIL(generate_parent_level_stmt(select_stmt, 
-                                                sub_stmt))) { 
-    LOG_WARN("failed to generate parent level select stmt", K(ret));
+  } else if (OB_FAIL(push_down_selective_filters(select_stmt, trans_happened))) {
+    LOG_WARN("failed to push down selective python udf filters", K(ret));
+  } else if (OB_FAIL(pull_up_python_udf(select_stmt, pulled_up))) {
+    LOG_WARN("failed to pull up python udf", K(ret));
+  } else if (!pulled_up) {
+    // every python udf filter is evaluated below the joins or in the table scan
   } else if (OB_FAIL(select_stmt->formalize_stmt(ctx_->session_info_))) {
     LOG_WARN("failed to formalize stmt.", K(ret));
   } else {
@@ -81,13 +82,228 @@ int ObTransformPullUpFilter::transform_one_stmt(
   return ret;
 }
 
+int ObTransformPullUpFilter::push_down_selective_filters(ObSelectStmt *select_stmt,
+                                                         bool &trans_happened)
+{
+  int ret = OB_SUCCESS;
+  ObSEArray<TableItem *, 4> tables;
+  if (OB_ISNULL(select_stmt)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("select stmt is null", K(ret));
+  } else if (select_stmt->get_table_size() <= 1) {
+    // no join to evaluate the filters before
+  } else {
+    // tables under joined tables are left alone, their filters may depend on the join type
+    for (int64_t i = 0; OB_SUCC(ret) && i < select_stmt->get_from_item_size(); ++i) {
+      const FromItem &from_item = select_stmt->get_from_item(i);
+      TableItem *table = NULL;
+      if (from_item.is_joined_) {
+        // do nothing
+      } else if (OB_ISNULL(table = select_stmt->get_table_item_by_id(from_item.table_id_))) {
+        ret = OB_ERR_UNEXPECTED;
+        LOG_WARN("table item is null", K(ret), K(from_item));
+      } else if (table->is_basic_table() && OB_FAIL(tables.push_back(table))) {
+        LOG_WARN("failed to push back table", K(ret));
+      }
+    }
+  }
+  for (int64_t i = 0; OB_SUCC(ret) && i < tables.count(); ++i) {
+    ObSqlBitSet<> table_ids;
+    ObSEArray<ObRawExpr *, 4> filters;
+    if (OB_FAIL(select_stmt->get_table_rel_ids(*tables.at(i), table_ids))) {
+      LOG_WARN("failed to get table rel ids", K(ret));
+    }
+    for (int64_t j = 0; OB_SUCC(ret) && j < select_stmt->get_condition_size(); ++j) {
+      ObRawExpr *cond = select_stmt->get_condition_expr(j);
+      bool is_selective = false;
+      if (OB_FAIL(is_selective_python_udf_filter(cond, table_ids, is_selective))) {
+        LOG_WARN("failed to check python udf filter", K(ret));
+      } else if (!is_selective) {
+        // evaluated on the joined rows
+      } else if (OB_FAIL(filters.push_back(cond))) {
+        LOG_WARN("failed to push back filter", K(ret));
+      }
+    }
+    if (OB_SUCC(ret) && !filters.empty()) {
+      if (OB_FAIL(push_down_table_filters(select_stmt, tables.at(i), filters))) {
+        LOG_WARN("failed to push down table filters", K(ret));
+      } else {
+        trans_happened = true;
+        OPT_TRACE("push down selective python udf filters below joins");
+      }
+    }
+  }
+  return ret;
+}
+
+int ObTransformPullUpFilter::push_down_table_filters(ObSelectStmt *select_stmt,
+                                                     TableItem *table,
+                                                     ObIArray<ObRawExpr *> &filters)
+{
+  int ret = OB_SUCCESS;
+  TableItem *view_table = NULL;
+  ObSelectStmt *view_stmt = NULL;
+  bool pulled_up = false;
+  if (OB_ISNULL(select_stmt) || OB_ISNULL(table) || OB_ISNULL(ctx_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("unexpected null", K(ret), K(select_stmt), K(table), K(ctx_));
+  } else if (OB_FAIL(ObOptimizerUtil::remove_item(select_stmt->get_condition_exprs(), filters))) {
+    LOG_WARN("failed to remove filters", K(ret));
+  } else if (OB_FAIL(ObTransformUtils::replace_with_empty_view(ctx_,
+                                                               select_stmt,
+                                                               view_table,
+                                                               table))) {
+    LOG_WARN("failed to create empty view", K(ret));
+  } else if (OB_FAIL(ObTransformUtils::create_inline_view(ctx_,
+                                                          select_stmt,
+                                                          view_table,
+                                                          table,
+                                                          &filters))) {
+    LOG_WARN("failed to create inline view", K(ret));
+  } else if (OB_ISNULL(view_stmt = view_table->ref_query_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("view stmt is null", K(ret));
+  } else if (OB_FAIL(pull_up_python_udf(view_stmt, pulled_up))) {
+    LOG_WARN("failed to pull up python udf", K(ret));
+  } else if (OB_FAIL(view_stmt->formalize_stmt(ctx_->session_info_))) {
+    LOG_WARN("failed to formalize stmt", K(ret));
+  }
+  return ret;
+}
+
+int ObTransformPullUpFilter::pull_up_python_udf(ObSelectStmt *select_stmt, bool &trans_happened)
+{
+  int ret = OB_SUCCESS;
+  ObSelectStmt *sub_stmt = NULL;
+  ObSEArray<int64_t, 4> scan_filter_idxs;
+  ObSEArray<ObRawExpr *, 4> scan_filters;
+  bool has_udf = false;
+  trans_happened = false;
+  if (OB_ISNULL(select_stmt)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("select stmt is null", K(ret));
+  } else if (OB_FAIL(get_scan_filters(*select_stmt, scan_filter_idxs))) {
+    LOG_WARN("failed to get python udf scan filters", K(ret));
+  } else if (OB_FAIL(get_conditions_by_idxs(*select_stmt, scan_filter_idxs, scan_filters))) {
+    LOG_WARN("failed to get python udf scan filters", K(ret));
+  } else if (OB_FAIL(has_python_udf(*select_stmt, scan_filters, has_udf))) {
+    LOG_WARN("failed to check python udf", K(ret));
+  } else if (!has_udf) {
+    // nothing left to pull up
+  } else if (OB_FAIL(generate_child_level_stmt(select_stmt, scan_filter_idxs, sub_stmt))) {
+    LOG_WARN("failed to generate child level sub stmt", K(ret));
+  } else if (OB_FAIL(ObOptimizerUtil::remove_item(select_stmt->get_condition_exprs(),
+                                                  scan_filters))) {
+    // evaluated by the table scan of sub stmt
+    LOG_WARN("failed to remove scan filters", K(ret));
+  } else if (OB_FAIL(generate_parent_level_stmt(select_stmt, sub_stmt))) {
+    LOG_WARN("failed to generate parent level select stmt", K(ret));
+  } else {
+    trans_happened = true;
+  }
+  if (OB_SUCC(ret) && !scan_filters.empty()) {
+    OPT_TRACE("keep selective python udf filters in table scan");
+  }
+  return ret;
+}
+
+int ObTransformPullUpFilter::get_scan_filters(const ObSelectStmt &stmt,
+                                              ObIArray<int64_t> &filter_idxs)
+{
+  int ret = OB_SUCCESS;
+  bool enabled = false;
+  const TableItem *table = NULL;
+  ObSqlBitSet<> table_ids;
+  if (OB_ISNULL(ctx_) || OB_ISNULL(ctx_->session_info_)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("unexpected null", K(ret), K(ctx_));
+  } else {
+    const uint64_t tenant_id = ctx_->session_info_->get_effective_tenant_id();
+    omt::ObTenantConfigGuard tenant_config(TENANT_CONF(tenant_id));
+    if (tenant_config.is_valid()) {
+      enabled = tenant_config->_enable_python_udf_filter_pushdown;
+    }
+  }
+  if (OB_FAIL(ret) || !enabled) {
+  } else if (1 != stmt.get_table_size() || 1 != stmt.get_from_item_size()
+             || stmt.get_from_item(0).is_joined_ || stmt.is_hierarchical_query()) {
+    // conditions of a hierarchical query are applied after CONNECT BY
+  } else if (OB_ISNULL(table = stmt.get_table_item(0))) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("table item is null", K(ret));
+  } else if (!table->is_basic_table() || is_virtual_table(table->ref_id_)) {
+    // no storage filter
+  } else if (OB_FAIL(stmt.get_table_rel_ids(*table, table_ids))) {
+    LOG_WARN("failed to get table rel ids", K(ret));
+  } else {
+    for (int64_t i = 0; OB_SUCC(ret) && i < stmt.get_condition_size(); ++i) {
+      bool is_selective = false;
+      if (OB_FAIL(is_selective_python_udf_filter(stmt.get_condition_expr(i),
+                                                 table_ids,
+                                                 is_selective))) {
+        LOG_WARN("failed to check python udf filter", K(ret));
+      } else if (!is_selective) {
+        // most rows pass it, larger batches of the python udf operator pay off more
+      } else if (OB_FAIL(filter_idxs.push_back(i))) {
+        LOG_WARN("failed to push back filter index", K(ret));
+      }
+    }
+  }
+  return ret;
+}
+
+int ObTransformPullUpFilter::get_conditions_by_idxs(const ObSelectStmt &stmt,
+                                                    const ObIArray<int64_t> &idxs,
+                                                    ObIArray<ObRawExpr *> &conds)
+{
+  int ret = OB_SUCCESS;
+  for (int64_t i = 0; OB_SUCC(ret) && i < idxs.count(); ++i) {
+    const int64_t idx = idxs.at(i);
+    if (OB_UNLIKELY(idx < 0 || idx >= stmt.get_condition_size())) {
+      ret = OB_ERR_UNEXPECTED;
+      LOG_WARN("condition index out of range", K(ret), K(idx), K(stmt.get_condition_size()));
+    } else if (OB_FAIL(conds.push_back(const_cast<ObRawExpr *>(stmt.get_condition_expr(idx))))) {
+      LOG_WARN("failed to push back condition", K(ret));
+    }
+  }
+  return ret;
+}
+
+int ObTransformPullUpFilter::is_selective_python_udf_filter(const ObRawExpr *cond,
+                                                            const ObSqlBitSet<> &table_ids,
+                                                            bool &is_selective)
+{
+  int ret = OB_SUCCESS;
+  double selectivity = 1.0;
+  bool found = false;
+  is_selective = false;
+  if (OB_ISNULL(cond)) {
+    ret = OB_ERR_UNEXPECTED;
+    LOG_WARN("condition is null", K(ret));
+  } else if (cond->has_flag(CNT_SUB_QUERY) ||
+             cond->has_flag(CNT_DYNAMIC_PARAM) ||
+             cond->has_flag(CNT_PL_UDF) ||
+             cond->get_relation_ids().is_empty() ||
+             !table_ids.is_superset(cond->get_relation_ids()) ||
+             !ObTransformUtils::expr_contain_type(cond, T_FUN_SYS_PYTHON_UDF)) {
+    // do nothing
+  } else if (OB_FAIL(ObLogPythonUDF::get_udf_selectivity(cond, selectivity, found))) {
+    LOG_WARN("failed to get python udf selectivity", K(ret));
+  } else {
+    is_selective = found && selectivity <= PUSH_DOWN_SELECTIVITY;
+  }
+  return ret;
+}
+
 int ObTransformPullUpFilter::generate_child_level_stmt(
     ObSelectStmt *&select_stmt,
+    const ObIArray<int64_t> &scan_filter_idxs,
     ObSelectStmt *&sub_stmt)
 {
   int ret = OB_SUCCESS;
   ObSEArray<ObRawExpr *, 4> python_udf_exprs; // for remove
   ObSEArray<ObRawExpr *, 4> select_exprs;
+  ObSEArray<ObRawExpr *, 4> scan_filters;
   //deep copy stmt as subplan
   if (OB_ISNULL(ctx_) || OB_ISNULL(ctx_->stmt_factory_) || OB_ISNULL(ctx_->expr_factory_)) {
     ret = OB_ERR_UNEXPECTED;
@@ -104,8 +320,13 @@ int ObTransformPullUpFilter::generate_child_level_stmt(
                                                    ctx_->src_qb_name_,
                                                    ctx_->src_hash_val_))) {
     LOG_WARN("failed to adjust statement id", K(ret));
+  } else if (OB_FAIL(get_conditions_by_idxs(*sub_stmt, scan_filter_idxs, scan_filters))) {
+    // the deep copy keeps the order of the conditions
+    LOG_WARN("failed to get python udf scan filters", K(ret));
   } else if (OB_FAIL(ObTransformUtils::extract_python_udf_exprs(sub_stmt->get_condition_exprs(), python_udf_exprs))) {
     LOG_WARN("failed to remove python udf condition exprs.", K(ret));
+  } else if (OB_FAIL(append(sub_stmt->get_condition_exprs(), scan_filters))) {
+    LOG_WARN("failed to keep python udf scan filters", K(ret));
   } else if (OB_FAIL(sub_stmt->get_select_exprs(select_exprs))) {
     LOG_WARN("failed to get select exprs of child stmt.", K(ret));
   } else if (OB_FAIL(ObTransformUtils::extract_python_udf_exprs(select_exprs, python_udf_exprs))) {
@@ -113,6 +334,10 @@ int ObTransformPullUpFilter::generate_child_level_stmt(
   } else {
     // remove select items
     sub_stmt->get_select_items().reset();
+    // ordered at the parent level
+    if (is_python_udf_topk(*select_stmt)) {
+      sub_stmt->get_order_items().reset();
+    }
     // remove limit exprs
     sub_stmt->set_limit_offset(NULL, NULL);
     // keep group-by exprs
@@ -160,11 +385,13 @@ int ObTransformPullUpFilter::generate_parent_level_stmt(ObSelectStmt *&select_st
     LOG_WARN("failed to extract aggr items into old exprs is null", K(ret));
   } else {
     // clear select stmt, keep conditions and projections 
+    if (!is_python_udf_topk(*select_stmt)) {
+      select_stmt->get_order_items().reset();
+    }
     select_stmt->get_table_items().reset();
     select_stmt->get_joined_tables().reset();
     select_stmt->get_from_items().reset();
     select_stmt->get_having_exprs().reset();
-    select_stmt->get_order_items().reset();
     select_stmt->get_group_exprs().reset(); // remove group-by exprs & aggr exprs
     select_stmt->get_aggr_items().reset();
     select_stmt->get_rollup_exprs().reset();
@@ -248,27 +475,61 @@ int ObTransformPullUpFilter::need_transform(const common::ObIArray<ObParentDMLSt
     LOG_WARN("get select exprs failed.", K(ret));
   } else if (select_exprs.empty()) {
     LOG_WARN("get none select exprs.", K(ret));
+  } else if (OB_FAIL(has_python_udf(static_cast<const ObSelectStmt &>(stmt), need_trans))) {
+    LOG_WARN("failed to check python udf", K(ret));
+  }
+  return ret;
+}
+
+int ObTransformPullUpFilter::has_python_udf(const ObSelectStmt &stmt, bool &has_udf)
+{
+  ObSEArray<ObRawExpr *, 1> kept_filters;
+  return has_python_udf(stmt, kept_filters, has_udf);
+}
+
+int ObTransformPullUpFilter::has_python_udf(const ObSelectStmt &stmt,
+                                            const ObIArray<ObRawExpr *> &kept_filters,
+                                            bool &has_udf)
+{
+  int ret = OB_SUCCESS;
+  ObSEArray<ObRawExpr *, 4> select_exprs;
+  has_udf = false;
+  if (OB_FAIL(stmt.get_select_exprs(select_exprs))) {
+    LOG_WARN("get select exprs failed.", K(ret));
   } else {
     // check stmt condition exprs
-    for(int32_t i = 0; i < stmt.get_condition_size(); i++) {
-      if(ObTransformUtils::expr_contain_type(const_cast<ObRawExpr *>(stmt.get_condition_expr(i)), T_FUN_SYS_PYTHON_UDF)) {
-        need_trans = true;
-        LOG_WARN("python udf in condition exprs.", K(ret));
-        break;
+    for(int32_t i = 0; !has_udf && i < stmt.get_condition_size(); i++) {
+      if (ObOptimizerUtil::find_item(kept_filters, stmt.get_condition_expr(i))) {
+        // stays in the table scan
+      } else if(ObTransformUtils::expr_contain_type(const_cast<ObRawExpr *>(stmt.get_condition_expr(i)), T_FUN_SYS_PYTHON_UDF)) {
+        has_udf = true;
+        LOG_TRACE("python udf in condition exprs.", K(ret));
       }
     }
     // check stmt projection exprs
-    for(int32_t i = 0; i < select_exprs.count(); i++) {
+    for(int32_t i = 0; !has_udf && i < select_exprs.count(); i++) {
       if(ObTransformUtils::expr_contain_type(select_exprs.at(i), T_FUN_SYS_PYTHON_UDF)) {
-        need_trans = true;
-        LOG_WARN("python udf in select exprs.", K(ret));
-        break;
+        has_udf = true;
+        LOG_TRACE("python udf in select exprs.", K(ret));
       }
     }
   }
   return ret;
 }
 
+bool ObTransformPullUpFilter::is_python_udf_topk(const ObSelectStmt &stmt)
+{
+  bool is_topk = false;
+  if (NULL != stmt.get_limit_expr() && NULL == stmt.get_limit_percent_expr()
+      && !stmt.is_fetch_with_ties()) {
+    for (int64_t i = 0; !is_topk && i < stmt.get_order_item_size(); i++) {
+      is_topk = ObTransformUtils::expr_contain_type(stmt.get_order_item(i).expr_,
+                                                    T_FUN_SYS_PYTHON_UDF);
+    }
+  }
+  return is_topk;
+}
+
 int ObTransformPullUpFilter::check_hint_allowed(const ObDMLStmt &stmt,
                                                 bool &allowed)
 {
@@ -27,8 +27,11 @@ public:
     ObDMLStmt *&stmt,
     bool &trans_happened) override;
 
+  // scan_filter_idxs are the indexes of the conditions kept in the table scan, see
+  // get_scan_filters()
   virtual int generate_child_level_stmt(
     ObSelectStmt *&select_stmt,
+    const ObIArray<int64_t> &scan_filter_idxs,
     ObSelectStmt *&sub_stmt);
 
   virtual int generate_parent_level_stmt(
@@ -42,6 +45,10 @@ public:
   int check_hint_allowed(const ObDMLStmt &stmt,
                          bool &allowed);
 
+  // a python udf filter on one table keeps below the joins when at most this ratio of the
+  // rows passes it, see ObLogPythonUDF::get_udf_selectivity()
+  static constexpr double PUSH_DOWN_SELECTIVITY = 0.1;
+
 private:
   virtual int need_transform(
     const common::ObIArray<ObParentDMLStmt> &parent_stmts,
@@ -51,6 +58,46 @@ private:
   
   virtual int construct_transform_hint(ObDMLStmt &stmt, void *trans_params) override;
 
+  static int has_python_udf(const ObSelectStmt &stmt, bool &has_udf);
+
+  // same, ignoring the conditions in kept_filters
+  static int has_python_udf(const ObSelectStmt &stmt,
+                            const ObIArray<ObRawExpr *> &kept_filters,
+                            bool &has_udf);
+
+  // ORDER BY on a python udf with a LIMIT: the order items go to the parent level, where the
+  // sort is a top-n over the output of the python udf operator instead of a full sort
+  static bool is_python_udf_topk(const ObSelectStmt &stmt);
+
+  // moves selective python udf filters on a single basic table into a view of that table,
+  // the filters are pulled up within the view and evaluated before the joins
+  int push_down_selective_filters(ObSelectStmt *select_stmt, bool &trans_happened);
+
+  int push_down_table_filters(ObSelectStmt *select_stmt,
+                              TableItem *table,
+                              ObIArray<ObRawExpr *> &filters);
+
+  // creates the subplan scan and pulls the python udfs above it, except the filters kept in
+  // the table scan by get_scan_filters()
+  int pull_up_python_udf(ObSelectStmt *select_stmt, bool &trans_happened);
+
+  // selective python udf filters on the only basic table of the stmt stay in its table scan.
+  // Storage evaluates them as black filters over the columns decoded from each micro-block
+  // and only projects the rows passing them, instead of copying every row into the python
+  // udf operator
+  // returns the indexes of those filters in the conditions of stmt
+  int get_scan_filters(const ObSelectStmt &stmt, ObIArray<int64_t> &filter_idxs);
+
+  static int get_conditions_by_idxs(const ObSelectStmt &stmt,
+                                    const ObIArray<int64_t> &idxs,
+                                    ObIArray<ObRawExpr *> &conds);
+
+  // cond is a python udf filter on the tables of table_ids that at most PUSH_DOWN_SELECTIVITY
+  // of the rows pass, shared by push_down_selective_filters() and get_scan_filters()
+  static int is_selective_python_udf_filter(const ObRawExpr *cond,
+                                            const ObSqlBitSet<> &table_ids,
+                                            bool &is_selective);
+
 
 private:
   ObArenaAllocator allocator_;
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+#ifndef OCEANBASE_UNITTEST_SQL_ENGINE_PYTHON_UDF_OB_PYTHON_UDF_TEST_UTIL_H_
+#define OCEANBASE_UNITTEST_SQL_ENGINE_PYTHON_UDF_OB_PYTHON_UDF_TEST_UTIL_H_
+
+#include "lib/allocator/ob_allocator.h"
+#include "sql/engine/expr/ob_expr.h"
+
+namespace oceanbase
+{
+namespace sql
+{
+
+// evaluation frames of the exprs of a python udf test, one frame per expr
+class ObPyUdfTestFrames
+{
+public:
+  ObPyUdfTestFrames(common::ObIAllocator &alloc, ObEvalCtx &eval_ctx, const int64_t batch_size)
+      : alloc_(alloc), eval_ctx_(eval_ctx), batch_size_(batch_size) {}
+
+  int init(const int64_t frame_cnt)
+  {
+    int ret = common::OB_SUCCESS;
+    if (OB_ISNULL(eval_ctx_.frames_ = static_cast<char **>(
+                      alloc_.alloc(sizeof(char *) * frame_cnt)))) {
+      ret = common::OB_ALLOCATE_MEMORY_FAILED;
+    }
+    return ret;
+  }
+
+  // frame of an expr: batch datums, eval info, eval flags, pvt skip and 8 bytes result per row
+  int init_expr(const int64_t frame_idx, const common::ObObjType type, ObExpr &expr)
+  {
+    int ret = common::OB_SUCCESS;
+    const int64_t datum_size = sizeof(common::ObDatum) * batch_size_;
+    const int64_t bit_size = ObBitVector::memory_size(batch_size_);
+    const int64_t frame_size = datum_size + sizeof(ObEvalInfo) + bit_size * 2
+                               + sizeof(int64_t) * batch_size_;
+    char *frame = static_cast<char *>(alloc_.alloc(frame_size));
+    if (OB_ISNULL(frame)) {
+      ret = common::OB_ALLOCATE_MEMORY_FAILED;
+    } else {
+      MEMSET(frame, 0, frame_size);
+      eval_ctx_.frames_[frame_idx] = frame;
+      expr.frame_idx_ = static_cast<uint32_t>(frame_idx);
+      expr.datum_off_ = 0;
+      expr.eval_info_off_ = static_cast<uint32_t>(datum_size);
+      expr.eval_flags_off_ = static_cast<uint32_t>(datum_size + sizeof(ObEvalInfo));
+      expr.pvt_skip_off_ = static_cast<uint32_t>(expr.eval_flags_off_ + bit_size);
+      expr.res_buf_off_ = static_cast<uint32_t>(expr.pvt_skip_off_ + bit_size);
+      expr.res_buf_len_ = sizeof(int64_t);
+      expr.batch_result_ = true;
+      expr.batch_idx_mask_ = UINT64_MAX;
+      expr.datum_meta_.type_ = type;
+      common::ObDatum *datums = expr.locate_batch_datums(eval_ctx_);
+      for (int64_t i = 0; i < batch_size_; i++) {
+        datums[i].ptr_ = frame + expr.res_buf_off_ + sizeof(int64_t) * i;
+      }
+    }
+    return ret;
+  }
+
+private:
+  common::ObIAllocator &alloc_;
+  ObEvalCtx &eval_ctx_;
+  const int64_t batch_size_;
+};
+
+} // end namespace sql
+} // end namespace oceanbase
+
+#endif // OCEANBASE_UNITTEST_SQL_ENGINE_PYTHON_UDF_OB_PYTHON_UDF_TEST_UTIL_H_
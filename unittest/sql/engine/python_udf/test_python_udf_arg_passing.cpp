@@ -0,0 +1,191 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+#define USING_LOG_PREFIX SQL_ENG
+
+#define PY_SSIZE_T_CLEAN
+#include <gtest/gtest.h>
+#include "lib/allocator/page_arena.h"
+#include "sql/engine/expr/ob_expr_python_udf.h"
+#include "sql/engine/ob_exec_context.h"
+#include "ob_python_udf_test_util.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+// udf(x, t) of a batch of x and a constant t, called through eval_test_udf_batch so that
+// the arguments are built by ObPythonUdfExprCtx::build_args
+class TestPythonUdfArgPassing : public ::testing::Test
+{
+public:
+  static const int64_t BATCH_SIZE = 8;
+  static const int64_t ARG_CNT = 2;
+  static const int64_t SKIPPED_ROW = 3;
+
+  TestPythonUdfArgPassing()
+      : alloc_(), exec_ctx_(alloc_), eval_ctx_(exec_ctx_),
+        frames_(alloc_, eval_ctx_, BATCH_SIZE), info_(alloc_, T_FUN_SYS_PYTHON_UDF) {}
+  virtual void SetUp()
+  {
+    if (!Py_IsInitialized()) {
+      Py_InitializeEx(0);
+      PyEval_SaveThread();
+    }
+    ASSERT_EQ(OB_SUCCESS, frames_.init(ARG_CNT + 1));
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(0, ObDoubleType, args_[0]));
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(1, ObDoubleType, args_[1]));
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(2, ObDoubleType, udf_));
+    args_[1].batch_result_ = false;
+    arg_ptrs_[0] = &args_[0];
+    arg_ptrs_[1] = &args_[1];
+    ObDatum *xs = args_[0].locate_batch_datums(eval_ctx_);
+    for (int64_t i = 0; i < BATCH_SIZE; i++) {
+      xs[i].set_double(static_cast<double>(i));
+    }
+    args_[1].locate_batch_datums(eval_ctx_)[0].set_double(0.5);
+    udf_.args_ = arg_ptrs_;
+    udf_.arg_cnt_ = ARG_CNT;
+    udf_.extra_info_ = &info_;
+    udf_.expr_ctx_id_ = 0;
+    expr_op_ctx_store_[0] = NULL;
+    exec_ctx_.set_expr_op_ctx_store(expr_op_ctx_store_);
+    exec_ctx_.set_expr_op_size(1);
+    skip_ = to_bit_vector(alloc_.alloc(ObBitVector::memory_size(BATCH_SIZE)));
+    ASSERT_TRUE(NULL != skip_);
+    skip_->init(BATCH_SIZE);
+    skip_->set(SKIPPED_ROW);
+  }
+  virtual void TearDown()
+  {
+    // python handles of the udf ctx are released with the GIL
+    exec_ctx_.reset_expr_op();
+  }
+  int import(const char *name, const uint64_t udf_id, const char *pycall,
+              const share::schema::ObPythonUDF::PyUdfArgPassing arg_passing)
+  {
+    share::schema::ObPythonUDFMeta &meta = info_.udf_meta_;
+    meta.name_ = ObString::make_string(name);
+    meta.pycall_ = ObString::make_string(pycall);
+    meta.ret_ = share::schema::ObPythonUDF::REAL;
+    meta.language_ = share::schema::ObPythonUDF::PYTHON;
+    meta.arg_passing_ = arg_passing;
+    meta.udf_id_ = udf_id;
+    meta.schema_version_ = 1;
+    meta.udf_attributes_names_.reuse();
+    meta.udf_attributes_names_.push_back(ObString::make_string("x"));
+    meta.udf_attributes_names_.push_back(ObString::make_string("t"));
+    return ObExprPythonUdf::import_udf(meta);
+  }
+  int eval()
+  {
+    udf_.get_evaluated_flags(eval_ctx_).reset(BATCH_SIZE);
+    return ObExprPythonUdf::eval_test_udf_batch(udf_, eval_ctx_, *skip_, BATCH_SIZE);
+  }
+  // x + t of every row but the skipped one
+  void check_results()
+  {
+    const ObDatum *results = udf_.locate_batch_datums(eval_ctx_);
+    for (int64_t i = 0; i < BATCH_SIZE; i++) {
+      if (SKIPPED_ROW != i) {
+        ASSERT_EQ(static_cast<double>(i) + 0.5, results[i].get_double());
+      }
+    }
+  }
+
+protected:
+  ObArenaAllocator alloc_;
+  ObExecContext exec_ctx_;
+  ObEvalCtx eval_ctx_;
+  ObPyUdfTestFrames frames_;
+  ObPythonUdfInfo info_;
+  ObExpr args_[ARG_CNT];
+  ObExpr *arg_ptrs_[ARG_CNT];
+  ObExpr udf_;
+  ObExprOperatorCtx *expr_op_ctx_store_[1];
+  ObBitVector *skip_;
+};
+
+TEST_F(TestPythonUdfArgPassing, positional)
+{
+  const char *pycall =
+      "def pyinitial():\n"
+      "    pass\n"
+      "def pyfun(x, t):\n"
+      "    assert t.shape == x.shape\n"
+      "    return x + t\n";
+  ASSERT_EQ(OB_SUCCESS, import("arg_positional", 1, pycall, share::schema::ObPythonUDF::POSITIONAL));
+  ASSERT_EQ(OB_SUCCESS, eval());
+  check_results();
+  // arrays and argument tuple of the ctx are reused by the next batch
+  ASSERT_EQ(OB_SUCCESS, eval());
+  check_results();
+}
+
+TEST_F(TestPythonUdfArgPassing, broadcast)
+{
+  const char *pycall =
+      "def pyinitial():\n"
+      "    pass\n"
+      "def pyfun(x, t):\n"
+      "    assert t.ndim == 0 and x.ndim == 1\n"
+      "    return x + t\n";
+  ASSERT_EQ(OB_SUCCESS, import("arg_broadcast", 2, pycall, share::schema::ObPythonUDF::BROADCAST));
+  ASSERT_EQ(OB_SUCCESS, eval());
+  check_results();
+}
+
+TEST_F(TestPythonUdfArgPassing, keyword)
+{
+  const char *pycall =
+      "def pyinitial():\n"
+      "    pass\n"
+      "def pyfun(*, x, t):\n"
+      "    assert isinstance(t, float)\n"
+      "    return x + t\n";
+  ASSERT_EQ(OB_SUCCESS, import("arg_keyword", 3, pycall, share::schema::ObPythonUDF::KEYWORD));
+  ASSERT_EQ(OB_SUCCESS, eval());
+  check_results();
+  // the keyword dict is cleared and refilled
+  ASSERT_EQ(OB_SUCCESS, eval());
+  check_results();
+}
+
+TEST_F(TestPythonUdfArgPassing, scalar_result)
+{
+  // one value for the whole batch is broadcast to every row
+  const char *pycall =
+      "def pyinitial():\n"
+      "    pass\n"
+      "def pyfun(x, t):\n"
+      "    return t * 2\n";
+  ASSERT_EQ(OB_SUCCESS, import("arg_scalar_result", 4, pycall, share::schema::ObPythonUDF::BROADCAST));
+  ASSERT_EQ(OB_SUCCESS, eval());
+  const ObDatum *results = udf_.locate_batch_datums(eval_ctx_);
+  for (int64_t i = 0; i < BATCH_SIZE; i++) {
+    if (SKIPPED_ROW != i) {
+      ASSERT_EQ(1.0, results[i].get_double());
+    }
+  }
+}
+
+} // end namespace sql
+} // end namespace oceanbase
+
+int main(int argc, char **argv)
+{
+  OB_LOGGER.set_log_level("WARN");
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,238 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+#define USING_LOG_PREFIX SQL_ENG
+
+#define PY_SSIZE_T_CLEAN
+#include <gtest/gtest.h>
+#include <string.h>
+#include "lib/allocator/page_arena.h"
+#include "sql/engine/expr/ob_expr_python_udf.h"
+#include "sql/engine/ob_exec_context.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_arrow.h"
+#include "ob_python_udf_test_util.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+class TestPythonUdfArrow : public ::testing::Test
+{
+public:
+  static const int64_t BATCH_SIZE = 8;
+  // int arg evaluated in batch, double arg gathered, varchar arg and const int arg
+  static const int64_t ARG_CNT = 4;
+
+  TestPythonUdfArrow()
+      : alloc_(), exec_ctx_(alloc_), eval_ctx_(exec_ctx_),
+        frames_(alloc_, eval_ctx_, BATCH_SIZE) {}
+  virtual void SetUp()
+  {
+    ASSERT_EQ(OB_SUCCESS, frames_.init(ARG_CNT + 1));
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(0, ObIntType, args_[0]));
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(1, ObDoubleType, args_[1]));
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(2, ObVarcharType, args_[2]));
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(3, ObIntType, args_[3]));
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(4, ObDoubleType, udf_));
+    for (int64_t i = 0; i < ARG_CNT; i++) {
+      arg_ptrs_[i] = &args_[i];
+    }
+    udf_.args_ = arg_ptrs_;
+    udf_.arg_cnt_ = ARG_CNT;
+    args_[3].batch_result_ = false;
+    ObDatum *ints = args_[0].locate_batch_datums(eval_ctx_);
+    ObDatum *doubles = args_[1].locate_batch_datums(eval_ctx_);
+    ObDatum *strs = args_[2].locate_batch_datums(eval_ctx_);
+    for (int64_t i = 0; i < BATCH_SIZE; i++) {
+      ints[i].set_int(i * 10);
+      // results of another expr, not 8 bytes apart
+      doubles[i].ptr_ = reinterpret_cast<char *>(&gathered_[BATCH_SIZE - 1 - i]);
+      doubles[i].set_double(i + 0.5);
+      strs[i].set_string(STRS[i], static_cast<int32_t>(strlen(STRS[i])));
+    }
+    args_[3].locate_batch_datums(eval_ctx_)[0].set_int(7);
+  }
+  static bool is_valid(const ArrowArray &array, const int64_t i)
+  {
+    const uint8_t *validity = static_cast<const uint8_t *>(array.buffers[0]);
+    return NULL == validity || 0 != (validity[i >> 3] & (1 << (i & 7)));
+  }
+  static void no_release_array(ArrowArray *array) { array->release = NULL; }
+
+protected:
+  static const char *STRS[BATCH_SIZE];
+  ObArenaAllocator alloc_;
+  ObExecContext exec_ctx_;
+  ObEvalCtx eval_ctx_;
+  ObPyUdfTestFrames frames_;
+  ObExpr args_[ARG_CNT];
+  ObExpr *arg_ptrs_[ARG_CNT];
+  ObExpr udf_;
+  double gathered_[BATCH_SIZE];
+};
+
+const char *TestPythonUdfArrow::STRS[BATCH_SIZE] = {"a", "bb", "", "ccc", "d", "ee", "f", "g"};
+
+TEST_F(TestPythonUdfArrow, export_batch)
+{
+  // row 3 skipped, the batch spans rows 1..5
+  const int32_t sel[] = {1, 2, 4, 5};
+  const int64_t sel_cnt = 4;
+  ArrowSchema schema;
+  ArrowArray array;
+  ASSERT_EQ(OB_SUCCESS, ObPyArrowBatch::export_batch(udf_, eval_ctx_, true, sel, sel_cnt,
+                                                     schema, array));
+  ASSERT_STREQ("+s", schema.format);
+  ASSERT_EQ(ARG_CNT, schema.n_children);
+  ASSERT_EQ(ARG_CNT, array.n_children);
+  ASSERT_EQ(5, array.length);
+  ASSERT_STREQ("arg0", schema.children[0]->name);
+  ASSERT_STREQ("l", schema.children[0]->format);
+  ASSERT_STREQ("g", schema.children[1]->format);
+  ASSERT_STREQ("u", schema.children[2]->format);
+  ASSERT_STREQ("l", schema.children[3]->format);
+
+  // ints evaluated in batch are used in place
+  const ArrowArray &ints = *array.children[0];
+  ASSERT_EQ(1, ints.null_count);
+  ASSERT_EQ(args_[0].locate_batch_datums(eval_ctx_)[1].ptr_, ints.buffers[1]);
+  ASSERT_TRUE(is_valid(ints, 0));
+  ASSERT_TRUE(is_valid(ints, 1));
+  ASSERT_FALSE(is_valid(ints, 2));
+  ASSERT_TRUE(is_valid(ints, 3));
+  ASSERT_EQ(40, static_cast<const int64_t *>(ints.buffers[1])[3]);
+
+  const ArrowArray &doubles = *array.children[1];
+  const double *d = static_cast<const double *>(doubles.buffers[1]);
+  ASSERT_NE(reinterpret_cast<const void *>(&gathered_[0]), doubles.buffers[1]);
+  ASSERT_EQ(1.5, d[0]);
+  ASSERT_EQ(2.5, d[1]);
+  ASSERT_EQ(5.5, d[4]);
+
+  // unselected rows are empty strings
+  const ArrowArray &strs = *array.children[2];
+  const int32_t *offsets = static_cast<const int32_t *>(strs.buffers[1]);
+  const char *data = static_cast<const char *>(strs.buffers[2]);
+  const int32_t expect_offsets[] = {0, 2, 2, 2, 3, 5};
+  for (int64_t i = 0; i <= 5; i++) {
+    ASSERT_EQ(expect_offsets[i], offsets[i]);
+  }
+  ASSERT_EQ(0, MEMCMP("bbdee", data, 5));
+
+  const ArrowArray &consts = *array.children[3];
+  for (int64_t i = 0; i < 5; i++) {
+    ASSERT_EQ(2 == i ? 0 : 7, static_cast<const int64_t *>(consts.buffers[1])[i]);
+  }
+
+  // a child moved out by the consumer is released on its own
+  ArrowArray moved = *array.children[1];
+  array.children[1]->release = NULL;
+  array.release(&array);
+  ASSERT_TRUE(NULL == array.release);
+  ASSERT_TRUE(NULL != moved.release);
+  moved.release(&moved);
+  schema.release(&schema);
+  ASSERT_TRUE(NULL == schema.release);
+}
+
+TEST_F(TestPythonUdfArrow, export_full_batch)
+{
+  const int32_t sel[] = {0, 1, 2};
+  ArrowSchema schema;
+  ArrowArray array;
+  ASSERT_EQ(OB_SUCCESS, ObPyArrowBatch::export_batch(udf_, eval_ctx_, true, sel, 3,
+                                                     schema, array));
+  // no validity bitmap when every row is selected
+  for (int64_t i = 0; i < ARG_CNT; i++) {
+    ASSERT_EQ(0, array.children[i]->null_count);
+    ASSERT_TRUE(NULL == array.children[i]->buffers[0]);
+  }
+  schema.release(&schema);
+  array.release(&array);
+}
+
+TEST_F(TestPythonUdfArrow, import_result)
+{
+  const int32_t sel[] = {1, 2, 4};
+  ObDatum *results = udf_.locate_batch_datums(eval_ctx_);
+  int64_t ret_cnt = 0;
+  ArrowSchema schema;
+  ArrowArray array;
+  MEMSET(&schema, 0, sizeof(schema));
+  MEMSET(&array, 0, sizeof(array));
+
+  // int32 result of every row of the span 1..4, offset by one, row 2 null
+  const int32_t ints[] = {-1, 10, 20, 30, 40};
+  const uint8_t validity = 0x1b; // 0b11011 with the offset, position 2 is null
+  const void *int_buffers[] = {&validity, ints};
+  schema.format = "i";
+  array.length = 4;
+  array.offset = 1;
+  array.n_buffers = 2;
+  array.buffers = int_buffers;
+  array.release = no_release_array;
+  ASSERT_EQ(OB_SUCCESS, ObPyArrowBatch::import_result(ObDoubleType, schema, array, sel, 3,
+                                                      results, ret_cnt));
+  ASSERT_EQ(3, ret_cnt);
+  ASSERT_EQ(10.0, results[1].get_double());
+  ASSERT_TRUE(results[2].is_null());
+  ASSERT_EQ(40.0, results[4].get_double());
+
+  // a compact result gives value k to row sel[k]
+  const double doubles[] = {0.5, 1.5};
+  const void *double_buffers[] = {NULL, doubles};
+  schema.format = "g";
+  array.length = 2;
+  array.offset = 0;
+  array.buffers = double_buffers;
+  ASSERT_EQ(OB_SUCCESS, ObPyArrowBatch::import_result(ObDoubleType, schema, array, sel, 3,
+                                                      results, ret_cnt));
+  ASSERT_EQ(2, ret_cnt);
+  ASSERT_EQ(0.5, results[1].get_double());
+  ASSERT_EQ(1.5, results[2].get_double());
+
+  // floating result of an integer udf
+  ASSERT_EQ(OB_NOT_SUPPORTED, ObPyArrowBatch::import_result(ObIntType, schema, array, sel, 3,
+                                                            results, ret_cnt));
+
+  // large utf8 strings
+  const int64_t offsets[] = {0, 1, 3, 6};
+  const void *str_buffers[] = {NULL, offsets, "xyyzzz"};
+  schema.format = "U";
+  array.length = 3;
+  array.n_buffers = 3;
+  array.buffers = str_buffers;
+  ASSERT_EQ(OB_SUCCESS, ObPyArrowBatch::import_result(ObVarcharType, schema, array, sel, 3,
+                                                      results, ret_cnt));
+  ASSERT_EQ(3, ret_cnt);
+  ASSERT_EQ(ObString::make_string("x"), results[1].get_string());
+  ASSERT_EQ(ObString::make_string("yy"), results[2].get_string());
+  ASSERT_EQ(ObString::make_string("zzz"), results[4].get_string());
+
+  // nested and dictionary encoded results are not supported
+  schema.format = "+l";
+  array.n_children = 1;
+  ASSERT_EQ(OB_NOT_SUPPORTED, ObPyArrowBatch::import_result(ObVarcharType, schema, array, sel, 3,
+                                                            results, ret_cnt));
+}
+
+} // end namespace sql
+} // end namespace oceanbase
+
+int main(int argc, char **argv)
+{
+  OB_LOGGER.set_log_level("WARN");
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,181 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+#define USING_LOG_PREFIX SQL_ENG
+
+#include <gtest/gtest.h>
+#include "sql/engine/python_udf_engine/ob_python_udf_batch_tuner.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+class TestPythonUdfBatchTuner : public ::testing::Test
+{
+public:
+  static const int64_t MAX_ITERATIONS = 100;
+
+  // per call overhead, per row cost and a penalty growing past 2048 rows (cache misses),
+  // the throughput peaks at about 2300 rows
+  static int64_t cycles(const int64_t rows)
+  {
+    const double over = rows > 2048 ? static_cast<double>(rows - 2048) : 0;
+    return static_cast<int64_t>(100000 + rows * 100 + 0.1 * over * over);
+  }
+  static double tput(const int64_t rows)
+  {
+    return static_cast<double>(rows) * 1000 / cycles(rows);
+  }
+  static int64_t run_policy(const ObPyBatchPolicyType type, ObPyBatchTuneState &state)
+  {
+    int64_t iter = 0;
+    const ObPyBatchPolicy &policy = ObPyBatchPolicy::get_policy(type);
+    state.policy_ = type;
+    policy.start(state);
+    for (; !state.converged_ && iter < MAX_ITERATIONS; iter++) {
+      policy.update(state, tput(state.cur_size_));
+    }
+    return iter;
+  }
+};
+
+TEST_F(TestPythonUdfBatchTuner, hill_climb)
+{
+  ObPyBatchTuneState state;
+  const int64_t iter = run_policy(PY_BATCH_HILL_CLIMB, state);
+  ASSERT_TRUE(state.converged_);
+  ASSERT_LT(iter, MAX_ITERATIONS);
+  ASSERT_EQ(state.best_size_, state.cur_size_);
+  ASSERT_GE(state.best_size_, 1024);
+  ASSERT_LE(state.best_size_, 4096);
+}
+
+TEST_F(TestPythonUdfBatchTuner, golden_section)
+{
+  ObPyBatchTuneState state;
+  const int64_t iter = run_policy(PY_BATCH_GOLDEN_SECTION, state);
+  ASSERT_TRUE(state.converged_);
+  ASSERT_LT(iter, MAX_ITERATIONS);
+  ASSERT_GE(state.best_size_, 1024);
+  ASSERT_LE(state.best_size_, 4096);
+}
+
+TEST_F(TestPythonUdfBatchTuner, latency_slo)
+{
+  ObPyBatchTuneState state;
+  const ObPyBatchPolicy &policy = ObPyBatchPolicy::get_policy(PY_BATCH_LATENCY_SLO);
+  state.policy_ = PY_BATCH_LATENCY_SLO;
+  state.slo_us_ = 500;
+  state.us_per_row_ = 1; // no more than 450 rows meet the slo
+  policy.start(state);
+  state.us_per_row_ = 1;
+  for (int64_t i = 0; !state.converged_ && i < MAX_ITERATIONS; i++) {
+    policy.update(state, tput(state.cur_size_));
+    ASSERT_LE(state.cur_size_, 450);
+  }
+  ASSERT_TRUE(state.converged_);
+  ASSERT_LE(state.best_size_, 450);
+}
+
+TEST_F(TestPythonUdfBatchTuner, tuner)
+{
+  ObPyBatchTuner tuner;
+  tuner.set_udf(1, 1);
+  ASSERT_EQ(ObPyBatchTuneState::DEFAULT_BATCH_SIZE, tuner.get_batch_size());
+  // partial batches are not samples
+  for (int64_t i = 0; i < 10; i++) {
+    tuner.add_sample(ObPyBatchSample(10, cycles(10), 10));
+  }
+  ASSERT_EQ(ObPyBatchTuneState::DEFAULT_BATCH_SIZE, tuner.get_batch_size());
+  for (int64_t i = 0; i < MAX_ITERATIONS * ObPyBatchTuner::SAMPLES_PER_PROBE; i++) {
+    const int64_t rows = tuner.get_batch_size();
+    tuner.add_sample(ObPyBatchSample(rows, cycles(rows), rows));
+  }
+  ObPyBatchTuneState state = tuner.get_state();
+  ASSERT_TRUE(state.converged_);
+  ASSERT_EQ(state.best_size_, tuner.get_batch_size());
+
+  // copied and serialized with the expr
+  ObPyBatchTuner copied;
+  ASSERT_EQ(OB_SUCCESS, copied.assign(tuner));
+  ASSERT_EQ(state.best_size_, copied.get_batch_size());
+  char buf[1024];
+  int64_t pos = 0;
+  ASSERT_EQ(OB_SUCCESS, tuner.serialize(buf, sizeof(buf), pos));
+  ASSERT_EQ(pos, tuner.get_serialize_size());
+  ObPyBatchTuner deserialized;
+  int64_t data_len = pos;
+  pos = 0;
+  ASSERT_EQ(OB_SUCCESS, deserialized.deserialize(buf, data_len, pos));
+  ASSERT_TRUE(deserialized.get_state().converged_);
+  ASSERT_EQ(state.best_size_, deserialized.get_batch_size());
+
+  // a drop of the throughput restarts the search
+  for (int64_t i = 0; i < ObPyBatchTuner::DRIFT_SAMPLES * ObPyBatchTuner::SAMPLES_PER_PROBE; i++) {
+    const int64_t rows = tuner.get_batch_size();
+    tuner.add_sample(ObPyBatchSample(rows, cycles(rows) * 2, rows));
+  }
+  ASSERT_FALSE(tuner.get_state().converged_);
+}
+
+TEST_F(TestPythonUdfBatchTuner, fixed_size)
+{
+  ObPyBatchTuner tuner;
+  tuner.set_udf(1, 1);
+  tuner.set_fixed_size(4096);
+  for (int64_t i = 0; i < MAX_ITERATIONS; i++) {
+    tuner.add_sample(ObPyBatchSample(4096, cycles(4096), 4096));
+  }
+  ASSERT_EQ(4096, tuner.get_batch_size());
+}
+
+TEST_F(TestPythonUdfBatchTuner, size_cache)
+{
+  ObPyBatchSizeCache cache;
+  int64_t size = 0;
+  double us_per_row = 0;
+  ASSERT_EQ(OB_SUCCESS, cache.init(OB_SYS_TENANT_ID));
+  ASSERT_EQ(OB_HASH_NOT_EXIST, cache.get(1, 1, size));
+  ASSERT_EQ(OB_SUCCESS, cache.put(1, 1, 2048, 2.5));
+  ASSERT_EQ(OB_SUCCESS, cache.get(1, 1, size));
+  ASSERT_EQ(2048, size);
+  ASSERT_EQ(OB_SUCCESS, cache.get(1, 1, size, us_per_row));
+  ASSERT_DOUBLE_EQ(2.5, us_per_row);
+  // udf replaced
+  ASSERT_EQ(OB_HASH_NOT_EXIST, cache.get(1, 2, size));
+
+  double selectivity = 0;
+  ASSERT_EQ(OB_HASH_NOT_EXIST, cache.get_selectivity(2, 1, selectivity));
+  ASSERT_EQ(OB_SUCCESS, cache.add_selectivity(2, 1, 1000, 100));
+  ASSERT_EQ(OB_SUCCESS, cache.get_selectivity(2, 1, selectivity));
+  ASSERT_DOUBLE_EQ(0.1, selectivity);
+  // weighted by rows
+  ASSERT_EQ(OB_SUCCESS, cache.add_selectivity(2, 1, 3000, 1500));
+  ASSERT_EQ(OB_SUCCESS, cache.get_selectivity(2, 1, selectivity));
+  ASSERT_DOUBLE_EQ(0.4, selectivity);
+  ASSERT_NE(OB_SUCCESS, cache.add_selectivity(2, 1, 10, 20));
+  ASSERT_EQ(OB_HASH_NOT_EXIST, cache.get_selectivity(2, 2, selectivity));
+  // the batch size is learned apart from the selectivity
+  ASSERT_EQ(OB_HASH_NOT_EXIST, cache.get(2, 1, size));
+}
+
+} // end namespace sql
+} // end namespace oceanbase
+
+int main(int argc, char **argv)
+{
+  OB_LOGGER.set_log_level("WARN");
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,167 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+#define USING_LOG_PREFIX SQL_ENG
+
+#include <gtest/gtest.h>
+#include "lib/allocator/page_arena.h"
+#include "share/datum/ob_datum_funcs.h"
+#include "sql/engine/expr/ob_expr.h"
+#include "sql/engine/ob_exec_context.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_dedup.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+class TestPythonUdfDedup : public ::testing::Test
+{
+public:
+  static const int64_t BATCH_SIZE = 100;
+
+  TestPythonUdfDedup() : alloc_(), exec_ctx_(alloc_), eval_ctx_(exec_ctx_) {}
+  virtual void SetUp() override
+  {
+    // one int arg of the udf, 8 bytes of payload per row after its datums
+    const int64_t frame_size = (sizeof(ObDatum) + sizeof(int64_t)) * BATCH_SIZE;
+    eval_ctx_.frames_ = static_cast<char **>(alloc_.alloc(sizeof(char *)));
+    ASSERT_TRUE(NULL != eval_ctx_.frames_);
+    eval_ctx_.frames_[0] = static_cast<char *>(alloc_.alloc(frame_size));
+    ASSERT_TRUE(NULL != eval_ctx_.frames_[0]);
+    MEMSET(eval_ctx_.frames_[0], 0, frame_size);
+    arg_.frame_idx_ = 0;
+    arg_.datum_off_ = 0;
+    arg_.batch_result_ = true;
+    arg_.basic_funcs_ = ObDatumFuncs::get_basic_func(ObIntType, CS_TYPE_BINARY);
+    ObDatum *datums = arg_.locate_batch_datums(eval_ctx_);
+    for (int64_t i = 0; i < BATCH_SIZE; i++) {
+      datums[i].ptr_ = eval_ctx_.frames_[0] + sizeof(ObDatum) * BATCH_SIZE + sizeof(int64_t) * i;
+      datums[i].set_int(i % 5);
+    }
+    args_[0] = &arg_;
+    udf_.arg_cnt_ = 1;
+    udf_.args_ = args_;
+  }
+
+protected:
+  ObArenaAllocator alloc_;
+  ObExecContext exec_ctx_;
+  ObEvalCtx eval_ctx_;
+  ObExpr arg_;
+  ObExpr *args_[1];
+  ObExpr udf_;
+};
+
+TEST_F(TestPythonUdfDedup, dedup)
+{
+  ObPyBatchDedup dedup;
+  int32_t sel[BATCH_SIZE];
+  int64_t sel_cnt = 0;
+  ObDatum results[BATCH_SIZE];
+  int64_t payloads[BATCH_SIZE];
+  // row 3 is skipped, the first row of arg 3 is row 8
+  for (int64_t i = 0; i < BATCH_SIZE; i++) {
+    if (3 != i) {
+      sel[sel_cnt++] = static_cast<int32_t>(i);
+    }
+    results[i].ptr_ = reinterpret_cast<char *>(&payloads[i]);
+    results[i].set_null();
+  }
+  ASSERT_EQ(OB_SUCCESS, dedup.prepare(alloc_, BATCH_SIZE));
+  ASSERT_EQ(OB_SUCCESS, dedup.dedup(udf_, eval_ctx_, sel, sel_cnt));
+  ASSERT_EQ(5, sel_cnt);
+  ASSERT_EQ(0, sel[0]);
+  ASSERT_EQ(1, sel[1]);
+  ASSERT_EQ(2, sel[2]);
+  ASSERT_EQ(4, sel[3]);
+  ASSERT_EQ(8, sel[4]);
+  ASSERT_EQ(BATCH_SIZE - 1 - 5, dedup.get_dup_cnt());
+
+  // results of the python call
+  for (int64_t k = 0; k < sel_cnt; k++) {
+    results[sel[k]].set_int(sel[k] % 5 * 10);
+  }
+  dedup.scatter(results);
+  ASSERT_EQ(0, dedup.get_dup_cnt());
+  for (int64_t i = 0; i < BATCH_SIZE; i++) {
+    if (3 == i) {
+      ASSERT_TRUE(results[i].is_null());
+    } else {
+      ASSERT_EQ(i % 5 * 10, results[i].get_int());
+    }
+  }
+
+  // buffers are kept for smaller batches
+  sel_cnt = BATCH_SIZE;
+  for (int64_t i = 0; i < BATCH_SIZE; i++) {
+    sel[i] = static_cast<int32_t>(i);
+  }
+  ASSERT_EQ(OB_SUCCESS, dedup.prepare(alloc_, BATCH_SIZE / 2));
+  ASSERT_EQ(OB_SUCCESS, dedup.dedup(udf_, eval_ctx_, sel, sel_cnt));
+  ASSERT_EQ(5, sel_cnt);
+  // a batch larger than prepared is refused
+  ObPyBatchDedup small;
+  sel_cnt = BATCH_SIZE;
+  for (int64_t i = 0; i < BATCH_SIZE; i++) {
+    sel[i] = static_cast<int32_t>(i);
+  }
+  ASSERT_EQ(OB_SUCCESS, small.prepare(alloc_, BATCH_SIZE / 2));
+  ASSERT_EQ(OB_INVALID_ARGUMENT, small.dedup(udf_, eval_ctx_, sel, sel_cnt));
+}
+
+TEST_F(TestPythonUdfDedup, const_args)
+{
+  ObPyBatchDedup dedup;
+  int32_t sel[BATCH_SIZE];
+  int64_t sel_cnt = BATCH_SIZE;
+  for (int64_t i = 0; i < BATCH_SIZE; i++) {
+    sel[i] = static_cast<int32_t>(i);
+  }
+  // every row has the args of the first one
+  arg_.batch_result_ = false;
+  ASSERT_EQ(OB_SUCCESS, dedup.prepare(alloc_, BATCH_SIZE));
+  ASSERT_EQ(OB_SUCCESS, dedup.dedup(udf_, eval_ctx_, sel, sel_cnt));
+  ASSERT_EQ(1, sel_cnt);
+  ASSERT_EQ(0, sel[0]);
+  ASSERT_EQ(BATCH_SIZE - 1, dedup.get_dup_cnt());
+}
+
+TEST_F(TestPythonUdfDedup, stat)
+{
+  ObPyDedupStat stat;
+  // small batches and the first batch
+  ASSERT_FALSE(stat.need_dedup(ObPyDedupStat::MIN_ROWS - 1));
+  ASSERT_TRUE(stat.need_dedup(BATCH_SIZE));
+  stat.add_batch(BATCH_SIZE, 10);
+  ASSERT_DOUBLE_EQ(0.1, stat.get_distinct_ratio());
+  ASSERT_TRUE(stat.need_dedup(BATCH_SIZE));
+  // mostly distinct, measured again after PROBE_INTERVAL batches
+  stat.add_batch(BATCH_SIZE, 90);
+  for (int64_t i = 0; i < ObPyDedupStat::PROBE_INTERVAL - 1; i++) {
+    ASSERT_FALSE(stat.need_dedup(BATCH_SIZE));
+  }
+  ASSERT_TRUE(stat.need_dedup(BATCH_SIZE));
+  stat.add_batch(BATCH_SIZE, 20);
+  ASSERT_TRUE(stat.need_dedup(BATCH_SIZE));
+}
+
+} // end namespace sql
+} // end namespace oceanbase
+
+int main(int argc, char **argv)
+{
+  OB_LOGGER.set_log_level("WARN");
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
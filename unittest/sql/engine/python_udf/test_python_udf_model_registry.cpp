@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+#define USING_LOG_PREFIX SQL_ENG
+
+#define PY_SSIZE_T_CLEAN
+#include <gtest/gtest.h>
+#include "sql/engine/expr/ob_expr_python_udf.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_model_registry.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+class TestPythonUdfModelRegistry : public ::testing::Test
+{
+public:
+  virtual void SetUp()
+  {
+    if (!Py_IsInitialized()) {
+      Py_InitializeEx(0);
+      PyEval_SaveThread();
+    }
+    gstate_ = PyGILState_Ensure();
+    ASSERT_EQ(OB_SUCCESS, registry_.init(OB_SYS_TENANT_ID));
+    registry_.set_mem_limit(0);
+  }
+  virtual void TearDown()
+  {
+    registry_.destroy();
+    PyGILState_Release(gstate_);
+  }
+
+  // pyinitial counts its runs and keeps a model of about 800KB
+  static void make_meta(const char *name, const uint64_t udf_id, const int64_t schema_version,
+                        share::schema::ObPythonUDFMeta &meta)
+  {
+    meta.name_ = ObString::make_string(name);
+    meta.pycall_ = ObString::make_string(
+        "import builtins\n"
+        "def pyinitial():\n"
+        "    global model\n"
+        "    builtins.ob_init_cnt = getattr(builtins, 'ob_init_cnt', 0) + 1\n"
+        "    model = [float(i) for i in range(100000)]\n"
+        "def pyfun(a):\n"
+        "    return a + model[1]\n");
+    meta.ret_ = share::schema::ObPythonUDF::REAL;
+    meta.udf_id_ = udf_id;
+    meta.schema_version_ = schema_version;
+  }
+  static int64_t get_init_cnt()
+  {
+    PyObject *cnt = PyDict_GetItemString(PyEval_GetBuiltins(), "ob_init_cnt");
+    return NULL == cnt ? 0 : PyLong_AsLongLong(cnt);
+  }
+  static bool is_loaded(const char *name)
+  {
+    std::string handler(name);
+    handler.append("_pyfun");
+    return NULL != PyDict_GetItemString(PyModule_GetDict(PyImport_AddModule("__main__")),
+                                        handler.c_str());
+  }
+
+protected:
+  ObPyModelRegistry registry_;
+  PyGILState_STATE gstate_;
+};
+
+TEST_F(TestPythonUdfModelRegistry, bind_once_per_version)
+{
+  share::schema::ObPythonUDFMeta meta;
+  ObSEArray<ObPyModelRegistry::Entry, 4> entries;
+  make_meta("registry_udf", 1, 1, meta);
+  const int64_t init_cnt = get_init_cnt();
+  ASSERT_EQ(OB_SUCCESS, registry_.bind(meta));
+  ASSERT_EQ(OB_SUCCESS, registry_.bind(meta));
+  ASSERT_EQ(init_cnt + 1, get_init_cnt());
+  ASSERT_TRUE(is_loaded("registry_udf"));
+  // the globals of the udf stay out of __main__
+  ASSERT_TRUE(NULL == PyDict_GetItemString(PyModule_GetDict(PyImport_AddModule("__main__")), "model"));
+  make_meta("registry_udf", 1, 2, meta);
+  ASSERT_EQ(OB_SUCCESS, registry_.bind(meta));
+  ASSERT_EQ(init_cnt + 2, get_init_cnt());
+  ASSERT_EQ(OB_SUCCESS, registry_.get_entries(entries));
+  ASSERT_EQ(1, entries.count());
+  ASSERT_EQ(2, entries.at(0).schema_version_);
+  ASSERT_EQ(ObPyModelRegistry::LOADED, entries.at(0).state_);
+  ASSERT_GT(entries.at(0).mem_size_, 0);
+}
+
+TEST_F(TestPythonUdfModelRegistry, evict_least_recently_used)
+{
+  share::schema::ObPythonUDFMeta meta_a;
+  share::schema::ObPythonUDFMeta meta_b;
+  ObSEArray<ObPyModelRegistry::Entry, 4> entries;
+  make_meta("registry_udf_a", 11, 1, meta_a);
+  make_meta("registry_udf_b", 12, 1, meta_b);
+  registry_.set_mem_limit(1);
+  ASSERT_EQ(OB_SUCCESS, registry_.bind(meta_a));
+  ASSERT_EQ(OB_SUCCESS, registry_.bind(meta_b));
+  // the udf just bound is kept even above the limit
+  ASSERT_FALSE(is_loaded("registry_udf_a"));
+  ASSERT_TRUE(is_loaded("registry_udf_b"));
+  ASSERT_EQ(OB_SUCCESS, registry_.get_entries(entries));
+  ASSERT_EQ(1, entries.count());
+  ASSERT_EQ(12, entries.at(0).udf_id_);
+  // reloaded on the next bind
+  const int64_t init_cnt = get_init_cnt();
+  ASSERT_EQ(OB_SUCCESS, registry_.bind(meta_a));
+  ASSERT_EQ(init_cnt + 1, get_init_cnt());
+  ASSERT_TRUE(is_loaded("registry_udf_a"));
+  ASSERT_FALSE(is_loaded("registry_udf_b"));
+  // unlimited
+  registry_.set_mem_limit(0);
+  ASSERT_EQ(OB_SUCCESS, registry_.bind(meta_b));
+  ASSERT_TRUE(is_loaded("registry_udf_a"));
+  ASSERT_TRUE(is_loaded("registry_udf_b"));
+  ASSERT_GT(registry_.get_mem_used(), entries.at(0).mem_size_);
+}
+
+} // end namespace sql
+} // end namespace oceanbase
+
+int main(int argc, char **argv)
+{
+  OB_LOGGER.set_log_level("WARN");
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+#define USING_LOG_PREFIX SQL_ENG
+
+#include <gtest/gtest.h>
+#include "sql/engine/python_udf_engine/ob_python_udf_result_cache.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+class TestPythonUdfResultCache : public ::testing::Test
+{
+};
+
+TEST_F(TestPythonUdfResultCache, key)
+{
+  const char args[] = "\x03\x00\x00\x00" "abc";
+  const char other_args[] = "\x03\x00\x00\x00" "abd";
+  ObPyResultCacheKey key(1001, 1, 10, ObString(sizeof(args) - 1, args));
+  ASSERT_TRUE(key == ObPyResultCacheKey(1001, 1, 10, ObString(sizeof(args) - 1, args)));
+  // another version of the udf or other args
+  ASSERT_FALSE(key == ObPyResultCacheKey(1001, 1, 11, ObString(sizeof(args) - 1, args)));
+  ASSERT_FALSE(key == ObPyResultCacheKey(1001, 1, 10, ObString(sizeof(other_args) - 1, other_args)));
+  ASSERT_FALSE(key == ObPyResultCacheKey(1002, 1, 10, ObString(sizeof(args) - 1, args)));
+
+  char buf[256];
+  ObIKVCacheKey *copied = NULL;
+  ASSERT_EQ(OB_INVALID_ARGUMENT, key.deep_copy(buf, key.size() - 1, copied));
+  ASSERT_EQ(OB_SUCCESS, key.deep_copy(buf, sizeof(buf), copied));
+  ASSERT_TRUE(key == *copied);
+  ASSERT_EQ(key.hash(), copied->hash());
+  ASSERT_EQ(buf + sizeof(key), static_cast<ObPyResultCacheKey *>(copied)->args_.ptr());
+}
+
+TEST_F(TestPythonUdfResultCache, value)
+{
+  char buf[256];
+  ObIKVCacheValue *copied = NULL;
+  const char str[] = "positive";
+  ObDatum datum;
+  datum.set_string(str, static_cast<int32_t>(sizeof(str) - 1));
+  ObPyResultCacheValue value(datum);
+  ASSERT_EQ(OB_SUCCESS, value.deep_copy(buf, sizeof(buf), copied));
+  const ObDatum &copied_datum = static_cast<ObPyResultCacheValue *>(copied)->datum_;
+  ASSERT_EQ(0, copied_datum.get_string().compare(ObString(sizeof(str) - 1, str)));
+  ASSERT_NE(datum.ptr_, copied_datum.ptr_);
+
+  int64_t int_value = 42;
+  datum.ptr_ = reinterpret_cast<const char *>(&int_value);
+  datum.pack_ = sizeof(int_value);
+  ObPyResultCacheValue int_result(datum);
+  ASSERT_EQ(OB_SUCCESS, int_result.deep_copy(buf, sizeof(buf), copied));
+  ASSERT_EQ(42, static_cast<ObPyResultCacheValue *>(copied)->datum_.get_int());
+}
+
+TEST_F(TestPythonUdfResultCache, evict_cnt)
+{
+  ObPyResultCacheStat stat;
+  stat.put_cnt_ = 100;
+  stat.kv_cnt_ = 60;
+  ASSERT_EQ(40, stat.get_evict_cnt());
+  // counters are read one after another
+  stat.kv_cnt_ = 101;
+  ASSERT_EQ(0, stat.get_evict_cnt());
+}
+
+} // end namespace sql
+} // end namespace oceanbase
+
+int main(int argc, char **argv)
+{
+  OB_LOGGER.set_log_level("WARN");
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
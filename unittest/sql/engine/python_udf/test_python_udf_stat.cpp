@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+#define USING_LOG_PREFIX SQL_ENG
+
+#include <gtest/gtest.h>
+#include "sql/engine/python_udf_engine/ob_python_udf_stat.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+static ObPyUdfStageStat make_stat(const int64_t rows, const int64_t batch_size)
+{
+  ObPyUdfStageStat stat;
+  stat.batch_cnt_ = 1;
+  stat.row_cnt_ = rows;
+  stat.gil_wait_cycles_ = 10;
+  stat.ob2py_cycles_ = 100;
+  stat.infer_cycles_ = 1000;
+  stat.py2ob_cycles_ = 200;
+  stat.batch_size_ = batch_size;
+  return stat;
+}
+
+TEST(TestPythonUdfStat, stage_stat)
+{
+  ObPyUdfStageStat stat;
+  stat.add(make_stat(256, 256));
+  stat.add(make_stat(100, 512));
+  ASSERT_EQ(2, stat.batch_cnt_);
+  ASSERT_EQ(356, stat.row_cnt_);
+  ASSERT_EQ(20, stat.gil_wait_cycles_);
+  ASSERT_EQ(200, stat.ob2py_cycles_);
+  ASSERT_EQ(2000, stat.infer_cycles_);
+  ASSERT_EQ(400, stat.py2ob_cycles_);
+  ASSERT_EQ(512, stat.batch_size_);
+  // a gil wait alone keeps the batch size of the last call
+  ObPyUdfStageStat wait;
+  wait.gil_wait_cycles_ = 5;
+  stat.add(wait);
+  ASSERT_EQ(2, stat.batch_cnt_);
+  ASSERT_EQ(25, stat.gil_wait_cycles_);
+  ASSERT_EQ(512, stat.batch_size_);
+}
+
+TEST(TestPythonUdfStat, stat_mgr)
+{
+  ObPyUdfStatMgr mgr;
+  ObSEArray<ObPyUdfStatInfo, 4> infos;
+  ASSERT_EQ(OB_NOT_INIT, mgr.add(ObPyUdfStatKey(1, 1), 1, ObString::make_string("f"),
+                                 make_stat(1, 1)));
+  ASSERT_EQ(OB_SUCCESS, mgr.init(OB_SYS_TENANT_ID));
+  // two plans running udf 1, one running udf 2
+  ASSERT_EQ(OB_SUCCESS, mgr.add(ObPyUdfStatKey(1, 10), 5, ObString::make_string("f"),
+                                make_stat(256, 256)));
+  ASSERT_EQ(OB_SUCCESS, mgr.add(ObPyUdfStatKey(1, 10), 6, ObString::make_string("f"),
+                                make_stat(128, 256)));
+  ASSERT_EQ(OB_SUCCESS, mgr.add(ObPyUdfStatKey(1, 11), 6, ObString::make_string("f"),
+                                make_stat(64, 64)));
+  ASSERT_EQ(OB_SUCCESS, mgr.add(ObPyUdfStatKey(2, 10), 7, ObString::make_string("g"),
+                                make_stat(32, 32)));
+  ASSERT_EQ(OB_SUCCESS, mgr.get_all(infos));
+  ASSERT_EQ(3, infos.count());
+  for (int64_t i = 0; i < infos.count(); i++) {
+    const ObPyUdfStatInfo &info = infos.at(i);
+    if (1 == info.key_.udf_id_ && 10 == info.key_.plan_id_) {
+      ASSERT_EQ(6, info.schema_version_);
+      ASSERT_EQ(0, info.get_name().compare("f"));
+      ASSERT_EQ(2, info.stat_.batch_cnt_);
+      ASSERT_EQ(384, info.stat_.row_cnt_);
+      ASSERT_EQ(2000, info.stat_.infer_cycles_);
+    } else if (1 == info.key_.udf_id_) {
+      ASSERT_EQ(11, info.key_.plan_id_);
+      ASSERT_EQ(64, info.stat_.row_cnt_);
+    } else {
+      ASSERT_EQ(2, info.key_.udf_id_);
+      ASSERT_EQ(0, info.get_name().compare("g"));
+      ASSERT_EQ(32, info.stat_.batch_size_);
+    }
+  }
+  mgr.destroy();
+}
+
+} // end namespace sql
+} // end namespace oceanbase
+
+int main(int argc, char **argv)
+{
+  OB_LOGGER.set_log_level("WARN");
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
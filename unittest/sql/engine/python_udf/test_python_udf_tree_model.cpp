@@ -0,0 +1,340 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+#define USING_LOG_PREFIX SQL_ENG
+
+#define PY_SSIZE_T_CLEAN
+#include <gtest/gtest.h>
+#include <cmath>
+#include <string>
+#include "lib/allocator/page_arena.h"
+#include "lib/time/ob_time_utility.h"
+#include "sql/engine/expr/ob_expr_python_udf.h"
+#include "sql/engine/ob_exec_context.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_tree_model.h"
+#include "ob_python_udf_test_util.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+// f0 < 0.5 ? 1 : (f1 < 2 ? -1 : 0.5), NaN of f0 goes right and NaN of f1 left, plus 0.25
+static const char *XGBOOST_TREES =
+    "[{\"nodeid\": 0, \"depth\": 0, \"split\": \"f0\", \"split_condition\": 0.5,"
+    "  \"yes\": 1, \"no\": 2, \"missing\": 2, \"children\": ["
+    "    {\"nodeid\": 1, \"leaf\": 1.0},"
+    "    {\"nodeid\": 2, \"depth\": 1, \"split\": \"f1\", \"split_condition\": 2,"
+    "     \"yes\": 3, \"no\": 4, \"missing\": 3, \"children\": ["
+    "       {\"nodeid\": 3, \"leaf\": -1.0}, {\"nodeid\": 4, \"leaf\": 0.5}]}]},"
+    " {\"nodeid\": 0, \"leaf\": 0.25}]";
+
+// f1 <= 1.5 ? 0.2 : -0.4, NaN goes left
+static const char *LIGHTGBM_TREE =
+    "{\"tree_index\": 0, \"tree_structure\": {\"split_index\": 0, \"split_feature\": 1,"
+    " \"threshold\": 1.5, \"decision_type\": \"<=\", \"default_left\": true,"
+    " \"missing_type\": \"NaN\", \"left_child\": {\"leaf_index\": 0, \"leaf_value\": 0.2},"
+    " \"right_child\": {\"leaf_index\": 1, \"leaf_value\": -0.4}}}";
+
+class TestPythonUdfTreeModel : public ::testing::Test
+{
+public:
+  static double sigmoid(const double x) { return 1.0 / (1.0 + std::exp(-x)); }
+
+protected:
+  ObArenaAllocator alloc_;
+};
+
+TEST_F(TestPythonUdfTreeModel, xgboost)
+{
+  ObPyTreeModel model;
+  // column major, rows (0, 0), (1, 0), (1, 3), (NaN, NaN), (0.5, 5)
+  const double features[] = {0, 1, 1, NAN, 0.5,
+                             0, 0, 3, NAN, 5};
+  double scores[5];
+  ASSERT_EQ(OB_SUCCESS, model.init(alloc_, ObString::make_string(XGBOOST_TREES)));
+  ASSERT_EQ(OB_INIT_TWICE, model.init(alloc_, ObString::make_string(XGBOOST_TREES)));
+  ASSERT_EQ(2, model.get_tree_cnt());
+  ASSERT_EQ(6, model.get_node_cnt());
+  ASSERT_EQ(2, model.get_feature_cnt());
+  model.score(features, 5, scores);
+  ASSERT_DOUBLE_EQ(1.25, scores[0]);
+  ASSERT_DOUBLE_EQ(-0.75, scores[1]);
+  ASSERT_DOUBLE_EQ(0.75, scores[2]);
+  ASSERT_DOUBLE_EQ(-0.75, scores[3]);
+  ASSERT_DOUBLE_EQ(0.75, scores[4]);
+
+  // the same trees with a base score and a logistic objective
+  ObPyTreeModel logistic;
+  std::string dump("{\"objective\": \"binary:logistic\", \"base_score\": 0.5, \"trees\": ");
+  dump.append(XGBOOST_TREES).append("}");
+  ASSERT_EQ(OB_SUCCESS, logistic.init(alloc_, ObString(dump.length(), dump.c_str())));
+  logistic.score(features, 5, scores);
+  ASSERT_DOUBLE_EQ(sigmoid(1.75), scores[0]);
+  ASSERT_DOUBLE_EQ(sigmoid(-0.25), scores[1]);
+}
+
+TEST_F(TestPythonUdfTreeModel, lightgbm)
+{
+  // column major, f1 of the rows is 1.5, 2, NaN
+  const double features[] = {0, 0, 0,
+                             1.5, 2, NAN};
+  double scores[3];
+  ObPyTreeModel model;
+  std::string dump("{\"objective\": \"binary sigmoid:1\", \"tree_info\": [");
+  dump.append(LIGHTGBM_TREE).append("]}");
+  ASSERT_EQ(OB_SUCCESS, model.init(alloc_, ObString(dump.length(), dump.c_str())));
+  ASSERT_EQ(2, model.get_feature_cnt());
+  model.score(features, 3, scores);
+  ASSERT_DOUBLE_EQ(sigmoid(0.2), scores[0]);
+  ASSERT_DOUBLE_EQ(sigmoid(-0.4), scores[1]);
+  ASSERT_DOUBLE_EQ(sigmoid(0.2), scores[2]);
+
+  // random forest, the mean of the trees
+  ObPyTreeModel forest;
+  dump.assign("{\"objective\": \"regression\", \"average_output\": true, \"tree_info\": [");
+  dump.append(LIGHTGBM_TREE).append(", ").append(LIGHTGBM_TREE).append("]}");
+  ASSERT_EQ(OB_SUCCESS, forest.init(alloc_, ObString(dump.length(), dump.c_str())));
+  forest.score(features, 3, scores);
+  ASSERT_DOUBLE_EQ(0.2, scores[0]);
+  ASSERT_DOUBLE_EQ(-0.4, scores[1]);
+}
+
+TEST_F(TestPythonUdfTreeModel, invalid_dump)
+{
+  const char *not_supported[] = {
+    // named feature
+    "[{\"nodeid\": 0, \"split\": \"age\", \"split_condition\": 1, \"yes\": 1, \"no\": 2,"
+    "  \"children\": [{\"nodeid\": 1, \"leaf\": 1}, {\"nodeid\": 2, \"leaf\": 2}]}]",
+    // objective
+    "{\"objective\": \"multi:softprob\", \"trees\": [{\"nodeid\": 0, \"leaf\": 1}]}",
+    // categorical split
+    "{\"tree_info\": [{\"tree_structure\": {\"split_feature\": 0, \"threshold\": \"1||2\","
+    " \"decision_type\": \"==\", \"missing_type\": \"None\","
+    " \"left_child\": {\"leaf_value\": 1}, \"right_child\": {\"leaf_value\": 2}}}]}"
+  };
+  const char *invalid[] = {
+    "[]",
+    "{\"objective\": \"reg:squarederror\"}",
+    // child not in the dump
+    "[{\"nodeid\": 0, \"split\": \"f0\", \"split_condition\": 1, \"yes\": 1, \"no\": 3,"
+    "  \"children\": [{\"nodeid\": 1, \"leaf\": 1}, {\"nodeid\": 2, \"leaf\": 2}]}]",
+    // feature out of range
+    "[{\"nodeid\": 0, \"split\": 5000, \"split_condition\": 1, \"yes\": 1, \"no\": 2,"
+    "  \"children\": [{\"nodeid\": 1, \"leaf\": 1}, {\"nodeid\": 2, \"leaf\": 2}]}]"
+  };
+  for (int64_t i = 0; i < ARRAYSIZEOF(not_supported); i++) {
+    ObPyTreeModel model;
+    ASSERT_EQ(OB_NOT_SUPPORTED, model.init(alloc_, ObString::make_string(not_supported[i])));
+    ASSERT_FALSE(model.is_inited());
+  }
+  for (int64_t i = 0; i < ARRAYSIZEOF(invalid); i++) {
+    ObPyTreeModel model;
+    ASSERT_EQ(OB_INVALID_ARGUMENT, model.init(alloc_, ObString::make_string(invalid[i])));
+    ASSERT_FALSE(model.is_inited());
+  }
+  ObPyTreeModel model;
+  ASSERT_NE(OB_SUCCESS, model.init(alloc_, ObString::make_string("[{\"nodeid\": 0,")));
+}
+
+// the same random ensemble scored by a numpy udf through eval_test_udf_batch and natively
+// through eval_tree_udf_batch
+class TestPythonUdfTreeBench : public ::testing::Test
+{
+public:
+  static const int64_t FEATURE_CNT = 4;
+  static const int64_t TREE_CNT = 100;
+  static const int64_t TREE_DEPTH = 6;
+  static const int64_t BATCH_SIZE = 256;
+  static const int64_t ROW_CNT = 8192;
+  // exprs of the args, then the python udf and the tree udf, one frame each
+  static const int64_t EXPR_CNT = FEATURE_CNT + 2;
+
+  TestPythonUdfTreeBench()
+      : alloc_(), exec_ctx_(alloc_), eval_ctx_(exec_ctx_), frames_(alloc_, eval_ctx_, BATCH_SIZE),
+        py_info_(alloc_, T_FUN_SYS_PYTHON_UDF), tree_info_(alloc_, T_FUN_SYS_PYTHON_UDF) {}
+  virtual void SetUp()
+  {
+    if (!Py_IsInitialized()) {
+      Py_InitializeEx(0);
+      PyEval_SaveThread();
+    }
+    srand(1);
+    std::string trees("[");
+    for (int64_t t = 0; t < TREE_CNT; t++) {
+      append_node(0, 0, trees);
+      trees.append(t < TREE_CNT - 1 ? ", " : "]");
+    }
+    dump_ = trees;
+    pycall_.assign("import json\n"
+                   "import numpy as np\n"
+                   "dump = r'''").append(dump_).append("'''\n"
+                   "def pyinitial():\n"
+                   "    global trees\n"
+                   "    trees = json.loads(dump)\n"
+                   "def walk(node, x, rows, out):\n"
+                   "    if 'leaf' in node:\n"
+                   "        out[rows] += node['leaf']\n"
+                   "        return\n"
+                   "    v = x[int(node['split'][1:])][rows]\n"
+                   "    left = v < node['split_condition']\n"
+                   "    if node['missing'] == node['yes']:\n"
+                   "        left |= np.isnan(v)\n"
+                   "    kids = {c['nodeid']: c for c in node['children']}\n"
+                   "    walk(kids[node['yes']], x, rows[left], out)\n"
+                   "    walk(kids[node['no']], x, rows[~left], out)\n"
+                   "def pyfun(f0, f1, f2, f3):\n"
+                   "    x = [f0, f1, f2, f3]\n"
+                   "    out = np.zeros(len(f0))\n"
+                   "    for t in trees:\n"
+                   "        walk(t, x, np.arange(len(f0)), out)\n"
+                   "    return out\n");
+    make_meta("bench_tree_py", 1, share::schema::ObPythonUDF::PYTHON, pycall_, py_info_.udf_meta_);
+    make_meta("bench_tree_native", 2, share::schema::ObPythonUDF::TREES, dump_,
+              tree_info_.udf_meta_);
+    ASSERT_EQ(OB_SUCCESS, tree_info_.init_tree_model());
+
+    ASSERT_EQ(OB_SUCCESS, frames_.init(EXPR_CNT));
+    for (int64_t i = 0; i < FEATURE_CNT; i++) {
+      ASSERT_EQ(OB_SUCCESS, frames_.init_expr(i, ObDoubleType, args_[i]));
+      arg_ptrs_[i] = &args_[i];
+    }
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(FEATURE_CNT, ObDoubleType, py_udf_));
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(FEATURE_CNT + 1, ObDoubleType, tree_udf_));
+    py_udf_.args_ = arg_ptrs_;
+    py_udf_.arg_cnt_ = FEATURE_CNT;
+    py_udf_.extra_info_ = &py_info_;
+    py_udf_.expr_ctx_id_ = 0;
+    tree_udf_.args_ = arg_ptrs_;
+    tree_udf_.arg_cnt_ = FEATURE_CNT;
+    tree_udf_.extra_info_ = &tree_info_;
+    tree_udf_.expr_ctx_id_ = 1;
+    expr_op_ctx_store_[0] = NULL;
+    expr_op_ctx_store_[1] = NULL;
+    exec_ctx_.set_expr_op_ctx_store(expr_op_ctx_store_);
+    exec_ctx_.set_expr_op_size(2);
+    skip_ = to_bit_vector(alloc_.alloc(ObBitVector::memory_size(BATCH_SIZE)));
+    ASSERT_TRUE(NULL != skip_);
+    skip_->init(BATCH_SIZE);
+  }
+  virtual void TearDown()
+  {
+    // python handles of the udf ctx are released with the GIL
+    exec_ctx_.reset_expr_op();
+  }
+
+  // complete tree, nodes numbered breadth-first
+  static void append_node(const int64_t node_id, const int64_t depth, std::string &out)
+  {
+    char buf[256];
+    if (TREE_DEPTH == depth) {
+      snprintf(buf, sizeof(buf), "{\"nodeid\": %ld, \"leaf\": %.17g}",
+               node_id, static_cast<double>(rand()) / RAND_MAX * 2 - 1);
+      out.append(buf);
+    } else {
+      const int64_t yes = node_id * 2 + 1;
+      const int64_t no = node_id * 2 + 2;
+      snprintf(buf, sizeof(buf),
+               "{\"nodeid\": %ld, \"split\": \"f%ld\", \"split_condition\": %.17g,"
+               " \"yes\": %ld, \"no\": %ld, \"missing\": %ld, \"children\": [",
+               node_id, rand() % FEATURE_CNT, static_cast<double>(rand()) / RAND_MAX,
+               yes, no, 0 == rand() % 2 ? yes : no);
+      out.append(buf);
+      append_node(yes, depth + 1, out);
+      out.append(", ");
+      append_node(no, depth + 1, out);
+      out.append("]}");
+    }
+  }
+  static void make_meta(const char *name, const uint64_t udf_id, const int64_t language,
+                        const std::string &code, share::schema::ObPythonUDFMeta &meta)
+  {
+    meta.name_ = ObString::make_string(name);
+    meta.pycall_ = ObString(code.length(), code.c_str());
+    meta.ret_ = share::schema::ObPythonUDF::REAL;
+    meta.language_ = static_cast<share::schema::ObPythonUDF::PyUdfLanguage>(language);
+    meta.udf_id_ = udf_id;
+    meta.schema_version_ = 1;
+  }
+  // features of the rows [start, start + BATCH_SIZE), some of them missing
+  void fill_batch(const int64_t start)
+  {
+    for (int64_t f = 0; f < FEATURE_CNT; f++) {
+      ObDatum *datums = args_[f].locate_batch_datums(eval_ctx_);
+      for (int64_t i = 0; i < BATCH_SIZE; i++) {
+        const int64_t row = start + i;
+        datums[i].set_double(0 == (row + f) % 97 ? NAN
+                             : static_cast<double>((row * 7919 + f * 104729) % 10007) / 10007);
+      }
+    }
+  }
+  int eval(ObExpr &expr, ObExpr::EvalBatchFunc func)
+  {
+    expr.get_evaluated_flags(eval_ctx_).reset(BATCH_SIZE);
+    return func(expr, eval_ctx_, *skip_, BATCH_SIZE);
+  }
+
+protected:
+  ObArenaAllocator alloc_;
+  ObExecContext exec_ctx_;
+  ObEvalCtx eval_ctx_;
+  ObPyUdfTestFrames frames_;
+  ObPythonUdfInfo py_info_;
+  ObPythonUdfInfo tree_info_;
+  std::string dump_;
+  std::string pycall_;
+  ObExpr args_[FEATURE_CNT];
+  ObExpr *arg_ptrs_[FEATURE_CNT];
+  ObExpr py_udf_;
+  ObExpr tree_udf_;
+  ObExprOperatorCtx *expr_op_ctx_store_[2];
+  ObBitVector *skip_;
+};
+
+TEST_F(TestPythonUdfTreeBench, python_vs_native)
+{
+  int64_t python_us = 0;
+  int64_t native_us = 0;
+  ASSERT_EQ(TREE_CNT, tree_info_.tree_model_.get_tree_cnt());
+  ASSERT_EQ(OB_SUCCESS, ObExprPythonUdf::import_udf(py_info_.udf_meta_));
+  for (int64_t start = 0; start < ROW_CNT; start += BATCH_SIZE) {
+    fill_batch(start);
+    int64_t begin = ObTimeUtility::current_time();
+    ASSERT_EQ(OB_SUCCESS, eval(py_udf_, ObExprPythonUdf::eval_test_udf_batch));
+    python_us += ObTimeUtility::current_time() - begin;
+    begin = ObTimeUtility::current_time();
+    ASSERT_EQ(OB_SUCCESS, eval(tree_udf_, ObExprPythonUdf::eval_tree_udf_batch));
+    native_us += ObTimeUtility::current_time() - begin;
+    const ObDatum *py_res = py_udf_.locate_batch_datums(eval_ctx_);
+    const ObDatum *tree_res = tree_udf_.locate_batch_datums(eval_ctx_);
+    for (int64_t i = 0; i < BATCH_SIZE; i++) {
+      ASSERT_NEAR(py_res[i].get_double(), tree_res[i].get_double(), 1e-9);
+    }
+  }
+  const int64_t trees = TREE_CNT;
+  const int64_t depth = TREE_DEPTH;
+  const int64_t batch_size = BATCH_SIZE;
+  LOG_INFO("tree model throughput in rows/s", K(trees), K(depth), K(batch_size),
+           "python", ROW_CNT * 1000000 / (python_us + 1),
+           "native", ROW_CNT * 1000000 / (native_us + 1));
+}
+
+} // end namespace sql
+} // end namespace oceanbase
+
+int main(int argc, char **argv)
+{
+  OB_LOGGER.set_log_level("WARN");
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
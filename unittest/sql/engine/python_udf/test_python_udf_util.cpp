@@ -0,0 +1,196 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+#define USING_LOG_PREFIX SQL_ENG
+
+#define PY_SSIZE_T_CLEAN
+#include <gtest/gtest.h>
+#include <string>
+#include "sql/engine/python_udf_engine/ob_python_udf_util.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+class TestPythonUdfUtil : public ::testing::Test
+{
+public:
+  virtual void SetUp()
+  {
+    if (!Py_IsInitialized()) {
+      Py_InitializeEx(0);
+      PyEval_SaveThread();
+    }
+    gstate_ = PyGILState_Ensure();
+    // numpy c api is loaded per translation unit
+    has_numpy_ = OB_SUCCESS == ObPythonUdfUtil::import_numpy()
+                 && (NULL != PyArray_API || _import_array() >= 0);
+    if (!has_numpy_) {
+      PyErr_Clear();
+    }
+  }
+  virtual void TearDown()
+  {
+    PyGILState_Release(gstate_);
+  }
+  static void set_strings(const char **strs, const int64_t cnt, ObDatum *datums)
+  {
+    for (int64_t i = 0; i < cnt; i++) {
+      datums[i].set_string(strs[i], static_cast<int32_t>(strlen(strs[i])));
+    }
+  }
+
+protected:
+  PyGILState_STATE gstate_;
+  bool has_numpy_;
+};
+
+TEST_F(TestPythonUdfUtil, strings_to_numpy)
+{
+  ASSERT_TRUE(has_numpy_);
+  // "héllo" is 5 code points in 6 bytes
+  const char *strs[] = {"ab", "skipped", "h\xc3\xa9llo", ""};
+  const int32_t sel[] = {0, 2, 3};
+  ObDatum datums[4];
+  PyObject *array = NULL;
+  set_strings(strs, 4, datums);
+  ASSERT_EQ(OB_SUCCESS, ObPythonUdfUtil::strings_to_numpy(datums, false, sel, 3, array));
+  ASSERT_TRUE(NULL != array);
+  PyArrayObject *np = reinterpret_cast<PyArrayObject *>(array);
+  ASSERT_EQ(NPY_UNICODE, PyArray_TYPE(np));
+  ASSERT_EQ(3, PyArray_DIM(np, 0));
+  ASSERT_EQ(static_cast<int64_t>(5 * sizeof(uint32_t)), PyArray_ITEMSIZE(np));
+  const uint32_t *data = static_cast<const uint32_t *>(PyArray_DATA(np));
+  const uint32_t expect[] = {'a', 'b', 0, 0, 0, 'h', 0xe9, 'l', 'l', 'o', 0, 0, 0, 0, 0};
+  for (int64_t i = 0; i < 15; i++) {
+    ASSERT_EQ(expect[i], data[i]);
+  }
+
+  // the owned unicode result is encoded into utf8 in place
+  ObDatum results[4];
+  int64_t ret_cnt = 0;
+  ASSERT_EQ(OB_SUCCESS, ObPythonUdfUtil::numpy_to_datums(ObVarcharType, array, sel, 3,
+                                                         results, ret_cnt));
+  ASSERT_EQ(3, ret_cnt);
+  ASSERT_EQ(ObString::make_string("ab"), results[0].get_string());
+  ASSERT_EQ(ObString::make_string("h\xc3\xa9llo"), results[2].get_string());
+  ASSERT_EQ(0, results[3].len_);
+  Py_DECREF(array);
+
+  // a const arg is repeated for every row
+  ASSERT_EQ(OB_SUCCESS, ObPythonUdfUtil::strings_to_numpy(datums + 2, true, sel, 3, array));
+  ASSERT_TRUE(NULL != array);
+  ASSERT_EQ(3, PyArray_DIM(reinterpret_cast<PyArrayObject *>(array), 0));
+  Py_DECREF(array);
+}
+
+TEST_F(TestPythonUdfUtil, strings_to_object_array)
+{
+  ASSERT_TRUE(has_numpy_);
+  ObDatum datums[8];
+  const int32_t sel[] = {0, 1, 2, 3, 4, 5, 6, 7};
+  PyObject *array = NULL;
+  std::string long_str(1000, 'x');
+  // one long string, padding the others to it wastes too much
+  for (int64_t i = 0; i < 8; i++) {
+    datums[i].set_string("a", 1);
+  }
+  datums[7].set_string(long_str.c_str(), static_cast<int32_t>(long_str.length()));
+  ASSERT_EQ(OB_SUCCESS, ObPythonUdfUtil::strings_to_numpy(datums, false, sel, 8, array));
+  ASSERT_TRUE(NULL == array);
+  // invalid utf8 is left to the object array
+  datums[7].set_string("\xff", 1);
+  ASSERT_EQ(OB_SUCCESS, ObPythonUdfUtil::strings_to_numpy(datums, false, sel, 8, array));
+  ASSERT_TRUE(NULL == array);
+  // datums_to_numpy falls back to an object array
+  datums[7].set_string(long_str.c_str(), static_cast<int32_t>(long_str.length()));
+  ASSERT_EQ(OB_SUCCESS, ObPythonUdfUtil::datums_to_numpy(ObVarcharType, datums, false, sel, 8,
+                                                         array));
+  ASSERT_EQ(NPY_OBJECT, PyArray_TYPE(reinterpret_cast<PyArrayObject *>(array)));
+  ASSERT_TRUE(ObPythonUdfUtil::is_reusable(ObVarcharType, array, 8));
+  ASSERT_FALSE(ObPythonUdfUtil::is_reusable(ObVarcharType, array, 9));
+  ASSERT_FALSE(ObPythonUdfUtil::is_reusable(ObIntType, array, 8));
+  Py_DECREF(array);
+}
+
+TEST_F(TestPythonUdfUtil, bytes_result)
+{
+  ASSERT_TRUE(has_numpy_);
+  npy_intp elements[1] = {2};
+  PyObject *array = PyArray_New(&PyArray_Type, 1, elements, NPY_STRING, NULL, NULL, 4, 0, NULL);
+  ASSERT_TRUE(NULL != array);
+  char *data = static_cast<char *>(PyArray_DATA(reinterpret_cast<PyArrayObject *>(array)));
+  MEMCPY(data, "ab\0\0abcd", 8);
+  const int32_t sel[] = {1, 3};
+  ObDatum results[4];
+  int64_t ret_cnt = 0;
+  ASSERT_EQ(OB_SUCCESS, ObPythonUdfUtil::numpy_to_datums(ObVarcharType, array, sel, 2,
+                                                         results, ret_cnt));
+  ASSERT_EQ(2, ret_cnt);
+  // read in place without the padding
+  ASSERT_EQ(data, results[1].ptr_);
+  ASSERT_EQ(2, results[1].len_);
+  ASSERT_EQ(ObString::make_string("abcd"), results[3].get_string());
+  Py_DECREF(array);
+}
+
+TEST_F(TestPythonUdfUtil, constant_arg)
+{
+  ASSERT_TRUE(has_numpy_);
+  ObDatum datum;
+  PyObject *obj = NULL;
+  // python scalars of ARG_PASSING KEYWORD
+  datum.set_int(42);
+  ASSERT_EQ(OB_SUCCESS, ObPythonUdfUtil::datum_to_python(ObIntType, datum, true, obj));
+  ASSERT_TRUE(PyLong_Check(obj));
+  ASSERT_EQ(42, PyLong_AsLongLong(obj));
+  ASSERT_TRUE(ObPythonUdfUtil::is_scalar(obj));
+  Py_DECREF(obj);
+  datum.set_string("v2", 2);
+  ASSERT_EQ(OB_SUCCESS, ObPythonUdfUtil::datum_to_python(ObVarcharType, datum, true, obj));
+  ASSERT_TRUE(PyUnicode_Check(obj));
+  ASSERT_STREQ("v2", PyUnicode_AsUTF8(obj));
+  Py_DECREF(obj);
+
+  // 0-d arrays of ARG_PASSING BROADCAST
+  datum.set_double(0.5);
+  ASSERT_EQ(OB_SUCCESS, ObPythonUdfUtil::datum_to_python(ObDoubleType, datum, false, obj));
+  ASSERT_TRUE(PyArray_Check(obj));
+  ASSERT_EQ(0, PyArray_NDIM(reinterpret_cast<PyArrayObject *>(obj)));
+  ASSERT_EQ(0.5, *static_cast<double *>(PyArray_DATA(reinterpret_cast<PyArrayObject *>(obj))));
+  ASSERT_TRUE(ObPythonUdfUtil::is_scalar(obj));
+  Py_DECREF(obj);
+  datum.set_string("v2", 2);
+  ASSERT_EQ(OB_SUCCESS, ObPythonUdfUtil::datum_to_python(ObVarcharType, datum, false, obj));
+  ASSERT_EQ(0, PyArray_NDIM(reinterpret_cast<PyArrayObject *>(obj)));
+  ASSERT_EQ(NPY_UNICODE, PyArray_TYPE(reinterpret_cast<PyArrayObject *>(obj)));
+  Py_DECREF(obj);
+
+  // a 1-d result is not broadcast
+  npy_intp elements[1] = {1};
+  obj = PyArray_SimpleNew(1, elements, NPY_INT64);
+  ASSERT_TRUE(NULL != obj);
+  ASSERT_FALSE(ObPythonUdfUtil::is_scalar(obj));
+  Py_DECREF(obj);
+}
+
+} // end namespace sql
+} // end namespace oceanbase
+
+int main(int argc, char **argv)
+{
+  OB_LOGGER.set_log_level("WARN");
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,243 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+#define USING_LOG_PREFIX SQL_ENG
+
+#include <gtest/gtest.h>
+#include <string>
+#include "lib/allocator/page_arena.h"
+#include "sql/engine/ob_exec_context.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_op.h"
+#include "ob_python_udf_test_util.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+// counts the pages the buffer takes and gives back
+class ObCountingAllocator : public ObIAllocator
+{
+public:
+  ObCountingAllocator() : alloc_cnt_(0), free_cnt_(0) {}
+  virtual void *alloc(const int64_t size) override
+  {
+    ++alloc_cnt_;
+    return arena_.alloc(size);
+  }
+  virtual void *alloc(const int64_t size, const ObMemAttr &attr) override
+  {
+    UNUSED(attr);
+    return alloc(size);
+  }
+  virtual void free(void *ptr) override
+  {
+    if (NULL != ptr) {
+      ++free_cnt_;
+    }
+  }
+  int64_t alloc_cnt_;
+  int64_t free_cnt_;
+private:
+  ObArenaAllocator arena_;
+};
+
+class TestPythonUdfVectorBuffer : public ::testing::Test
+{
+public:
+  static const int64_t BATCH_SIZE = 16;
+  static const int64_t MAX_SIZE = 2 * BATCH_SIZE;
+
+  TestPythonUdfVectorBuffer()
+      : alloc_(), exec_ctx_(alloc_), eval_ctx_(exec_ctx_),
+        frames_(alloc_, eval_ctx_, BATCH_SIZE), skip_size_(0) {}
+  virtual void SetUp() override
+  {
+    ASSERT_EQ(OB_SUCCESS, frames_.init(4));
+    // int and varchar columns saved from the src exprs, loaded into the dst exprs
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(0, ObIntType, src_int_));
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(1, ObVarcharType, src_str_));
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(2, ObIntType, dst_int_));
+    ASSERT_EQ(OB_SUCCESS, frames_.init_expr(3, ObVarcharType, dst_str_));
+    ASSERT_EQ(OB_SUCCESS, src_exprs_.push_back(&src_int_));
+    ASSERT_EQ(OB_SUCCESS, src_exprs_.push_back(&src_str_));
+    ASSERT_EQ(OB_SUCCESS, dst_exprs_.push_back(&dst_int_));
+    ASSERT_EQ(OB_SUCCESS, dst_exprs_.push_back(&dst_str_));
+    skip_ = to_bit_vector(alloc_.alloc(ObBitVector::memory_size(BATCH_SIZE)));
+    ASSERT_TRUE(NULL != skip_);
+    brs_.skip_ = to_bit_vector(alloc_.alloc(ObBitVector::memory_size(BATCH_SIZE)));
+    ASSERT_TRUE(NULL != brs_.skip_);
+    brs_.skip_->init(BATCH_SIZE);
+    skip_size_ = BATCH_SIZE;
+  }
+
+protected:
+  // string payload of row seq, str_len bytes
+  static void make_str(const int64_t seq, const int64_t str_len, std::string &str)
+  {
+    str.assign(str_len, static_cast<char>('a' + seq % 26));
+    if (str_len > 0) {
+      str[str_len - 1] = static_cast<char>('A' + seq % 26);
+    }
+  }
+  // rows begin_seq.. into the src exprs, one row skipped at skip_idx
+  int save(ObVectorBuffer &buffer, const int64_t begin_seq, const int64_t cnt,
+           const int64_t str_len, const int64_t skip_idx = -1)
+  {
+    ObDatum *ints = src_int_.locate_batch_datums(eval_ctx_);
+    ObDatum *strs = src_str_.locate_batch_datums(eval_ctx_);
+    ObBatchRows brs;
+    int64_t seq = begin_seq;
+    brs.skip_ = skip_;
+    brs.size_ = cnt;
+    skip_->init(BATCH_SIZE);
+    for (int64_t i = 0; i < cnt; i++) {
+      if (i == skip_idx) {
+        skip_->set(i);
+        ints[i].set_int(-1);
+        strs[i].set_string("skipped", 7);
+      } else {
+        make_str(seq, str_len, strs_[i]);
+        ints[i].set_int(seq);
+        strs[i].set_string(strs_[i].c_str(), static_cast<int32_t>(strs_[i].length()));
+        ++seq;
+      }
+    }
+    return buffer.save(eval_ctx_, src_exprs_, brs);
+  }
+  // cnt rows loaded into the dst exprs are rows begin_seq..
+  void check_load(ObVectorBuffer &buffer, const int64_t begin_seq, const int64_t cnt,
+                  const int64_t str_len)
+  {
+    std::string str;
+    ASSERT_EQ(OB_SUCCESS, buffer.load(eval_ctx_, brs_, skip_size_, BATCH_SIZE));
+    ASSERT_EQ(cnt, brs_.size_);
+    const ObDatum *ints = dst_int_.locate_batch_datums(eval_ctx_);
+    const ObDatum *strs = dst_str_.locate_batch_datums(eval_ctx_);
+    for (int64_t i = 0; i < cnt; i++) {
+      make_str(begin_seq + i, str_len, str);
+      ASSERT_EQ(begin_seq + i, ints[i].get_int());
+      ASSERT_EQ(str_len, strs[i].len_);
+      ASSERT_EQ(0, MEMCMP(str.c_str(), strs[i].ptr_, str_len));
+    }
+  }
+
+  ObArenaAllocator alloc_;
+  ObExecContext exec_ctx_;
+  ObEvalCtx eval_ctx_;
+  ObPyUdfTestFrames frames_;
+  ObExpr src_int_;
+  ObExpr src_str_;
+  ObExpr dst_int_;
+  ObExpr dst_str_;
+  ObSEArray<ObExpr *, 2> src_exprs_;
+  ObSEArray<ObExpr *, 2> dst_exprs_;
+  ObBitVector *skip_;
+  ObBatchRows brs_;
+  int64_t skip_size_;
+  std::string strs_[BATCH_SIZE];
+};
+
+TEST_F(TestPythonUdfVectorBuffer, wrap_around)
+{
+  ObCountingAllocator page_alloc;
+  ObVectorBuffer buffer;
+  ASSERT_EQ(OB_SUCCESS, buffer.init(dst_exprs_, exec_ctx_, page_alloc, NULL, MAX_SIZE));
+  ASSERT_EQ(OB_SUCCESS, save(buffer, 0, 10, 8));
+  ASSERT_EQ(OB_SUCCESS, save(buffer, 10, 11, 8, 3));
+  ASSERT_EQ(OB_SUCCESS, save(buffer, 20, 10, 8));
+  ASSERT_EQ(30, buffer.get_size());
+  check_load(buffer, 0, 16, 8);
+  check_load(buffer, 16, 14, 8);
+  // the rows just loaded stay reserved until the next load
+  ASSERT_EQ(MAX_SIZE - 14, buffer.get_free_size());
+  // slots 30, 31, 0..7
+  ASSERT_EQ(OB_SUCCESS, save(buffer, 30, 10, 8));
+  ASSERT_EQ(8, buffer.get_free_size());
+  ASSERT_NE(OB_SUCCESS, save(buffer, 40, 10, 8));
+  // a load over the end of the ring
+  check_load(buffer, 30, 10, 8);
+  ASSERT_EQ(OB_SUCCESS, save(buffer, 40, 10, 8));
+  check_load(buffer, 40, 10, 8);
+  ASSERT_FALSE(buffer.is_saved());
+  check_load(buffer, 50, 0, 8);
+}
+
+TEST_F(TestPythonUdfVectorBuffer, large_payload)
+{
+  const int64_t large_len = ObVectorBuffer::PAGE_SIZE + 1000;
+  ObCountingAllocator page_alloc;
+  ObVectorBuffer buffer;
+  ASSERT_EQ(OB_SUCCESS, buffer.init(dst_exprs_, exec_ctx_, page_alloc, NULL, MAX_SIZE));
+  const int64_t init_alloc_cnt = page_alloc.alloc_cnt_;
+  ASSERT_EQ(OB_SUCCESS, save(buffer, 0, 2, large_len));
+  // a page for the ints, one per payload larger than a page
+  ASSERT_EQ(init_alloc_cnt + 3, page_alloc.alloc_cnt_);
+  check_load(buffer, 0, 2, large_len);
+  ASSERT_EQ(OB_SUCCESS, save(buffer, 2, 1, 10));
+  check_load(buffer, 2, 1, 10);
+  // consumed large pages are freed, not kept for reuse
+  ASSERT_EQ(2, page_alloc.free_cnt_);
+}
+
+TEST_F(TestPythonUdfVectorBuffer, page_recycling)
+{
+  const int64_t str_len = 1000;
+  ObCountingAllocator page_alloc;
+  ObVectorBuffer buffer;
+  ASSERT_EQ(OB_SUCCESS, buffer.init(dst_exprs_, exec_ctx_, page_alloc, NULL, MAX_SIZE));
+  const int64_t init_alloc_cnt = page_alloc.alloc_cnt_;
+  // 100 batches take 1.6M of payloads, the pages of the consumed ones are reused
+  for (int64_t i = 0; i < 100; i++) {
+    ASSERT_EQ(OB_SUCCESS, save(buffer, i * BATCH_SIZE, BATCH_SIZE, str_len));
+    check_load(buffer, i * BATCH_SIZE, BATCH_SIZE, str_len);
+  }
+  ASSERT_LE(page_alloc.alloc_cnt_ - init_alloc_cnt, 3);
+  ASSERT_EQ(0, page_alloc.free_cnt_);
+  // every page is unused after reuse, all of them go back
+  buffer.reuse();
+  buffer.free_unused_pages();
+  ASSERT_EQ(page_alloc.alloc_cnt_ - init_alloc_cnt, page_alloc.free_cnt_);
+}
+
+TEST_F(TestPythonUdfVectorBuffer, rescan_reuse)
+{
+  const int64_t str_len = 1000;
+  ObCountingAllocator page_alloc;
+  ObVectorBuffer buffer;
+  ASSERT_EQ(OB_SUCCESS, buffer.init(dst_exprs_, exec_ctx_, page_alloc, NULL, MAX_SIZE));
+  ASSERT_EQ(OB_SUCCESS, save(buffer, 0, BATCH_SIZE, str_len));
+  ASSERT_EQ(OB_SUCCESS, save(buffer, BATCH_SIZE, BATCH_SIZE, str_len));
+  check_load(buffer, 0, BATCH_SIZE, str_len);
+  const int64_t alloc_cnt = page_alloc.alloc_cnt_;
+  // rows of the previous scan are dropped, its pages are reused
+  buffer.reuse();
+  ASSERT_FALSE(buffer.is_saved());
+  ASSERT_EQ(MAX_SIZE, buffer.get_free_size());
+  ASSERT_EQ(OB_SUCCESS, save(buffer, 100, BATCH_SIZE, str_len));
+  ASSERT_EQ(OB_SUCCESS, save(buffer, 100 + BATCH_SIZE, BATCH_SIZE, str_len));
+  check_load(buffer, 100, BATCH_SIZE, str_len);
+  check_load(buffer, 100 + BATCH_SIZE, BATCH_SIZE, str_len);
+  ASSERT_EQ(alloc_cnt, page_alloc.alloc_cnt_);
+  ASSERT_EQ(0, page_alloc.free_cnt_);
+}
+
+} // end namespace sql
+} // end namespace oceanbase
+
+int main(int argc, char **argv)
+{
+  OB_LOGGER.set_log_level("WARN");
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,255 @@
+/**
+ * Copyright (c) 2021 OceanBase
+ * OceanBase CE is licensed under Mulan PubL v2.
+ * You can use this software according to the terms and conditions of the Mulan PubL v2.
+ * You may obtain a copy of Mulan PubL v2 at:
+ *          http://license.coscl.org.cn/MulanPubL-2.0
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PubL v2 for more details.
+ */
+
+#define USING_LOG_PREFIX SQL_ENG
+
+#define PY_SSIZE_T_CLEAN
+#include <gtest/gtest.h>
+#include "lib/time/ob_time_utility.h"
+#include "sql/engine/expr/ob_expr_python_udf.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_util.h"
+#include "sql/engine/python_udf_engine/ob_python_udf_worker_pool.h"
+
+namespace oceanbase
+{
+using namespace common;
+namespace sql
+{
+
+// embedded main interpreter vs worker process, on the same udf and batches
+class TestPythonUdfWorkerPool : public ::testing::Test
+{
+public:
+  static const int64_t ROW_CNT = 1 << 16;
+  static const int64_t BUFFER_SIZE = 16 << 20;
+
+  TestPythonUdfWorkerPool() {}
+  virtual void SetUp()
+  {
+    for (int64_t i = 0; i < ROW_CNT; i++) {
+      a_[i].ptr_ = reinterpret_cast<const char *>(&a_val_[i]);
+      b_[i].ptr_ = reinterpret_cast<const char *>(&b_val_[i]);
+      res_[i].ptr_ = reinterpret_cast<const char *>(&res_val_[i]);
+      a_[i].set_int(i);
+      b_[i].set_double(static_cast<double>(i) / 2);
+      sel_[i] = static_cast<int32_t>(i);
+    }
+    meta_.name_ = ObString::make_string("bench_udf");
+    meta_.pycall_ = ObString::make_string(
+        "import numpy as np\n"
+        "def pyinitial():\n"
+        "    pass\n"
+        "def pyfun(a, b):\n"
+        "    return a * 2 + b\n");
+    meta_.ret_ = share::schema::ObPythonUDF::REAL;
+    meta_.udf_id_ = 1;
+    meta_.schema_version_ = 1;
+    args_[0] = ObPyWorkerArg(ObIntType, a_, false);
+    args_[1] = ObPyWorkerArg(ObDoubleType, b_, false);
+  }
+  virtual void TearDown() {}
+
+  int run_worker(ObPyWorkerChannel &channel, const int64_t batch_size)
+  {
+    int ret = OB_SUCCESS;
+    for (int64_t start = 0; OB_SUCC(ret) && start < ROW_CNT; start += batch_size) {
+      const int64_t cnt = std::min(batch_size, ROW_CNT - start);
+      for (int64_t done = 0, write_cnt = 0, ret_cnt = 0; OB_SUCC(ret) && done < cnt; done += write_cnt) {
+        if (OB_FAIL(channel.write_batch(meta_, args_, 2, ObDoubleType,
+                                        sel_ + start + done, cnt - done, write_cnt))) {
+        } else if (OB_FAIL(channel.run())) {
+        } else if (OB_FAIL(channel.read_result(ObDoubleType, sel_ + start + done, write_cnt,
+                                               res_, ret_cnt))) {
+        }
+      }
+    }
+    return ret;
+  }
+
+  int run_embedded(PyObject *pyfun, const int64_t batch_size)
+  {
+    int ret = OB_SUCCESS;
+    for (int64_t start = 0; OB_SUCC(ret) && start < ROW_CNT; start += batch_size) {
+      const int64_t cnt = std::min(batch_size, ROW_CNT - start);
+      PyObject *a = NULL;
+      PyObject *b = NULL;
+      PyObject *args = NULL;
+      PyObject *result = NULL;
+      int64_t ret_cnt = 0;
+      if (OB_FAIL(ObPythonUdfUtil::datums_to_numpy(ObIntType, a_, false, sel_ + start, cnt, a))) {
+      } else if (OB_FAIL(ObPythonUdfUtil::datums_to_numpy(ObDoubleType, b_, false, sel_ + start, cnt, b))) {
+      } else if (OB_ISNULL(args = PyTuple_Pack(2, a, b))) {
+        ret = OB_ERR_UNEXPECTED;
+      } else if (OB_ISNULL(result = PyObject_CallObject(pyfun, args))) {
+        ret = OB_ERR_UNEXPECTED;
+      } else if (OB_FAIL(ObPythonUdfUtil::numpy_to_datums(ObDoubleType, result, sel_ + start, cnt,
+                                                          res_, ret_cnt))) {
+      }
+      Py_XDECREF(a);
+      Py_XDECREF(b);
+      Py_XDECREF(args);
+      Py_XDECREF(result);
+    }
+    return ret;
+  }
+
+  void check_result()
+  {
+    for (int64_t i = 0; i < ROW_CNT; i += 997) {
+      ASSERT_DOUBLE_EQ(static_cast<double>(i) * 2 + static_cast<double>(i) / 2, res_[i].get_double());
+    }
+  }
+
+protected:
+  int64_t a_val_[ROW_CNT];
+  double b_val_[ROW_CNT];
+  double res_val_[ROW_CNT];
+  ObDatum a_[ROW_CNT];
+  ObDatum b_[ROW_CNT];
+  ObDatum res_[ROW_CNT];
+  int32_t sel_[ROW_CNT];
+  ObPyWorkerArg args_[2];
+  share::schema::ObPythonUDFMeta meta_;
+};
+
+TEST_F(TestPythonUdfWorkerPool, worker_result)
+{
+  ObPyWorkerPool pool;
+  ObPyWorkerChannel *channel = NULL;
+  ASSERT_EQ(OB_SUCCESS, pool.init(OB_SYS_TENANT_ID, 1, BUFFER_SIZE, "python3"));
+  ASSERT_EQ(OB_SUCCESS, pool.borrow(channel));
+  ASSERT_EQ(OB_SUCCESS, run_worker(*channel, ROW_CNT));
+  check_result();
+  // the udf is loaded once per worker
+  ASSERT_EQ(OB_SUCCESS, run_worker(*channel, 100));
+  check_result();
+  pool.give_back(channel);
+}
+
+TEST_F(TestPythonUdfWorkerPool, worker_restart_after_crash)
+{
+  ObPyWorkerPool pool;
+  ObPyWorkerChannel *channel = NULL;
+  ASSERT_EQ(OB_SUCCESS, pool.init(OB_SYS_TENANT_ID, 1, BUFFER_SIZE, "python3"));
+  ASSERT_EQ(OB_SUCCESS, pool.borrow(channel));
+  share::schema::ObPythonUDFMeta crash_meta = meta_;
+  crash_meta.udf_id_ = 2;
+  crash_meta.pycall_ = ObString::make_string(
+      "import os\n"
+      "def pyinitial():\n"
+      "    pass\n"
+      "def pyfun(a, b):\n"
+      "    os._exit(1)\n");
+  int64_t write_cnt = 0;
+  ASSERT_EQ(OB_SUCCESS, channel->write_batch(crash_meta, args_, 2, ObDoubleType, sel_, 10, write_cnt));
+  ASSERT_NE(OB_SUCCESS, channel->run());
+  ASSERT_FALSE(channel->is_worker_alive());
+  pool.give_back(channel);
+  // next borrower gets a fresh worker
+  ASSERT_EQ(OB_SUCCESS, pool.borrow(channel));
+  ASSERT_EQ(OB_SUCCESS, run_worker(*channel, 4096));
+  check_result();
+  pool.give_back(channel);
+}
+
+// the caller keeps going between submit() and wait(), as the pipelined operator does
+TEST_F(TestPythonUdfWorkerPool, worker_submit_wait)
+{
+  ObPyWorkerPool pool;
+  ObPyWorkerChannel *channel = NULL;
+  int64_t write_cnt = 0;
+  int64_t ret_cnt = 0;
+  ASSERT_EQ(OB_SUCCESS, pool.init(OB_SYS_TENANT_ID, 1, BUFFER_SIZE, "python3"));
+  ASSERT_EQ(OB_SUCCESS, pool.borrow(channel));
+  ASSERT_EQ(OB_SUCCESS, channel->write_batch(meta_, args_, 2, ObDoubleType, sel_, 4096, write_cnt));
+  ASSERT_EQ(4096, write_cnt);
+  ASSERT_EQ(OB_SUCCESS, channel->submit());
+  ASSERT_TRUE(channel->is_running());
+  ASSERT_NE(OB_SUCCESS, channel->submit());
+  ASSERT_EQ(OB_SUCCESS, channel->wait());
+  ASSERT_FALSE(channel->is_running());
+  ASSERT_EQ(OB_SUCCESS, channel->read_result(ObDoubleType, sel_, write_cnt, res_, ret_cnt));
+  ASSERT_EQ(write_cnt, ret_cnt);
+  ASSERT_DOUBLE_EQ(4095 * 2 + 4095.0 / 2, res_[4095].get_double());
+  // a channel given back with a batch in flight is restarted
+  ASSERT_EQ(OB_SUCCESS, channel->write_batch(meta_, args_, 2, ObDoubleType, sel_, 10, write_cnt));
+  ASSERT_EQ(OB_SUCCESS, channel->submit());
+  pool.give_back(channel);
+  ASSERT_EQ(OB_SUCCESS, pool.borrow(channel));
+  ASSERT_EQ(OB_SUCCESS, run_worker(*channel, 4096));
+  check_result();
+  pool.give_back(channel);
+}
+
+// a thread holding a channel does not wait for another one
+TEST_F(TestPythonUdfWorkerPool, try_borrow)
+{
+  ObPyWorkerPool pool;
+  ObPyWorkerChannel *channel = NULL;
+  ObPyWorkerChannel *other = NULL;
+  ASSERT_EQ(OB_SUCCESS, pool.init(OB_SYS_TENANT_ID, 1, BUFFER_SIZE, "python3"));
+  ASSERT_EQ(OB_SUCCESS, pool.try_borrow(channel));
+  ASSERT_TRUE(NULL != channel);
+  ASSERT_EQ(OB_SUCCESS, pool.try_borrow(other));
+  ASSERT_TRUE(NULL == other);
+  pool.give_back(channel);
+  ASSERT_EQ(OB_SUCCESS, pool.try_borrow(other));
+  ASSERT_EQ(channel, other);
+  pool.give_back(other);
+}
+
+TEST_F(TestPythonUdfWorkerPool, throughput)
+{
+  const int64_t batch_sizes[] = {256, 4096, ROW_CNT};
+  ObPyWorkerPool pool;
+  ObPyWorkerChannel *channel = NULL;
+  PyGILState_STATE gstate;
+  PyObject *pyfun = NULL;
+  ASSERT_EQ(OB_SUCCESS, pool.init(OB_SYS_TENANT_ID, 1, BUFFER_SIZE, "python3"));
+  ASSERT_EQ(OB_SUCCESS, pool.borrow(channel));
+  if (!Py_IsInitialized()) {
+    Py_InitializeEx(0);
+    PyEval_SaveThread();
+  }
+  gstate = PyGILState_Ensure();
+  ASSERT_EQ(OB_SUCCESS, ObPythonUdfUtil::import_numpy());
+  ASSERT_EQ(OB_SUCCESS, ObExprPythonUdf::load_udf(meta_));
+  pyfun = PyObject_GetAttrString(PyImport_AddModule("__main__"), "bench_udf_pyfun");
+  ASSERT_TRUE(NULL != pyfun);
+  for (int64_t i = 0; i < ARRAYSIZEOF(batch_sizes); i++) {
+    int64_t begin = ObTimeUtility::current_time();
+    ASSERT_EQ(OB_SUCCESS, run_embedded(pyfun, batch_sizes[i]));
+    const int64_t embedded_us = ObTimeUtility::current_time() - begin;
+    check_result();
+    begin = ObTimeUtility::current_time();
+    ASSERT_EQ(OB_SUCCESS, run_worker(*channel, batch_sizes[i]));
+    const int64_t worker_us = ObTimeUtility::current_time() - begin;
+    check_result();
+    const int64_t batch_size = batch_sizes[i];
+    LOG_INFO("throughput in rows/s", K(batch_size),
+             "embedded", ROW_CNT * 1000000 / (embedded_us + 1),
+             "worker", ROW_CNT * 1000000 / (worker_us + 1));
+  }
+  Py_XDECREF(pyfun);
+  PyGILState_Release(gstate);
+  pool.give_back(channel);
+}
+
+} // end namespace sql
+} // end namespace oceanbase
+
+int main(int argc, char **argv)
+{
+  OB_LOGGER.set_log_level("WARN");
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}